@@ -201,6 +201,10 @@
 #endif
 #endif
 
+#ifndef HASP_USE_LAZY_PAGES
+#define HASP_USE_LAZY_PAGES 0 // Build pages on first use and evict inactive pages under memory pressure
+#endif
+
 #define HASP_OBJECT_NOTATION "p%ub%u"
 
 #ifndef HASP_ATTRIBUTE_FAST_MEM
@@ -385,11 +389,7 @@ static WiFiSpiClass WiFi;
 #endif
 
 #if defined(POSIX)
-#ifdef USE_MONITOR
-#define delay SDL_Delay
-#else
-#define delay msleep
-#endif
+#define delay msleep // monotonic, also with SDL
 #endif
 
 #if HASP_TARGET_PC
@@ -408,12 +408,12 @@ static WiFiSpiClass WiFi;
 #define strcpy_P strcpy
 #define strstr_P strstr
 #define halRestartMcu()
-#if USE_MONITOR
+#if defined(POSIX)
+#define millis PosixMillis // same clock as the lvgl tick
+#elif USE_MONITOR
 #define millis SDL_GetTicks
 #elif defined(WINDOWS)
 #define millis Win32Millis
-#elif defined(POSIX)
-#define millis PosixMillis
 #endif
 
 #define DEC 10
@@ -6,6 +6,7 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,12 +19,27 @@ void* lodepng_realloc(void* ptr, size_t new_size);
 void lodepng_free(void* ptr);
 #endif // LODEPNG_NO_COMPILE_ALLOCATORS
 
+typedef struct
+{
+    uint16_t block_size;
+    uint16_t block_count;
+    uint16_t used;
+    uint16_t high_water;
+    uint32_t allocs;
+    uint32_t fallbacks;
+    uint8_t fragmentation; // Percentage of the used blocks that was not requested
+} hasp_mem_pool_stats_t;
+
 bool hasp_use_psram();
 void* hasp_calloc(size_t num, size_t size);
+void* hasp_calloc_persistent(size_t num, size_t size);
 void* hasp_malloc(size_t size);
 void* hasp_realloc(void* ptr, size_t new_size);
 void hasp_free(void* ptr);
 
+bool hasp_mem_get_pool_stats(uint8_t index, hasp_mem_pool_stats_t* stats);
+void hasp_mem_get_stats(uint32_t* psram_allocs, uint32_t* heap_allocs);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,21 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Time base of lvgl on the PC builds, the same monotonic clock as millis() */
+
+#ifndef HASP_TICK_H
+#define HASP_TICK_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t hasp_tick_get(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif // HASP_TICK_H
@@ -307,7 +307,9 @@ typedef void* lv_img_decoder_user_data_t;
 #endif   /*LV_TICK_CUSTOM*/
 
 #else
-#define LV_TICK_CUSTOM     0
+#define LV_TICK_CUSTOM     1
+#define LV_TICK_CUSTOM_INCLUDE  "hasp_tick.h"     /*Monotonic clock of the PC builds*/
+#define LV_TICK_CUSTOM_SYS_TIME_EXPR (hasp_tick_get())
 #endif
 
 typedef void* lv_disp_drv_user_data_t;             /*Type of user data in the display driver*/
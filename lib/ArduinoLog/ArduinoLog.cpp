@@ -107,6 +107,33 @@ void Logging::setSuffix(printfunction f)
     #endif
 }
 
+void Logging::setLine(linefunction f, int level)
+{
+    #ifndef DISABLE_LOGGING
+    _line      = f;
+    _lineLevel = level;
+    #endif
+}
+
+void Logging::printOutputs(uint8_t tag, int level, LogLine & line)
+{
+    #ifndef DISABLE_LOGGING
+    for(int i = 0; i < 3; i++) {
+        if(_logOutput[i] == NULL || level > _level[i]) continue;
+
+        if(_prefix != NULL) {
+            _prefix(tag, level, _logOutput[i]);
+        }
+
+        _logOutput[i]->write((const uint8_t *)line.c_str(), line.length());
+
+        if(_suffix != NULL) {
+            _suffix(tag, level, _logOutput[i]);
+        }
+    }
+    #endif
+}
+
 void Logging::print(Print * logOutput, const __FlashStringHelper * format, va_list args)
 {
     #ifndef DISABLE_LOGGING
@@ -23,6 +23,43 @@ Licensed under the MIT License <http://opensource.org/licenses/MIT>.
 #endif
 //#include "StringStream.h"
 typedef void (*printfunction)(uint8_t tag, int level, Print*);
+typedef void (*linefunction)(uint8_t tag, int level, const char* line, size_t len);
+
+#ifndef LOG_LINE_SIZE
+#define LOG_LINE_SIZE 256
+#endif
+
+/* Collects one formatted message, longer ones are cut off */
+class LogLine : public Print {
+  public:
+    size_t write(uint8_t c) override
+    {
+        if(_len >= sizeof(_buffer) - 1) {
+            _overflow = true;
+            return 0;
+        }
+        _buffer[_len++] = c;
+        return 1;
+    }
+    const char* c_str()
+    {
+        _buffer[_len] = 0;
+        return _buffer;
+    }
+    size_t length() const
+    {
+        return _len;
+    }
+    bool overflow() const
+    {
+        return _overflow;
+    }
+
+  private:
+    char _buffer[LOG_LINE_SIZE];
+    size_t _len    = 0;
+    bool _overflow = false;
+};
 
 //#include <stdint.h>
 //#include <stddef.h>
@@ -175,6 +212,16 @@ class Logging {
      */
     void setSuffix(printfunction f);
 
+    /**
+     * Sets a function that gets every message up to level once, formatted
+     * without prefix and suffix, whether or not an output is registered.
+     *
+     * \param f - The function to be called
+     * \param level - messages <= this level are passed
+     * \return void
+     */
+    void setLine(linefunction f, int level);
+
     /**
      * Output a fatal error message. Output message contains
      * F: followed by original message
@@ -317,10 +364,26 @@ class Logging {
 
     void printFormat(Print* logOutput, const char format, va_list* args);
 
+    void printOutputs(uint8_t tag, int level, LogLine& line);
+
     template <class T> void printLevel(uint8_t tag, int level, T msg, ...)
     {
 #ifndef DISABLE_LOGGING
 
+        if(_line != NULL && level <= _lineLevel) {
+            // Formatted once for the line function and the outputs, only a message that got cut is formatted again
+            LogLine line;
+            va_list args;
+            va_start(args, msg);
+            print(&line, msg, args);
+            va_end(args);
+            _line(tag, level, line.c_str(), line.length());
+            if(!line.overflow()) {
+                printOutputs(tag, level, line);
+                return;
+            }
+        }
+
         for(int i = 0; i < 3; i++) {
             if(_logOutput[i] == NULL || level > _level[i]) continue;
 
@@ -347,6 +410,8 @@ class Logging {
 
     printfunction _prefix = NULL;
     printfunction _suffix = NULL;
+    linefunction _line    = NULL;
+    int _lineLevel        = LOG_LEVEL_SILENT;
 #endif
 };
 
@@ -271,12 +271,18 @@ static lv_fs_res_t fs_tell(lv_fs_drv_t* drv, void* file_p, uint32_t* pos_p)
  */
 static lv_fs_res_t fs_remove(lv_fs_drv_t* drv, const char* path)
 {
-    (void)drv; /*Unused*/
-    lv_fs_res_t res = LV_FS_RES_NOT_IMP;
-
-    /* Add your code here*/
+    char buf[256];
+#ifndef WIN32
+    int len = snprintf(buf, sizeof(buf), "%s/%s", (char*)drv->user_data, path);
+#else
+    int len = snprintf(buf, sizeof(buf), "%s\\%s", (char*)drv->user_data, path);
+#endif
+    if(len < 0 || len >= (int)sizeof(buf)) return LV_FS_RES_INV_PARAM; /*Don't remove a truncated path*/
 
-    return res;
+    if(remove(buf) == 0)
+        return LV_FS_RES_OK;
+    else
+        return LV_FS_RES_UNKNOWN;
 }
 
 /**
@@ -306,12 +312,13 @@ static lv_fs_res_t fs_trunc(lv_fs_drv_t* drv, void* file_p)
  */
 static lv_fs_res_t fs_rename(lv_fs_drv_t* drv, const char* oldname, const char* newname)
 {
-    (void)drv; /*Unused*/
-    static char new[512];
-    static char old[512];
+    char new[512];
+    char old[512];
 
-    sprintf(old, "%s/%s", drv->user_data, oldname);
-    sprintf(new, "%s/%s", drv->user_data, newname);
+    int old_len = snprintf(old, sizeof(old), "%s/%s", (char*)drv->user_data, oldname);
+    int new_len = snprintf(new, sizeof(new), "%s/%s", (char*)drv->user_data, newname);
+    if(old_len < 0 || old_len >= (int)sizeof(old) || new_len < 0 || new_len >= (int)sizeof(new))
+        return LV_FS_RES_INV_PARAM; /*Don't rename a truncated path*/
 
     int r = rename(old, new);
 
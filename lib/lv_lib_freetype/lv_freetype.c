@@ -20,6 +20,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 
 #if CONFIG_FREERTOS_UNICORE
 #define ARDUINO_RUNNING_CORE 0
@@ -28,6 +29,7 @@
 #endif
 
 #define LV_USE_FT_STACK_SIZE 24 * 1024 // FreeType consumes a large amount of stack
+#define LV_FT_SEEN_KEYS 256            // glyphs remembered to tell a reload from a first render
 
 /*
  * FreeType requires up to 32KB of stack to run, which overflows the stack of 8KB.
@@ -79,6 +81,7 @@ typedef struct name_refer_t
 #if LV_FREETYPE_CACHE_SIZE >= 0
 static void face_generic_finalizer_cache(void* object);
 static FT_Error font_face_requester(FTC_FaceID face_id, FT_Library library_is, FT_Pointer req_data, FT_Face* aface);
+static bool cache_manager_new(uint16_t max_faces, uint16_t max_sizes, uint32_t max_bytes);
 static bool lv_ft_font_init_cache(lv_ft_info_t* info);
 static void lv_ft_font_destroy_cache(lv_font_t* font);
 #else
@@ -99,11 +102,13 @@ static const char* name_refer_find(const char* name);
  **********************/
 static FT_Library library;
 static lv_ll_t names_ll;
+static lv_ft_cache_stats_t cache_stats;
 
 #if LV_FREETYPE_CACHE_SIZE >= 0
 static FTC_Manager cache_manager;
 static FTC_CMapCache cmap_cache;
 static FT_Face current_face = NULL;
+static uint32_t seen_keys[LV_FT_SEEN_KEYS];
 
 #if LV_FREETYPE_SBIT_CACHE
 static FTC_SBitCache sbit_cache;
@@ -138,33 +143,11 @@ bool lv_freetype_init(uint16_t max_faces, uint16_t max_sizes, uint32_t max_bytes
     _lv_ll_init(&names_ll, sizeof(name_refer_t));
 
 #if LV_FREETYPE_CACHE_SIZE >= 0
-    error = FTC_Manager_New(library, max_faces, max_sizes, max_bytes, font_face_requester, NULL, &cache_manager);
-    if(error) {
+    if(!cache_manager_new(max_faces, max_sizes, max_bytes)) {
         FT_Done_FreeType(library);
-        LV_LOG_ERROR("Failed to open cache manager");
         return false;
     }
 
-    error = FTC_CMapCache_New(cache_manager, &cmap_cache);
-    if(error) {
-        LV_LOG_ERROR("Failed to open Cmap Cache");
-        goto Fail;
-    }
-
-#if LV_FREETYPE_SBIT_CACHE
-    error = FTC_SBitCache_New(cache_manager, &sbit_cache);
-    if(error) {
-        LV_LOG_ERROR("Failed to open sbit cache");
-        goto Fail;
-    }
-#else
-    error = FTC_ImageCache_New(cache_manager, &image_cache);
-    if(error) {
-        LV_LOG_ERROR("Failed to open image cache");
-        goto Fail;
-    }
-#endif
-
     // initialize the queues to send request and receive response
     FTRequestQueue  = xQueueCreate(1, sizeof(FT_glyph_dsc_request));
     FTResponseQueue = xQueueCreate(1, sizeof(FT_glyph_dsc_response));
@@ -175,8 +158,8 @@ bool lv_freetype_init(uint16_t max_faces, uint16_t max_sizes, uint32_t max_bytes
     if(FTRequestQueue && FTResponseQueue) {
         return true;
     }
-Fail:
     FTC_Manager_Done(cache_manager);
+    cache_manager = NULL;
     FT_Done_FreeType(library);
     return false;
 #else
@@ -188,6 +171,37 @@ Fail:
 #endif /* LV_FREETYPE_CACHE_SIZE */
 }
 
+bool lv_freetype_set_cache(uint16_t max_faces, uint16_t max_sizes, uint32_t max_bytes)
+{
+#if LV_FREETYPE_CACHE_SIZE >= 0
+    /* The FreeType task only runs while the lvgl thread waits for its response, so it is idle now */
+    if(!cache_manager_new(max_faces, max_sizes, max_bytes)) return false;
+    lv_freetype_reset_cache_stats();
+    return true;
+#else
+    LV_UNUSED(max_faces);
+    LV_UNUSED(max_sizes);
+    LV_UNUSED(max_bytes);
+    return false;
+#endif
+}
+
+void lv_freetype_get_cache_stats(lv_ft_cache_stats_t* stats)
+{
+    *stats = cache_stats;
+}
+
+void lv_freetype_reset_cache_stats(void)
+{
+    cache_stats.hits     = 0;
+    cache_stats.misses   = 0;
+    cache_stats.reloads  = 0;
+    cache_stats.uncached = 0;
+    cache_stats.faces    = 0;
+    cache_stats.hit_us   = 0;
+    cache_stats.miss_us  = 0;
+}
+
 void lv_freetype_destroy(void)
 {
 #if LV_FREETYPE_CACHE_SIZE >= 0
@@ -230,11 +244,77 @@ static void face_generic_finalizer_cache(void* object)
     LV_LOG_WARN("face finalizer(%p)\n", face);
 }
 
+/* Creates a cache manager with its cmap and glyph caches, the current ones are kept on failure */
+static bool cache_manager_new(uint16_t max_faces, uint16_t max_sizes, uint32_t max_bytes)
+{
+    FTC_Manager manager;
+    FTC_CMapCache cmap;
+#if LV_FREETYPE_SBIT_CACHE
+    FTC_SBitCache glyphs;
+#else
+    FTC_ImageCache glyphs;
+#endif
+
+    FT_Error error = FTC_Manager_New(library, max_faces, max_sizes, max_bytes, font_face_requester, NULL, &manager);
+    if(error) {
+        LV_LOG_ERROR("Failed to open cache manager");
+        return false;
+    }
+
+    error = FTC_CMapCache_New(manager, &cmap);
+    if(error) {
+        LV_LOG_ERROR("Failed to open Cmap Cache");
+        FTC_Manager_Done(manager);
+        return false;
+    }
+
+#if LV_FREETYPE_SBIT_CACHE
+    error = FTC_SBitCache_New(manager, &glyphs);
+#else
+    error = FTC_ImageCache_New(manager, &glyphs);
+#endif
+    if(error) {
+        LV_LOG_ERROR("Failed to open glyph cache");
+        FTC_Manager_Done(manager);
+        return false;
+    }
+
+    if(cache_manager) FTC_Manager_Done(cache_manager);
+    cache_manager = manager;
+    cmap_cache    = cmap;
+#if LV_FREETYPE_SBIT_CACHE
+    sbit_cache = glyphs;
+#else
+    image_cache = glyphs;
+#endif
+    current_face = NULL;
+    memset(seen_keys, 0, sizeof(seen_keys));
+
+    cache_stats.max_faces = max_faces;
+    cache_stats.max_sizes = max_sizes;
+    cache_stats.max_bytes = max_bytes;
+    return true;
+}
+
+/* A glyph rendered into the cache was rendered before if its key is still remembered */
+static void cache_count_miss(FTC_FaceID face_id, FT_UInt glyph_index)
+{
+    uint32_t key = (uint32_t)(uintptr_t)face_id * 2654435761u ^ glyph_index * 40503u;
+    if(key == 0) key = 1; // an empty entry
+    uint32_t* pos = &seen_keys[key % LV_FT_SEEN_KEYS];
+
+    cache_stats.misses++;
+    if(*pos == key) cache_stats.reloads++;
+    *pos = key;
+}
+
 static FT_Error font_face_requester(FTC_FaceID face_id, FT_Library library_is, FT_Pointer req_data, FT_Face* aface)
 {
     LV_UNUSED(library_is);
     LV_UNUSED(req_data);
 
+    cache_stats.faces++;
+
     lv_font_fmt_ft_dsc_t* dsc = (lv_font_fmt_ft_dsc_t*)face_id;
     FT_Error error;
     if(dsc->mem) {
@@ -294,6 +374,8 @@ static bool get_glyph_dsc_cb_cache(const lv_font_t* font, lv_font_glyph_dsc_t* d
     }
 
     lv_font_fmt_ft_dsc_t* dsc = (lv_font_fmt_ft_dsc_t*)(font->dsc);
+    int64_t start             = esp_timer_get_time();
+    bool rendered             = true;
 
     FTC_FaceID face_id = (FTC_FaceID)dsc;
     FT_Size face_size;
@@ -326,9 +408,13 @@ static bool get_glyph_dsc_cb_cache(const lv_font_t* font, lv_font_glyph_dsc_t* d
             current_face = NULL;
             return false;
         }
+        cache_stats.uncached++;
         goto end;
     }
 
+    /* Only a glyph rendered into the cache is loaded into the glyph slot of the face */
+    face->glyph->format = FT_GLYPH_FORMAT_NONE;
+
     FTC_ImageTypeRec desc_type;
     desc_type.face_id = face_id;
     desc_type.flags   = FT_LOAD_RENDER | FT_LOAD_TARGET_NORMAL;
@@ -368,11 +454,23 @@ static bool get_glyph_dsc_cb_cache(const lv_font_t* font, lv_font_glyph_dsc_t* d
     dsc_out->bpp   = 8;                                             /*Bit per pixel: 1/2/4/8*/
 #endif
 
+    rendered = face->glyph->format != FT_GLYPH_FORMAT_NONE;
+    if(rendered) {
+        cache_count_miss(face_id, glyph_index);
+    } else {
+        cache_stats.hits++;
+    }
+
 end:
     if((dsc->style & FT_FONT_STYLE_ITALIC) && (unicode_letter_next == '\0')) {
         dsc_out->adv_w = dsc_out->box_w + dsc_out->ofs_x;
     }
 
+    if(rendered) {
+        cache_stats.miss_us += esp_timer_get_time() - start;
+    } else {
+        cache_stats.hit_us += esp_timer_get_time() - start;
+    }
     return true;
 }
 
@@ -504,6 +602,7 @@ void lv_ft_font_destroy_cache(lv_font_t* font)
         LV_LOG_WARN("RemoveFaceID : %s %u", dsc->name, dsc->height);
 
         FTC_Manager_RemoveFaceID(cache_manager, (FTC_FaceID)dsc);
+        memset(seen_keys, 0, sizeof(seen_keys)); // the address can be reused by the next font
         name_refer_del(dsc->name);
         lv_mem_free(dsc);
         font->dsc = NULL;
@@ -47,6 +47,20 @@ typedef struct
     uint16_t height;
 } lv_font_fmt_ft_dsc_t;
 
+typedef struct
+{
+    uint16_t max_faces; /* Limits of the cache manager */
+    uint16_t max_sizes;
+    uint32_t max_bytes;
+    uint32_t hits;     /* Glyphs served from the cache */
+    uint32_t misses;   /* Glyphs rendered into the cache */
+    uint32_t reloads;  /* Misses on glyphs that were cached before, i.e. evicted */
+    uint32_t uncached; /* Bold glyphs, rendered on every lookup */
+    uint32_t faces;    /* Faces opened by the cache manager */
+    uint32_t hit_us;   /* Time spent on hits */
+    uint32_t miss_us;  /* Time spent on misses and uncached glyphs */
+} lv_ft_cache_stats_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -61,6 +75,26 @@ typedef struct
  */
 bool lv_freetype_init(uint16_t max_faces, uint16_t max_sizes, uint32_t max_bytes);
 
+/**
+ * Replace the cache manager by one with new limits, the fonts stay valid and their glyphs are rendered again.
+ * @param max_faces Maximum number of opened FT_Face objects. Use 0 for defaults.
+ * @param max_sizes Maximum number of opened FT_Size objects. Use 0 for defaults.
+ * @param max_bytes Maximum number of bytes to use for cached data nodes. Use 0 for defaults.
+ * @return true on success, otherwise false and the old cache is kept.
+ */
+bool lv_freetype_set_cache(uint16_t max_faces, uint16_t max_sizes, uint32_t max_bytes);
+
+/**
+ * Get the limits and the hit and miss counters of the glyph cache
+ * @param stats pointer to the statistics to fill
+ */
+void lv_freetype_get_cache_stats(lv_ft_cache_stats_t* stats);
+
+/**
+ * Reset the hit and miss counters of the glyph cache
+ */
+void lv_freetype_reset_cache_stats(void);
+
 /**
  * Destroy freetype library
  */
@@ -11,6 +11,7 @@
 #include "lv_widgets/lv_canvas.h"
 #include "lv_qrcode.h"
 #include "qrcodegen.h"
+#include "qrcode_expand.h"
 
 /*********************
  *      DEFINES
@@ -25,10 +26,13 @@
 /**********************
  *  STATIC PROTOTYPES
  **********************/
+static uint32_t qrcode_data_hash(const void* data, uint32_t data_len);
+static lv_res_t lv_qrcode_signal(lv_obj_t* qrcode, lv_signal_t sign, void* param);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+static lv_signal_cb_t ancestor_signal;
 
 /**********************
  *      MACROS
@@ -67,6 +71,13 @@ lv_obj_t* lv_qrcode_create(lv_obj_t* parent, lv_coord_t size, lv_color_t dark_co
     ext->static_txt     = 0;
     ext->dot.tmp_ptr    = NULL;
     ext->dot_tmp_alloc  = 0;
+    ext->qr             = NULL;
+    ext->qr_hash        = 0;
+    ext->qr_len         = 0;
+    ext->qr_drawn       = 0;
+
+    if(ancestor_signal == NULL) ancestor_signal = lv_obj_get_signal_cb(new_qrcode);
+    lv_obj_set_signal_cb(new_qrcode, lv_qrcode_signal);
 
     /*Allocate QR bitmap buffer*/
     uint32_t buf_size = LV_CANVAS_BUF_SIZE_INDEXED_1BIT(size, size);
@@ -114,44 +125,63 @@ lv_obj_t* lv_qrcode_create(lv_obj_t* parent, lv_coord_t size, lv_color_t dark_co
  */
 lv_res_t lv_qrcode_update(lv_obj_t* qrcode, const void* data, uint32_t data_len)
 {
-    lv_color_t c;
-    c.full = 1;
-    lv_canvas_fill_bg(qrcode, c, 0);
-    // lv_canvas_zoom();
+    lv_qrcode_ext_t* ext = lv_obj_get_ext_attr(qrcode);
 
     LV_LOG_INFO("Update QR-code text with length : %d", data_len);
 
     if(data_len > qrcodegen_BUFFER_LEN_MAX) return LV_RES_INV;
 
-    uint8_t qr0[qrcodegen_BUFFER_LEN_MAX];
-    uint8_t data_tmp[qrcodegen_BUFFER_LEN_MAX];
-    memcpy(data_tmp, data, data_len);
+    /*Unchanged data keeps the encoded symbol, the data is stored after it to rule out hash collisions*/
+    uint32_t hash = qrcode_data_hash(data, data_len);
+    bool cached   = ext->qr != NULL && ext->qr_hash == hash && ext->qr_len == data_len;
+    if(cached) {
+        int qr_size = qrcodegen_getSize(ext->qr);
+        cached      = memcmp(ext->qr + (qr_size * qr_size + 7) / 8 + 1, data, data_len) == 0;
+    }
+    if(!cached) {
+        uint8_t qr0[qrcodegen_BUFFER_LEN_MAX];
+        uint8_t data_tmp[qrcodegen_BUFFER_LEN_MAX];
+        memcpy(data_tmp, data, data_len);
 
-    bool ok = qrcodegen_encodeBinary(data_tmp, data_len, qr0, qrcodegen_Ecc_MEDIUM, qrcodegen_VERSION_MIN,
-                                     qrcodegen_VERSION_MAX, qrcodegen_Mask_AUTO, true);
+        bool ok = qrcodegen_encodeBinary(data_tmp, data_len, qr0, qrcodegen_Ecc_MEDIUM, qrcodegen_VERSION_MIN,
+                                         qrcodegen_VERSION_MAX, qrcodegen_Mask_AUTO, true);
 
-    if(!ok) {
-        LV_LOG_WARN("QR-code encoding error");
-        return LV_RES_INV;
+        if(!ok) {
+            LV_LOG_WARN("QR-code encoding error");
+            return LV_RES_INV;
+        }
+
+        int qr_size  = qrcodegen_getSize(qr0);
+        uint32_t len = (qr_size * qr_size + 7) / 8 + 1;
+        uint8_t* qr  = lv_mem_realloc(ext->qr, len + data_len);
+        LV_ASSERT_MEM(qr);
+        if(qr == NULL) return LV_RES_INV;
+
+        memcpy(qr, qr0, len);
+        memcpy(qr + len, data, data_len);
+        ext->qr       = qr;
+        ext->qr_hash  = hash;
+        ext->qr_len   = data_len;
+        ext->qr_drawn = 0;
     }
 
-    lv_coord_t obj_w = lv_obj_get_width(qrcode);
-    int qr_size      = qrcodegen_getSize(qr0);      // Number of vertical QR blocks
-    int scale        = obj_w / (qr_size + 2);       // +2 guaranteed a minimum of 1 block margin all round
-    int scaled       = qr_size * scale;
-    int margin       = (obj_w - scaled) / 2;
+    lv_img_dsc_t* img = lv_canvas_get_img(qrcode);
+    lv_coord_t obj_w  = img->header.w;
+    if(ext->qr_drawn == obj_w) return LV_RES_OK; /*Nothing changed*/
+
+    int qr_size = qrcodegen_getSize(ext->qr);     // Number of vertical QR blocks
+    int scale   = obj_w / (qr_size + 2);          // +2 guaranteed a minimum of 1 block margin all round
+    int scaled  = qr_size * scale;
+    int margin  = (obj_w - scaled) / 2;
 
     LV_LOG_INFO("Update QR-code data : obj_w[%d] QR moduls[%d] scale factor[%d]", obj_w, qr_size, scale);
 
-    /*Expand the qr encodet binary to canvas size*/
-    for(int y = 0; y < scaled; y++) {
-        for(int x = 0; x < scaled; x++) {
-            c.full = qrcodegen_getModule(qr0, x / scale, y / scale) ? 0 : 1;
-            lv_canvas_set_px(qrcode, x + margin, y + margin, c);
-        }
-    }
+    /*Expand the qr encoded binary straight into the canvas bitmap, after the 2 color palette*/
+    uint8_t* bitmap = (uint8_t*)img->data + 2 * sizeof(lv_color32_t);
+    qrcode_expand(bitmap, (obj_w + 7) >> 3, img->header.h, ext->qr, scale, margin);
+    ext->qr_drawn = obj_w;
 
-    qrcode->signal_cb(qrcode, LV_SIGNAL_CLEANUP, NULL);
+    lv_obj_invalidate(qrcode);
 
     return LV_RES_OK;
 }
@@ -304,8 +334,9 @@ lv_res_t lv_qrcode_set_size(lv_obj_t * qrcode, lv_coord_t size)
     if(buf == NULL) return LV_RES_INV;
 
     lv_canvas_set_buffer(qrcode, buf, size, size, LV_IMG_CF_INDEXED_1BIT);
+    ext->qr_drawn = 0;
 
-    lv_qrcode_update(qrcode, ext->text, strlen(ext->text));
+    if(ext->text) lv_qrcode_update(qrcode, ext->text, strlen(ext->text));
 
 //     qrcode->signal_cb(qrcode, LV_SIGNAL_CLEANUP, NULL);
 
@@ -326,3 +357,38 @@ void lv_qrcode_delete(lv_obj_t* qrcode)
 /**********************
  *   STATIC FUNCTIONS
  **********************/
+
+/**
+ * Signal function of the QR code
+ * @param qrcode pointer to a QR code object
+ * @param sign a signal type from lv_signal_t enum
+ * @param param pointer to a signal specific variable
+ * @return LV_RES_OK: the object is not deleted in the function; LV_RES_INV: the object is deleted
+ */
+static lv_res_t lv_qrcode_signal(lv_obj_t* qrcode, lv_signal_t sign, void* param)
+{
+    lv_res_t res = ancestor_signal(qrcode, sign, param);
+    if(res != LV_RES_OK) return res;
+    if(sign == LV_SIGNAL_GET_TYPE) return lv_obj_handle_get_type_signal(param, LV_OBJX_NAME);
+
+    if(sign == LV_SIGNAL_CLEANUP) {
+        /*The cached segments belong to the object however it is deleted*/
+        lv_qrcode_ext_t* ext = lv_obj_get_ext_attr(qrcode);
+        lv_mem_free(ext->qr);
+        ext->qr = NULL;
+    }
+
+    return res;
+}
+
+/*FNV-1a, only used to detect unchanged data*/
+static uint32_t qrcode_data_hash(const void* data, uint32_t data_len)
+{
+    const uint8_t* p = data;
+    uint32_t hash    = 2166136261u;
+    while(data_len--) {
+        hash ^= *p++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
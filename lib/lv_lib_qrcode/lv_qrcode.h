@@ -40,6 +40,11 @@ typedef struct {
         char tmp[4]; /* Directly store the characters if <=4 characters */
     } dot;
 
+    uint8_t * qr;          /*Cached encoded symbol, followed by the data it encodes*/
+    uint32_t qr_hash;      /*Hash of the data of the cached symbol*/
+    uint32_t qr_len;       /*Length of the data of the cached symbol*/
+    lv_coord_t qr_drawn;   /*Bitmap size the symbol was last drawn at, 0 if not drawn*/
+
     uint8_t static_txt : 1;             /*Flag to indicate the text is static*/
     uint8_t dot_tmp_alloc : 1; /*True if dot_tmp has been allocated. False if dot_tmp directly holds up to 4 bytes of
                                   characters */
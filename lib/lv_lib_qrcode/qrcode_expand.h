@@ -0,0 +1,86 @@
+/**
+ * @file qrcode_expand.h
+ *
+ */
+
+#ifndef QRCODE_EXPAND_H
+#define QRCODE_EXPAND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <string.h>
+#include "qrcodegen.h"
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Clear the bits [x, end) of a 1-bit row, MSB first
+ */
+static inline void qrcode_clear_bits(uint8_t * row, int x, int end)
+{
+    while(x < end && (x & 7)) {
+        row[x >> 3] &= ~(0x80 >> (x & 7));
+        x++;
+    }
+    if(end - x >= 8) {
+        memset(row + (x >> 3), 0x00, (end - x) >> 3);
+        x += (end - x) & ~7;
+    }
+    while(x < end) {
+        row[x >> 3] &= ~(0x80 >> (x & 7));
+        x++;
+    }
+}
+
+/**
+ * Expand an encoded QR symbol into a 1-bit bitmap of size x size pixels.
+ * Light pixels are 1 and dark pixels are 0. Each module row is built once
+ * from runs of dark modules and then copied for the other rows of the module.
+ * @param dst first pixel row of the bitmap
+ * @param stride bytes per bitmap row
+ * @param size width and height of the bitmap in pixels
+ * @param qr encoded symbol from qrcodegen
+ * @param scale pixels per module
+ * @param margin offset of the symbol in pixels
+ */
+static inline void qrcode_expand(uint8_t * dst, uint32_t stride, int size, const uint8_t * qr, int scale, int margin)
+{
+    int qr_size = qrcodegen_getSize(qr);
+    int scaled  = qr_size * scale;
+
+    /*Quiet zone above the symbol*/
+    memset(dst, 0xFF, stride * margin);
+    uint8_t * row = dst + stride * margin;
+
+    for(int my = 0; my < qr_size; my++) {
+        memset(row, 0xFF, stride);
+
+        for(int mx = 0; mx < qr_size; mx++) {
+            if(!qrcodegen_getModule(qr, mx, my)) continue;
+
+            int start = mx;
+            while(mx + 1 < qr_size && qrcodegen_getModule(qr, mx + 1, my)) mx++;
+            qrcode_clear_bits(row, margin + start * scale, margin + (mx + 1) * scale);
+        }
+
+        for(int i = 1; i < scale; i++) memcpy(row + i * stride, row, stride);
+        row += stride * scale;
+    }
+
+    /*Quiet zone below the symbol*/
+    memset(row, 0xFF, stride * (size - margin - scaled));
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*QRCODE_EXPAND_H*/
@@ -1,25 +1,23 @@
 /* MIT License - Copyright (c) 2019-2024 Francis Van Roie
    For full license information read the LICENSE file in the project folder */
 
-// USAGE: - Copy this file and rename it to my_custom_fan_rotator.cpp, also copy my_custom_template.h and rename it to my_custom.h
-//        - Uncomment in your user_config_override.h the line containing #define HASP_USE_CUSTOM 1
-//        - Change false to true on line 16
-//        - Set the page and id of your object on lines 27 and 28
-//        - Optionally set the default rotation state and angle on lines 21 and 22
-//        - At run time you can change fanspeed and fanangle by updating the topics hasp/<yourplate>/custom/fanspeed 
+// USAGE: - Copy this file and rename it to my_custom_fan_rotator.cpp
+//        - Change false to true on line 15
+//        - Set the page and id of your object on lines 24 and 25
+//        - Optionally set the default rotation state and angle on lines 19 and 20
+//        - At run time you can change fanspeed and fanangle by updating the topics hasp/<yourplate>/custom/fanspeed
 //          and hasp/<yourplate>/custom/fanangle with values desired from your home automation system
-// NOTE:  This gives best results with small images (up to 64x64 pixels). Large images may draw choppy due to limited 
+// NOTE:  This gives best results with small images (up to 64x64 pixels). Large images may draw choppy due to limited
 //        computing capacity of the MCU.
 
 #include "hasplib.h"
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0 && false // <-- set this to true in your code
+#if false // <-- set this to true in your code
 
 #include "hasp_debug.h"
 
-uint16_t fanspeed       = 0;   // rotation off by default (the time between angle turns in ms)
-uint16_t fanangle       = 450; // default angle of one turn (0.1 degree precision, so this means 45°)
-unsigned long prev_loop = 0;
+static uint16_t fanspeed = 0;   // rotation off by default (the time between angle turns in ms)
+static uint16_t fanangle = 450; // default angle of one turn (0.1 degree precision, so this means 45°)
 
 static void my_rotate_fan()
 {
@@ -33,14 +31,10 @@ static void my_rotate_fan()
     lv_img_set_angle(fan, angle % 3600);
 }
 
-void custom_setup()
+static void fan_loop()
 {
-    // Initialization code here
-    prev_loop = millis();
-}
+    static unsigned long prev_loop = 0;
 
-void custom_loop()
-{
     // Non-blocking code here, this should execute very fast!
     if(fanspeed && (millis() - prev_loop > fanspeed)) {
         my_rotate_fan();
@@ -48,29 +42,8 @@ void custom_loop()
     }
 }
 
-void custom_every_second()
-{
-    // Unused
-}
-
-void custom_every_5seconds()
-{
-    // Unused
-}
-
-bool custom_pin_in_use(uint8_t pin)
-{
-    // no pins are used
-    return false;
-}
-
-void custom_get_sensors(JsonDocument& doc)
-{
-    // Unused
-}
-
-/* Receive custom topic & payload messages */
-void custom_topic_payload(const char* topic, const char* payload, uint8_t source)
+/* Receive the custom/fanspeed and custom/fanangle messages, the filter keeps the others away */
+static void fan_topic_payload(const char* topic, const char* payload, uint8_t source)
 {
     bool update = strlen(payload) > 0;
     LOG_INFO(TAG_CUSTOM, "Handling custom message: %s => %s", topic, payload);
@@ -94,12 +67,24 @@ void custom_topic_payload(const char* topic, const char* payload, uint8_t source
             dispatch_state_subtopic("fanangle", buffer);
         }
     }
-
-    // LOG_VERBOSE(TAG_CUSTOM, "Handled custom message: %s => %s", topic, payload);
-}
-
-void custom_state_subtopic(const char* subtopic, const char* payload){
-    // Not used
 }
 
-#endif // HASP_USE_CUSTOM
+/* The tick rate is the lowest fanspeed that still turns smoothly, the loop itself skips the ticks in between */
+static const hasp_plugin_t fan_plugin = {
+    "fan",               // name in the log and on the info page
+    "fanspeed,fanangle", // custom topics
+    NULL,                // state subtopics, none
+    10,                  // loop interval in ms
+    2000,                // time budget per call in us, rotating a small image
+    NULL,                // setup
+    fan_loop,            // loop
+    NULL,                // every_second
+    NULL,                // every_5seconds
+    NULL,                // pin_in_use
+    NULL,                // get_sensors
+    fan_topic_payload,   // topic_payload
+    NULL,                // state_subtopic
+};
+HASP_PLUGIN_REGISTER(fan_plugin);
+
+#endif
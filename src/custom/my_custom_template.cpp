@@ -2,37 +2,37 @@
    For full license information read the LICENSE file in the project folder */
 
 // USAGE: - Copy this file and rename it to my_custom.cpp
-//        - Change false to true on line 9
+//        - Change false to true on line 11
+//        - Plugins register themselves, HASP_USE_CUSTOM and my_custom.h are only needed for the older custom_*
+//          functions declared in my_custom_template.h
 
 #include "hasplib.h"
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0 && false // <-- set this to true in your code
+#if false // <-- set this to true in your code
 
 #include "hasp_debug.h"
 
-void custom_setup()
+static void my_setup()
 {
     // Initialization code here
     randomSeed(millis());
-}
 
-void custom_loop()
-{
-    // Non-blocking code here, this should execute very fast!
+    // Custom commands can be added to the command registry, e.g. command/hello=1
+    // dispatch_add_command(PSTR("hello"), my_hello_command, DISPATCH_ARG_NUMBER);
 }
 
-void custom_every_second()
+static void my_every_second()
 {
     Serial.print("#");
 }
 
-void custom_every_5seconds()
+static void my_every_5seconds()
 {
     LOG_VERBOSE(TAG_CUSTOM, "5 seconds have passsed...");
-    dispatch_state_subtopic("my_sensor","{\"test\":123}");
+    dispatch_state_subtopic("my_sensor", "{\"test\":123}");
 }
 
-bool custom_pin_in_use(uint8_t pin)
+static bool my_pin_in_use(uint8_t pin)
 {
     if(pin == 1024) return true; // fictuous used pin
 
@@ -40,7 +40,7 @@ bool custom_pin_in_use(uint8_t pin)
     return false;
 }
 
-void custom_get_sensors(JsonDocument& doc)
+static void my_get_sensors(JsonDocument& doc)
 {
     /* Sensor Name */
     JsonObject sensor = doc.createNestedObject(F("Custom"));
@@ -49,13 +49,22 @@ void custom_get_sensors(JsonDocument& doc)
     sensor[F("Random")] = HASP_RANDOM(256);
 }
 
-void custom_topic_payload(const char* topic, const char* payload, uint8_t source){
-    // Not used
-}
-
-void custom_state_subtopic(const char* subtopic, const char* payload){
-    // Not used
-}
-
-
-#endif // HASP_USE_CUSTOM
\ No newline at end of file
+/* Unused callbacks are NULL, the plugin is only called for what it fills in */
+static const hasp_plugin_t my_plugin = {
+    "my_plugin",       // name in the log and on the info page
+    NULL,              // custom topics, none
+    NULL,              // state subtopics, none
+    0,                 // loop interval in ms
+    0,                 // time budget per call in us, 0 is the default
+    my_setup,          // setup
+    NULL,              // loop
+    my_every_second,   // every_second
+    my_every_5seconds, // every_5seconds
+    my_pin_in_use,     // pin_in_use
+    my_get_sensors,    // get_sensors
+    NULL,              // topic_payload
+    NULL,              // state_subtopic
+};
+HASP_PLUGIN_REGISTER(my_plugin);
+
+#endif
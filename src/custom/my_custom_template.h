@@ -1,6 +1,8 @@
 /* MIT License - Copyright (c) 2019-2024 Francis Van Roie
    For full license information read the LICENSE file in the project folder */
 
+// The older interface, new code registers a hasp_plugin_t instead, see hasp/hasp_plugin.h
+//
 // USAGE: - Copy this file and rename it to my_custom.h
 //        - uncomment in your user_config_override.h the line containing #define HASP_USE_CUSTOM 1
 //
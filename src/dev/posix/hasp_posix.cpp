@@ -15,9 +15,11 @@
 #endif
 
 #include "hasp_posix.h"
+#include "hasp_posix_metrics.h"
 
 #include "hasp_conf.h"
 #include "hasp_debug.h"
+#include "hasp/hasp_parser.h"
 
 #ifdef USE_MONITOR
 #include "display/monitor.h"
@@ -26,7 +28,7 @@
 #include "drv/tft/tft_driver.h"
 #endif
 
-#include <fstream>
+#include <pthread.h>
 #include <unistd.h>
 
 // extern monitor_t monitor;
@@ -53,6 +55,8 @@ PosixDevice::PosixDevice()
     _backlight_power  = 1;
     _backlight_invert = 0;
     _backlight_level  = 255;
+    _lvgl_used        = 0;
+    _lvgl_frag        = 0;
 }
 
 void PosixDevice::set_config(const JsonObject& settings)
@@ -83,6 +87,23 @@ void PosixDevice::set_config(const JsonObject& settings)
 
 void PosixDevice::reboot()
 {}
+
+void PosixDevice::init()
+{
+    posix_metrics_sample(); // the heap and cpu values are read before the first 5 second tick
+}
+
+void PosixDevice::loop_5s()
+{
+    posix_metrics_sample();
+
+#if LV_MEM_CUSTOM == 0
+    lv_mem_monitor_t mem_mon;
+    lv_mem_monitor(&mem_mon);
+    _lvgl_used = mem_mon.total_size - mem_mon.free_size;
+    _lvgl_frag = mem_mon.frag_pct;
+#endif
+}
 void PosixDevice::show_info()
 {
     struct utsname uts;
@@ -160,6 +181,13 @@ void PosixDevice::set_backlight_level(uint8_t level)
 
 uint8_t PosixDevice::get_backlight_level()
 {
+#if USE_FBDEV
+    // What the panel shows, a backlight with few steps rounds the level
+    if(_backlight.is_open() && _backlight_power) {
+        uint8_t level = _backlight.get_level();
+        return _backlight_invert ? 255 - level : level;
+    }
+#endif
     return _backlight_level;
 }
 
@@ -182,63 +210,88 @@ void PosixDevice::update_backlight()
     monitor_backlight(level);
 #elif USE_FBDEV
     // set display backlight, if possible
-    if(backlight_device != "") {
-        if(backlight_max == 0) {
-            std::ifstream f;
-            f.open("/sys/class/backlight/" + backlight_device + "/max_brightness");
-            if(!f.fail()) {
-                f >> backlight_max;
-                f.close();
-            } else {
-                perror("Max brightness read failed");
-            }
-        }
-
-        int brightness = map(level, 0, 255, 0, backlight_max);
-        LOG_VERBOSE(0, "Setting brightness to %d/255 (%d)", level, brightness);
+    if(backlight_device == "") return;
 
-        std::ofstream f;
-        f.open("/sys/class/backlight/" + backlight_device + "/brightness");
-        if(!f.fail()) {
-            f << brightness;
-            f.close();
-        } else {
-            perror("Brightness write failed (are you root?)");
+    std::string path = "/sys/class/backlight/" + backlight_device;
+    if(_backlight.open_due(path, millis())) {
+        if(!_backlight.open(path, backlight_max, millis())) {
+            LOG_ERROR(0, "Backlight %s not writable (are you root?)", path.c_str());
+            return;
         }
+        // backlight_max stays the configured override, the max of this device must not carry over to the next one
+        LOG_VERBOSE(0, "Backlight %s max %d", path.c_str(), _backlight.get_max());
+    }
+    if(!_backlight.is_open()) return;
+
+    // Written by the task at most once per frame, a slider or fade only sets the last level of the frame
+    _backlight.set_level(level);
+    if(_backlight.pending() && !_backlight_task) {
+        _backlight_task = lv_task_create(backlight_task_cb, LV_DISP_DEF_REFR_PERIOD, LV_TASK_PRIO_MID, this);
+        lv_task_ready(_backlight_task); // the first change is written on the next frame
     }
 #endif
 }
 
-size_t PosixDevice::get_free_max_block()
+#if USE_FBDEV
+/* The task deletes itself after a frame without changes or a failed write, which stays pending for the next update */
+void PosixDevice::backlight_task_cb(lv_task_t* task)
 {
-#ifndef TARGET_OS_MAC
-    struct sysinfo s_info;
-    if(sysinfo(&s_info) < 0) return 0;
-    return s_info.freeram;
-#else
-    return 0;
+    PosixDevice* device = (PosixDevice*)task->user_data;
+    if(device->_backlight.flush()) return;
+    lv_task_del(task);
+    device->_backlight_task = NULL;
+}
 #endif
+
+size_t PosixDevice::get_free_max_block()
+{
+    return posix_metrics_max_block(posix_metrics_get());
 }
 
 size_t PosixDevice::get_free_heap(void)
 {
-#ifndef TARGET_OS_MAC
-    struct sysinfo s_info;
-    if(sysinfo(&s_info) < 0) return 0;
-    return s_info.freeram;
-#else
-    return 0;
-#endif
+    return posix_metrics_free_heap(posix_metrics_get());
 }
 
 uint8_t PosixDevice::get_heap_fragmentation()
 {
-    return 0;
+    return posix_metrics_fragmentation(posix_metrics_get());
 }
 
 uint16_t PosixDevice::get_cpu_frequency()
 {
-    return 0;
+    return posix_metrics_get().cpu_mhz;
+}
+
+void PosixDevice::get_info(JsonDocument& doc)
+{
+    char size_buf[32];
+    char load_buf[48];
+    posix_metrics_t metrics = posix_metrics_get();
+
+    JsonObject info = doc.createNestedObject(F("Process"));
+    Parser::format_bytes(metrics.rss, size_buf, sizeof(size_buf));
+    info[F("Resident")] = size_buf;
+    Parser::format_bytes(metrics.heap_used, size_buf, sizeof(size_buf));
+    info[F("Heap Used")] = size_buf;
+    Parser::format_bytes(metrics.heap_arena, size_buf, sizeof(size_buf));
+    info[F("Heap Arena")] = size_buf;
+#if LV_MEM_CUSTOM == 0
+    Parser::format_bytes(_lvgl_used, size_buf, sizeof(size_buf));
+    snprintf(load_buf, sizeof(load_buf), "%s (%u%% " D_INFO_FRAGMENTATION ")", size_buf, _lvgl_frag);
+    info[F("LVGL Used")] = load_buf;
+#endif
+    snprintf(load_buf, sizeof(load_buf), "%u.%u%%", metrics.cpu_load / 10, metrics.cpu_load % 10);
+    info[F("CPU Load")] = load_buf;
+
+    info = doc.createNestedObject(F("Threads"));
+    for(uint8_t i = 0; i < metrics.threads; i++) {
+        const posix_thread_metrics_t& thread = metrics.thread[i];
+        snprintf(load_buf, sizeof(load_buf), "%u.%u%%, %u.%03us", thread.cpu_load / 10, thread.cpu_load % 10,
+                 thread.cpu_ms / 1000, thread.cpu_ms % 1000);
+        snprintf(size_buf, sizeof(size_buf), "%s %d", thread.name, thread.tid);
+        info[size_buf] = load_buf;
+    }
 }
 
 bool PosixDevice::is_system_pin(uint8_t pin)
@@ -246,10 +299,14 @@ bool PosixDevice::is_system_pin(uint8_t pin)
     return false;
 }
 
-void PosixDevice::run_thread(void (*func)(void*), void* arg)
+void PosixDevice::run_thread(void (*func)(void*), void* arg, const char* name)
 {
     pthread_t thread;
-    pthread_create(&thread, NULL, (void* (*)(void*))func, arg);
+    if(pthread_create(&thread, NULL, (void* (*)(void*))func, arg) != 0) return;
+    pthread_detach(thread);
+#if defined(__linux__)
+    if(name) pthread_setname_np(thread, name); // shows up in the thread metrics, top -H and gdb
+#endif
 }
 
 #ifndef TARGET_OS_MAC
@@ -281,25 +338,6 @@ long PosixDevice::get_uptime()
 
 } // namespace dev
 
-static time_t tv_sec_start = 0;
-
-unsigned long PosixMillis()
-{
-    struct timespec spec;
-    clock_gettime(CLOCK_REALTIME, &spec);
-    if(tv_sec_start == 0) {
-        tv_sec_start = spec.tv_sec;
-    }
-    unsigned long msec1 = (spec.tv_sec - tv_sec_start) * 1000;
-    unsigned long msec2 = spec.tv_nsec / 1e6;
-    return msec1 + msec2;
-}
-
-void msleep(unsigned long millis)
-{
-    usleep(millis * 1000);
-}
-
 dev::PosixDevice haspDevice;
 
 #endif // POSIX
@@ -15,7 +15,9 @@ extern "C" {
 }
 
 #include "hasp_conf.h"
+#include "lvgl.h"
 #include "../device.h"
+#include "hasp_posix_backlight.h"
 
 #if defined(POSIX)
 static inline void itoa(int i, char* out, int unused_)
@@ -34,7 +36,9 @@ class PosixDevice : public BaseDevice {
     void set_config(const JsonObject& settings);
 
     void reboot() override;
+    void init() override;
     void show_info() override;
+    void loop_5s() override;
 
     const char* get_hostname();
     void set_hostname(const char*);
@@ -55,10 +59,11 @@ class PosixDevice : public BaseDevice {
     uint8_t get_heap_fragmentation();
     uint16_t get_cpu_frequency();
     long get_uptime();
+    void get_info(JsonDocument& doc) override;
 
     bool is_system_pin(uint8_t pin) override;
 
-    void run_thread(void (*func)(void*), void* arg);
+    void run_thread(void (*func)(void*), void* arg, const char* name = NULL);
 
   public:
     std::string backlight_device;
@@ -74,7 +79,14 @@ class PosixDevice : public BaseDevice {
     uint8_t _backlight_power;
     uint8_t _backlight_invert;
 
+    size_t _lvgl_used; // sampled with the process metrics
+    uint8_t _lvgl_frag;
+
+    PosixBacklight _backlight;
+    lv_task_t* _backlight_task = NULL;
+
     void update_backlight();
+    static void backlight_task_cb(lv_task_t* task);
 };
 
 } // namespace dev
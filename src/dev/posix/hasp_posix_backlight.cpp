@@ -0,0 +1,156 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Sysfs backlight of the fbdev panels
+ *
+ * A slider or a fade changes the level many times per second. Opening, writing and closing the brightness file for
+ * each of them costs three syscalls and a driver call every time, while the panel can only show one level per frame.
+ * brightness and actual_brightness are opened once, set_level only remembers the level and flush writes it from the
+ * display task when it maps to a different raw value than the last write. actual_brightness is read back after each
+ * write, the driver may round or clamp the value and the published level should be what the panel shows. A device
+ * that can't be opened is tried again after a wait that doubles with every failure.
+ */
+
+#if defined(POSIX)
+
+#include "hasp_posix_backlight.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace dev {
+
+PosixBacklight::~PosixBacklight()
+{
+    close();
+}
+
+bool PosixBacklight::open(const std::string& path, int max_override, uint32_t now)
+{
+    close();
+    if(path != _path) _retry_wait = 0;
+    _path = path;
+
+    int max_fd = ::open((path + "/max_brightness").c_str(), O_RDONLY | O_CLOEXEC);
+    _max       = max_override > 0 ? max_override : read_value(max_fd);
+    if(max_fd >= 0) ::close(max_fd);
+
+    _brightness_fd = ::open((path + "/brightness").c_str(), O_WRONLY | O_CLOEXEC);
+    _actual_fd     = ::open((path + "/actual_brightness").c_str(), O_RDONLY | O_CLOEXEC);
+    if(_brightness_fd < 0 || _max <= 0) {
+        close();
+        // a panel that is not writable stays so, don't try again on every update of a fade
+        _retry_wait = _retry_wait ? _retry_wait * 2 : POSIX_BACKLIGHT_RETRY_MIN;
+        if(_retry_wait > POSIX_BACKLIGHT_RETRY_MAX) _retry_wait = POSIX_BACKLIGHT_RETRY_MAX;
+        _retry_at = now + _retry_wait;
+        return false;
+    }
+
+    _retry_wait = 0;
+    _actual     = read_value(_actual_fd);
+    _level      = to_level(_actual);
+    return true;
+}
+
+bool PosixBacklight::open_due(const std::string& path, uint32_t now) const
+{
+    if(path != _path) return true;
+    if(is_open()) return false;
+    return (int32_t)(now - _retry_at) >= 0;
+}
+
+void PosixBacklight::close()
+{
+    if(_brightness_fd >= 0) ::close(_brightness_fd);
+    if(_actual_fd >= 0) ::close(_actual_fd);
+    _brightness_fd = _actual_fd = -1;
+    _written                    = -1;
+    _pending                    = false;
+}
+
+bool PosixBacklight::is_open() const
+{
+    return _brightness_fd >= 0;
+}
+
+const std::string& PosixBacklight::path() const
+{
+    return _path;
+}
+
+int PosixBacklight::get_max() const
+{
+    return _max;
+}
+
+void PosixBacklight::set_level(uint8_t level)
+{
+    _level   = level;
+    _pending = to_raw(level) != _written;
+}
+
+bool PosixBacklight::pending() const
+{
+    return _pending;
+}
+
+bool PosixBacklight::flush()
+{
+    if(!_pending || !is_open()) return false;
+
+    int raw = to_raw(_level);
+    char buffer[16];
+    int len = snprintf(buffer, sizeof(buffer), "%d\n", raw);
+    if(pwrite(_brightness_fd, buffer, len, 0) != len) return false; // still pending, the next update tries again
+    _pending = false;
+    _written = raw;
+    _writes++;
+
+    int actual = read_value(_actual_fd);
+    _actual    = actual >= 0 ? actual : raw; // not every driver has actual_brightness
+    return true;
+}
+
+uint8_t PosixBacklight::get_level() const
+{
+    return to_level(_pending ? to_raw(_level) : _actual);
+}
+
+int PosixBacklight::get_raw() const
+{
+    return _actual;
+}
+
+uint32_t PosixBacklight::get_writes() const
+{
+    return _writes;
+}
+
+int PosixBacklight::to_raw(uint8_t level) const
+{
+    return (level * _max + 127) / 255;
+}
+
+uint8_t PosixBacklight::to_level(int raw) const
+{
+    if(_max <= 0 || raw <= 0) return 0;
+    if(raw >= _max) return 255;
+    return (raw * 255 + _max / 2) / _max;
+}
+
+/* Sysfs attributes are read again from offset 0 on an open descriptor */
+int PosixBacklight::read_value(int fd) const
+{
+    if(fd < 0) return -1;
+    char buffer[16];
+    ssize_t len = pread(fd, buffer, sizeof(buffer) - 1, 0);
+    if(len <= 0) return -1;
+    buffer[len] = 0;
+    return atoi(buffer);
+}
+
+} // namespace dev
+
+#endif // POSIX
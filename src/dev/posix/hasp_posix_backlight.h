@@ -0,0 +1,67 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_POSIX_BACKLIGHT_H
+#define HASP_POSIX_BACKLIGHT_H
+
+#include <stdint.h>
+#include <string>
+
+#ifndef POSIX_BACKLIGHT_RETRY_MIN
+#define POSIX_BACKLIGHT_RETRY_MIN 1000 // ms before a device that failed to open is tried again
+#endif
+
+#ifndef POSIX_BACKLIGHT_RETRY_MAX
+#define POSIX_BACKLIGHT_RETRY_MAX 60000 // the wait doubles after each failed retry up to this
+#endif
+
+namespace dev {
+
+/* A backlight in /sys/class/backlight, the files stay open and only the last level of a frame is written */
+class PosixBacklight {
+  public:
+    ~PosixBacklight();
+
+    /* path is the device folder, e.g. /sys/class/backlight/10-0045, a failed open is remembered with its retry time */
+    bool open(const std::string& path, int max_override, uint32_t now);
+    /* True for another device, or for the same one that failed to open and has waited out its retry time */
+    bool open_due(const std::string& path, uint32_t now) const;
+    void close();
+    bool is_open() const;
+    const std::string& path() const;
+    int get_max() const;
+
+    /* Stores the level 0-255, nothing is written until flush */
+    void set_level(uint8_t level);
+    bool pending() const;
+
+    /* Writes the stored level if the panel would change and reads back what the driver made of it, a level that
+     * could not be written stays pending */
+    bool flush();
+
+    /* The level on the panel in 0-255, as reported by actual_brightness after the last write */
+    uint8_t get_level() const;
+    int get_raw() const;
+    uint32_t get_writes() const;
+
+  private:
+    std::string _path;
+    int _brightness_fd = -1;
+    int _actual_fd     = -1;
+    int _max           = 0;
+    int _written       = -1; // raw value of the last write
+    int _actual        = 0;  // raw value read back
+    uint8_t _level     = 0;
+    bool _pending      = false;
+    uint32_t _writes   = 0;
+    uint32_t _retry_at   = 0; // millis of the next open of a device that failed
+    uint32_t _retry_wait = 0; // 0 after a successful open
+
+    int to_raw(uint8_t level) const;
+    uint8_t to_level(int raw) const;
+    int read_value(int fd) const;
+};
+
+} // namespace dev
+
+#endif // HASP_POSIX_BACKLIGHT_H
@@ -0,0 +1,231 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Resource usage of the process on POSIX
+ *
+ * sysinfo() only tells how much memory the whole system has left, which says nothing about a leak or fragmentation
+ * in openHASP itself. Here the resident set and the thread cpu times come from /proc/self, the heap from the malloc
+ * statistics and the cpu clock from cpufreq. Walking the malloc bins and the task list is too slow for the debug
+ * prefix or every status update, so the values are sampled on the 5 second timer and the getters read the copy.
+ * The http and websocket threads read the copy while the loop samples, it is swapped and copied under a mutex.
+ */
+
+#if defined(POSIX)
+
+#include "hasp_posix_metrics.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <mutex>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+static posix_metrics_t metrics; // written by posix_metrics_sample only, read by the other threads under the mutex
+static std::mutex metrics_mutex;
+
+static uint64_t metrics_last_ms   = 0;
+static uint64_t metrics_last_proc = 0; // cpu ms of the whole process
+
+static uint64_t metrics_now_ms(void)
+{
+    struct timespec spec;
+    clock_gettime(CLOCK_MONOTONIC, &spec);
+    return (uint64_t)spec.tv_sec * 1000 + spec.tv_nsec / 1000000;
+}
+
+static size_t metrics_read_file(const char* path, char* buffer, size_t size)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return 0;
+    ssize_t len = read(fd, buffer, size - 1);
+    close(fd);
+    if(len < 0) len = 0;
+    buffer[len] = 0;
+    return len;
+}
+
+/* Splits a /proc/.../stat line into the comm and the user and system ticks */
+static bool metrics_parse_stat(char* line, char* name, size_t name_size, uint64_t& ticks)
+{
+    char* open_paren  = strchr(line, '(');
+    char* close_paren = strrchr(line, ')'); // the comm may contain a ')' itself
+    if(!open_paren || !close_paren || close_paren < open_paren) return false;
+
+    if(name) {
+        size_t len = close_paren - open_paren - 1;
+        if(len >= name_size) len = name_size - 1;
+        memcpy(name, open_paren + 1, len);
+        name[len] = 0;
+    }
+
+    // state is the first field after the comm, utime the 12th and stime the 13th
+    char* field = close_paren + 1;
+    uint64_t utime = 0, stime = 0;
+    for(int n = 0; n < 13; n++) {
+        field = strchr(field, ' ');
+        if(!field) return false;
+        field++;
+        if(n == 11) utime = strtoull(field, NULL, 10);
+        if(n == 12) stime = strtoull(field, NULL, 10);
+    }
+    ticks = utime + stime;
+    return true;
+}
+
+static uint16_t metrics_load(uint64_t cpu_ms, uint64_t elapsed_ms)
+{
+    if(elapsed_ms == 0) return 0;
+    uint64_t permille = cpu_ms * 1000 / elapsed_ms;
+    return permille > 0xFFFF ? 0xFFFF : (uint16_t)permille;
+}
+
+static void metrics_sample_threads(posix_metrics_t& sample, const posix_metrics_t& previous, uint64_t elapsed_ms,
+                                   long hz)
+{
+    char path[64];
+    char line[512];
+    uint64_t ticks;
+
+    if(metrics_read_file("/proc/self/stat", line, sizeof(line)) && metrics_parse_stat(line, NULL, 0, ticks)) {
+        uint64_t cpu_ms = ticks * 1000 / hz;
+        if(previous.samples) sample.cpu_load = metrics_load(cpu_ms - metrics_last_proc, elapsed_ms);
+        metrics_last_proc = cpu_ms;
+    }
+
+    DIR* dir = opendir("/proc/self/task");
+    if(!dir) return;
+
+    int pid = getpid();
+    while(struct dirent* entry = readdir(dir)) {
+        if(entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        if(sample.threads >= POSIX_METRICS_MAX_THREADS) break;
+
+        posix_thread_metrics_t& thread = sample.thread[sample.threads];
+        thread.tid                     = atoi(entry->d_name);
+        snprintf(path, sizeof(path), "/proc/self/task/%d/stat", thread.tid);
+        if(!metrics_read_file(path, line, sizeof(line)) ||
+           !metrics_parse_stat(line, thread.name, sizeof(thread.name), ticks))
+            continue;
+
+        if(thread.tid == pid) strcpy(thread.name, "main"); // the comm of the main thread is the process name
+        thread.cpu_ms   = ticks * 1000 / hz;
+        thread.cpu_load = 0;
+        for(uint8_t i = 0; i < previous.threads; i++) {
+            if(previous.thread[i].tid != thread.tid) continue;
+            thread.cpu_load = metrics_load(thread.cpu_ms - previous.thread[i].cpu_ms, elapsed_ms);
+            break;
+        }
+        sample.threads++;
+    }
+    closedir(dir);
+}
+
+#if defined(__GLIBC__)
+/* mallinfo only knows the free total, malloc_info lists the smallest and largest chunk of every bin in use */
+static void metrics_sample_largest(posix_metrics_t& sample)
+{
+    char* xml   = NULL;
+    size_t size = 0;
+    FILE* file  = open_memstream(&xml, &size);
+    if(!file) return;
+    malloc_info(0, file);
+    fclose(file);
+
+    for(char* entry = xml; (entry = strchr(entry, '<')) != NULL; entry++) {
+        if(strncmp(entry, "<size ", 6) && strncmp(entry, "<unsorted ", 10)) continue;
+        char* end   = strchr(entry, '>');
+        char* to    = strstr(entry, " to=\"");
+        char* count = strstr(entry, " count=\"");
+        if(!end || !to || !count || to > end || count > end) continue;
+        if(strtoul(count + 8, NULL, 10) == 0) continue; // empty bin, the bounds are not chunks
+        size_t chunk = strtoull(to + 5, NULL, 10);
+        if(chunk > sample.heap_large) sample.heap_large = chunk;
+    }
+    free(xml);
+}
+#endif
+
+static void metrics_sample_memory(posix_metrics_t& sample)
+{
+    char buffer[2048];
+
+    if(metrics_read_file("/proc/self/statm", buffer, sizeof(buffer))) {
+        char* field = strchr(buffer, ' ');
+        if(field) sample.rss = strtoull(field + 1, NULL, 10) * sysconf(_SC_PAGESIZE);
+    }
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+#elif defined(__GLIBC__)
+    struct mallinfo info = mallinfo(); // int fields, wrap above 2 GB
+#endif
+#if defined(__GLIBC__)
+    sample.heap_arena = info.arena;
+    sample.heap_used  = info.uordblks + info.hblkhd;
+    sample.heap_free  = info.fordblks;
+    sample.heap_large = info.keepcost; // the top chunk
+    metrics_sample_largest(sample);
+#endif
+}
+
+static void metrics_sample_cpu(posix_metrics_t& sample)
+{
+    char buffer[4096];
+
+    if(metrics_read_file("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq", buffer, sizeof(buffer))) {
+        sample.cpu_mhz = strtoul(buffer, NULL, 10) / 1000; // kHz
+    } else if(metrics_read_file("/proc/cpuinfo", buffer, sizeof(buffer))) {
+        char* line = strstr(buffer, "cpu MHz");
+        if(line && (line = strchr(line, ':'))) sample.cpu_mhz = strtoul(line + 1, NULL, 10);
+    }
+}
+
+void posix_metrics_sample(void)
+{
+    static long hz = sysconf(_SC_CLK_TCK);
+
+    posix_metrics_t sample = {};
+    uint64_t now           = metrics_now_ms();
+
+    metrics_sample_memory(sample);
+    metrics_sample_cpu(sample);
+    if(hz > 0) metrics_sample_threads(sample, metrics, now - metrics_last_ms, hz);
+
+    sample.samples  = metrics.samples + 1;
+    metrics_last_ms = now;
+
+    std::lock_guard<std::mutex> lock(metrics_mutex);
+    metrics = sample;
+}
+
+posix_metrics_t posix_metrics_get(void)
+{
+    std::lock_guard<std::mutex> lock(metrics_mutex);
+    return metrics;
+}
+
+size_t posix_metrics_free_heap(const posix_metrics_t& metrics)
+{
+    return metrics.heap_free;
+}
+
+size_t posix_metrics_max_block(const posix_metrics_t& metrics)
+{
+    return metrics.heap_large;
+}
+
+uint8_t posix_metrics_fragmentation(const posix_metrics_t& metrics)
+{
+    if(metrics.heap_free == 0) return 0;
+    return 100 - metrics.heap_large * 100 / metrics.heap_free;
+}
+
+#endif // POSIX
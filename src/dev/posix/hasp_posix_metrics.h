@@ -0,0 +1,47 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_POSIX_METRICS_H
+#define HASP_POSIX_METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef POSIX_METRICS_MAX_THREADS
+#define POSIX_METRICS_MAX_THREADS 16
+#endif
+
+struct posix_thread_metrics_t
+{
+    int tid;
+    char name[16];     // comm of the thread, "main" for the thread running the loop and lvgl
+    uint32_t cpu_ms;   // user and system time since the thread started
+    uint16_t cpu_load; // permille of one core since the previous sample
+};
+
+struct posix_metrics_t
+{
+    uint32_t samples;
+    size_t rss;        // resident set of the process
+    size_t heap_arena; // bytes malloc took from the system for its arenas
+    size_t heap_used;  // bytes allocated by the application, mmapped blocks included
+    size_t heap_free;  // free bytes inside the arenas
+    size_t heap_large; // largest free chunk in the arenas
+    uint16_t cpu_mhz;
+    uint16_t cpu_load; // permille of one core since the previous sample, all threads
+    uint8_t threads;   // number of entries in thread, the process may have more
+    posix_thread_metrics_t thread[POSIX_METRICS_MAX_THREADS];
+};
+
+/* Reads /proc, /sys and the malloc statistics, takes tens of us and walks the malloc bins, call it from a slow timer */
+void posix_metrics_sample(void);
+
+/* A copy of the last sample, safe to call from any thread */
+posix_metrics_t posix_metrics_get(void);
+
+/* Free heap, largest block and fragmentation of the process heap in the sense of the microcontroller targets */
+size_t posix_metrics_free_heap(const posix_metrics_t& metrics);
+size_t posix_metrics_max_block(const posix_metrics_t& metrics);
+uint8_t posix_metrics_fragmentation(const posix_metrics_t& metrics);
+
+#endif // HASP_POSIX_METRICS_H
@@ -0,0 +1,46 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Time base of the POSIX builds
+ *
+ * millis(), delay() and the lvgl tick all use CLOCK_MONOTONIC, so setting the wall clock by hand or by NTP does not
+ * make timers, animations or the idle timeout jump. The tick is read from the clock when lvgl asks for it instead of
+ * being counted by a thread that sleeps 5 ms at a time, which falls behind whenever the sleep overshoots.
+ */
+
+#if defined(POSIX)
+
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "hasp_tick.h"
+
+static int64_t posix_monotonic_ns()
+{
+    struct timespec spec;
+    clock_gettime(CLOCK_MONOTONIC, &spec);
+    return (int64_t)spec.tv_sec * 1000000000 + spec.tv_nsec;
+}
+
+unsigned long PosixMillis()
+{
+    static const int64_t start = posix_monotonic_ns(); // millis() counts from the first call
+    return (unsigned long)((posix_monotonic_ns() - start) / 1000000);
+}
+
+void msleep(unsigned long millis)
+{
+    struct timespec req;
+    req.tv_sec  = millis / 1000;
+    req.tv_nsec = (millis % 1000) * 1000000;
+    while(nanosleep(&req, &req) != 0 && errno == EINTR) {
+    } // a relative sleep, not affected by changes of the wall clock
+}
+
+extern "C" uint32_t hasp_tick_get(void)
+{
+    return (uint32_t)PosixMillis();
+}
+
+#endif // POSIX
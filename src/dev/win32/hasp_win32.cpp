@@ -7,6 +7,7 @@
 #include "Windows.h"
 
 #include "hasp_win32.h"
+#include "hasp_tick.h"
 
 #include "hasp_conf.h"
 #include "hasp_debug.h"
@@ -187,7 +188,7 @@ bool Win32Device::is_system_pin(uint8_t pin)
     return false;
 }
 
-void Win32Device::run_thread(void (*func)(void*), void* arg)
+void Win32Device::run_thread(void (*func)(void*), void* arg, const char* name)
 {
     CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)func, arg, 0, NULL);
 }
@@ -204,6 +205,11 @@ long Win32Millis()
     return GetTickCount64();
 }
 
+extern "C" uint32_t hasp_tick_get(void)
+{
+    return millis();
+}
+
 dev::Win32Device haspDevice;
 
 #endif // WINDOWS
@@ -45,7 +45,7 @@ class Win32Device : public BaseDevice {
 
     bool is_system_pin(uint8_t pin) override;
 
-    void run_thread(void (*func)(void*), void* arg);
+    void run_thread(void (*func)(void*), void* arg, const char* name = NULL);
 
   private:
     std::string _hostname;
@@ -12,39 +12,27 @@
 #include "dev/device.h"
 #include "hasp_debug.h"
 
-#include <unistd.h>
-#include <pthread.h>
-
 namespace dev {
 
-static void* tick_thread(void* data)
-{
-    (void)data;
-
-    while(1) {
-        usleep(5000);
-        lv_tick_inc(5);
-    }
-
-    return 0;
-}
-
 int32_t TftNullDrv::width()
 {
-    return _width;
+    return _rotation.width();
 }
 int32_t TftNullDrv::height()
 {
-    return _height;
+    return _rotation.height();
+}
+
+static void null_flush(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
+{
+    lv_disp_flush_ready(disp);
 }
 
 void TftNullDrv::init(int32_t w, int h)
 {
     _width  = w;
-    _height = h;
-
-    pthread_t tick_pthread;
-    pthread_create(&tick_pthread, 0, tick_thread, NULL);
+    _height = h; // lvgl reads its tick from millis(), no tick thread is needed
+    _rotation.set_size(w, h);
 
     LOG_VERBOSE(TAG_TFT, F("Null driver initialized (%dx%d)"), w, h);
 }
@@ -58,14 +46,19 @@ void TftNullDrv::splashscreen()
 {}
 
 void TftNullDrv::set_rotation(uint8_t rotation)
-{}
+{
+    _rotation.set_rotation(rotation);
+}
 
 void TftNullDrv::set_invert(bool invert)
-{}
+{
+    _rotation.set_invert(invert);
+}
 
+/* The pixels are turned like on a panel, so the headless build shows the cost of the rotation */
 void TftNullDrv::flush_pixels(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
 {
-    lv_disp_flush_ready(disp);
+    _rotation.flush(disp, area, color_p, null_flush);
 }
 
 bool TftNullDrv::is_driver_pin(uint8_t pin)
@@ -9,6 +9,7 @@
 #if HASP_USE_NULL_DRIVER && HASP_TARGET_PC
 
 #include "lvgl.h"
+#include "tft_driver_rotation.h"
 
 namespace dev {
 
@@ -31,6 +32,7 @@ class TftNullDrv : BaseTft {
 
   private:
     int32_t _width, _height;
+    TftRotation _rotation;
 };
 
 } // namespace dev
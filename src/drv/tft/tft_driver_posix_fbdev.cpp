@@ -43,30 +43,13 @@ extern uint16_t tft_height;
 
 namespace dev {
 
-/**
- * A task to measure the elapsed time for LittlevGL
- * @param data unused
- * @return never return
- */
-static void* tick_thread(void* data)
-{
-    (void)data;
-
-    while(1) {
-        usleep(5000);   /*Sleep for 5 millisecond*/
-        lv_tick_inc(5); /*Tell LittelvGL that 5 milliseconds were elapsed*/
-    }
-
-    return 0;
-}
-
 int32_t TftFbdevDrv::width()
 {
-    return _width;
+    return _rotation.width();
 }
 int32_t TftFbdevDrv::height()
 {
-    return _height;
+    return _rotation.height();
 }
 
 static void* gui_entrypoint(void* arg)
@@ -75,11 +58,9 @@ static void* gui_entrypoint(void* arg)
     // create an LVGL GUI task thread
     pthread_t gui_pthread;
     pthread_create(&gui_pthread, 0, (void* (*)(void*))gui_task, NULL);
+    pthread_setname_np(gui_pthread, "gui");
 #endif
-    // create an LVGL tick thread
-    pthread_t tick_pthread;
-    pthread_create(&tick_pthread, 0, tick_thread, NULL);
-    return 0;
+    return 0; // lvgl reads its tick from millis()
 }
 
 void TftFbdevDrv::init(int32_t w, int h)
@@ -115,6 +96,7 @@ void TftFbdevDrv::init(int32_t w, int h)
      * The following input devices are handled: mouse, keyboard, mousewheel */
     fbdev_init(fbdev_path.empty() ? NULL : fbdev_path.c_str());
     fbdev_get_sizes((uint32_t*)&_width, (uint32_t*)&_height);
+    _rotation.set_size(_width, _height);
 
     // show the splashscreen early
     splashscreen();
@@ -201,6 +183,7 @@ void TftFbdevDrv::init(int32_t w, int h)
                 printf("Failed to register evdev\n");
                 continue;
             }
+            if(dev_type == LV_INDEV_TYPE_POINTER) _rotation.rotate_input(&indev->driver);
             evdev_data_t* user_data = (evdev_data_t*)indev->driver.user_data;
             LOG_VERBOSE(TAG_TFT, F("Resolution : X=%d (%d..%d), Y=%d (%d..%d)"), user_data->x_max,
                         user_data->x_absinfo.minimum, user_data->x_absinfo.maximum, user_data->y_max,
@@ -228,12 +211,17 @@ void TftFbdevDrv::splashscreen()
     fbdev_splashscreen(logoImage, logoWidth, logoHeight, fgColor, bgColor);
 }
 void TftFbdevDrv::set_rotation(uint8_t rotation)
-{}
+{
+    _rotation.set_rotation(rotation);
+    LOG_VERBOSE(TAG_TFT, F("Rotation   : %d (%dx%d)"), rotation, width(), height());
+}
 void TftFbdevDrv::set_invert(bool invert)
-{}
+{
+    _rotation.set_invert(invert);
+}
 void TftFbdevDrv::flush_pixels(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
 {
-    lv_disp_flush_ready(disp);
+    _rotation.flush(disp, area, color_p, fbdev_flush);
 }
 bool TftFbdevDrv::is_driver_pin(uint8_t pin)
 {
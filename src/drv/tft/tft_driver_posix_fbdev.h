@@ -10,6 +10,7 @@
 // #warning Building H driver FBDEV
 
 #include "lvgl.h"
+#include "tft_driver_rotation.h"
 
 #include <vector>
 
@@ -38,6 +39,7 @@ class TftFbdevDrv : BaseTft {
 
   private:
     int32_t _width, _height;
+    TftRotation _rotation;
 };
 
 } // namespace dev
@@ -0,0 +1,129 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "tft_driver_rotation.h"
+
+#if HASP_TARGET_PC
+
+#if LV_COLOR_DEPTH == 32
+typedef uint32_t tft_pixel_t;
+#define TFT_INVERT_MASK 0x00FFFFFF // keep the alpha channel
+#elif LV_COLOR_DEPTH == 16
+typedef uint16_t tft_pixel_t;
+#define TFT_INVERT_MASK 0xFFFF
+#else
+typedef uint8_t tft_pixel_t;
+#define TFT_INVERT_MASK 0xFF
+#endif
+
+static_assert(sizeof(tft_pixel_t) == sizeof(lv_color_t), "lv_color_t is not a plain pixel");
+
+namespace dev {
+
+struct rotation_input_t
+{
+    lv_indev_drv_t* indev_drv;
+    bool (*read_cb)(lv_indev_drv_t* indev_drv, lv_indev_data_t* data);
+    TftRotation* rotation;
+};
+
+static rotation_input_t rotation_inputs[8];
+
+void TftRotation::set_size(int32_t width, int32_t height)
+{
+    _width  = width;
+    _height = height;
+}
+
+void TftRotation::set_rotation(uint8_t rotation)
+{
+    _rotation = rotation & 3;
+}
+
+void TftRotation::set_invert(bool invert)
+{
+    _invert = invert;
+}
+
+bool TftRotation::is_active() const
+{
+    return _rotation != 0 || _invert;
+}
+
+int32_t TftRotation::width() const
+{
+    return _rotation % 2 ? _height : _width;
+}
+
+int32_t TftRotation::height() const
+{
+    return _rotation % 2 ? _width : _height;
+}
+
+void TftRotation::flush(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p, flush_cb_t flush_cb)
+{
+    if(!is_active()) {
+        flush_cb(disp, area, color_p);
+        return;
+    }
+
+    int32_t w        = lv_area_get_width(area);
+    int32_t h        = lv_area_get_height(area);
+    tft_pixel_t mask = _invert ? TFT_INVERT_MASK : 0;
+    tft_pixel_t* src = (tft_pixel_t*)color_p;
+
+    if(_rotation == 0) { // inverted in place, lvgl draws the next area over the buffer anyway
+        tft_rotate_pixels<tft_pixel_t>(0, mask, src, src, w, h);
+        flush_cb(disp, area, color_p);
+        return;
+    }
+
+    if(_scratch.size() < (size_t)(w * h)) _scratch.resize(w * h);
+    tft_rotate_pixels<tft_pixel_t>(_rotation, mask, src, (tft_pixel_t*)_scratch.data(), w, h);
+
+    tft_rect_t in = {area->x1, area->y1, area->x2, area->y2}, out;
+    tft_rotate_rect(_rotation, _width, _height, in, out);
+    lv_area_t panel_area = {(lv_coord_t)out.x1, (lv_coord_t)out.y1, (lv_coord_t)out.x2, (lv_coord_t)out.y2};
+
+    // The flush callbacks clip to the resolution of the driver, which lvgl has in logical size
+    lv_disp_drv_t panel = *disp;
+    panel.hor_res       = _width;
+    panel.ver_res       = _height;
+    flush_cb(&panel, &panel_area, _scratch.data()); // flush ready goes through the shared buffer
+}
+
+bool TftRotation::input_read_cb(lv_indev_drv_t* indev_drv, lv_indev_data_t* data)
+{
+    for(rotation_input_t& input : rotation_inputs) {
+        if(input.indev_drv != indev_drv) continue;
+
+        bool more             = input.read_cb(indev_drv, data);
+        TftRotation* rotation = input.rotation;
+        if(rotation->_rotation) {
+            int32_t x = data->point.x, y = data->point.y;
+            tft_unrotate_point(rotation->_rotation, rotation->_width, rotation->_height, x, y);
+            data->point.x = x;
+            data->point.y = y;
+        }
+        return more;
+    }
+    return false;
+}
+
+void TftRotation::rotate_input(lv_indev_drv_t* indev_drv)
+{
+    if(!indev_drv || indev_drv->read_cb == input_read_cb) return;
+
+    for(rotation_input_t& input : rotation_inputs) {
+        if(input.indev_drv) continue;
+        input.indev_drv    = indev_drv;
+        input.read_cb      = indev_drv->read_cb;
+        input.rotation     = this;
+        indev_drv->read_cb = input_read_cb;
+        return;
+    }
+}
+
+} // namespace dev
+
+#endif // HASP_TARGET_PC
@@ -0,0 +1,49 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+ For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_TFT_DRIVER_ROTATION_H
+#define HASP_TFT_DRIVER_ROTATION_H
+
+#if HASP_TARGET_PC
+
+#include "lvgl.h"
+#include "tft_rotate.h"
+
+#include <vector>
+
+namespace dev {
+
+/* Rotation and inversion done on the flush path of the PC drivers, which have no hardware for it */
+class TftRotation {
+  public:
+    typedef void (*flush_cb_t)(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p);
+
+    void set_size(int32_t width, int32_t height); // of the panel
+    void set_rotation(uint8_t rotation);
+    void set_invert(bool invert);
+
+    bool is_active() const;
+    int32_t width() const; // what lvgl draws
+    int32_t height() const;
+
+    /* Hands the area to flush_cb as it must appear on the panel */
+    void flush(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p, flush_cb_t flush_cb);
+
+    /* The points read by this pointer input are turned along with the picture */
+    void rotate_input(lv_indev_drv_t* indev_drv);
+
+  private:
+    int32_t _width    = 0;
+    int32_t _height   = 0;
+    uint8_t _rotation = 0;
+    bool _invert      = false;
+    std::vector<lv_color_t> _scratch;
+
+    static bool input_read_cb(lv_indev_drv_t* indev_drv, lv_indev_data_t* data);
+};
+
+} // namespace dev
+
+#endif // HASP_TARGET_PC
+
+#endif // HASP_TFT_DRIVER_ROTATION_H
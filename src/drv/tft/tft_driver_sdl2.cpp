@@ -44,30 +44,13 @@ bool gui_pop_screenshot_request(void)
 
 namespace dev {
 
-/**
- * A task to measure the elapsed time for LittlevGL
- * @param data unused
- * @return never return
- */
-static int tick_thread(void* data)
-{
-    (void)data;
-
-    while(1) {
-        SDL_Delay(5);   /*Sleep for 5 millisecond*/
-        lv_tick_inc(5); /*Tell LittelvGL that 5 milliseconds were elapsed*/
-    }
-
-    return 0;
-}
-
 int32_t TftSdl::width()
 {
-    return _width;
+    return _rotation.width();
 }
 int32_t TftSdl::height()
 {
-    return _height;
+    return _rotation.height();
 }
 
 void TftSdl::init(int32_t w, int h)
@@ -81,6 +64,7 @@ void TftSdl::init(int32_t w, int h)
 
     _width  = w;
     _height = h;
+    _rotation.set_size(w, h);
 
     /* Add a display
      * Use the 'monitor' driver which creates window on PC's monitor to simulate a display*/
@@ -91,10 +75,7 @@ void TftSdl::init(int32_t w, int h)
      * Use the 'mouse' driver which reads the PC's mouse*/
     mouse_init();
 
-    /* Tick init.
-     * You have to call 'lv_tick_inc()' in periodically to inform LittelvGL about how much time were elapsed
-     * Create an SDL thread to do this*/
-    SDL_CreateThread(tick_thread, "tick", NULL);
+    /* lvgl reads its tick from millis(), no tick thread is needed */
     SDL_AddEventWatch(screenshot_event_watch, NULL);
 
 #if HASP_USE_LVGL_TASK
@@ -120,12 +101,20 @@ void TftSdl::splashscreen()
     monitor_splashscreen(logoImage, logoWidth, logoHeight, lv_color_to32(fgColor), lv_color_to32(bgColor));
 }
 void TftSdl::set_rotation(uint8_t rotation)
-{}
+{
+    _rotation.set_rotation(rotation);
+}
 void TftSdl::set_invert(bool invert)
-{}
+{
+    _rotation.set_invert(invert);
+}
 void TftSdl::flush_pixels(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
 {
-    monitor_flush(disp, area, color_p);
+    _rotation.flush(disp, area, color_p, monitor_flush);
+}
+void TftSdl::rotate_input(lv_indev_drv_t* indev_drv)
+{
+    _rotation.rotate_input(indev_drv);
 }
 bool TftSdl::is_driver_pin(uint8_t pin)
 {
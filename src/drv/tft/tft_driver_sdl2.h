@@ -11,6 +11,7 @@
 
 #include "lvgl.h"
 #include "indev/mouse.h"
+#include "tft_driver_rotation.h"
 
 namespace dev {
 
@@ -24,6 +25,7 @@ class TftSdl : BaseTft {
     void set_invert(bool invert);
 
     void flush_pixels(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p);
+    void rotate_input(lv_indev_drv_t* indev_drv);
     bool is_driver_pin(uint8_t pin);
 
     const char* get_tft_model();
@@ -33,6 +35,7 @@ class TftSdl : BaseTft {
 
   private:
     int32_t _width, _height;
+    TftRotation _rotation;
 };
 
 } // namespace dev
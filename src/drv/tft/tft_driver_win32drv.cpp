@@ -23,23 +23,6 @@
 
 namespace dev {
 
-/**
- * A task to measure the elapsed time for LittlevGL
- * @param data unused
- * @return never return
- */
-static DWORD tick_thread(void* data)
-{
-    (void)data;
-
-    while(1) {
-        Sleep(5);       /*Sleep for 5 millisecond*/
-        lv_tick_inc(5); /*Tell LittelvGL that 5 milliseconds were elapsed*/
-    }
-
-    return 0;
-}
-
 int32_t TftWin32Drv::width()
 {
     return _width;
@@ -87,9 +70,7 @@ static DWORD gui_entrypoint(HANDLE semaphore)
     // wait for the LVGL task now
     WaitForSingleObject(thread, 4000);
 #else
-    // create a LVGL tick thread
-    CreateThread(NULL, 0, tick_thread, NULL, 0, NULL);
-    // create a LVGL task for the message loop
+    // create a LVGL task for the message loop, the tick is read from millis()
     lv_task_create(win32_message_loop, 5, LV_TASK_PRIO_HIGHEST, NULL);
 #endif
     return 0;
@@ -0,0 +1,41 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "tft_rotate.h"
+
+void tft_rotate_rect(uint8_t rotation, int32_t width, int32_t height, const tft_rect_t& in, tft_rect_t& out)
+{
+    switch(rotation & 3) {
+        case 0:
+            out = in;
+            break;
+        case 1:
+            out = {width - 1 - in.y2, in.x1, width - 1 - in.y1, in.x2};
+            break;
+        case 2:
+            out = {width - 1 - in.x2, height - 1 - in.y2, width - 1 - in.x1, height - 1 - in.y1};
+            break;
+        case 3:
+            out = {in.y1, height - 1 - in.x2, in.y2, height - 1 - in.x1};
+            break;
+    }
+}
+
+void tft_unrotate_point(uint8_t rotation, int32_t width, int32_t height, int32_t& x, int32_t& y)
+{
+    int32_t px = x, py = y;
+    switch(rotation & 3) {
+        case 1:
+            x = py;
+            y = width - 1 - px;
+            break;
+        case 2:
+            x = width - 1 - px;
+            y = height - 1 - py;
+            break;
+        case 3:
+            x = height - 1 - py;
+            y = px;
+            break;
+    }
+}
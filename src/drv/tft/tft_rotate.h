@@ -0,0 +1,73 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Software rotation and color inversion for the PC display drivers
+ *
+ * lvgl draws the picture upright in the logical size, the driver turns every flushed area onto the panel. Rotation
+ * r turns the picture r * 90 degrees clockwise, so rotation 1 and 3 swap the width and the height. A 90 degree turn
+ * reads the source by rows and writes the destination by columns, which misses the cache on every pixel of a large
+ * area. It is done in square tiles instead, a tile of source rows and destination rows both fit in the cache.
+ */
+
+#ifndef HASP_TFT_ROTATE_H
+#define HASP_TFT_ROTATE_H
+
+#include <stdint.h>
+
+#ifndef TFT_ROTATE_TILE
+#define TFT_ROTATE_TILE 32 // pixels
+#endif
+
+struct tft_rect_t
+{
+    int32_t x1, y1, x2, y2; // inclusive, like lv_area_t
+};
+
+/* The area on the panel of width x height pixels that a logical area is drawn to */
+void tft_rotate_rect(uint8_t rotation, int32_t width, int32_t height, const tft_rect_t& in, tft_rect_t& out);
+
+/* A point read on the panel, e.g. a touch, into logical coordinates */
+void tft_unrotate_point(uint8_t rotation, int32_t width, int32_t height, int32_t& x, int32_t& y);
+
+/* Copies a w x h block of pixels turned by rotation into dst, every pixel xor'ed with invert_mask */
+template <typename T>
+void tft_rotate_pixels(uint8_t rotation, T invert_mask, const T* src, T* dst, int32_t w, int32_t h)
+{
+    switch(rotation & 3) {
+        case 0:
+            for(int32_t i = 0; i < w * h; i++) dst[i] = src[i] ^ invert_mask;
+            break;
+
+        case 2: // the block reversed
+            for(int32_t i = 0, n = w * h; i < n; i++) dst[n - 1 - i] = src[i] ^ invert_mask;
+            break;
+
+        case 1: // source row j becomes destination column h - 1 - j
+            for(int32_t ty = 0; ty < h; ty += TFT_ROTATE_TILE) {
+                int32_t ty2 = ty + TFT_ROTATE_TILE < h ? ty + TFT_ROTATE_TILE : h;
+                for(int32_t tx = 0; tx < w; tx += TFT_ROTATE_TILE) {
+                    int32_t tx2 = tx + TFT_ROTATE_TILE < w ? tx + TFT_ROTATE_TILE : w;
+                    for(int32_t i = tx; i < tx2; i++) {
+                        T* out = dst + i * h + (h - 1);
+                        for(int32_t j = ty; j < ty2; j++) out[-j] = src[j * w + i] ^ invert_mask;
+                    }
+                }
+            }
+            break;
+
+        case 3: // source column i becomes destination row w - 1 - i
+            for(int32_t ty = 0; ty < h; ty += TFT_ROTATE_TILE) {
+                int32_t ty2 = ty + TFT_ROTATE_TILE < h ? ty + TFT_ROTATE_TILE : h;
+                for(int32_t tx = 0; tx < w; tx += TFT_ROTATE_TILE) {
+                    int32_t tx2 = tx + TFT_ROTATE_TILE < w ? tx + TFT_ROTATE_TILE : w;
+                    for(int32_t i = tx; i < tx2; i++) {
+                        T* out = dst + (w - 1 - i) * h;
+                        for(int32_t j = ty; j < ty2; j++) out[j] = src[j * w + i] ^ invert_mask;
+                    }
+                }
+            }
+            break;
+    }
+}
+
+#endif // HASP_TFT_ROTATE_H
@@ -10,13 +10,26 @@
 #include <Wire.h>
 #include "Goodix.h"
 
-#include "touch_driver.h" // base class
-#include "touch_helper.h" // i2c scanner
+#include "touch_driver.h"  // base class
+#include "touch_helper.h"  // i2c scanner
+#include "touch_gesture.h" // multi-point acquisition
 
 #include "../../hasp/hasp.h" // for hasp_sleep_state
 extern uint8_t hasp_sleep_state;
 
 static Goodix touch = Goodix();
+static dev::TouchPoints touch_points;
+
+#ifndef TOUCH_IRQ_MODE
+#define TOUCH_IRQ_MODE RISING // same edge as the Goodix library
+#endif
+
+#if TOUCH_IRQ != -1
+IRAM_ATTR static void GT911_irq()
+{
+    touch_points.irq();
+}
+#endif
 // static int8_t GT911_num_touches;
 // static GTPoint* GT911_points;
 
@@ -60,26 +73,40 @@ namespace dev {
 
 IRAM_ATTR bool TouchGt911::read(lv_indev_drv_t* indev_driver, lv_indev_data_t* data)
 {
-    //  LOG_VERBOSE(TAG_GUI, F("Contacts: %d"), GT911_num_touches);
-    static GTPoint points[5];
+    static GTPoint points[TOUCH_MAX_POINTS];
 
-    if(touch.readInput((uint8_t*)&points) > 0) {
-
-        if(hasp_sleep_state != HASP_SLEEP_OFF) hasp_update_sleep_state(); // update Idle
+    if(touch_points.read_needed(millis())) {
+        int8_t contacts = touch.readInput((uint8_t*)&points);
+        if(contacts < 0) contacts = 0;
+        if(contacts > TOUCH_MAX_POINTS) contacts = TOUCH_MAX_POINTS;
 
+        touch_point_t report[TOUCH_MAX_POINTS];
+        for(int8_t i = 0; i < contacts; i++) {
+            report[i].id = points[i].trackId;
 #ifdef TOUCH_WIDTH
-        data->point.x = map(points[0].x, 0, TOUCH_WIDTH - 1, 0, TFT_WIDTH - 1);
+            report[i].x = map(points[i].x, 0, TOUCH_WIDTH - 1, 0, TFT_WIDTH - 1);
 #else
-        data->point.x = points[0].x;
+            report[i].x = points[i].x;
 #endif
 
 #ifdef TOUCH_HEIGHT
-        data->point.y = map(points[0].y, 0, TOUCH_HEIGHT - 1, 0, TFT_HEIGHT - 1);
+            report[i].y = map(points[i].y, 0, TOUCH_HEIGHT - 1, 0, TFT_HEIGHT - 1);
 #else
-        data->point.y = points[0].y;
+            report[i].y = points[i].y;
 #endif
+        }
+
+        touch_gesture_t gesture = touch_points.update(millis(), contacts, report);
+        if(gesture != TOUCH_GESTURE_NONE) gesture_event_handler(touch_gesture_name(gesture));
+    }
+
+    if(touch_points.count > 0) {
 
-        data->state = LV_INDEV_STATE_PR;
+        if(hasp_sleep_state != HASP_SLEEP_OFF) hasp_update_sleep_state(); // update Idle
+
+        data->point.x = touch_points.points[0].x;
+        data->point.y = touch_points.points[0].y;
+        data->state   = LV_INDEV_STATE_PR;
         hasp_set_sleep_offset(0); // Reset the offset
 
     } else {
@@ -122,6 +149,12 @@ found:
 
     Wire.begin(TOUCH_SDA, TOUCH_SCL, (uint32_t)I2C_TOUCH_FREQUENCY);
     touch_scan(Wire); // The address could change during begin, so scan afterwards
+
+#if TOUCH_IRQ != -1
+    // Only read the controller after it signalled new data
+    attachInterrupt(digitalPinToInterrupt(TOUCH_IRQ), GT911_irq, TOUCH_IRQ_MODE);
+    touch_points.set_irq_enabled(true);
+#endif
 }
 
 } // namespace dev
@@ -0,0 +1,114 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "touch_gesture.h"
+
+const char* touch_gesture_name(touch_gesture_t gesture)
+{
+    switch(gesture) {
+        case TOUCH_GESTURE_PINCH_IN:
+            return "pinch_in";
+        case TOUCH_GESTURE_PINCH_OUT:
+            return "pinch_out";
+        case TOUCH_GESTURE_LEFT2:
+            return "left2";
+        case TOUCH_GESTURE_RIGHT2:
+            return "right2";
+        case TOUCH_GESTURE_UP2:
+            return "up2";
+        case TOUCH_GESTURE_DOWN2:
+            return "down2";
+        default:
+            return "";
+    }
+}
+
+static int32_t touch_distance(const touch_point_t* a, const touch_point_t* b)
+{
+    float dx = a->x - b->x;
+    float dy = a->y - b->y;
+    return (int32_t)sqrtf(dx * dx + dy * dy);
+}
+
+namespace dev {
+
+bool TouchPoints::read_needed(uint32_t now)
+{
+    polls++;
+
+    if(!irq_enabled || irq_pending || (count > 0 && now - last_report >= TOUCH_IRQ_TIMEOUT)) {
+        irq_pending = false; // cleared before the read, so an interrupt during the read is not lost
+        reads++;
+        return true;
+    }
+
+    return false;
+}
+
+touch_gesture_t TouchPoints::update(uint32_t now, uint8_t num, const touch_point_t* report)
+{
+    if(num > TOUCH_MAX_POINTS) num = TOUCH_MAX_POINTS;
+    memcpy(points, report, num * sizeof(touch_point_t));
+    count       = num;
+    last_report = now;
+
+    return recognize();
+}
+
+const touch_point_t* TouchPoints::find(uint8_t track_id) const
+{
+    for(uint8_t i = 0; i < count; i++)
+        if(points[i].id == track_id) return &points[i];
+    return NULL;
+}
+
+touch_gesture_t TouchPoints::recognize()
+{
+    if(count == 0) {
+        // All fingers are lifted, the next touch can make a new gesture
+        tracking = false;
+        done     = false;
+        return TOUCH_GESTURE_NONE;
+    }
+    if(done) return TOUCH_GESTURE_NONE;
+
+    const touch_point_t* a = find(id[0]);
+    const touch_point_t* b = find(id[1]);
+
+    if(count < 2 || !tracking || !a || !b) {
+        tracking = count >= 2;
+        if(!tracking) return TOUCH_GESTURE_NONE;
+
+        // (Re)start following the first two fingers
+        id[0]      = points[0].id;
+        id[1]      = points[1].id;
+        start_x    = points[0].x + points[1].x;
+        start_y    = points[0].y + points[1].y;
+        start_dist = touch_distance(&points[0], &points[1]);
+        return TOUCH_GESTURE_NONE;
+    }
+
+    int32_t pinch  = touch_distance(a, b) - start_dist;
+    int32_t dx     = (a->x + b->x - start_x) / 2;
+    int32_t dy     = (a->y + b->y - start_y) / 2;
+    int32_t travel = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+
+    touch_gesture_t gesture = TOUCH_GESTURE_NONE;
+    if(abs(pinch) >= TOUCH_GESTURE_PINCH_MIN && abs(pinch) > travel) {
+        gesture = pinch < 0 ? TOUCH_GESTURE_PINCH_IN : TOUCH_GESTURE_PINCH_OUT;
+    } else if(travel >= TOUCH_GESTURE_SWIPE_MIN && travel > abs(pinch)) {
+        if(abs(dx) > abs(dy))
+            gesture = dx < 0 ? TOUCH_GESTURE_LEFT2 : TOUCH_GESTURE_RIGHT2;
+        else
+            gesture = dy < 0 ? TOUCH_GESTURE_UP2 : TOUCH_GESTURE_DOWN2;
+    }
+
+    if(gesture != TOUCH_GESTURE_NONE) done = true;
+    return gesture;
+}
+
+} // namespace dev
@@ -0,0 +1,97 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_TOUCH_GESTURE_H
+#define HASP_TOUCH_GESTURE_H
+
+#include <stdint.h>
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+#ifndef TOUCH_MAX_POINTS
+#define TOUCH_MAX_POINTS 5
+#endif
+
+#ifndef TOUCH_GESTURE_SWIPE_MIN
+#define TOUCH_GESTURE_SWIPE_MIN 60 // pixels the fingers travel together for a two-finger swipe
+#endif
+
+#ifndef TOUCH_GESTURE_PINCH_MIN
+#define TOUCH_GESTURE_PINCH_MIN 50 // pixels the distance between the fingers changes for a pinch
+#endif
+
+#ifndef TOUCH_IRQ_TIMEOUT
+#define TOUCH_IRQ_TIMEOUT 100 // ms without interrupt while touched before the controller is read anyway
+#endif
+
+enum touch_gesture_t : uint8_t {
+    TOUCH_GESTURE_NONE = 0,
+    TOUCH_GESTURE_PINCH_IN,
+    TOUCH_GESTURE_PINCH_OUT,
+    TOUCH_GESTURE_LEFT2,
+    TOUCH_GESTURE_RIGHT2,
+    TOUCH_GESTURE_UP2,
+    TOUCH_GESTURE_DOWN2,
+};
+
+struct touch_point_t
+{
+    uint8_t id; // track id reported by the controller
+    int16_t x;
+    int16_t y;
+};
+
+const char* touch_gesture_name(touch_gesture_t gesture);
+
+namespace dev {
+
+/* Acquisition layer between a multi-point touch controller and lvgl
+ *
+ * With an interrupt line the controller is only read after it signalled new data, or when a touch is held and no
+ * interrupt arrived for TOUCH_IRQ_TIMEOUT ms, so a missed release can not keep the screen pressed. Without an
+ * interrupt line every poll reads the controller. All reported points are kept and two-finger gestures are
+ * recognized while the fingers move, at most one gesture per touch.
+ */
+class TouchPoints {
+  public:
+    uint8_t count = 0;
+    touch_point_t points[TOUCH_MAX_POINTS];
+
+    uint32_t polls = 0; // lvgl input device polls
+    uint32_t reads = 0; // controller reads
+
+    IRAM_ATTR void irq()
+    {
+        irq_pending = true;
+    }
+
+    void set_irq_enabled(bool enabled)
+    {
+        irq_enabled = enabled;
+        irq_pending = true;
+    }
+
+    bool read_needed(uint32_t now);
+    touch_gesture_t update(uint32_t now, uint8_t num, const touch_point_t* report);
+
+  private:
+    volatile bool irq_pending = false;
+    bool irq_enabled          = false;
+    uint32_t last_report      = 0;
+
+    bool tracking = false; // two fingers are being followed
+    bool done     = false; // the gesture of this touch was already reported
+    uint8_t id[2];
+    int32_t start_x; // sum of the x coordinates of both fingers
+    int32_t start_y; // sum of the y coordinates of both fingers
+    int32_t start_dist;
+
+    const touch_point_t* find(uint8_t track_id) const;
+    touch_gesture_t recognize();
+};
+
+} // namespace dev
+
+#endif // HASP_TOUCH_GESTURE_H
@@ -166,7 +166,7 @@ void hasp_font_free(lv_font_t* font)
             }
 
             if(NULL != dsc->glyph_bitmap) {
-                free((void*)dsc->glyph_bitmap);
+                hasp_free((void*)dsc->glyph_bitmap);
             }
             if(NULL != dsc->glyph_dsc) {
                 free((void*)dsc->glyph_dsc);
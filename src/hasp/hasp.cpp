@@ -187,8 +187,117 @@ void hasp_get_sleep_payload(uint8_t state, char* payload)
 
 /**
  * Anti Burn-in protection
+ *
+ * The pattern is precomputed once into a tile of (rows + 1) full-width lines. Each frame pushes the tile as bands of
+ * rows at a different offset into the tile, so no pixel data is generated while the antiburn is running:
+ *  - noise    : random colors, pushed at a random offset
+ *  - invert   : checkerboard, the one row offset inverts every pixel on alternate frames
+ *  - gradient : hue gradient, the offset scrolls the gradient horizontally
+ *
+ * The number of pixels pushed per task run is limited by the pixel rate and by the duty cycle, which is the
+ * percentage of the task period the display bus may be occupied. The bus time is measured on every run.
  */
+#ifndef HASP_ANTIBURN_TILE_SIZE
+#define HASP_ANTIBURN_TILE_SIZE 2048 // Number of pixels in the precomputed pattern tile, at least two lines are used
+#endif
+
+typedef struct
+{
+    lv_color_t* tile;     // Precomputed pattern of (rows + 1) * width pixels
+    lv_coord_t width;     // Horizontal resolution, also the stride of the tile
+    lv_coord_t rows;      // Height of a pushed band
+    lv_coord_t cursor;    // Next row to push in the current frame
+    uint32_t phase;       // Frame counter, selects the tile offset
+    uint32_t throughput;  // Measured pixels per millisecond
+    uint32_t frames;      // Statistics: completed frames
+    uint32_t pixels;      // Statistics: pixels pushed
+    uint32_t busy_ms;     // Statistics: time spent pushing pixels
+    uint32_t start;       // Statistics: tick when the antiburn started
+} hasp_antiburn_t;
+
 static lv_task_t* antiburn_task;
+static hasp_antiburn_t antiburn;
+static uint8_t antiburn_mode     = HASP_ANTIBURN_NOISE;
+static uint8_t antiburn_duty     = 100; // Percent of the task period the display bus can be used
+static uint32_t antiburn_rate    = 0;   // Maximum pixels per task run, 0 = unlimited
+static uint32_t antiburn_elapsed = 0;   // Statistics: duration of the last antiburn run
+
+static void hasp_antiburn_get_screen(lv_coord_t& scr_w, lv_coord_t& scr_h)
+{
+    lv_disp_t* disp = lv_disp_get_default();
+    lv_obj_t* layer = lv_disp_get_layer_sys(NULL);
+
+    if(disp->driver.sw_rotate || !layer) {
+        scr_w = disp->driver.hor_res - 1; // use hardware w
+        scr_h = disp->driver.ver_res - 1; // use hardware h
+    } else {
+        scr_w = lv_obj_get_width(layer) - 1;  // use software w
+        scr_h = lv_obj_get_height(layer) - 1; // use software h
+    }
+}
+
+static void hasp_antiburn_free_tile()
+{
+    if(antiburn.tile) free(antiburn.tile);
+    antiburn.tile = NULL;
+}
+
+static bool hasp_antiburn_init_tile()
+{
+    lv_coord_t scr_w;
+    lv_coord_t scr_h;
+    hasp_antiburn_get_screen(scr_w, scr_h);
+
+    hasp_antiburn_free_tile();
+    memset(&antiburn, 0, sizeof(antiburn));
+
+    // Bands always span the full width, so the stride of the tile matches the flushed area on any panel
+    antiburn.width = scr_w + 1;
+    antiburn.rows  = HASP_ANTIBURN_TILE_SIZE / antiburn.width - 1;
+    if(antiburn.rows < 1) antiburn.rows = 1; // wide panel, the tile grows to two lines
+
+    size_t len = (antiburn.rows + 1) * antiburn.width;
+#ifdef ESP32
+    antiburn.tile = (lv_color_t*)heap_caps_malloc(sizeof(lv_color_t) * len, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+    antiburn.tile = (lv_color_t*)malloc(sizeof(lv_color_t) * len);
+#endif
+    if(!antiburn.tile) return false;
+
+    for(size_t i = 0; i < len; i++) {
+        uint32_t x = i % antiburn.width;
+        uint32_t y = i / antiburn.width;
+
+        switch(antiburn_mode) {
+            case HASP_ANTIBURN_INVERT:
+                antiburn.tile[i] = ((x + y) & 1) ? LV_COLOR_WHITE : LV_COLOR_BLACK;
+                break;
+            case HASP_ANTIBURN_GRADIENT:
+                antiburn.tile[i] = lv_color_hsv_to_rgb(x * 359 / antiburn.width, 100, 100);
+                break;
+            default:
+                antiburn.tile[i] = lv_color_make(HASP_RANDOM(256), HASP_RANDOM(256), HASP_RANDOM(256));
+        }
+    }
+
+    antiburn.start = lv_tick_get();
+    return true;
+}
+
+// Offset into the tile for the current frame, at most one row so the rectangle stays within the tile
+static size_t hasp_antiburn_get_offset()
+{
+    switch(antiburn_mode) {
+        case HASP_ANTIBURN_INVERT:
+            return (antiburn.phase & 1) ? antiburn.width : 0;
+        case HASP_ANTIBURN_GRADIENT: {
+            uint32_t step = antiburn.width / 16 + 1;
+            return (antiburn.phase * step) % antiburn.width;
+        }
+        default:
+            return HASP_RANDOM(antiburn.width);
+    }
+}
 
 bool hasp_stop_antiburn()
 {
@@ -205,8 +314,14 @@ bool hasp_stop_antiburn()
         lv_task_del(antiburn_task);
         lv_obj_invalidate(lv_scr_act());
         changed = true;
+
+        antiburn_elapsed = lv_tick_elaps(antiburn.start);
+        LOG_INFO(TAG_HASP, F("Antiburn %u frames, %u pixels, bus %u/%u ms (%u%%)"), antiburn.frames, antiburn.pixels,
+                 antiburn.busy_ms, antiburn_elapsed,
+                 antiburn_elapsed ? (uint32_t)((uint64_t)antiburn.busy_ms * 100 / antiburn_elapsed) : 0);
     }
     antiburn_task = NULL;
+    hasp_antiburn_free_tile();
     hasp_set_wakeup_touch(haspDevice.get_backlight_power() == false); // enabled if backlight is OFF
 
     // gui_hide_pointer(false);
@@ -215,60 +330,53 @@ bool hasp_stop_antiburn()
 
 void hasp_antiburn_cb(lv_task_t* task)
 {
-    lv_obj_t* layer = lv_disp_get_layer_sys(NULL);
-    if(layer) {
-        // Fill a buffer with random colors
-        lv_color_t color[1223]; // prime
-        size_t max_len = sizeof(color) / sizeof(color[0]);
-        for(size_t x = 0; x < max_len; x++) {
-            color[x].full = HASP_RANDOM(UINT16_MAX);
-        }
-        max_len -= 64; // leave some headroom to randomize
-
-        // list of possible draw widths; prime numbers combat recurring patterns on the screen
-        uint8_t prime[] = {61,  67,  73,  79,  83,  89,  97,  103, 109, 113, 127, 131, 137, 139, 149,
-                           157, 163, 167, 173, 179, 181, 191, 197, 211, 223, 227, 229, 233, 251};
-
+    if(antiburn.tile) {
         lv_disp_t* disp         = lv_disp_get_default();
         lv_disp_drv_t* disp_drv = &disp->driver;
 
         lv_coord_t scr_h;
         lv_coord_t scr_w;
+        hasp_antiburn_get_screen(scr_w, scr_h);
 
-        if(disp_drv->sw_rotate) {
-            scr_w = disp_drv->hor_res - 1; // use hardware w
-            scr_h = disp_drv->ver_res - 1; // use hardware h
-        } else {
-            scr_w = lv_obj_get_width(layer) - 1;  // use software w
-            scr_h = lv_obj_get_height(layer) - 1; // use software h
+        // Limit the pixels pushed in this run to the rate and to the duty cycle of the measured bus throughput
+        uint32_t budget = antiburn_rate > 0 ? antiburn_rate : UINT32_MAX;
+        if(antiburn_duty < 100 && antiburn.throughput > 0) {
+            uint32_t limit = antiburn.throughput * task->period / 100 * antiburn_duty;
+            if(limit < budget) budget = limit;
         }
 
-        lv_coord_t w = scr_w; // maximum screen width
+        uint32_t start  = lv_tick_get();
+        uint32_t pushed = 0;
+        size_t offset   = hasp_antiburn_get_offset();
         lv_area_t area;
 
-        area.y1 = 0;
-        while(area.y1 <= scr_h) {
-            if(w > scr_w) w = scr_w;     // limit to the actual screenwidth
-            if(w > max_len) w = max_len; // don't overrun the buffer
-            lv_coord_t h    = max_len / w;
-            size_t headroom = (sizeof(color) / sizeof(color[0])) -
-                              (h * w); // additional bytes in the buffer that can be used for a random offset
-
-            area.y2 = area.y1 + h - 1;
+        do { // push at least one band
+            area.y1 = antiburn.cursor;
+            area.y2 = area.y1 + antiburn.rows - 1;
             if(area.y2 > scr_h) area.y2 = scr_h;
 
             area.x1 = 0;
-            while(area.x1 <= scr_w) {
-                area.x2 = area.x1 + w - 1;
-                if(area.x2 > scr_w) area.x2 = scr_w;
+            area.x2 = antiburn.width - 1;
 
-                size_t offset = headroom ? HASP_RANDOM(headroom) : 0;
-                haspTft.flush_pixels(disp_drv, &area, color + offset);
-                area.x1 += w;
-            }
+            haspTft.flush_pixels(disp_drv, &area, antiburn.tile + offset);
+            pushed += antiburn.width * (area.y2 - area.y1 + 1);
+            if(antiburn_mode == HASP_ANTIBURN_NOISE) offset = hasp_antiburn_get_offset();
 
-            w = prime[HASP_RANDOM(sizeof(prime) / sizeof(prime[0]))]; // new random width
-            area.y1 += h;
+            antiburn.cursor = area.y2 + 1;
+            if(antiburn.cursor > scr_h) { // frame completed, the next run starts a new frame
+                antiburn.cursor = 0;
+                antiburn.frames++;
+                antiburn.phase++;
+                break;
+            }
+        } while(pushed < budget);
+
+        uint32_t elapsed = lv_tick_elaps(start);
+        antiburn.busy_ms += elapsed;
+        antiburn.pixels += pushed;
+        if(elapsed > 0) {
+            uint32_t rate       = pushed / elapsed;
+            antiburn.throughput = antiburn.throughput ? (antiburn.throughput + rate) / 2 : rate;
         }
     }
 
@@ -279,6 +387,16 @@ void hasp_antiburn_cb(lv_task_t* task)
     }
 }
 
+/**
+ * Set the Anti Burn-in pattern, duty cycle in percent and pixel rate per task run
+ */
+void hasp_set_antiburn_pattern(uint8_t mode, uint8_t duty, uint32_t rate)
+{
+    if(mode <= HASP_ANTIBURN_GRADIENT) antiburn_mode = mode;
+    if(duty > 0 && duty <= 100) antiburn_duty = duty;
+    antiburn_rate = rate;
+}
+
 /**
  * Enable/Disable Anti Burn-in protection
  */
@@ -289,7 +407,7 @@ void hasp_set_antiburn(int32_t repeat_count, uint32_t period)
         if(!layer) return;
 
         if(!antiburn_task) antiburn_task = lv_task_create(hasp_antiburn_cb, period, LV_TASK_PRIO_LOW, NULL);
-        if(antiburn_task) {
+        if(antiburn_task && hasp_antiburn_init_tile()) {
             // lv_obj_set_style_local_bg_color(layer, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLACK);
             // lv_obj_set_style_local_bg_opa(layer, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_OPA_COVER);
             hasp_set_wakeup_touch(true);
@@ -304,6 +422,7 @@ void hasp_set_antiburn(int32_t repeat_count, uint32_t period)
 
         } else {
             LOG_INFO(TAG_HASP, F("Antiburn %s"), D_INFO_FAILED);
+            hasp_stop_antiburn();
         }
     } else {
         hasp_stop_antiburn();
@@ -405,6 +524,7 @@ void haspReconnect()
 // Shows/hides the global progress bar and updates the value
 void haspProgressVal(uint8_t val)
 {
+    GuiLock lock("progress"); // called by the network services outside the gui lock
     lv_obj_t* layer = lv_disp_get_layer_sys(NULL);
     lv_obj_t* bar   = hasp_find_obj_from_page_id(255U, 10U);
     if(layer && bar) {
@@ -435,6 +555,7 @@ void haspProgressVal(uint8_t val)
 // Sets the value string of the global progress bar
 void haspProgressMsg(const char* msg)
 {
+    GuiLock lock("progress"); // called by the network services outside the gui lock
     if(lv_obj_t* bar = hasp_find_obj_from_page_id(255U, 10U)) {
         char value_str[10];
         snprintf_P(value_str, sizeof(value_str), PSTR("value_str"));
@@ -710,6 +831,7 @@ void haspClearPage(uint16_t pageid)
 
 void hasp_get_info(JsonDocument& doc)
 {
+    GuiLock lock("info"); // reads the lvgl memory and pages for the web server
     std::string buffer;
     buffer.reserve(64);
     char size_buf[32];
@@ -788,6 +910,41 @@ void hasp_get_info(JsonDocument& doc)
     info[F(D_INFO_FREE_MEMORY)]   = size_buf;
     info[F(D_INFO_FRAGMENTATION)] = std::to_string(mem_mon.frag_pct) + "%";
 #endif
+
+#if HASP_USE_LAZY_PAGES > 0
+    info = doc.createNestedObject(F("Pages"));
+    haspPages.get_info(info);
+#endif
+
+    hasp_mem_pool_stats_t pool;
+    for(uint8_t i = 0; hasp_mem_get_pool_stats(i, &pool); i++) {
+        char key[16];
+        char value[48];
+        if(i == 0) info = doc.createNestedObject(F("Memory Pools"));
+        snprintf_P(key, sizeof(key), PSTR("%u bytes"), pool.block_size);
+        snprintf_P(value, sizeof(value), PSTR("%u/%u max %u frag %u%% miss %u"), pool.used, pool.block_count,
+                   pool.high_water, pool.fragmentation, pool.fallbacks);
+        info[key] = value;
+    }
+
+#if HASP_USE_FREETYPE > 0
+    info = doc.createNestedObject(F("Font Cache"));
+    font_get_info(info);
+#endif
+
+    info = doc.createNestedObject(F("Style Classes"));
+    hasp_style_get_info(info);
+
+#if HASP_USE_GUI_LOCK > 0
+    info = doc.createNestedObject(F("GUI Lock"));
+    gui_get_lock_info(info);
+#endif
+
+    info = doc.createNestedObject(F("Plugins"));
+    plugin_get_info(info);
+
+    info = doc.createNestedObject(F("Commands"));
+    dispatch_get_command_stats(info);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -825,6 +982,10 @@ bool haspGetConfig(const JsonObject& settings)
     if(strcmp(haspPagesPath, settings[FPSTR(FP_CONFIG_PAGES)].as<String>().c_str()) != 0) changed = true;
     settings[FPSTR(FP_CONFIG_PAGES)] = haspPagesPath;
 
+#if HASP_USE_FREETYPE > 0
+    changed |= font_get_config(settings);
+#endif
+
     if(changed) configOutput(settings, TAG_HASP);
     return changed;
 }
@@ -878,6 +1039,10 @@ bool haspSetConfig(const JsonObject& settings)
         strncpy(haspZiFontPath, settings[FPSTR(FP_CONFIG_ZIFONT)], sizeof(haspZiFontPath));
     }
 
+#if HASP_USE_FREETYPE > 0
+    changed |= font_set_config(settings);
+#endif
+
     return changed;
 }
 #endif // HASP_USE_CONFIG
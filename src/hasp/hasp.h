@@ -45,6 +45,10 @@ extern "C" {
 #define HASP_SLEEP_LONG 2
 #define HASP_SLEEP_LAST 3
 
+#define HASP_ANTIBURN_NOISE 0
+#define HASP_ANTIBURN_INVERT 1
+#define HASP_ANTIBURN_GRADIENT 2
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -85,6 +89,7 @@ void hasp_set_sleep_time(uint16_t short_time, uint16_t long_time);
 void hasp_set_sleep_offset(uint32_t offset);
 void hasp_set_wakeup_touch(bool en);
 void hasp_set_antiburn(int32_t repeat_count, uint32_t period);
+void hasp_set_antiburn_pattern(uint8_t mode, uint8_t duty, uint32_t rate);
 bool hasp_stop_antiburn();
 hasp_event_t hasp_get_antiburn();
 
@@ -53,6 +53,12 @@ void my_image_release_resources(lv_obj_t* obj)
     }
 }
 
+/* Button maps set from a payload are a single lv_mem block: the label pointer array followed by the labels */
+static inline bool my_map_is_owned(const char** map)
+{
+    return map && map != btnmatrix_default_map && map != msgbox_default_map;
+}
+
 void my_btnmatrix_map_clear(lv_obj_t* obj)
 {
     lv_btnmatrix_ext_t* ext = (lv_btnmatrix_ext_t*)lv_obj_get_ext_attr(obj);
@@ -60,22 +66,12 @@ void my_btnmatrix_map_clear(lv_obj_t* obj)
 
     LOG_DEBUG(TAG_ATTR, "%s %d %x   btn_cnt: %d", __FILE__, __LINE__, map_p_tmp, ext->btn_cnt);
 
-    if(ext->map_p && (ext->btn_cnt > 0)) {
+    // The map exists and is not a default map
+    if(!my_map_is_owned(map_p_tmp)) return;
 
-        // The map exists and is not the default lvgl map anymore
-        if((map_p_tmp == NULL) || (btnmatrix_default_map == NULL) || (map_p_tmp == btnmatrix_default_map)) return;
-
-        LOG_DEBUG(TAG_ATTR, "%s %d %x", __FILE__, __LINE__,
-                  *map_p_tmp);                                          // label buffer reserved as a contiguous block
-        LOG_DEBUG(TAG_ATTR, "%s %d %x", __FILE__, __LINE__, map_p_tmp); // label pointer array block
-        lv_btnmatrix_set_map(obj, btnmatrix_default_map);               // reset to default btnmap pointer
-
-        LOG_DEBUG(TAG_ATTR, F("%s %d"), __FILE__, __LINE__);
-        lv_mem_free(*map_p_tmp); // free label buffer reserved as a contiguous block
-        LOG_DEBUG(TAG_ATTR, F("%s %d"), __FILE__, __LINE__);
-        lv_mem_free(map_p_tmp); // free label pointer array block
-        LOG_DEBUG(TAG_ATTR, F("%s %d"), __FILE__, __LINE__);
-    }
+    // reset to a static default btnmap pointer
+    lv_btnmatrix_set_map(obj, btnmatrix_default_map ? btnmatrix_default_map : msgbox_default_map);
+    lv_mem_free(map_p_tmp); // free label pointer array and label buffer
 }
 
 void my_msgbox_map_clear(lv_obj_t* obj)
@@ -93,96 +89,198 @@ void my_msgbox_map_clear(lv_obj_t* obj)
         my_btnmatrix_map_clear(btnmatrix);         // Clear the custom button map if it exists
 }
 
-// Create new btnmatrix button map from json array
-const char** my_map_create(const char* payload)
+static inline const char* my_json_skip_ws(const char* p)
 {
-    // Reserve memory for JsonDocument
-    // StaticJsonDocument<1024> map_doc;
-    size_t maxsize = (128u * ((strlen(payload) / 128) + 1)) + 1024;
-    DynamicJsonDocument map_doc(maxsize);
-    DeserializationError jsonError = deserializeJson(map_doc, payload);
-
-    if(jsonError) { // Couldn't parse incoming JSON payload
-        dispatch_json_error(TAG_ATTR, jsonError);
-        return NULL;
+    while(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    return p;
+}
+
+static bool my_json_hex4(const char* p, uint32_t* value)
+{
+    *value = 0;
+    for(uint8_t i = 0; i < 4; i++) {
+        char c = p[i];
+        if(c >= '0' && c <= '9')
+            c -= '0';
+        else if(c >= 'a' && c <= 'f')
+            c -= 'a' - 10;
+        else if(c >= 'A' && c <= 'F')
+            c -= 'A' - 10;
+        else
+            return false;
+        *value = (*value << 4) | c;
     }
+    return true;
+}
 
-    JsonArray arr = map_doc.as<JsonArray>(); // Parse payload
+/* Unescape the quoted json string at p into out, or only measure it when out is NULL
+ * Returns the position after the closing quote, or NULL on a syntax error */
+static const char* my_json_string(const char* p, char* out, size_t* len)
+{
+    char quote = *p++;
+    size_t pos = 0;
 
-    size_t tot_len            = sizeof(char*) * (arr.size() + 1);
-    const char** map_data_str = (const char**)lv_mem_alloc(tot_len);
-    if(map_data_str == NULL) {
-        LOG_ERROR(TAG_ATTR, F("Out of memory while creating button map"));
-        return NULL;
+    while(*p != quote) {
+        char c = *p++;
+        if(c == '\0') return NULL;
+
+        if(c == '\\') {
+            c = *p++;
+            switch(c) {
+                case '\0':
+                    return NULL;
+                case 'b':
+                    c = '\b';
+                    break;
+                case 'f':
+                    c = '\f';
+                    break;
+                case 'n':
+                    c = '\n';
+                    break;
+                case 'r':
+                    c = '\r';
+                    break;
+                case 't':
+                    c = '\t';
+                    break;
+                case 'u': {
+                    uint32_t cp, low;
+                    if(!my_json_hex4(p, &cp)) return NULL;
+                    p += 4;
+                    if(cp >= 0xD800 && cp < 0xDC00 && p[0] == '\\' && p[1] == 'u' && my_json_hex4(p + 2, &low) &&
+                       low >= 0xDC00 && low < 0xE000) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00); // surrogate pair
+                        p += 6;
+                    }
+
+                    uint8_t n = cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+                    if(out) {
+                        char* dst = out + pos;
+                        switch(n) {
+                            case 1:
+                                dst[0] = cp;
+                                break;
+                            case 2:
+                                dst[0] = 0xC0 | (cp >> 6);
+                                dst[1] = 0x80 | (cp & 0x3F);
+                                break;
+                            case 3:
+                                dst[0] = 0xE0 | (cp >> 12);
+                                dst[1] = 0x80 | ((cp >> 6) & 0x3F);
+                                dst[2] = 0x80 | (cp & 0x3F);
+                                break;
+                            default:
+                                dst[0] = 0xF0 | (cp >> 18);
+                                dst[1] = 0x80 | ((cp >> 12) & 0x3F);
+                                dst[2] = 0x80 | ((cp >> 6) & 0x3F);
+                                dst[3] = 0x80 | (cp & 0x3F);
+                        }
+                    }
+                    pos += n;
+                    continue;
+                }
+                default: // \" \' \\ \/
+                    break;
+            }
+        }
+
+        if(out) out[pos] = c;
+        pos++;
     }
-    memset(map_data_str, 0, tot_len);
 
-    // Create buffer
-    tot_len = 0;
-    for(JsonVariant btn : arr) {
-        tot_len += strlen(btn.as<const char*>()) + 1;
+    *len = pos;
+    return p + 1;
+}
+
+/* Parse a json array of strings into map, or only count the labels and the map size when map is NULL
+ * The map holds count + 1 label pointers followed by the labels and a final empty string */
+static bool my_map_parse(const char* payload, const char** map, uint16_t* count, size_t* size)
+{
+    char* text   = map ? (char*)(map + *count + 1) : NULL;
+    uint16_t idx = 0;
+    size_t pos   = 0;
+
+    const char* p = my_json_skip_ws(payload);
+    if(*p++ != '[') return false;
+
+    p = my_json_skip_ws(p);
+    if(*p != ']') {
+        while(true) {
+            size_t len;
+            if(*p != '"' && *p != '\'') return false;
+            if(!(p = my_json_string(p, text ? text + pos : NULL, &len))) return false;
+
+            if(map) {
+                text[pos + len] = '\0';
+                map[idx] = text + pos;
+            }
+            idx++;
+            pos += len + 1;
+
+            p = my_json_skip_ws(p);
+            if(*p == ']') break;
+            if(*p++ != ',') return false;
+            p = my_json_skip_ws(p);
+        }
     }
-    tot_len++; // trailing '\0'
-    LOG_VERBOSE(TAG_ATTR, F("Array Size = %d, Map Length = %d"), arr.size(), tot_len);
 
-    char* buffer_addr = (char*)lv_mem_alloc(tot_len);
-    if(buffer_addr == NULL) {
-        lv_mem_free(map_data_str);
-        LOG_ERROR(TAG_ATTR, F("Out of memory while creating button map"));
+    if(map) {
+        text[pos] = '\0';
+        map[idx]  = text + pos; // save pointer to the last \0 byte
+    }
+    *count = idx;
+    *size  = sizeof(char*) * (idx + 1) + pos + 1;
+    return true;
+}
+
+// Create new btnmatrix button map from json array, the current map is rewritten in place if it is large enough
+static const char** my_map_create(const char** current, const char* payload)
+{
+    uint16_t count;
+    size_t size;
+
+    /* Validate and size the map first, so the current map is kept on bad input */
+    if(!my_map_parse(payload, NULL, &count, &size)) {
+        LOG_ERROR(TAG_ATTR, F(D_JSON_FAILED " %s"), payload);
         return NULL;
     }
-    memset(buffer_addr, 0, tot_len); // Important, last index needs to be 0 => empty string ""
 
-    /* Point of no return, destroy & free the previous map */
-    LOG_DEBUG(TAG_ATTR, F("%s %d   map addr:  %x"), __FILE__, __LINE__, map_data_str);
-    // my_btnmatrix_map_clear(obj); // Free previous map
+    const char** map = current;
+    if(!my_map_is_owned(current) || _lv_mem_get_size(current) < size) {
+        map = (const char**)lv_mem_alloc(size);
+        if(map == NULL) {
+            LOG_ERROR(TAG_ATTR, F("Out of memory while creating button map"));
+            return NULL;
+        }
+    }
 
-    // Fill buffer
-    size_t index = 0;
-    size_t pos   = 0;
-    LOG_DEBUG(TAG_ATTR, F("%s %d   lbl addr:  %x"), __FILE__, __LINE__, buffer_addr);
-    for(JsonVariant btn : arr) {
-        // size_t len = btn.as<String>().length() + 1;
-        size_t len = strlen(btn.as<const char*>()) + 1;
-        LOG_VERBOSE(TAG_ATTR, F(D_BULLET "Adding button: %s (%d bytes) %x"), btn.as<const char*>(), len,
-                    buffer_addr + pos);
-        // LOG_VERBOSE(TAG_ATTR, F(D_BULLET "Adding button: %s (%d bytes) %x"), btn.as<String>().c_str(), len,
-        // buffer_addr + pos);
-        memccpy(buffer_addr + pos, btn.as<const char*>(), 0, len); // Copy the label text into the buffer
-        // memccpy(buffer_addr + pos, btn.as<String>().c_str(), 0, len); // Copy the label text into the buffer
-        map_data_str[index++] = buffer_addr + pos; // save pointer to the label in the array
-        pos += len;
-    }
-    map_data_str[index] = buffer_addr + pos; // save pointer to the last \0 byte
-
-    LOG_DEBUG(TAG_ATTR, F("%s %d"), __FILE__, __LINE__);
-    return map_data_str;
+    my_map_parse(payload, map, &count, &size);
+    LOG_VERBOSE(TAG_ATTR, F("Array Size = %d, Map Length = %d"), count, size);
+    return map;
 }
 
 static void my_btnmatrix_set_map(lv_obj_t* obj, const char* payload)
 {
-    LOG_DEBUG(TAG_ATTR, F("%s %d"), __FILE__, __LINE__);
-    const char** map = my_map_create(payload);
+    lv_btnmatrix_ext_t* ext = (lv_btnmatrix_ext_t*)lv_obj_get_ext_attr(obj);
+    const char** map        = my_map_create(ext->map_p, payload);
     if(!map) return;
 
-    LOG_DEBUG(TAG_ATTR, F("%s %d"), __FILE__, __LINE__);
-    my_btnmatrix_map_clear(obj); // Free previous map
-    LOG_DEBUG(TAG_ATTR, F("%s %d"), __FILE__, __LINE__);
+    if(map != ext->map_p) my_btnmatrix_map_clear(obj); // Free previous map
     lv_btnmatrix_set_map(obj, map);
-    LOG_DEBUG(TAG_ATTR, F("%s %d"), __FILE__, __LINE__);
 }
 
 static void my_msgbox_set_map(lv_obj_t* obj, const char* payload)
 {
-    LOG_DEBUG(TAG_ATTR, F("%s %d"), __FILE__, __LINE__);
-    const char** map = my_map_create(payload);
+    lv_msgbox_ext_t* ext = (lv_msgbox_ext_t*)lv_obj_get_ext_attr(obj);
+    const char** current = NULL;
+    if(ext->btnm) current = ((lv_btnmatrix_ext_t*)lv_obj_get_ext_attr(ext->btnm))->map_p;
+
+    const char** map = my_map_create(current, payload);
     if(!map) return;
 
-    LOG_DEBUG(TAG_ATTR, F("%s %d"), __FILE__, __LINE__);
-    my_msgbox_map_clear(obj); // Free previous map
-    LOG_DEBUG(TAG_ATTR, F("%s %d"), __FILE__, __LINE__);
+    if(map != current) my_msgbox_map_clear(obj); // Free previous map
     lv_msgbox_add_btns(obj, map);
-    LOG_DEBUG(TAG_ATTR, F("%s %d"), __FILE__, __LINE__);
 }
 
 void my_line_clear_points(lv_obj_t* obj)
@@ -193,56 +291,57 @@ void my_line_clear_points(lv_obj_t* obj)
     lv_mem_free(ptr);
 }
 
+static const char* my_json_coord(const char* p, lv_coord_t* value)
+{
+    char* end;
+    *value = (lv_coord_t)strtod(p, &end);
+    return end == p ? NULL : my_json_skip_ws(end);
+}
+
+// Parse [[x,y],[x,y],...] straight into the current point array, it only grows when more points are needed
 static bool my_line_set_points(lv_obj_t* obj, const char* payload)
 {
-    my_line_clear_points(obj); // delete pointmap
-
-    // count LEFT SQUARE BRACKET => nb points +1
-    uint16_t count = 0;
-    for (const char* p = payload; *p; p++) 
-        if (*p == '[') count++;
-    count--;
-    
-    // Reserve memory for JsonDocument rounded to upper 128 bytes
-    uint16_t maxsize = 128u * (3*JSON_ARRAY_SIZE(1)*count / 128+1) ;
-    
-    LOG_VERBOSE(TAG_ATTR,"payload: %s",payload);
-    LOG_TRACE(TAG_ATTR,"count: %u maxsize: %u taille brut %u",count,maxsize,(uint32_t)(3*JSON_ARRAY_SIZE(1)*count));
-
-    DynamicJsonDocument doc(maxsize);
-    DeserializationError jsonError = deserializeJson(doc, payload);
-
-    if(jsonError) { // Couldn't parse incoming JSON payload
-        dispatch_json_error(TAG_ATTR, jsonError);
-        return false;
-    }
-     LOG_VERBOSE(TAG_ATTR,"Memory usage: %u",(uint32_t)doc.memoryUsage());
-
-    JsonArray arr  = doc.as<JsonArray>(); // Parse payload
-    size_t tot_len = sizeof(lv_point_t*) * (arr.size());
-    if(tot_len == 0) return false; // bad input
-
-    lv_point_t* point_arr = (lv_point_t*)lv_mem_alloc(tot_len);
-    if(point_arr == NULL) {
-        LOG_ERROR(TAG_ATTR, F("Out of memory while creating line points"));
-        return false;
-    }
-    memset(point_arr, 0, tot_len);
-
-    size_t index = 0;
-    for(JsonVariant v : arr) {
-        JsonArray point = v.as<JsonArray>(); // Parse point
-        if(point.size() == 2) {
-            point_arr[index].x = point[0].as<int16_t>();
-            point_arr[index].y = point[1].as<int16_t>();
-            LOG_VERBOSE(TAG_ATTR, F(D_BULLET "Adding point %d: %d,%d"), index, point_arr[index].x, point_arr[index].y);
-            index++;
+    lv_line_ext_t* ext  = (lv_line_ext_t*)lv_obj_get_ext_attr(obj);
+    lv_point_t* points  = (lv_point_t*)ext->point_array;
+    uint32_t capacity   = points ? _lv_mem_get_size(points) / sizeof(lv_point_t) : 0;
+    uint16_t count      = 0;
+    const char* p       = my_json_skip_ws(payload);
+
+    if(*p++ != '[') goto error;
+    do {
+        p = my_json_skip_ws(p);
+        if(*p++ != '[') goto error;
+
+        if(count == capacity) {
+            if(count == UINT16_MAX) goto error;
+            capacity          = capacity < 8 ? 8 : capacity * 2;
+            if(capacity > UINT16_MAX) capacity = UINT16_MAX;
+            lv_point_t* grown = (lv_point_t*)lv_mem_realloc(points, capacity * sizeof(lv_point_t));
+            if(grown == NULL) {
+                LOG_ERROR(TAG_ATTR, F("Out of memory while creating line points"));
+                goto error;
+            }
+            points = grown; // the line keeps the freed array until lv_line_set_points below
         }
-    }
 
-    my_line_clear_points(obj);                 // free previous pointlist
-    lv_line_set_points(obj, point_arr, index); // arr.size());
+        lv_point_t* point = &points[count];
+        if(!(p = my_json_coord(my_json_skip_ws(p), &point->x)) || *p++ != ',') goto error;
+        if(!(p = my_json_coord(my_json_skip_ws(p), &point->y)) || *p++ != ']') goto error;
+        count++;
+
+        p = my_json_skip_ws(p);
+    } while(*p++ == ',');
+    if(p[-1] != ']') goto error;
+
+    LOG_VERBOSE(TAG_ATTR, F("Line points: %u"), count);
+    lv_line_set_points(obj, points, count);
     return true;
+
+error:
+    LOG_ERROR(TAG_ATTR, F(D_JSON_FAILED " %s"), payload);
+    lv_line_set_points(obj, NULL, 0); // bad input clears the line
+    lv_mem_free(points);
+    return false;
 }
 
 static lv_font_t* haspPayloadToFont(const char* payload)
@@ -2568,11 +2667,38 @@ static hasp_attribute_type_t attribute_common_bool(lv_obj_t* obj, uint16_t attr_
 
 // ##################### Default Attributes ########################################################
 
+/* While set, getters write the JSON value to this buffer instead of dispatching it, see hasp_get_obj_attribute */
+static char* attr_capture_buffer = NULL;
+static size_t attr_capture_size  = 0;
+static size_t attr_capture_len   = 0;
+
+static void attr_capture(const char* data, bool is_json)
+{
+    size_t len;
+    if(data && is_json) {
+        len = strlen(data);
+        if(len < attr_capture_size) memcpy(attr_capture_buffer, data, len + 1);
+    } else {
+        StaticJsonDocument<16> doc; // const char* is not copied
+        if(data)
+            doc.set(data);
+        else
+            doc.set(nullptr);
+        len = measureJson(doc);
+        if(len < attr_capture_size) serializeJson(doc, attr_capture_buffer, attr_capture_size);
+    }
+    attr_capture_len = len; // the buffer is left alone when it is too small
+}
+
 void attr_out(lv_obj_t* obj, const char* attribute, const char* data, bool is_json)
 {
     uint8_t pageid;
     uint8_t objid;
 
+    if(attr_capture_buffer) {
+        attr_capture(data, is_json);
+        return;
+    }
     if(!attribute || !hasp_find_id_from_obj(obj, &pageid, &objid)) return;
 
     size_t len = 10;
@@ -2625,6 +2751,14 @@ void attr_out_color(lv_obj_t* obj, const char* attribute, lv_color_t color)
     uint8_t pageid;
     uint8_t objid;
 
+    if(attr_capture_buffer) {
+        char buffer[16];
+        lv_color32_t c32;
+        c32.full = lv_color_to32(color);
+        snprintf_P(buffer, sizeof(buffer), PSTR("#%02x%02x%02x"), c32.ch.red, c32.ch.green, c32.ch.blue);
+        attr_capture(buffer, false);
+        return;
+    }
     if(!attribute || !hasp_find_id_from_obj(obj, &pageid, &objid)) return;
 
     const size_t size = 64 + strlen(attribute);
@@ -2904,7 +3038,7 @@ void hasp_process_obj_attribute(lv_obj_t* obj, const char* attribute, const char
     // Output the returned value or warning
     switch(ret) {
         case HASP_ATTR_TYPE_NOT_FOUND:
-            LOG_WARNING(TAG_ATTR, F(D_ATTRIBUTE_UNKNOWN " (%d)"), attribute, attr_hash);
+            if(!attr_capture_buffer) LOG_WARNING(TAG_ATTR, F(D_ATTRIBUTE_UNKNOWN " (%d)"), attribute, attr_hash);
             break;
 
         case HASP_ATTR_TYPE_INT_READONLY:
@@ -2958,3 +3092,24 @@ void hasp_process_obj_attribute(lv_obj_t* obj, const char* attribute, const char
             LOG_ERROR(TAG_ATTR, F(D_ERROR_UNKNOWN " (%d)"), ret);
     }
 }
+
+/**
+ * Retrieve the value of an attribute of an object as JSON text instead of dispatching it
+ * @param obj lv_obj_t*: the object to get the attribute from
+ * @param attribute char*: the attribute name
+ * @param buffer char*: receives the value as it would be dispatched, e.g. 10, "Text" or "#ff0000"
+ * @param size size_t: size of the buffer
+ * @return length of the value, 0 if the object has no such attribute, size or more if the value does not fit
+ */
+size_t hasp_get_obj_attribute(lv_obj_t* obj, const char* attribute, char* buffer, size_t size)
+{
+    if(!obj || !buffer || size == 0) return 0;
+
+    attr_capture_buffer = buffer;
+    attr_capture_size   = size;
+    attr_capture_len    = 0;
+    hasp_process_obj_attribute(obj, attribute, "", false);
+    attr_capture_buffer = NULL;
+
+    return attr_capture_len;
+}
@@ -28,6 +28,7 @@ void my_image_release_resources(lv_obj_t* obj);
 void my_obj_del_task(const lv_obj_t* obj);
 
 void hasp_process_obj_attribute(lv_obj_t* obj, const char* attr_p, const char* payload, bool update);
+size_t hasp_get_obj_attribute(lv_obj_t* obj, const char* attribute, char* buffer, size_t size);
 
 bool attribute_set_normalized_value(lv_obj_t* obj, hasp_update_value_t& value);
 
@@ -99,7 +99,7 @@ static void my_prune_ext_tags(lv_obj_t* obj)
 // create extended user_data properties object
 static hasp_ext_user_data_t* my_create_ext_tags(lv_obj_t* obj)
 {
-    void* ext          = hasp_calloc(1, sizeof(hasp_ext_user_data_t));
+    void* ext          = hasp_calloc_persistent(1, sizeof(hasp_ext_user_data_t));
     obj->user_data.ext = ext;
     return (hasp_ext_user_data_t*)ext;
 }
@@ -15,6 +15,7 @@
 #if HASP_USE_DEBUG > 0
 #include "../hasp_debug.h"
 #include "hasp_gui.h" // for screenshot
+#include "hasp_loop.h"
 
 #if HASP_TARGET_PC
 #include <iostream>
@@ -23,13 +24,20 @@
 #include <queue>
 #include <mutex>
 #include <string>
+#include <chrono>
 #include "../mqtt/hasp_mqtt.h"
 
 /* Deferred command queue: MQTT callback runs on Paho thread; jsonl/json handlers call LVGL
  * (hasp_new_object) which is not thread-safe. Queue jsonl/json for processing on main thread.
  * 64 is enough for burst layout + state; PC has plenty of memory. */
 #define DISPATCH_DEFERRED_QUEUE_MAX 64
-static std::queue<std::pair<std::string, std::string>> deferred_queue;
+struct dispatch_deferred_t
+{
+    std::string topic; // empty for a text line
+    std::string payload;
+    uint8_t source;
+};
+static std::queue<dispatch_deferred_t> deferred_queue;
 static std::mutex deferred_mutex;
 #else
 #include "StringStream.h"
@@ -37,6 +45,7 @@ static std::mutex deferred_mutex;
 #include "CharStream.h"
 
 #include "hasp_oobe.h"
+#include "hasp_fade.h"
 #include "sys/gpio/hasp_gpio.h"
 #include "hal/hasp_hal.h"
 
@@ -52,8 +61,14 @@ dispatch_conf_t dispatch_setings = {.teleperiod = 300};
 uint16_t dispatchSecondsToNextTeleperiod = 0;
 uint16_t dispatchSecondsToNextSensordata = 0;
 uint16_t dispatchSecondsToNextDiscovery  = 0;
-uint8_t nCommands                        = 0;
-haspCommand_t commands[29];
+
+/* Command registry: open hashing over a power-of-two bucket table, grown on demand */
+#define DISPATCH_COMMANDS_INITIAL 32
+static haspCommand_t* commands   = NULL;
+static int16_t* command_buckets  = NULL;
+static uint16_t nCommands        = 0;
+static uint16_t command_capacity = 0;
+static uint16_t bucket_mask      = 0;
 
 moodlight_t moodlight    = {.brightness = 255};
 uint8_t saved_jsonl_page = 0;
@@ -90,9 +105,7 @@ void dispatch_state_subtopic(const char* subtopic, const char* payload)
 
 #endif
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
-    custom_state_subtopic(subtopic, payload);
-#endif
+    plugin_state_subtopic(subtopic, payload);
 }
 
 void dispatch_state_eventid(const char* topic, hasp_event_t eventid)
@@ -319,6 +332,167 @@ static void dispatch_output(const char* topic, const char* payload)
 //     }
 // }
 
+/******************************************* Command registry *******************************************/
+
+/* Case-insensitive FNV-1a hash, p_str may live in PROGMEM */
+static uint32_t dispatch_command_hash(const char* p_str, bool progmem)
+{
+    uint32_t hash = 2166136261u;
+    for(;; p_str++) {
+#ifdef ARDUINO
+        char c = progmem ? (char)pgm_read_byte(p_str) : *p_str;
+#else
+        char c = *p_str;
+#endif
+        if(c == '\0') break;
+        hash ^= (uint8_t)tolower(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static inline uint32_t dispatch_micros()
+{
+#if HASP_TARGET_PC
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#else
+    return micros();
+#endif
+}
+
+/* Chain every command into a bucket table of at least twice the capacity */
+static bool dispatch_rehash_commands(uint16_t capacity)
+{
+    uint16_t buckets = 16;
+    while(buckets < capacity * 2) buckets <<= 1;
+
+    int16_t* table = command_buckets;
+    if(!table || buckets != bucket_mask + 1u) {
+        table = (int16_t*)hasp_malloc(buckets * sizeof(int16_t));
+        if(!table) return false;
+        hasp_free(command_buckets);
+    }
+
+    for(uint16_t i = 0; i < buckets; i++) table[i] = -1;
+    for(uint16_t i = 0; i < nCommands; i++) {
+        uint16_t bucket  = commands[i].hash & (buckets - 1);
+        commands[i].next = table[bucket];
+        table[bucket]    = i;
+    }
+
+    command_buckets = table;
+    bucket_mask     = buckets - 1;
+    return true;
+}
+
+static bool dispatch_grow_commands()
+{
+    uint16_t capacity = command_capacity ? command_capacity * 2 : DISPATCH_COMMANDS_INITIAL;
+
+    haspCommand_t* table = (haspCommand_t*)hasp_realloc(commands, capacity * sizeof(haspCommand_t));
+    if(!table) return false;
+
+    commands         = table;
+    command_capacity = capacity;
+    return dispatch_rehash_commands(capacity);
+}
+
+/* Returns the index of the command or -1, unknown topics normally end on the first probe */
+static int16_t dispatch_find_command(const char* topic)
+{
+    if(!command_buckets) return -1;
+
+    uint32_t hash = dispatch_command_hash(topic, false);
+    for(int16_t i = command_buckets[hash & bucket_mask]; i >= 0; i = commands[i].next) {
+        if(commands[i].hash == hash && !strcasecmp_P(topic, commands[i].p_cmdstr)) return i;
+    }
+    return -1;
+}
+
+/* Register a command handler, an existing command with the same name is replaced */
+bool dispatch_add_command(const char* p_cmdstr, dispatch_cmd_cb_t func, uint8_t args)
+{
+    int16_t index = dispatch_find_command(p_cmdstr);
+    if(index >= 0) {
+        commands[index].p_cmdstr = p_cmdstr;
+        commands[index].func     = func;
+        commands[index].args     = args;
+        return true;
+    }
+
+    if(nCommands >= command_capacity && !dispatch_grow_commands()) {
+        LOG_ERROR(TAG_MSGR, F("CMD_OVERFLOW %d"), nCommands);
+        return false;
+    }
+
+    haspCommand_t& command = commands[nCommands];
+    command.p_cmdstr       = p_cmdstr;
+    command.func           = func;
+    command.hash           = dispatch_command_hash(p_cmdstr, true);
+    command.args           = args;
+    command.count          = 0;
+    command.time_us        = 0;
+
+    uint16_t bucket          = command.hash & bucket_mask;
+    command.next             = command_buckets[bucket];
+    command_buckets[bucket]  = nCommands++;
+    return true;
+}
+
+bool dispatch_remove_command(const char* p_cmdstr)
+{
+    int16_t index = dispatch_find_command(p_cmdstr);
+    if(index < 0) return false;
+
+    // Move the last command into the gap and rebuild the chains
+    nCommands--;
+    if(index != nCommands) commands[index] = commands[nCommands];
+    return dispatch_rehash_commands(command_capacity);
+}
+
+/* Bitmask of the DISPATCH_ARG_* kinds the payload satisfies */
+static uint8_t dispatch_payload_kind(const char* payload)
+{
+    if(payload[0] == '\0') return DISPATCH_ARG_NONE;
+
+    const char* json = payload;
+    while(isspace((unsigned char)*json)) json++; // deserializeJson skips leading whitespace too
+    if(json[0] == '{' || json[0] == '[') return DISPATCH_ARG_JSON | DISPATCH_ARG_TEXT;
+
+    uint8_t kind = DISPATCH_ARG_TEXT;
+    if(Parser::is_only_digits(payload[0] == '-' ? payload + 1 : payload)) kind |= DISPATCH_ARG_NUMBER;
+    if(Parser::is_true(payload) || !strcasecmp_P(payload, PSTR("off")) || !strcasecmp_P(payload, PSTR("false")) ||
+       !strcasecmp_P(payload, PSTR("no")) || !strcmp_P(payload, PSTR("0")))
+        kind |= DISPATCH_ARG_BOOL;
+    return kind;
+}
+
+static void dispatch_exec_command(haspCommand_t& command, const char* topic, const char* payload, uint8_t source)
+{
+    if(command.args != DISPATCH_ARG_ANY && !(dispatch_payload_kind(payload) & command.args)) {
+        LOG_WARNING(TAG_MSGR, F(D_DISPATCH_INVALID_PAYLOAD " => %s"), topic, payload);
+        return;
+    }
+
+    uint32_t start = dispatch_micros();
+    command.func(topic, payload, source); /* execute command */
+    command.time_us += dispatch_micros() - start;
+    command.count++;
+}
+
+void dispatch_get_command_stats(JsonObject& info)
+{
+    char value[32];
+    for(uint16_t i = 0; i < nCommands; i++) {
+        if(commands[i].count == 0) continue;
+        snprintf_P(value, sizeof(value), PSTR("%u x %u.%03u ms"), commands[i].count, commands[i].time_us / 1000,
+                   commands[i].time_us % 1000);
+        info[commands[i].p_cmdstr] = value;
+    }
+}
+
 // objectattribute=value
 static void dispatch_command(const char* topic, const char* payload, bool update, uint8_t source)
 {
@@ -326,13 +500,11 @@ static void dispatch_command(const char* topic, const char* payload, bool update
 
     if(dispatch_parse_button_attribute(topic, payload, update)) return; // matched pxby.attr, first for speed
 
-    // check and execute commands from commands array
-    for(int i = 0; i < nCommands; i++) {
-        if(!strcasecmp_P(topic, commands[i].p_cmdstr)) {
-            // LOG_DEBUG(TAG_MSGR, F("Command %d found in array !!!"), i);
-            commands[i].func(topic, payload, source); /* execute command */
-            return;
-        }
+    // check and execute commands from the registry
+    int16_t index = dispatch_find_command(topic);
+    if(index >= 0) {
+        dispatch_exec_command(commands[index], topic, payload, source);
+        return;
     }
 
     /* =============================== Not standard payload commands ===================================== */
@@ -343,32 +515,6 @@ static void dispatch_command(const char* topic, const char* payload, bool update
     } else if(topic == strstr_P(topic, PSTR("input"))) {
         dispatch_input(topic + 5, payload);
 
-        // } else if(strcasecmp_P(topic, PSTR("screenshot")) == 0) {
-        //     guiTakeScreenshot("/screenshot.bmp"); // Literal String
-
-#if HASP_USE_CONFIG > 0
-
-#if HASP_USE_WIFI > 0
-    } else if(!strcmp_P(topic, FP_CONFIG_SSID) || !strcmp_P(topic, FP_CONFIG_PASS)) {
-        StaticJsonDocument<64> settings;
-        settings[topic] = payload;
-        wifiSetConfig(settings.as<JsonObject>());
-#endif // HASP_USE_WIFI
-
-#if HASP_USE_MQTT > 0
-    } else if(!strcmp_P(topic, PSTR("mqtthost")) || !strcmp_P(topic, PSTR("mqttport")) ||
-              !strcmp_P(topic, PSTR("mqttuser")) || !strcmp_P(topic, PSTR("mqttpass")) ||
-              !strcmp_P(topic, PSTR("hostname"))) {
-        // char item[5];
-        // memset(item, 0, sizeof(item));
-        // strncpy(item, topic + 4, 4);
-
-        StaticJsonDocument<64> settings;
-        settings[topic + 4] = payload;
-        mqttSetConfig(settings.as<JsonObject>());
-#endif // HASP_USE_MQTT
-
-#endif // HASP_USE_CONFIG
     } else {
         if(strlen(payload) == 0) {
             //    dispatch_simple_text_command(topic); // Could cause an infinite loop!
@@ -443,6 +589,8 @@ static void dispatch_simple_text_command(const char* cmnd, uint8_t source)
 // Strip command/config prefix from the topic and process the payload
 void dispatch_topic_payload(const char* topic, const char* payload, bool update, uint8_t source)
 {
+    GuiLock lock("dispatch"); // commands come in from other threads too
+
     if(!strcmp_P(topic, PSTR(MQTT_TOPIC_COMMAND)) || topic[0] == '\0') {
         dispatch_simple_text_command((char*)payload, source);
         return;
@@ -462,31 +610,41 @@ void dispatch_topic_payload(const char* topic, const char* payload, bool update,
     }
 #endif
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
     if(topic == strstr_P(topic, PSTR(MQTT_TOPIC_CUSTOM "/"))) { // startsWith custom
         topic += 7u;
-        custom_topic_payload(topic, (char*)payload, source);
+        if(!plugin_topic_payload(topic, (char*)payload, source))
+            LOG_WARNING(TAG_MSGR, F("No plugin handles " MQTT_TOPIC_CUSTOM "/%s"), topic);
         return;
     }
-#endif
 
     dispatch_command(topic, (char*)payload, update, source); // dispatch as is
 }
 
 #if HASP_TARGET_PC
-void dispatch_defer_command(const char* topic, const char* payload)
+static void dispatch_defer(const char* topic, const char* payload, uint8_t source)
 {
     std::lock_guard<std::mutex> lock(deferred_mutex);
     if(deferred_queue.size() >= DISPATCH_DEFERRED_QUEUE_MAX) {
         (void)deferred_queue.front();
         deferred_queue.pop(); // drop oldest
     }
-    deferred_queue.push({std::string(topic), std::string(payload)});
+    deferred_queue.push({std::string(topic), std::string(payload), source});
+    loop_wake(); // handle it on the main loop now
+}
+
+void dispatch_defer_command(const char* topic, const char* payload)
+{
+    dispatch_defer(topic, payload, TAG_MQTT);
+}
+
+void dispatch_defer_text_line(const char* cmnd, uint8_t source)
+{
+    dispatch_defer("", cmnd, source);
 }
 
 void dispatch_process_deferred(void)
 {
-    std::pair<std::string, std::string> item;
+    dispatch_deferred_t item;
     for(;;) {
         {
             std::lock_guard<std::mutex> lock(deferred_mutex);
@@ -494,8 +652,12 @@ void dispatch_process_deferred(void)
             item = deferred_queue.front();
             deferred_queue.pop();
         }
-        bool update = item.second.size() > 0;
-        dispatch_topic_payload(item.first.c_str(), item.second.c_str(), update, TAG_MQTT);
+        if(item.topic.empty()) {
+            dispatch_text_line(item.payload.c_str(), item.source);
+        } else {
+            bool update = item.payload.size() > 0;
+            dispatch_topic_payload(item.topic.c_str(), item.payload.c_str(), update, item.source);
+        }
     }
 }
 #endif
@@ -991,7 +1153,7 @@ void dispatch_shell_execute(const char*, const char* payload, uint8_t source)
 {
     // must duplicate the string for thread's own usage
     char* command = strdup(payload);
-    haspDevice.run_thread((void (*)(void*))shell_command_thread, (void*)command);
+    haspDevice.run_thread((void (*)(void*))shell_command_thread, (void*)command, "shell");
 }
 #endif
 
@@ -1106,6 +1268,58 @@ void dispatch_clear_font(const char*, const char* payload, uint8_t source)
     font_clear_list(payload);
 }
 
+// Writes the live objects as jsonl, payload is an optional page number and an optional file, e.g. "2 /page2.jsonl"
+static void dispatch_export_pages(const char*, const char* payload, uint8_t source)
+{
+    uint8_t first = 0;
+    uint8_t last  = HASP_NUM_PAGES;
+
+    while(*payload == ' ') payload++;
+    if(isdigit(*payload)) {
+        int pageid = atoi(payload);
+        if(pageid != 0 && (pageid > HASP_NUM_PAGES || !haspPages.is_valid(pageid))) {
+            LOG_WARNING(TAG_MSGR, F(D_HASP_INVALID_PAGE), (unsigned)pageid);
+            return;
+        }
+        first = last = pageid;
+        while(isdigit(*payload)) payload++;
+        while(*payload == ' ') payload++;
+    }
+
+    hasp_export_jsonl(first, last, payload); // an empty filename streams to the export state topic
+}
+
+// Loads a jsonl file like the pages file at boot
+static void dispatch_load_pages(const char*, const char* payload, uint8_t source)
+{
+    if(payload[0] == 'L' && payload[1] == ':') payload += 2; // strip littlefs drive letter
+    haspPages.load_jsonl(payload, false); // only the pages file is indexed for lazy pages
+}
+
+#if HASP_USE_FREETYPE > 0
+// Show or change the FreeType glyph cache, e.g. {"bytes":65536,"warmup":1} or "reset" to clear the statistics
+void dispatch_font_cache(const char* topic, const char* payload, uint8_t source)
+{
+    if(!strcasecmp_P(payload, PSTR("reset"))) {
+        font_reset_stats();
+    } else if(strlen(payload) > 0) {
+        StaticJsonDocument<128> json;
+        DeserializationError jsonError = deserializeJson(json, payload);
+        if(!jsonError && json.is<JsonObject>()) {
+            font_set_cache(json.as<JsonObject>());
+        } else {
+            LOG_WARNING(TAG_MSGR, F(D_DISPATCH_INVALID_PAYLOAD " => %s"), topic, payload);
+        }
+    }
+
+    char subtopic[10];
+    char buffer[160];
+    memcpy_P(subtopic, PSTR("fontcache"), 10);
+    font_get_cache_state(buffer, sizeof(buffer));
+    dispatch_state_subtopic(subtopic, buffer);
+}
+#endif
+
 void dispatch_dim(const char*, const char* level)
 {
     // Set the current state
@@ -1119,6 +1333,18 @@ void dispatch_dim(const char*, const char* level)
     dispatch_state_subtopic(topic, payload);
 }
 
+static void dispatch_moodlight_state()
+{
+    char buffer[128];
+    char out_topic[16];
+    memcpy_P(out_topic, PSTR("moodlight"), 10);
+    snprintf_P(buffer, sizeof(buffer),
+               PSTR("{\"state\":\"%s\",\"brightness\":%u,\"color\":\"#%02x%02x%02x\",\"r\":%u,\"g\":%u,\"b\":%u}"),
+               moodlight.power ? "on" : "off", moodlight.brightness, moodlight.rgbww[0], moodlight.rgbww[1],
+               moodlight.rgbww[2], moodlight.rgbww[0], moodlight.rgbww[1], moodlight.rgbww[2]);
+    dispatch_state_subtopic(out_topic, buffer);
+}
+
 void dispatch_moodlight(const char* topic, const char* payload, uint8_t source)
 {
     // Set the current state
@@ -1133,6 +1359,11 @@ void dispatch_moodlight(const char* topic, const char* payload, uint8_t source)
         if(jsonError) { // Couldn't parse incoming JSON command
             dispatch_json_error(TAG_MSGR, jsonError);
         } else {
+#if HASP_USE_GPIO > 0
+            moodlight_t from = moodlight;
+            fade_moodlight_output(from); // continue from the current values of a running transition
+#endif
+
             JsonVariant state = json[F("state")];
             if(!state.isNull()) moodlight.power = Parser::is_true(state);
 
@@ -1151,20 +1382,20 @@ void dispatch_moodlight(const char* topic, const char* payload, uint8_t source)
             }
 
 #if HASP_USE_GPIO > 0
+            uint32_t transition = json[F("transition")].as<float>() * 1000; // seconds
+            if(transition > 0) {
+                fade_moodlight(from, moodlight, transition, dispatch_moodlight_state);
+                return; // the state is published at the end of the transition
+            }
+
+            fade_moodlight_stop();
             gpio_set_moodlight(moodlight);
 #endif
         }
     }
 
     // Return the current state
-    char buffer[128];
-    char out_topic[16];
-    memcpy_P(out_topic, PSTR("moodlight"), 10);
-    snprintf_P(buffer, sizeof(buffer),
-               PSTR("{\"state\":\"%s\",\"brightness\":%u,\"color\":\"#%02x%02x%02x\",\"r\":%u,\"g\":%u,\"b\":%u}"),
-               moodlight.power ? "on" : "off", moodlight.brightness, moodlight.rgbww[0], moodlight.rgbww[1],
-               moodlight.rgbww[2], moodlight.rgbww[0], moodlight.rgbww[1], moodlight.rgbww[2]);
-    dispatch_state_subtopic(out_topic, buffer);
+    dispatch_moodlight_state();
 }
 
 // void dispatch_backlight_obsolete(const char* topic, const char* payload, uint8_t source)
@@ -1174,10 +1405,45 @@ void dispatch_moodlight(const char* topic, const char* payload, uint8_t source)
 //     dispatch_backlight(topic, payload, source);
 // }
 
+static struct
+{
+    bool power;
+    uint8_t level;
+} backlight_target; // state at the end of the running transition
+
+static void dispatch_backlight_state()
+{
+    char topic[10];
+    memcpy_P(topic, PSTR("backlight"), 10);
+    dispatch_state_brightness(topic, (hasp_event_t)haspDevice.get_backlight_power(), haspDevice.get_backlight_level());
+}
+
+static void dispatch_backlight_faded()
+{
+    if(!backlight_target.power) {
+        haspDevice.set_backlight_power(false);
+        hasp_set_wakeup_touch(true);
+    }
+    haspDevice.set_backlight_level(backlight_target.level); // level to return to when powered on again
+    dispatch_backlight_state();
+}
+
 void dispatch_backlight(const char*, const char* payload, uint8_t source)
 {
-    bool power    = haspDevice.get_backlight_power();
-    uint8_t level = haspDevice.get_backlight_level();
+    bool power          = haspDevice.get_backlight_power();
+    uint8_t level       = haspDevice.get_backlight_level();
+    uint32_t transition = 0;
+
+    if(strlen(payload) == 0) { // only return the current state, also during a transition
+        dispatch_backlight_state();
+        return;
+    }
+
+    // Changes are relative to the end state of a running transition
+    if(fade_backlight_active()) {
+        power = backlight_target.power;
+        level = backlight_target.level;
+    }
 
     // Set the current state
     if(strlen(payload) != 0) {
@@ -1219,10 +1485,26 @@ void dispatch_backlight(const char*, const char* payload, uint8_t source)
 
                 if(!state.isNull()) power = Parser::is_true(state);
                 if(!brightness.isNull()) level = brightness.as<uint8_t>();
+                transition = json[F("transition")].as<float>() * 1000; // seconds
             }
         }
     }
 
+    if(transition > 0) {
+        uint8_t from = haspDevice.get_backlight_power() ? haspDevice.get_backlight_level() : 0;
+        if(power && !haspDevice.get_backlight_power()) {
+            haspDevice.set_backlight_level(0);
+            haspDevice.set_backlight_power(true);
+            hasp_set_wakeup_touch(false);
+        }
+
+        backlight_target.power = power;
+        backlight_target.level = level;
+        fade_backlight(from, power ? level : 0, transition, dispatch_backlight_faded);
+        return; // the state is published at the end of the transition
+    }
+    fade_backlight_stop();
+
     // toggle power and wakeup touch if changed
     if(power) haspDevice.set_backlight_level(level); // set level before power on
     if(haspDevice.get_backlight_power() != power) {
@@ -1232,9 +1514,7 @@ void dispatch_backlight(const char*, const char* payload, uint8_t source)
     if(!power) haspDevice.set_backlight_level(level); // set level after power off
 
     // Return the current state
-    char topic[10];
-    memcpy_P(topic, PSTR("backlight"), 10);
-    dispatch_state_brightness(topic, (hasp_event_t)haspDevice.get_backlight_power(), haspDevice.get_backlight_level());
+    dispatch_backlight_state();
 }
 
 void dispatch_web_update(const char*, const char* espOtaUrl, uint8_t source)
@@ -1248,7 +1528,7 @@ void dispatch_web_update(const char*, const char* espOtaUrl, uint8_t source)
 void dispatch_antiburn(const char*, const char* payload, uint8_t source)
 {
     if(strlen(payload) >= 0) {
-        StaticJsonDocument<128> json;
+        StaticJsonDocument<256> json;
 
         // Note: Deserialization needs to be (const char *) so the objects WILL be copied
         // this uses more memory but otherwise the mqtt receive buffer can get overwritten by the send buffer !!
@@ -1258,6 +1538,8 @@ void dispatch_antiburn(const char*, const char* payload, uint8_t source)
         uint32_t period = 1000;
         bool state      = false;
 
+        hasp_set_antiburn_pattern(HASP_ANTIBURN_NOISE, 100, 0); // defaults
+
         if(jsonError) { // Couldn't parse incoming payload as json
             state = Parser::is_true(payload);
         } else {
@@ -1270,6 +1552,30 @@ void dispatch_antiburn(const char*, const char* payload, uint8_t source)
             } else { // other text
                 JsonVariant key = json[F("state")];
                 if(!key.isNull()) state = Parser::is_true(key);
+
+                uint8_t mode     = HASP_ANTIBURN_NOISE;
+                const char* name = json[F("mode")].as<const char*>();
+                if(name) {
+                    if(!strcasecmp_P(name, PSTR("invert")))
+                        mode = HASP_ANTIBURN_INVERT;
+                    else if(!strcasecmp_P(name, PSTR("gradient")))
+                        mode = HASP_ANTIBURN_GRADIENT;
+                }
+
+                key = json[F("period")];
+                if(key.is<uint32_t>() && key.as<uint32_t>() > 0) period = key.as<uint32_t>();
+
+                key = json[F("duration")]; // in seconds
+                if(key.is<uint32_t>()) count = key.as<uint32_t>() * 1000 / period;
+                if(count < 1) count = 1;
+
+                int duty = json[F("duty")] | 100; // percent of the period the display bus can be used
+                if(duty < 1 || duty > 100) {
+                    LOG_WARNING(TAG_MSGR, F("Invalid antiburn duty %d, using %d"), duty, duty < 1 ? 1 : 100);
+                    duty = duty < 1 ? 1 : 100;
+                }
+
+                hasp_set_antiburn_pattern(mode, duty, json[F("rate")] | 0);
             }
         }
         hasp_set_antiburn(state ? count : 0, period); // ON = 30 cycles of 1000 milli seconds (i.e. 30 sec)
@@ -1340,9 +1646,7 @@ void dispatch_send_sensordata(const char*, const char*, uint8_t source)
 
     haspDevice.get_sensors(doc);
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
-    custom_get_sensors(doc);
-#endif
+    plugin_get_sensors(doc);
 
     //     JsonObject input = doc.createNestedObject(F("input"));
     //     JsonArray relay  = doc.createNestedArray(F("power"));
@@ -1648,29 +1952,64 @@ void dispatch_service(const char*, const char* payload, uint8_t source)
 #endif
 }
 
+#if LV_USE_FS_IF
+void dispatch_unzip(const char*, const char* filename, uint8_t source)
+{
+    filesystem_unzip(filename);
+}
+#endif
+
 /******************************************* Commands builder *******************************************/
 
-static void dispatch_add_command(const char* p_cmdstr, void (*func)(const char*, const char*, uint8_t))
+#if HASP_USE_CONFIG > 0 && (HASP_USE_WIFI > 0 || HASP_USE_MQTT > 0)
+/* The settings key of a config command, the topic is matched case-insensitive so take the registered name */
+static bool dispatch_config_key(const char* topic, char* key, size_t size)
 {
-    if(nCommands >= sizeof(commands) / sizeof(haspCommand_t)) {
-        LOG_FATAL(TAG_MSGR, F("CMD_OVERFLOW %d"), nCommands); // Needs to be in curly braces
-    } else {
-        commands[nCommands].p_cmdstr = p_cmdstr;
-        commands[nCommands].func     = func;
-        nCommands++;
-    }
+    int16_t index = dispatch_find_command(topic);
+    if(index < 0) return false;
+
+    strncpy_P(key, commands[index].p_cmdstr, size - 1);
+    key[size - 1] = '\0';
+    for(char* c = key; *c; c++) *c = tolower(*c);
+    return true;
 }
+#endif
+
+#if HASP_USE_CONFIG > 0
+#if HASP_USE_WIFI > 0
+static void dispatch_wifi_config(const char* topic, const char* payload, uint8_t source)
+{
+    char key[16];
+    if(!dispatch_config_key(topic, key, sizeof(key))) return;
+
+    StaticJsonDocument<64> settings;
+    settings[key] = payload;
+    wifiSetConfig(settings.as<JsonObject>());
+}
+#endif // HASP_USE_WIFI
+
+#if HASP_USE_MQTT > 0
+static void dispatch_mqtt_config(const char* topic, const char* payload, uint8_t source)
+{
+    char key[16];
+    if(!dispatch_config_key(topic, key, sizeof(key))) return;
+
+    StaticJsonDocument<64> settings;
+    settings[key + 4] = payload; // strip mqtt or host prefix
+    mqttSetConfig(settings.as<JsonObject>());
+}
+#endif // HASP_USE_MQTT
+#endif // HASP_USE_CONFIG
 
 void dispatchSetup()
 {
-    // In order of importance : commands are NOT case-sensitive
+    // Commands are NOT case-sensitive, other modules can add their own using dispatch_add_command()
     // The command.func() call will receive the full topic and payload parameters!
 
     LOG_TRACE(TAG_MSGR, F(D_SERVICE_STARTING));
 
-    /* WARNING: remember to expand the commands array when adding new commands */
-    dispatch_add_command(PSTR("json"), dispatch_parse_json);
-    dispatch_add_command(PSTR("jsonl"), dispatch_parse_jsonl);
+    dispatch_add_command(PSTR("json"), dispatch_parse_json, DISPATCH_ARG_JSON);
+    dispatch_add_command(PSTR("jsonl"), dispatch_parse_jsonl, DISPATCH_ARG_JSON);
     dispatch_add_command(PSTR("page"), dispatch_page);
     dispatch_add_command(PSTR("backlight"), dispatch_backlight);
     dispatch_add_command(PSTR("moodlight"), dispatch_moodlight);
@@ -1679,6 +2018,12 @@ void dispatchSetup()
     dispatch_add_command(PSTR("statusupdate"), dispatch_statusupdate);
     dispatch_add_command(PSTR("clearpage"), dispatch_clear_page);
     dispatch_add_command(PSTR("clearfont"), dispatch_clear_font);
+    dispatch_add_command(PSTR("pages/export"), dispatch_export_pages, DISPATCH_ARG_NONE | DISPATCH_ARG_TEXT);
+    dispatch_add_command(PSTR("pages/load"), dispatch_load_pages, DISPATCH_ARG_TEXT);
+#if HASP_USE_FREETYPE > 0
+    dispatch_add_command(PSTR("fontcache"), dispatch_font_cache,
+                         DISPATCH_ARG_NONE | DISPATCH_ARG_JSON | DISPATCH_ARG_TEXT);
+#endif
     dispatch_add_command(PSTR("sensors"), dispatch_send_sensordata);
     dispatch_add_command(PSTR("theme"), dispatch_theme);
     dispatch_add_command(PSTR("run"), dispatch_run_script);
@@ -1687,7 +2032,8 @@ void dispatchSetup()
     dispatch_add_command(PSTR("shell"), dispatch_shell_execute);
 #endif
     dispatch_add_command(PSTR("service"), dispatch_service);
-    dispatch_add_command(PSTR("antiburn"), dispatch_antiburn);
+    dispatch_add_command(PSTR("antiburn"), dispatch_antiburn,
+                         DISPATCH_ARG_NONE | DISPATCH_ARG_BOOL | DISPATCH_ARG_NUMBER | DISPATCH_ARG_JSON);
     dispatch_add_command(PSTR("calibrate"), dispatch_calibrate);
     dispatch_add_command(PSTR("update"), dispatch_web_update);
     dispatch_add_command(PSTR("reboot"), dispatch_reboot);
@@ -1702,15 +2048,26 @@ void dispatchSetup()
     // dispatch_add_command(PSTR("light"), dispatch_backlight_obsolete);
     dispatch_add_command(PSTR("wakeup"), dispatch_wakeup_obsolete); // used in CC
 
-#if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
-#if defined(ARDUINO_ARCH_ESP32)
-    dispatch_add_command(PSTR("unzip"), filesystemUnzip);
-#endif
+#if LV_USE_FS_IF
+    dispatch_add_command(PSTR("unzip"), dispatch_unzip);
 #endif
 #if HASP_USE_CONFIG > 0 && HASP_TARGET_ARDUINO
     dispatch_add_command(PSTR("setupap"), oobeFakeSetup);
 #endif
-    /* WARNING: remember to expand the commands array when adding new commands */
+
+#if HASP_USE_CONFIG > 0
+#if HASP_USE_WIFI > 0
+    dispatch_add_command(FP_CONFIG_SSID, dispatch_wifi_config);
+    dispatch_add_command(FP_CONFIG_PASS, dispatch_wifi_config);
+#endif
+#if HASP_USE_MQTT > 0
+    dispatch_add_command(PSTR("mqtthost"), dispatch_mqtt_config);
+    dispatch_add_command(PSTR("mqttport"), dispatch_mqtt_config);
+    dispatch_add_command(PSTR("mqttuser"), dispatch_mqtt_config);
+    dispatch_add_command(PSTR("mqttpass"), dispatch_mqtt_config);
+    dispatch_add_command(PSTR("hostname"), dispatch_mqtt_config);
+#endif
+#endif
 
     LOG_INFO(TAG_MSGR, F(D_SERVICE_STARTED));
 }
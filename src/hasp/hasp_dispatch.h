@@ -47,6 +47,16 @@ enum hasp_event_t { // even = released, odd = pressed
     HASP_EVENT_CHANGED = 32
 };
 
+/* Payload kinds a command accepts, checked before the handler is called */
+#define DISPATCH_ARG_NONE 0x01   // empty payload
+#define DISPATCH_ARG_BOOL 0x02   // on/off, true/false, yes/no, 0/1
+#define DISPATCH_ARG_NUMBER 0x04 // integer
+#define DISPATCH_ARG_JSON 0x08   // object or array
+#define DISPATCH_ARG_TEXT 0x10   // anything else
+#define DISPATCH_ARG_ANY 0xFF
+
+typedef void (*dispatch_cmd_cb_t)(const char* topic, const char* payload, uint8_t source);
+
 /* ===== Default Event Processors ===== */
 void dispatchSetup(void);
 IRAM_ATTR void dispatchLoop(void);
@@ -96,6 +106,7 @@ void dispatch_normalized_group_values(hasp_update_value_t& value);
 #if HASP_TARGET_PC
 /* Defer json/jsonl from MQTT thread to main (LVGL) thread to avoid segfault (PC/SDL2 only). */
 void dispatch_defer_command(const char* topic, const char* payload);
+void dispatch_defer_text_line(const char* cmnd, uint8_t source);
 void dispatch_process_deferred(void);
 #endif
 
@@ -105,16 +116,26 @@ void dispatch_state_brightness(const char* topic, hasp_event_t eventid, int32_t
 void dispatch_state_val(const char* topic, hasp_event_t eventid, int32_t val);
 void dispatch_state_antiburn(hasp_event_t eventid);
 
+/* ===== Command Registry ===== */
+bool dispatch_add_command(const char* p_cmdstr, dispatch_cmd_cb_t func, uint8_t args = DISPATCH_ARG_ANY);
+bool dispatch_remove_command(const char* p_cmdstr);
+
 /* ===== Getter and Setter Functions ===== */
 void dispatch_get_discovery_data(JsonDocument& doc);
+void dispatch_get_command_stats(JsonObject& info);
 
 /* ===== Read/Write Configuration ===== */
 
 /* ===== Structs and Constants ===== */
 struct haspCommand_t
 {
-    const char* p_cmdstr;
-    void (*func)(const char*, const char*, uint8_t);
+    const char* p_cmdstr; // PROGMEM name, compared case-insensitive
+    dispatch_cmd_cb_t func;
+    uint32_t hash;    // case-insensitive hash of p_cmdstr
+    int16_t next;     // next command in the same hash bucket, -1 = end of chain
+    uint8_t args;     // DISPATCH_ARG_* mask
+    uint32_t count;   // number of invocations
+    uint32_t time_us; // cumulative handler time
 };
 
 #endif
\ No newline at end of file
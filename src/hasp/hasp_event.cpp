@@ -25,6 +25,10 @@
 #include <time.h>
 #include <sys/time.h>
 
+#if !defined(ARDUINO_ARCH_ESP8266)
+#include <atomic>
+#endif
+
 #include "hasplib.h"
 
 #include "lv_core/lv_obj.h" // for tabview ext
@@ -277,6 +281,25 @@ static void event_send_object_data(lv_obj_t* obj, const char* data)
     }
 }
 
+// Keep a value changed by the user, so the object gets it back when an evicted page is rebuilt
+static void event_retain(lv_obj_t* obj, const char* attr, const char* payload)
+{
+#if HASP_USE_LAZY_PAGES > 0
+    uint8_t pageid;
+    uint8_t objid;
+    if(hasp_find_id_from_obj(obj, &pageid, &objid)) haspPages.retain(pageid, objid, attr, payload);
+#endif
+}
+
+static void event_retain_val(lv_obj_t* obj, int val)
+{
+#if HASP_USE_LAZY_PAGES > 0
+    char buffer[12];
+    snprintf_P(buffer, sizeof(buffer), PSTR("%d"), val);
+    event_retain(obj, "val", buffer);
+#endif
+}
+
 // Send out events with a val attribute
 static void event_object_val_event(lv_obj_t* obj, uint8_t eventid, int16_t val)
 {
@@ -432,6 +455,67 @@ void swipe_event_handler(lv_obj_t* obj, lv_event_t event)
     }
 }
 
+/* Gestures are recognized in the input device read of lvgl, the driver only queues them and the main loop
+ * publishes them. Each index is written by one side only. */
+#define GESTURE_QUEUE_SIZE 4
+static const char* volatile gesture_queue[GESTURE_QUEUE_SIZE];
+#if defined(ARDUINO_ARCH_ESP8266)
+static volatile uint8_t gesture_head = 0; // single core and the lx106 has no atomics
+static volatile uint8_t gesture_tail = 0;
+#else
+static std::atomic<uint8_t> gesture_head(0); // written by the touch driver
+static std::atomic<uint8_t> gesture_tail(0); // written by the main loop
+#endif
+
+/**
+ * Called by a multi-point touch driver when it recognized a gesture
+ * @param gesture name of the gesture, e.g. pinch_in or left2, must be a static string
+ */
+IRAM_ATTR void gesture_event_handler(const char* gesture)
+{
+    uint8_t head = gesture_head;
+    uint8_t next = (head + 1) % GESTURE_QUEUE_SIZE;
+    if(next == gesture_tail) return; // the main loop fell behind, drop the gesture
+
+    gesture_queue[head] = gesture;
+    gesture_head        = next;
+}
+
+/* Publishes a gesture and runs the action of the swipe property of the current page with exactly that key */
+static void gesture_event_send(const char* gesture)
+{
+    char payload[32];
+    snprintf_P(payload, sizeof(payload), PSTR("{\"event\":\"%s\"}"), gesture);
+    dispatch_state_subtopic("gesture", payload);
+
+    const char* swipe = my_obj_get_swipe(haspPages.get_obj(haspPages.get()));
+    if(!swipe) return;
+
+    StaticJsonDocument<256> doc;
+    StaticJsonDocument<64> filter;
+
+    filter[gesture]                = true;
+    DeserializationError jsonError = deserializeJson(doc, swipe, DeserializationOption::Filter(filter));
+    if(jsonError) {
+        dispatch_json_error(TAG_EVENT, jsonError);
+    } else if(doc.containsKey(gesture)) {
+        script_event_handler(gesture, swipe);
+    }
+}
+
+/**
+ * Publishes the queued touch gestures, called from the main loop
+ */
+void gesture_event_loop()
+{
+    while(gesture_tail != gesture_head) {
+        uint8_t tail        = gesture_tail;
+        const char* gesture = gesture_queue[tail];
+        gesture_tail        = (tail + 1) % GESTURE_QUEUE_SIZE;
+        gesture_event_send(gesture);
+    }
+}
+
 /**
  * Called when a textarea is clicked
  * @param obj pointer to a textarea object
@@ -594,6 +678,7 @@ void toggle_event_handler(lv_obj_t* obj, lv_event_t event)
     }
 
     event_object_val_event(obj, hasp_event_id, last_value_sent);
+    event_retain_val(obj, last_value_sent);
 
     // Update group objects and gpios on release
     if(obj->user_data.groupid && hasp_event_id == HASP_EVENT_UP) {
@@ -670,6 +755,7 @@ void selector_event_handler(lv_obj_t* obj, lv_event_t event)
     last_value_sent = val;
     last_obj_sent   = obj;
     event_object_selection_changed(obj, hasp_event_id, val, buffer);
+    event_retain_val(obj, val);
 
     if(obj->user_data.groupid && max > 0) // max a cannot be 0, its the divider
         if(hasp_event_id == HASP_EVENT_UP || hasp_event_id == HASP_EVENT_CHANGED) {
@@ -831,6 +917,7 @@ void slider_event_handler(lv_obj_t* obj, lv_event_t event)
     last_value_sent = val;
     last_obj_sent   = obj;
     event_object_val_event(obj, hasp_event_id, val);
+    event_retain_val(obj, val);
 
     if(obj->user_data.groupid && (hasp_event_id == HASP_EVENT_CHANGED || hasp_event_id == HASP_EVENT_UP) && min != max)
         event_update_group(obj->user_data.groupid, obj, !!val, val, min, max);
@@ -855,6 +942,7 @@ void cpicker_event_handler(lv_obj_t* obj, lv_event_t event)
     if(hasp_event_id == HASP_EVENT_CHANGED && last_color_sent.full == color.full) return; // same value as before
 
     char data[512];
+    char rgb[8];
     {
         char eventname[8];
         Parser::get_event_name(hasp_event_id, eventname, sizeof(eventname));
@@ -864,6 +952,7 @@ void cpicker_event_handler(lv_obj_t* obj, lv_event_t event)
         c32.full        = lv_color_to32(color);
         hsv             = lv_color_rgb_to_hsv(c32.ch.red, c32.ch.green, c32.ch.blue);
         last_color_sent = color;
+        snprintf_P(rgb, sizeof(rgb), PSTR("#%02x%02x%02x"), c32.ch.red, c32.ch.green, c32.ch.blue);
 
         if(const char* tag = my_obj_get_tag(obj))
             snprintf_P(data, sizeof(data),
@@ -879,6 +968,7 @@ void cpicker_event_handler(lv_obj_t* obj, lv_event_t event)
                        hsv.s, hsv.v);
     }
     event_send_object_data(obj, data);
+    event_retain(obj, "color", rgb);
 
     // event_update_group(obj->user_data.groupid, obj, val, min, max);
 }
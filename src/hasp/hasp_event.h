@@ -29,6 +29,10 @@ void calendar_event_handler(lv_obj_t* obj, lv_event_t event);
 void textarea_event_handler(lv_obj_t* obj, lv_event_t event);
 void alarm_event_handler(lv_obj_t* obj, lv_event_t event);
 
+// Touch gesture handler
+IRAM_ATTR void gesture_event_handler(const char* gesture);
+void gesture_event_loop();
+
 // Other functions
 void event_reset_last_value_sent();
 
@@ -0,0 +1,357 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Export of the live objects back to jsonl
+ *
+ * The values come from the getters of hasp_process_obj_attribute, captured as JSON text instead of being dispatched
+ * one message at a time. Defaults are read from a new object of each type, created once per export on a screen that
+ * is never shown and deleted afterwards.
+ *
+ * Styles are read in the current state of an object, so they are not exported for checked or disabled objects.
+ * Fonts, button maps and line points have no getter and are not exported either.
+ */
+
+#include "hasplib.h"
+#include "hasp_export.h"
+
+#define EXPORT_TEMP_FILE "L:/export.tmp"
+#define EXPORT_MAX_TYPE 64
+
+/* In the order they are restored: the range and options before the value, the text before the size */
+static const char EXPORT_ATTRIBUTES[] PROGMEM =
+    "groupid tag action swipe options min max start_value mode direction type text template src x y w h ext_click_h "
+    "ext_click_v hidden enabled click toggle one_check val cols rows anim_time speed angle rotation zoom start_angle "
+    "end_angle start_angle1 end_angle1 btn_pos offset_x offset_y pivot_x pivot_y max_height adjustable auto_size "
+    "show_selected y_invert antialias mode_fixed critical_value line_count label_count color opacity align";
+
+/* Local styles of the default state, exported for the main part and the parts of the object type */
+static const char EXPORT_STYLES[] PROGMEM =
+    "radius clip_corner transform_width transform_height bg_color bg_grad_color bg_grad_dir bg_main_stop bg_grad_stop "
+    "bg_opa pad_top pad_bottom pad_left pad_right pad_inner margin_top margin_bottom margin_left margin_right "
+    "border_color border_width border_side border_opa border_post outline_color outline_width outline_pad "
+    "outline_opa shadow_color shadow_width shadow_ofs_x shadow_ofs_y shadow_spread shadow_opa text_color "
+    "text_sel_color text_letter_space text_line_space text_decor text_opa line_color line_width line_dash_width "
+    "line_dash_gap line_rounded line_opa value_str value_color value_opa value_ofs_x value_ofs_y value_align "
+    "value_letter_space value_line_space pattern_repeat pattern_opa pattern_recolor pattern_recolor_opa image_opa "
+    "image_recolor image_recolor_opa scale_grad_color scale_end_color scale_width scale_border_width "
+    "scale_end_border_width scale_end_line_width";
+
+struct export_context_t
+{
+    hasp_export_write_t write;
+    void* user;
+    hasp_export_stats_t* stats;
+    lv_obj_t* scratch;                 // screen holding the reference objects
+    lv_obj_t* refs[EXPORT_MAX_TYPE];   // new object of each type, created on first use
+    size_t len;                        // of the line
+    char line[HASP_EXPORT_LINE_SIZE];  //
+    char value[HASP_EXPORT_LINE_SIZE]; // of the object
+    char ref[HASP_EXPORT_LINE_SIZE];   // of the reference object
+};
+
+/* Part suffixes of the hasp_attribute_get_part_state_new notation that map to a part other than the main one */
+static const char* export_parts(lv_obj_t* obj)
+{
+    switch(obj_get_type(obj)) {
+        case LV_HASP_SLIDER:
+        case LV_HASP_SWITCH:
+        case LV_HASP_ARC:
+            return PSTR("10 20");
+        case LV_HASP_BAR:
+        case LV_HASP_SPINNER:
+        case LV_HASP_CHECKBOX:
+            return PSTR("10");
+        case LV_HASP_CPICKER:
+            return PSTR("20");
+        case LV_HASP_ROLLER:
+            return PSTR("50");
+        case LV_HASP_DROPDOWN:
+            return PSTR("40 50 80");
+        case LV_HASP_GAUGE:
+            return PSTR("10 60");
+        case LV_HASP_MSGBOX:
+            return PSTR("30 40");
+        case LV_HASP_TABVIEW:
+            return PSTR("10 30 40 50");
+        case LV_HASP_BTNMATRIX:
+            return PSTR("40");
+        default:
+            return NULL;
+    }
+}
+
+/* Copies the next space separated word of a PROGMEM list, returns the position after it */
+static const char* export_next_word(const char* p_list, char* word, size_t size)
+{
+    size_t len = 0;
+    for(;; p_list++) {
+#ifdef ARDUINO
+        char c = (char)pgm_read_byte(p_list);
+#else
+        char c = *p_list;
+#endif
+        if(c == '\0') break;
+        if(c == ' ') {
+            if(len == 0) continue;
+            break;
+        }
+        if(len < size - 1) word[len++] = c;
+    }
+    word[len] = '\0';
+    return p_list;
+}
+
+static lv_obj_t* export_reference(export_context_t* ctx, uint8_t type)
+{
+    if(type == LV_HASP_SCREEN) return ctx->scratch;
+    if(type == 0 || type >= EXPORT_MAX_TYPE) return NULL;
+
+    if(!ctx->refs[type]) {
+        lv_obj_t* parent = type == LV_HASP_TAB ? export_reference(ctx, LV_HASP_TABVIEW) : ctx->scratch;
+        if(parent) ctx->refs[type] = hasp_create_object(parent, type);
+    }
+    return ctx->refs[type];
+}
+
+/* Leaves room for the closing brace */
+static bool export_append(export_context_t* ctx, const char* text, size_t len)
+{
+    if(ctx->len + len >= sizeof(ctx->line) - 1) return false;
+    memcpy(ctx->line + ctx->len, text, len);
+    ctx->len += len;
+    ctx->line[ctx->len] = '\0';
+    return true;
+}
+
+static bool export_append_key(export_context_t* ctx, const char* key, const char* value, size_t len)
+{
+    size_t start = ctx->len;
+    if(export_append(ctx, ",\"", 2) && export_append(ctx, key, strlen(key)) && export_append(ctx, "\":", 2) &&
+       export_append(ctx, value, len))
+        return true;
+
+    ctx->len            = start;
+    ctx->line[ctx->len] = '\0';
+    return false;
+}
+
+/* Adds the attribute to the line when its value differs from the reference object */
+static void export_attribute(export_context_t* ctx, lv_obj_t* obj, lv_obj_t* ref, const char* attribute)
+{
+    size_t len = hasp_get_obj_attribute(obj, attribute, ctx->value, sizeof(ctx->value));
+    if(len == 0) return; // not an attribute of this object
+
+    if(ref && len < sizeof(ctx->value)) {
+        size_t ref_len = hasp_get_obj_attribute(ref, attribute, ctx->ref, sizeof(ctx->ref));
+        if(ref_len == len && !memcmp(ctx->value, ctx->ref, len)) return; // default value
+    }
+
+    if(len < sizeof(ctx->value) && export_append_key(ctx, attribute, ctx->value, len)) {
+        ctx->stats->attributes++;
+    } else {
+        uint8_t pageid = 0;
+        haspPages.get_id(obj, &pageid);
+        LOG_WARNING(TAG_HASP, F(HASP_OBJECT_NOTATION ".%s does not fit on a line"), pageid, obj->user_data.id,
+                    attribute);
+        ctx->stats->skipped++;
+    }
+}
+
+static void export_list(export_context_t* ctx, lv_obj_t* obj, lv_obj_t* ref, const char* p_list, const char* suffix)
+{
+    char attribute[32];
+    size_t suffix_len = suffix ? strlen(suffix) : 0;
+    uint8_t type      = obj_get_type(obj);
+
+    while(true) {
+        p_list = export_next_word(p_list, attribute, sizeof(attribute) - suffix_len);
+        if(attribute[0] == '\0') break;
+
+        if(!strcmp_P(attribute, PSTR("text")) && (type == LV_HASP_DROPDOWN || type == LV_HASP_ROLLER))
+            continue; // the selected option, read-only
+        if(!strcmp_P(attribute, PSTR("val")) && type == LV_HASP_TABVIEW) continue; // after the tabs
+
+        if(suffix) strcat(attribute, suffix);
+        export_attribute(ctx, obj, ref, attribute);
+    }
+}
+
+static void export_write(export_context_t* ctx)
+{
+    ctx->line[ctx->len++] = '}';
+    ctx->line[ctx->len]   = '\0';
+    ctx->write(ctx->line, ctx->len, ctx->user);
+    ctx->stats->lines++;
+    ctx->stats->bytes += ctx->len;
+}
+
+static void export_object(export_context_t* ctx, lv_obj_t* obj, uint8_t pageid, uint8_t parentid)
+{
+    uint8_t id = obj->user_data.id;
+
+    /* The top layer is not an object, page objects are b0 */
+    if(id || obj_check_type(obj, LV_HASP_SCREEN)) {
+        lv_obj_t* ref = export_reference(ctx, obj_get_type(obj));
+        ctx->len      = snprintf_P(ctx->line, sizeof(ctx->line), PSTR("{\"page\":%u,\"id\":%u"), pageid, id);
+        size_t header = ctx->len;
+
+        if(id) { // the line creates the object, so it is written even without attributes
+            size_t len = hasp_get_obj_attribute(obj, "obj", ctx->value, sizeof(ctx->value));
+            export_append_key(ctx, "obj", ctx->value, len);
+            if(parentid) {
+                char number[8];
+                export_append_key(ctx, "parentid", number, snprintf_P(number, sizeof(number), PSTR("%u"), parentid));
+            }
+            header = 0;
+        }
+
+        export_list(ctx, obj, ref, EXPORT_ATTRIBUTES, NULL);
+
+        if(lv_obj_get_state(obj, LV_OBJ_PART_MAIN) == LV_STATE_DEFAULT) {
+            export_list(ctx, obj, ref, EXPORT_STYLES, NULL);
+
+            char suffix[4];
+            const char* p_parts = export_parts(obj);
+            while(p_parts) {
+                p_parts = export_next_word(p_parts, suffix, sizeof(suffix));
+                if(suffix[0] == '\0') break;
+                export_list(ctx, obj, ref, EXPORT_STYLES, suffix);
+            }
+        } else {
+            LOG_VERBOSE(TAG_HASP, F(HASP_OBJECT_NOTATION " is checked or disabled, styles not exported"), pageid,
+                        id);
+            ctx->stats->unstyled++;
+        }
+
+        if(ctx->len > header) export_write(ctx); // a page without changes has no line
+        if(id) parentid = id;
+    }
+
+    /* Oldest first, so loading the lines restores the order in which objects are drawn */
+    lv_obj_t* child = lv_obj_get_child_back(obj, NULL);
+    while(child) {
+        export_object(ctx, child, pageid, parentid);
+        child = lv_obj_get_child_back(obj, child);
+    }
+
+    /* The selected tab can only be restored once the tabs exist */
+    if(id && obj_check_type(obj, LV_HASP_TABVIEW)) {
+        ctx->len      = snprintf_P(ctx->line, sizeof(ctx->line), PSTR("{\"page\":%u,\"id\":%u"), pageid, id);
+        size_t header = ctx->len;
+        export_attribute(ctx, obj, export_reference(ctx, LV_HASP_TABVIEW), "val");
+        if(ctx->len > header) export_write(ctx);
+    }
+}
+
+bool hasp_export_pages(uint8_t first, uint8_t last, hasp_export_write_t write, void* user, hasp_export_stats_t& stats)
+{
+    memset(&stats, 0, sizeof(stats));
+
+    export_context_t* ctx = (export_context_t*)hasp_malloc(sizeof(export_context_t));
+    if(!ctx) {
+        LOG_ERROR(TAG_HASP, F(D_ERROR_OUT_OF_MEMORY));
+        return false;
+    }
+    memset(ctx->refs, 0, sizeof(ctx->refs));
+    ctx->write   = write;
+    ctx->user    = user;
+    ctx->stats   = &stats;
+    ctx->scratch = lv_obj_create(NULL, NULL);
+    if(ctx->scratch) ctx->scratch->user_data.objid = LV_HASP_SCREEN;
+
+    for(uint16_t pageid = first; pageid <= last && pageid <= HASP_NUM_PAGES; pageid++) {
+#if HASP_USE_LAZY_PAGES > 0
+        if(pageid >= PAGE_START_INDEX && !haspPages.is_built(pageid)) haspPages.build(pageid);
+#endif
+        lv_obj_t* page = haspPages.get_obj(pageid);
+        if(page) export_object(ctx, page, pageid, 0);
+    }
+
+    if(ctx->scratch) lv_obj_del(ctx->scratch); // and the reference objects
+    hasp_free(ctx);
+    return true;
+}
+
+static void export_to_state(const char* line, size_t len, void* user)
+{
+    dispatch_state_subtopic("export", line);
+}
+
+struct export_file_t
+{
+    lv_fs_file_t file;
+    bool failed;
+};
+
+static void export_to_file(const char* line, size_t len, void* user)
+{
+    export_file_t* out = (export_file_t*)user;
+    uint32_t bw        = 0;
+    uint32_t nl        = 0;
+    if(out->failed) return;
+
+    if(lv_fs_write(&out->file, line, len, &bw) != LV_FS_RES_OK || bw != len ||
+       lv_fs_write(&out->file, "\n", 1, &nl) != LV_FS_RES_OK || nl != 1)
+        out->failed = true;
+}
+
+void hasp_export_jsonl(uint8_t first, uint8_t last, const char* filename)
+{
+    hasp_export_stats_t stats;
+    uint32_t start = millis();
+    bool ok;
+
+    char path[64] = "L:";
+    if(filename[0] == 'L' && filename[1] == ':') filename += 2;
+    if(strlen(filename) > sizeof(path) - 3) {
+        LOG_ERROR(TAG_HASP, F("Filename %s is too long"), filename);
+        return;
+    }
+    strncat(path, filename, sizeof(path) - 3);
+
+    if(filename[0] == '\0') {
+        ok = hasp_export_pages(first, last, export_to_state, NULL, stats);
+    } else {
+        export_file_t out;
+        out.failed = false;
+        if(lv_fs_open(&out.file, EXPORT_TEMP_FILE, LV_FS_MODE_WR) != LV_FS_RES_OK) {
+            LOG_ERROR(TAG_HASP, F(D_FILE_SAVE_FAILED), EXPORT_TEMP_FILE);
+            return;
+        }
+        ok = hasp_export_pages(first, last, export_to_file, &out, stats) && !out.failed;
+        lv_fs_close(&out.file);
+
+        /* Replace the old file only now that the new one is complete */
+#if HASP_USE_LAZY_PAGES > 0
+        if(ok) haspPages.drop_index(path); // the page offsets will be invalid
+#endif
+        if(ok && lv_fs_rename(EXPORT_TEMP_FILE, path) != LV_FS_RES_OK) {
+            lv_fs_remove(path);
+            ok = lv_fs_rename(EXPORT_TEMP_FILE, path) == LV_FS_RES_OK;
+        }
+        if(!ok) {
+            LOG_ERROR(TAG_HASP, F(D_FILE_SAVE_FAILED), path);
+            lv_fs_remove(EXPORT_TEMP_FILE);
+            return;
+        }
+    }
+    if(!ok) return;
+
+    uint32_t elapsed = millis() - start;
+    LOG_INFO(TAG_HASP, F("Exported %u lines with %u attributes in %u ms"), stats.lines, stats.attributes, elapsed);
+    if(stats.unstyled)
+        LOG_WARNING(TAG_HASP, F("Styles of %u checked or disabled objects not exported"), stats.unstyled);
+
+    StaticJsonDocument<256> doc;
+    doc[F("lines")]      = stats.lines;
+    doc[F("attributes")] = stats.attributes;
+    doc[F("bytes")]      = stats.bytes;
+    doc[F("unstyled")]   = stats.unstyled;
+    doc[F("skipped")]    = stats.skipped;
+    doc[F("ms")]         = elapsed;
+    if(filename[0] != '\0') doc[F("file")] = (const char*)path;
+
+    char payload[160];
+    serializeJson(doc, payload, sizeof(payload));
+    dispatch_state_subtopic("export", payload);
+}
@@ -0,0 +1,41 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Export of the live objects back to jsonl
+ *
+ * Each object becomes one line that Page::load_jsonl can read again, with only the attributes that differ from a new
+ * object of the same type. Lines are written in creation order, parents before their children.
+ */
+
+#ifndef HASP_EXPORT_H
+#define HASP_EXPORT_H
+
+#include "hasplib.h"
+
+#ifndef HASP_EXPORT_LINE_SIZE
+#if defined(ARDUINO_ARCH_ESP8266)
+#define HASP_EXPORT_LINE_SIZE 512
+#else
+#define HASP_EXPORT_LINE_SIZE 1024
+#endif
+#endif
+
+struct hasp_export_stats_t
+{
+    uint16_t lines;      // one per object, and one more for a tabview to select its tab
+    uint16_t unstyled;   // objects in the checked or disabled state, their styles are not exported
+    uint16_t skipped;    // values that did not fit on a line
+    uint32_t attributes; // attributes written
+    uint32_t bytes;      // size of the lines, without the newlines
+};
+
+/* Called for every line, which is not terminated by a newline */
+typedef void (*hasp_export_write_t)(const char* line, size_t len, void* user);
+
+/* Exports the pages from first to last, page 0 is the top layer. Returns false when out of memory. */
+bool hasp_export_pages(uint8_t first, uint8_t last, hasp_export_write_t write, void* user, hasp_export_stats_t& stats);
+
+/* Exports to a file on the local filesystem, or to the export state topic when filename is empty */
+void hasp_export_jsonl(uint8_t first, uint8_t last, const char* filename);
+
+#endif // HASP_EXPORT_H
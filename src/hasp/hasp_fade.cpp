@@ -0,0 +1,152 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Backlight and moodlight transitions
+ *
+ * All transitions are stepped by a single lvgl task, which only exists while a transition runs. Values are
+ * interpolated linearly in perceived lightness, value^(1/gamma), so a fade looks even instead of racing through
+ * the dark end. The done callback runs after the final value is set, that is where the state gets published.
+ */
+
+#include <math.h>
+
+#include "hasplib.h"
+#include "hasp_fade.h"
+
+#include "dev/device.h"
+#include "sys/gpio/hasp_gpio.h"
+#include "../hasp_debug.h"
+
+struct fade_t
+{
+    bool active;
+    uint32_t start;
+    uint32_t duration;
+    fade_done_cb_t done_cb;
+};
+
+static lv_task_t* fade_task = NULL;
+
+static fade_t backlight_fade;
+static uint8_t backlight_from;
+static uint8_t backlight_to;
+
+#if HASP_USE_GPIO > 0
+static fade_t moodlight_fade;
+static moodlight_t moodlight_from;
+static moodlight_t moodlight_to;
+static moodlight_t moodlight_output;
+#endif
+
+uint8_t fade_level(uint8_t from, uint8_t to, uint32_t elapsed, uint32_t duration)
+{
+    if(elapsed >= duration) return to;
+
+    float start = powf(from / 255.0f, 1.0f / HASP_FADE_GAMMA);
+    float end   = powf(to / 255.0f, 1.0f / HASP_FADE_GAMMA);
+    float pos   = start + (end - start) * elapsed / duration;
+    return (uint8_t)(powf(pos, HASP_FADE_GAMMA) * 255.0f + 0.5f);
+}
+
+/* Returns true on the last step of the transition */
+static bool fade_step(fade_t& fade, uint32_t& elapsed)
+{
+    elapsed = lv_tick_elaps(fade.start);
+    if(elapsed < fade.duration) return false;
+
+    fade.active = false;
+    return true;
+}
+
+static void fade_task_cb(lv_task_t* task)
+{
+    uint32_t elapsed;
+
+    if(backlight_fade.active) {
+        bool last     = fade_step(backlight_fade, elapsed);
+        uint8_t level = fade_level(backlight_from, backlight_to, elapsed, backlight_fade.duration);
+        LOG_DEBUG(TAG_HASP, F("Backlight fade %u ms => %u"), elapsed, level);
+        haspDevice.set_backlight_level(level);
+        if(last && backlight_fade.done_cb) backlight_fade.done_cb();
+    }
+
+#if HASP_USE_GPIO > 0
+    if(moodlight_fade.active) {
+        bool last = fade_step(moodlight_fade, elapsed);
+        if(last) {
+            moodlight_output = moodlight_to;
+        } else {
+            uint32_t duration = moodlight_fade.duration;
+            uint8_t from      = moodlight_from.power ? moodlight_from.brightness : 0;
+            uint8_t to        = moodlight_to.power ? moodlight_to.brightness : 0;
+
+            moodlight_output.power      = 1;
+            moodlight_output.brightness = fade_level(from, to, elapsed, duration);
+            for(uint8_t i = 0; i < sizeof(moodlight_output.rgbww); i++)
+                moodlight_output.rgbww[i] =
+                    fade_level(moodlight_from.rgbww[i], moodlight_to.rgbww[i], elapsed, duration);
+        }
+        LOG_DEBUG(TAG_HASP, F("Moodlight fade %u ms => %u #%02x%02x%02x"), elapsed, moodlight_output.brightness,
+                  moodlight_output.rgbww[0], moodlight_output.rgbww[1], moodlight_output.rgbww[2]);
+        gpio_set_moodlight(moodlight_output);
+        if(last && moodlight_fade.done_cb) moodlight_fade.done_cb();
+    }
+
+    if(moodlight_fade.active) return;
+#endif
+
+    if(backlight_fade.active) return;
+    lv_task_del(fade_task);
+    fade_task = NULL;
+}
+
+static void fade_start(fade_t& fade, uint32_t duration, fade_done_cb_t done_cb)
+{
+    fade.active   = true;
+    fade.start    = lv_tick_get();
+    fade.duration = duration;
+    fade.done_cb  = done_cb;
+
+    if(!fade_task) fade_task = lv_task_create(fade_task_cb, HASP_FADE_PERIOD, LV_TASK_PRIO_MID, NULL);
+}
+
+void fade_backlight(uint8_t from, uint8_t to, uint32_t duration, fade_done_cb_t done_cb)
+{
+    backlight_from = from;
+    backlight_to   = to;
+    fade_start(backlight_fade, duration, done_cb);
+}
+
+/* The task deletes itself on its next run when nothing is left to fade */
+void fade_backlight_stop()
+{
+    backlight_fade.active = false;
+}
+
+bool fade_backlight_active()
+{
+    return backlight_fade.active;
+}
+
+#if HASP_USE_GPIO > 0
+void fade_moodlight(const moodlight_t& from, const moodlight_t& to, uint32_t duration, fade_done_cb_t done_cb)
+{
+    moodlight_from   = from;
+    moodlight_to     = to;
+    moodlight_output = from;
+    fade_start(moodlight_fade, duration, done_cb);
+}
+
+void fade_moodlight_stop()
+{
+    moodlight_fade.active = false;
+}
+
+/* The values currently on the pins while a transition runs */
+bool fade_moodlight_output(moodlight_t& output)
+{
+    if(!moodlight_fade.active) return false;
+    output = moodlight_output;
+    return true;
+}
+#endif
@@ -0,0 +1,31 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_FADE_H
+#define HASP_FADE_H
+
+#include "hasplib.h"
+
+#ifndef HASP_FADE_PERIOD
+#define HASP_FADE_PERIOD 20 // ms between two steps of a transition
+#endif
+
+#ifndef HASP_FADE_GAMMA
+#define HASP_FADE_GAMMA 2.2f
+#endif
+
+typedef void (*fade_done_cb_t)(void);
+
+uint8_t fade_level(uint8_t from, uint8_t to, uint32_t elapsed, uint32_t duration);
+
+void fade_backlight(uint8_t from, uint8_t to, uint32_t duration, fade_done_cb_t done_cb);
+void fade_backlight_stop();
+bool fade_backlight_active();
+
+#if HASP_USE_GPIO > 0
+void fade_moodlight(const moodlight_t& from, const moodlight_t& to, uint32_t duration, fade_done_cb_t done_cb);
+void fade_moodlight_stop();
+bool fade_moodlight_output(moodlight_t& output);
+#endif
+
+#endif
@@ -2,6 +2,7 @@
    For full license information read the LICENSE file in the project folder */
 
 #include <string.h>
+#include <algorithm>
 
 #include "hasplib.h"
 #if HASP_USE_FREETYPE > 0
@@ -13,6 +14,19 @@
 #include "lv_freetype.h"
 #include "ft2build.h"  // for FT_FREETYPE_H macro
 #include FT_FREETYPE_H // for FREETYPE_VERSION macros
+
+#include <vector>
+
+#ifndef LVGL_FREETYPE_MAX_FACES // FreeType defaults
+#define LVGL_FREETYPE_MAX_FACES 0
+#define LVGL_FREETYPE_MAX_SIZES 0
+#define LVGL_FREETYPE_MAX_BYTES 0
+#define LVGL_FREETYPE_MAX_BYTES_PSRAM 0
+#endif
+
+#ifndef HASP_FONT_WARMUP_BUDGET
+#define HASP_FONT_WARMUP_BUDGET 5 // ms of glyph rendering per run of the warm-up task
+#endif
 #else
 typedef struct
 {
@@ -45,6 +59,39 @@ typedef struct
     uint8_t type;
 } hasp_font_info_t;
 
+#if HASP_USE_FREETYPE > 0
+typedef struct
+{
+    uint16_t faces;
+    uint16_t sizes;
+    uint32_t bytes; // 0 = the build default
+    bool warmup;    // render the glyphs of the neighbouring pages in idle time
+    bool started;
+} hasp_font_cache_t;
+
+typedef struct
+{
+    bool pending;      // the next frame draws a new page
+    uint32_t misses;   // glyph misses when the page was set
+    uint32_t last_ms;  // the last page switch frame
+    uint32_t last_misses;
+    uint32_t total_ms; // since the statistics were reset
+    uint32_t count;
+} hasp_font_switch_t;
+
+static hasp_font_cache_t font_cache = {LVGL_FREETYPE_MAX_FACES, LVGL_FREETYPE_MAX_SIZES, 0, false, false};
+static hasp_font_switch_t font_switch;
+static std::vector<std::pair<const lv_font_t*, uint32_t>> font_warmup_glyphs;
+static lv_task_t* font_warmup_task = NULL;
+static uint32_t font_warmup_count  = 0;
+
+static uint32_t font_cache_bytes()
+{
+    if(font_cache.bytes) return font_cache.bytes;
+    return hasp_use_psram() ? LVGL_FREETYPE_MAX_BYTES_PSRAM : LVGL_FREETYPE_MAX_BYTES;
+}
+#endif // HASP_USE_FREETYPE
+
 bool font_dummy_glyph_dsc(const struct _lv_font_struct*, lv_font_glyph_dsc_t*, uint32_t letter, uint32_t letter_next)
 {
     return false;
@@ -60,10 +107,12 @@ void font_setup()
 #if(HASP_USE_FREETYPE > 0) // initialize the FreeType renderer
 
 #if defined(ARDUINO_ARCH_ESP32)
-    if(lv_freetype_init(LVGL_FREETYPE_MAX_FACES, LVGL_FREETYPE_MAX_SIZES,
-                        hasp_use_psram() ? LVGL_FREETYPE_MAX_BYTES_PSRAM : LVGL_FREETYPE_MAX_BYTES)) {
+    if(lv_freetype_init(font_cache.faces, font_cache.sizes, font_cache_bytes())) {
+        font_cache.started = true;
         LOG_VERBOSE(TAG_FONT, F("FreeType v%d.%d.%d " D_SERVICE_STARTED " = %d"), FREETYPE_MAJOR, FREETYPE_MINOR,
                     FREETYPE_PATCH, hasp_use_psram());
+        LOG_VERBOSE(TAG_FONT, F("FreeType cache %u faces, %u sizes, %u bytes"), font_cache.faces, font_cache.sizes,
+                    font_cache_bytes());
         LOG_DEBUG(TAG_FONT, F("FreeType High Watermark %u"), lv_ft_freetype_high_watermark());
     } else {
         LOG_ERROR(TAG_FONT, F("FreeType " D_SERVICE_START_FAILED));
@@ -111,6 +160,10 @@ static void font_release(void* node)
 
 void font_clear_list(const char* payload)
 {
+#if HASP_USE_FREETYPE > 0
+    font_warmup_glyphs.clear(); // the fonts are about to be destroyed
+#endif
+
     if(_lv_ll_is_empty(&hasp_fonts_ll)) return;
 
     while(void* node = _lv_ll_get_head(&hasp_fonts_ll)) {
@@ -262,3 +315,201 @@ lv_font_t* get_font(const char* payload)
 
     return font_add_to_list(payload);
 }
+
+#if HASP_USE_FREETYPE > 0
+static bool font_cache_apply(uint16_t faces, uint16_t sizes, uint32_t bytes, bool warmup)
+{
+    bool limits = faces != font_cache.faces || sizes != font_cache.sizes || bytes != font_cache.bytes;
+    if(!limits && warmup == font_cache.warmup) return false;
+
+    font_cache.warmup = warmup;
+    if(!warmup) font_warmup_glyphs.clear();
+
+    if(limits) {
+        font_cache.faces = faces;
+        font_cache.sizes = sizes;
+        font_cache.bytes = bytes;
+        if(font_cache.started && lv_freetype_set_cache(faces, sizes, font_cache_bytes())) {
+            LOG_INFO(TAG_FONT, F("FreeType cache %u faces, %u sizes, %u bytes"), faces, sizes, font_cache_bytes());
+        } else if(font_cache.started) {
+            LOG_ERROR(TAG_FONT, F("FreeType cache " D_SERVICE_START_FAILED));
+        }
+    }
+
+    memset(&font_switch, 0, sizeof(font_switch)); // page switches are measured with the new settings
+    return true;
+}
+
+static bool font_is_freetype(const lv_font_t* font)
+{
+    hasp_font_info_t* font_p = (hasp_font_info_t*)_lv_ll_get_head(&hasp_fonts_ll);
+    while(font_p) {
+        if(font_p->font == font) return font_p->type != 0;
+        font_p = (hasp_font_info_t*)_lv_ll_get_next(&hasp_fonts_ll, font_p);
+    }
+    return false;
+}
+
+// Queue every letter of the labels on the page that is drawn with a FreeType font
+static void font_warmup_collect(lv_obj_t* parent)
+{
+    lv_obj_t* child = NULL;
+    while((child = lv_obj_get_child(parent, child))) {
+        lv_obj_type_t list;
+        lv_obj_get_type(child, &list);
+
+        if(!strcmp_P(list.type[0], PSTR("lv_label"))) {
+            const lv_font_t* font = lv_obj_get_style_text_font(child, LV_LABEL_PART_MAIN);
+            const char* text      = lv_label_get_text(child);
+            if(text && font_is_freetype(font)) {
+                uint32_t i = 0;
+                while(uint32_t letter = _lv_txt_encoded_next(text, &i)) {
+                    if(letter >= 0x20) font_warmup_glyphs.push_back(std::make_pair(font, letter));
+                }
+            }
+        }
+        font_warmup_collect(child);
+    }
+}
+
+// Render queued glyphs into the cache while lvgl has nothing to draw
+static void font_warmup_cb(lv_task_t* task)
+{
+    if(font_switch.pending || lv_anim_count_running() > 0 || lv_disp_get_inv_buf_size(lv_disp_get_default()) > 0)
+        return; // the page switch frame goes first
+
+    uint32_t start = millis();
+    while(!font_warmup_glyphs.empty() && millis() - start < HASP_FONT_WARMUP_BUDGET) {
+        std::pair<const lv_font_t*, uint32_t> glyph = font_warmup_glyphs.back();
+        font_warmup_glyphs.pop_back();
+
+        lv_font_glyph_dsc_t dsc;
+        lv_font_get_glyph_dsc(glyph.first, &dsc, glyph.second, 0);
+        font_warmup_count++;
+    }
+
+    if(font_warmup_glyphs.empty()) {
+        lv_task_del(task);
+        font_warmup_task = NULL;
+    }
+}
+
+void font_warmup(lv_obj_t* page)
+{
+    if(!font_cache.started || !font_cache.warmup || !page || page == lv_scr_act()) return;
+
+    font_warmup_collect(page); // an unbuilt lazy page has no labels yet
+    std::sort(font_warmup_glyphs.begin(), font_warmup_glyphs.end());
+    font_warmup_glyphs.erase(std::unique(font_warmup_glyphs.begin(), font_warmup_glyphs.end()),
+                             font_warmup_glyphs.end());
+
+    if(!font_warmup_glyphs.empty() && !font_warmup_task)
+        font_warmup_task = lv_task_create(font_warmup_cb, 20, LV_TASK_PRIO_LOWEST, NULL);
+}
+
+void font_page_switched(uint8_t pageid)
+{
+    if(!font_cache.started) return;
+
+    lv_ft_cache_stats_t stats;
+    lv_freetype_get_cache_stats(&stats);
+    font_switch.pending = true;
+    font_switch.misses  = stats.misses + stats.uncached;
+
+    font_warmup(haspPages.get_obj(haspPages.get_next(pageid)));
+    font_warmup(haspPages.get_obj(haspPages.get_prev(pageid)));
+}
+
+// Called for every frame lvgl draws, the first one after a page switch is timed
+void font_monitor_frame(uint32_t time)
+{
+    if(!font_switch.pending) return;
+
+    lv_ft_cache_stats_t stats;
+    lv_freetype_get_cache_stats(&stats);
+    font_switch.pending     = false;
+    font_switch.last_ms     = time;
+    font_switch.last_misses = stats.misses + stats.uncached - font_switch.misses;
+    font_switch.total_ms += time;
+    font_switch.count++;
+    LOG_VERBOSE(TAG_FONT, F("Page switch frame %u ms, %u glyphs rendered"), time, font_switch.last_misses);
+}
+
+// Change the limits of the glyph cache with "faces", "sizes", "bytes" and "warmup", the others are kept
+bool font_set_cache(const JsonObject& settings)
+{
+    return font_cache_apply(settings[F("faces")] | font_cache.faces, settings[F("sizes")] | font_cache.sizes,
+                            settings[F("bytes")] | font_cache.bytes, settings[F("warmup")] | font_cache.warmup);
+}
+
+void font_reset_stats()
+{
+    lv_freetype_reset_cache_stats();
+    memset(&font_switch, 0, sizeof(font_switch));
+    font_warmup_count = 0;
+}
+
+void font_get_cache_state(char* buffer, size_t len)
+{
+    lv_ft_cache_stats_t stats;
+    lv_freetype_get_cache_stats(&stats);
+    uint32_t switch_ms = font_switch.count ? font_switch.total_ms / font_switch.count : 0;
+    snprintf_P(buffer, len,
+               PSTR("{\"faces\":%u,\"sizes\":%u,\"bytes\":%u,\"warmup\":%u,\"hits\":%u,\"misses\":%u,"
+                    "\"reloads\":%u,\"switch_ms\":%u}"),
+               stats.max_faces, stats.max_sizes, stats.max_bytes, font_cache.warmup, stats.hits,
+               stats.misses + stats.uncached, stats.reloads, switch_ms);
+}
+
+void font_get_info(JsonObject& info)
+{
+    char size_buf[16];
+    char buffer[64];
+    lv_ft_cache_stats_t stats;
+    lv_freetype_get_cache_stats(&stats);
+
+    Parser::format_bytes(stats.max_bytes, size_buf, sizeof(size_buf));
+    snprintf_P(buffer, sizeof(buffer), PSTR("%u faces, %u sizes, %s"), stats.max_faces, stats.max_sizes, size_buf);
+    info[F("Limits")] = buffer;
+    snprintf_P(buffer, sizeof(buffer), PSTR("%u hits, %u misses, %u reloads, %u uncached"), stats.hits, stats.misses,
+               stats.reloads, stats.uncached);
+    info[F("Glyphs")] = buffer;
+    snprintf_P(buffer, sizeof(buffer), PSTR("hit %u us, miss %u us"), stats.hits ? stats.hit_us / stats.hits : 0,
+               stats.misses + stats.uncached ? stats.miss_us / (stats.misses + stats.uncached) : 0);
+    info[F("Lookup")]       = buffer;
+    info[F("Faces Opened")] = stats.faces;
+    snprintf_P(buffer, sizeof(buffer), PSTR("%s, %u glyphs"), font_cache.warmup ? "on" : "off", font_warmup_count);
+    info[F("Warm-up")] = buffer;
+    if(font_switch.count) {
+        snprintf_P(buffer, sizeof(buffer), PSTR("last %u ms (%u glyphs), avg %u ms over %u"), font_switch.last_ms,
+                   font_switch.last_misses, font_switch.total_ms / font_switch.count, font_switch.count);
+        info[F("Page Switch")] = buffer;
+    }
+}
+
+#if HASP_USE_CONFIG > 0
+bool font_get_config(const JsonObject& settings)
+{
+    bool changed = false;
+
+    if(font_cache.bytes != settings[FPSTR(FP_CONFIG_FONTCACHE)].as<uint32_t>()) changed = true;
+    settings[FPSTR(FP_CONFIG_FONTCACHE)] = font_cache.bytes;
+
+    if(font_cache.warmup != settings[FPSTR(FP_CONFIG_FONTWARMUP)].as<bool>()) changed = true;
+    settings[FPSTR(FP_CONFIG_FONTWARMUP)] = font_cache.warmup;
+
+    return changed;
+}
+
+bool font_set_config(const JsonObject& settings)
+{
+    uint32_t bytes = font_cache.bytes;
+    bool warmup    = font_cache.warmup;
+
+    if(settings[FPSTR(FP_CONFIG_FONTCACHE)].is<uint32_t>()) bytes = settings[FPSTR(FP_CONFIG_FONTCACHE)];
+    if(!settings[FPSTR(FP_CONFIG_FONTWARMUP)].isNull()) warmup = settings[FPSTR(FP_CONFIG_FONTWARMUP)].as<bool>();
+
+    return font_cache_apply(font_cache.faces, font_cache.sizes, bytes, warmup);
+}
+#endif // HASP_USE_CONFIG
+#endif // HASP_USE_FREETYPE
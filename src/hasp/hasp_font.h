@@ -8,4 +8,18 @@ void font_setup();
 lv_font_t* get_font(const char* payload);
 void font_clear_list(const char* payload);
 
+#if HASP_USE_FREETYPE > 0
+void font_warmup(lv_obj_t* page);
+void font_page_switched(uint8_t pageid);
+void font_monitor_frame(uint32_t time);
+bool font_set_cache(const JsonObject& settings);
+void font_reset_stats();
+void font_get_cache_state(char* buffer, size_t len);
+void font_get_info(JsonObject& info);
+#if HASP_USE_CONFIG > 0
+bool font_get_config(const JsonObject& settings);
+bool font_set_config(const JsonObject& settings);
+#endif
+#endif
+
 #endif
\ No newline at end of file
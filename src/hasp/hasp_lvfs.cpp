@@ -4,6 +4,7 @@
 #include "lv_fs_if.h"
 
 #include "hasp_conf.h" // include first
+#include "hasplib.h"
 #include "hasp_debug.h"
 
 void filesystem_list_path(const char* path)
@@ -34,3 +35,347 @@ void filesystem_list_path(const char* path)
 
     lv_fs_dir_close(&dir);
 }
+
+/* ===== Zip extraction ===== */
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include "rom/crc.h"
+#include "rom/miniz.h" // tinfl in ROM
+#define HASP_UNZIP_INFLATE 1
+#elif defined(POSIX)
+#include <zlib.h>
+#define HASP_UNZIP_INFLATE 1
+#else
+#define HASP_UNZIP_INFLATE 0
+#endif
+
+#ifndef HASP_UNZIP_BLOCK_SIZE
+#define HASP_UNZIP_BLOCK_SIZE 4096
+#endif
+
+#define ZIP_LOCAL_HEADER 0x04034b50
+#define ZIP_CENTRAL_HEADER 0x02014b50
+#define ZIP_END_OF_CENTRAL 0x06054b50
+#define ZIP_DATA_DESCRIPTOR 0x08074b50
+#define ZIP_FLAG_DATA_DESCRIPTOR 0x0008
+#define ZIP_NO_COMPRESSION 0
+#define ZIP_DEFLATE 8
+
+#define ZIP_TEMP_FILE "L:/unzip.tmp"
+
+static inline uint16_t zip_u16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t zip_u32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t zip_crc32(uint32_t crc, const uint8_t* buf, size_t len)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    return crc32_le(crc, buf, len);
+#elif defined(POSIX)
+    return crc32(crc, buf, len);
+#else
+    crc = ~crc;
+    while(len--) {
+        crc ^= *buf++;
+        for(uint8_t k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+#endif
+}
+
+struct zip_entry_t
+{
+    uint16_t method;
+    uint16_t flags;
+    uint32_t crc;
+    uint32_t compressed_size;
+    uint32_t uncompressed_size;
+    uint32_t data_start;
+};
+
+static bool zip_read(lv_fs_file_t* file, void* buf, uint32_t len)
+{
+    uint32_t br = 0;
+    return lv_fs_read(file, buf, len, &br) == LV_FS_RES_OK && br == len;
+}
+
+static bool zip_write(lv_fs_file_t* file, const void* buf, uint32_t len)
+{
+    uint32_t bw = 0;
+    return len == 0 || (lv_fs_write(file, buf, len, &bw) == LV_FS_RES_OK && bw == len);
+}
+
+/* Copy a stored entry, returns the number of bytes written or -1 on error */
+static int32_t zip_copy_stored(lv_fs_file_t* zip, lv_fs_file_t* out, zip_entry_t& entry, uint8_t* buffer,
+                               uint32_t& crc)
+{
+    uint32_t remaining = entry.compressed_size;
+    while(remaining > 0) {
+        uint32_t len = remaining < HASP_UNZIP_BLOCK_SIZE ? remaining : HASP_UNZIP_BLOCK_SIZE;
+        if(!zip_read(zip, buffer, len) || !zip_write(out, buffer, len)) return -1;
+        crc = zip_crc32(crc, buffer, len);
+        remaining -= len;
+    }
+    return entry.compressed_size;
+}
+
+#if HASP_UNZIP_INFLATE > 0
+/* Inflate a deflated entry, the input is read in blocks and the output is written as soon as it is produced.
+ * Returns the number of compressed bytes consumed or -1 on error */
+static int32_t zip_inflate(lv_fs_file_t* zip, lv_fs_file_t* out, zip_entry_t& entry, uint32_t available,
+                           uint8_t* buffer, uint32_t& crc, uint32_t& written)
+{
+    /* The compressed size is unknown when a data descriptor follows, then the rest of the file is available */
+    uint32_t remaining = (entry.flags & ZIP_FLAG_DATA_DESCRIPTOR) ? available : entry.compressed_size;
+    uint32_t consumed  = 0;
+    uint32_t in_avail  = 0;
+    uint32_t in_ofs    = 0;
+    bool ok            = false;
+
+#if defined(ARDUINO_ARCH_ESP32)
+    /* tinfl writes into a circular 32K dictionary that doubles as output buffer */
+    tinfl_decompressor* inflator = (tinfl_decompressor*)hasp_malloc(sizeof(tinfl_decompressor));
+    uint8_t* dict                = (uint8_t*)hasp_malloc(TINFL_LZ_DICT_SIZE);
+    size_t dict_ofs              = 0;
+    if(!inflator || !dict) goto done;
+    tinfl_init(inflator);
+
+    for(;;) {
+        if(in_avail == 0 && remaining > 0) {
+            in_avail = remaining < HASP_UNZIP_BLOCK_SIZE ? remaining : HASP_UNZIP_BLOCK_SIZE;
+            if(!zip_read(zip, buffer, in_avail)) goto done;
+            remaining -= in_avail;
+            in_ofs = 0;
+        }
+
+        size_t in_bytes  = in_avail;
+        size_t out_bytes = TINFL_LZ_DICT_SIZE - dict_ofs;
+        tinfl_status status =
+            tinfl_decompress(inflator, buffer + in_ofs, &in_bytes, dict, dict + dict_ofs, &out_bytes,
+                             remaining > 0 ? TINFL_FLAG_HAS_MORE_INPUT : 0);
+        in_ofs += in_bytes;
+        in_avail -= in_bytes;
+        consumed += in_bytes;
+
+        if(out_bytes > 0) {
+            if(!zip_write(out, dict + dict_ofs, out_bytes)) goto done;
+            crc = zip_crc32(crc, dict + dict_ofs, out_bytes);
+            written += out_bytes;
+            dict_ofs = (dict_ofs + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+        }
+
+        if(status == TINFL_STATUS_DONE) {
+            ok = true;
+            break;
+        }
+        if(status < 0 || (status == TINFL_STATUS_NEEDS_MORE_INPUT && in_avail == 0 && remaining == 0)) break;
+    }
+
+done:
+    hasp_free(dict);
+    hasp_free(inflator);
+#else
+    uint8_t* output = (uint8_t*)hasp_malloc(HASP_UNZIP_BLOCK_SIZE);
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if(output && inflateInit2(&zs, -MAX_WBITS) == Z_OK) {
+        for(;;) {
+            if(in_avail == 0 && remaining > 0) {
+                in_avail = remaining < HASP_UNZIP_BLOCK_SIZE ? remaining : HASP_UNZIP_BLOCK_SIZE;
+                if(!zip_read(zip, buffer, in_avail)) break;
+                remaining -= in_avail;
+                in_ofs = 0;
+            }
+
+            zs.next_in   = buffer + in_ofs;
+            zs.avail_in  = in_avail;
+            zs.next_out  = output;
+            zs.avail_out = HASP_UNZIP_BLOCK_SIZE;
+            int res      = inflate(&zs, Z_NO_FLUSH);
+
+            uint32_t in_bytes  = in_avail - zs.avail_in;
+            uint32_t out_bytes = HASP_UNZIP_BLOCK_SIZE - zs.avail_out;
+            in_ofs += in_bytes;
+            in_avail -= in_bytes;
+            consumed += in_bytes;
+
+            if(out_bytes > 0) {
+                if(!zip_write(out, output, out_bytes)) break;
+                crc = zip_crc32(crc, output, out_bytes);
+                written += out_bytes;
+            }
+
+            if(res == Z_STREAM_END) {
+                ok = true;
+                break;
+            }
+            if((res != Z_OK && res != Z_BUF_ERROR) || (out_bytes == 0 && in_avail == 0 && remaining == 0)) break;
+        }
+        inflateEnd(&zs);
+    }
+    hasp_free(output);
+#endif
+
+    return ok ? (int32_t)consumed : -1;
+}
+#endif // HASP_UNZIP_INFLATE
+
+/* Extract one entry into the temporary file and move it in place when the checksum matches */
+static bool zip_extract_entry(lv_fs_file_t* zip, uint32_t zip_size, zip_entry_t& entry, const char* name,
+                              uint8_t* buffer)
+{
+    lv_fs_file_t out;
+    uint32_t crc     = 0;
+    uint32_t written = 0;
+    int32_t consumed = -1;
+    uint32_t start   = millis();
+
+    if(lv_fs_open(&out, ZIP_TEMP_FILE, LV_FS_MODE_WR) != LV_FS_RES_OK) {
+        LOG_ERROR(TAG_FILE, F(D_FILE_SAVE_FAILED), ZIP_TEMP_FILE);
+        return false;
+    }
+
+    if(entry.method == ZIP_NO_COMPRESSION && !(entry.flags & ZIP_FLAG_DATA_DESCRIPTOR)) {
+        consumed = zip_copy_stored(zip, &out, entry, buffer, crc);
+        written  = consumed;
+#if HASP_UNZIP_INFLATE > 0
+    } else if(entry.method == ZIP_DEFLATE) {
+        consumed = zip_inflate(zip, &out, entry, zip_size - entry.data_start, buffer, crc, written);
+#endif
+    } else {
+        LOG_WARNING(TAG_FILE, F("Compression is not supported %d"), entry.method);
+    }
+    lv_fs_close(&out);
+
+    if(consumed >= 0 && (entry.flags & ZIP_FLAG_DATA_DESCRIPTOR)) {
+        /* crc and sizes follow the data, with an optional signature */
+        uint8_t desc[16];
+        lv_fs_seek(zip, entry.data_start + consumed);
+        if(zip_read(zip, desc, sizeof(desc))) {
+            const uint8_t* p        = zip_u32(desc) == ZIP_DATA_DESCRIPTOR ? desc + 4 : desc;
+            entry.crc               = zip_u32(p);
+            entry.compressed_size   = zip_u32(p + 4);
+            entry.uncompressed_size = zip_u32(p + 8);
+        } else {
+            consumed = -1;
+        }
+    }
+
+    if(consumed < 0 || crc != entry.crc || written != entry.uncompressed_size) {
+        if(consumed >= 0) LOG_ERROR(TAG_FILE, F("CRC mismatch %s"), name);
+        LOG_ERROR(TAG_FILE, F(D_FILE_SAVE_FAILED), name);
+        lv_fs_remove(ZIP_TEMP_FILE);
+        return false;
+    }
+
+    /* Replace the old file only now that the new one is complete */
+#if HASP_USE_LAZY_PAGES > 0
+    haspPages.drop_index(name); // the page offsets will be invalid
+#endif
+    if(lv_fs_rename(ZIP_TEMP_FILE, name) != LV_FS_RES_OK) {
+        lv_fs_remove(name);
+        if(lv_fs_rename(ZIP_TEMP_FILE, name) != LV_FS_RES_OK) {
+            LOG_ERROR(TAG_FILE, F(D_FILE_SAVE_FAILED), name);
+            lv_fs_remove(ZIP_TEMP_FILE);
+            return false;
+        }
+    }
+
+    uint32_t elapsed = millis() - start;
+    char size[16];
+    Parser::format_bytes(written, size, sizeof(size));
+    LOG_VERBOSE(TAG_FILE, F(D_BULLET "%s (%s) %u ms, %u kB/s"), name, size, elapsed,
+                elapsed > 0 ? written / elapsed : written / 1000);
+    return true;
+}
+
+/* Extract all files from a zip archive on the local filesystem, e.g. L:/bundle.zip */
+void filesystem_unzip(const char* filename)
+{
+    char path[64] = "L:";
+    if(filename[0] == 'L' && filename[1] == ':') filename += 2;
+    strncat(path, filename, sizeof(path) - 3);
+
+    lv_fs_file_t zip;
+    if(lv_fs_open(&zip, path, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+        LOG_WARNING(TAG_FILE, F(D_FILE_NOT_FOUND ": %s"), path);
+        return;
+    }
+
+    uint8_t* buffer = (uint8_t*)hasp_malloc(HASP_UNZIP_BLOCK_SIZE);
+    if(!buffer) {
+        LOG_ERROR(TAG_FILE, F(D_ERROR_OUT_OF_MEMORY));
+        lv_fs_close(&zip);
+        return;
+    }
+
+    uint32_t zip_size = 0;
+    lv_fs_size(&zip, &zip_size);
+
+    uint32_t start = millis();
+    uint16_t count = 0;
+    uint8_t header[30];
+    bool done = false;
+
+    while(!done && zip_read(&zip, header, 4)) {
+        uint32_t signature = zip_u32(header);
+        if(signature != ZIP_LOCAL_HEADER) {
+            if(signature != ZIP_CENTRAL_HEADER && signature != ZIP_END_OF_CENTRAL)
+                LOG_WARNING(TAG_FILE, F("invalid %x"), signature);
+            break; // the central directory follows the last file
+        }
+
+        if(!zip_read(&zip, header + 4, sizeof(header) - 4)) break;
+
+        zip_entry_t entry;
+        entry.flags              = zip_u16(header + 6);
+        entry.method             = zip_u16(header + 8);
+        entry.crc                = zip_u32(header + 14);
+        entry.compressed_size    = zip_u32(header + 18);
+        entry.uncompressed_size  = zip_u32(header + 22);
+        uint16_t filename_length = zip_u16(header + 26);
+        uint16_t extra_length    = zip_u16(header + 28);
+
+        char name[258] = "L:/";
+        if(filename_length > sizeof(name) - 4) {
+            LOG_WARNING(TAG_FILE, F("filename length too long %d"), filename_length);
+            break;
+        }
+        if(!zip_read(&zip, name + 3, filename_length)) break;
+        name[3 + filename_length] = '\0';
+
+        uint32_t pos = 0;
+        lv_fs_tell(&zip, &pos);
+        entry.data_start = pos + extra_length;
+        lv_fs_seek(&zip, entry.data_start);
+
+        if(name[2 + filename_length] == '/') {
+            // directory entry, nothing to extract
+        } else if(zip_extract_entry(&zip, zip_size, entry, name, buffer)) {
+            count++;
+        } else {
+            done = (entry.flags & ZIP_FLAG_DATA_DESCRIPTOR); // the next header can't be found
+        }
+
+        if(entry.flags & ZIP_FLAG_DATA_DESCRIPTOR) {
+            /* the descriptor may or may not start with a signature */
+            uint8_t sig[4];
+            uint32_t next = entry.data_start + entry.compressed_size;
+            lv_fs_seek(&zip, next);
+            next += (zip_read(&zip, sig, 4) && zip_u32(sig) == ZIP_DATA_DESCRIPTOR) ? 16 : 12;
+            lv_fs_seek(&zip, next);
+        } else {
+            lv_fs_seek(&zip, entry.data_start + entry.compressed_size);
+        }
+    }
+
+    hasp_free(buffer);
+    lv_fs_close(&zip);
+    LOG_VERBOSE(TAG_FILE, F("extracting %s complete, %u files in %u ms"), path, count, millis() - start);
+}
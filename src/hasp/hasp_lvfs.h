@@ -5,5 +5,6 @@
 #define HASP_LVFS_H
 
 void filesystem_list_path(const char* path);
+void filesystem_unzip(const char* filename);
 
 #endif
\ No newline at end of file
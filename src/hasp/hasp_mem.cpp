@@ -1,41 +1,351 @@
-
 /* MIT License - Copyright (c) 2019-2024 Francis Van Roie
    For full license information read the LICENSE file in the project folder */
 
 #include <stdlib.h>
+#include <string.h>
 #include "hasplib.h"
 #include "hasp_mem.h"
 
-#ifdef ESP32
-bool hasp_use_psram()
+#if !defined(ARDUINO_ARCH_ESP8266)
+#include <atomic>
+#endif
+
+#if HASP_TARGET_PC
+#include <mutex>
+#endif
+
+/* Memory allocator
+ *
+ * Allocations are routed by size class:
+ *  - small requests up to the largest pool block are served from fixed-block pools in internal RAM,
+ *    falling back to the heap when the pool of that size class is exhausted
+ *  - requests of HASP_MEM_PSRAM_MIN bytes or more and all persistent allocations go to PSram when available
+ *  - everything else goes to the general heap
+ *
+ * The PSram capability is detected once. The pools are carved from a single arena on first use,
+ * so ownership of a pointer is resolved with an address range check.
+ */
+
+#ifndef HASP_MEM_POOLS
+#if defined(ESP32) || HASP_TARGET_PC
+#define HASP_MEM_POOLS 1
+#else
+#define HASP_MEM_POOLS 0 // Not enough RAM to reserve an arena
+#endif
+#endif
+
+#ifndef HASP_MEM_PSRAM_MIN
+#define HASP_MEM_PSRAM_MIN 1024 // Requests of this size or larger are placed in PSram
+#endif
+
+#ifndef HASP_MEM_PSRAM_EMULATE
+#define HASP_MEM_PSRAM_EMULATE 0 // Report PSram as available on targets without PSram, for testing the routing
+#endif
+
+#if HASP_MEM_POOLS > 0
+typedef struct
 {
-    return psramFound() && ESP.getPsramSize() > 0;
-}
+    uint16_t block_size;
+    uint16_t block_count;
+    uint8_t* base;                   // First block in the arena
+    uint16_t* requested;             // Requested size per block, 0 = free
+    uint16_t free_head;              // Index of the first free block, block_count = none
+    uint16_t used;                   // Blocks in use
+    uint16_t high_water;             // Maximum blocks in use
+    std::atomic<uint32_t> allocs;    // Allocations served by this pool
+    std::atomic<uint32_t> fallbacks; // Allocations sent to the heap because the pool was exhausted
+    uint32_t requested_bytes;        // Sum of the requested sizes of the blocks in use
+} hasp_mem_pool_t;
+
+static hasp_mem_pool_t mem_pools[] = {
+    {16, 96},
+    {32, 96},
+    {64, 48},
+    {128, 24},
+    {256, 12},
+};
+static const uint8_t mem_pool_count = sizeof(mem_pools) / sizeof(mem_pools[0]);
+
+// hasp_free checks the range without the lock, the arena is published after the pools are set up
+static std::atomic<uint8_t*> mem_arena(NULL);
+static uint8_t* mem_arena_end = NULL;
+static bool mem_arena_failed  = false;
+#endif // HASP_MEM_POOLS
+
+static int8_t mem_psram_found = -1; // -1 = not detected yet
+#if defined(ARDUINO_ARCH_ESP8266)
+static uint32_t mem_psram_allocs = 0; // single core and the lx106 has no atomic increment
+static uint32_t mem_heap_allocs  = 0;
+#else
+static std::atomic<uint32_t> mem_psram_allocs(0);
+static std::atomic<uint32_t> mem_heap_allocs(0);
 #endif
 
-void* hasp_calloc(size_t num, size_t size)
+#if defined(ESP32)
+static portMUX_TYPE mem_mux = portMUX_INITIALIZER_UNLOCKED;
+#define HASP_MEM_LOCK() portENTER_CRITICAL(&mem_mux)
+#define HASP_MEM_UNLOCK() portEXIT_CRITICAL(&mem_mux)
+#elif HASP_TARGET_PC
+static std::mutex mem_mutex;
+#define HASP_MEM_LOCK() mem_mutex.lock()
+#define HASP_MEM_UNLOCK() mem_mutex.unlock()
+#else
+#define HASP_MEM_LOCK()
+#define HASP_MEM_UNLOCK()
+#endif
+
+bool hasp_use_psram()
 {
+    if(mem_psram_found < 0) {
 #ifdef ESP32
-    return hasp_use_psram() ? ps_calloc(num, size) : calloc(num, size);
+        mem_psram_found = psramFound() && ESP.getPsramSize() > 0;
 #else
-    return calloc(num, size);
+        mem_psram_found = HASP_MEM_PSRAM_EMULATE;
 #endif
+    }
+    return mem_psram_found > 0;
 }
 
-void* hasp_malloc(size_t size)
+static void* hasp_mem_psram_malloc(size_t size)
 {
+    mem_psram_allocs++;
 #ifdef ESP32
-    return hasp_use_psram() ? ps_malloc(size) : malloc(size);
+    return ps_malloc(size);
 #else
     return malloc(size);
 #endif
 }
 
+static void* hasp_mem_heap_malloc(size_t size)
+{
+    mem_heap_allocs++;
+    return malloc(size);
+}
+
+#if HASP_MEM_POOLS > 0
+static bool hasp_mem_pool_init()
+{
+    if(mem_arena.load(std::memory_order_acquire)) return true;
+    if(mem_arena_failed) return false;
+
+    size_t size = 0;
+    for(uint8_t i = 0; i < mem_pool_count; i++) {
+        size += mem_pools[i].block_count * (mem_pools[i].block_size + sizeof(uint16_t));
+    }
+
+#ifdef ESP32
+    uint8_t* arena = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+    uint8_t* arena = (uint8_t*)malloc(size);
+#endif
+    if(!arena) {
+        mem_arena_failed = true;
+        return false;
+    }
+
+    // Blocks first to keep them aligned, followed by the requested size tables
+    uint8_t* base[mem_pool_count];
+    uint16_t* requested[mem_pool_count];
+    uint8_t* blocks = arena;
+    uint16_t* sizes = (uint16_t*)(arena + size);
+    for(uint8_t i = 0; i < mem_pool_count; i++) {
+        const hasp_mem_pool_t* pool = &mem_pools[i];
+        base[i]                     = blocks;
+        blocks += pool->block_count * pool->block_size;
+        sizes -= pool->block_count;
+        requested[i] = sizes;
+
+        // Thread the free list through the unused blocks
+        for(uint16_t b = 0; b < pool->block_count; b++) {
+            requested[i][b]                              = 0;
+            *(uint16_t*)(base[i] + b * pool->block_size) = b + 1;
+        }
+    }
+
+    // Publish the arena last, other tasks may be allocating already
+    bool published = false;
+    HASP_MEM_LOCK();
+    if(!mem_arena.load(std::memory_order_relaxed)) {
+        for(uint8_t i = 0; i < mem_pool_count; i++) {
+            mem_pools[i].base      = base[i];
+            mem_pools[i].requested = requested[i];
+            mem_pools[i].free_head = 0;
+        }
+        mem_arena_end = blocks;
+        mem_arena.store(arena, std::memory_order_release);
+        published = true;
+    }
+    HASP_MEM_UNLOCK();
+
+    if(!published) free(arena); // another task was first
+    return true;
+}
+
+static inline bool hasp_mem_in_pool(void* ptr)
+{
+    uint8_t* arena = mem_arena.load(std::memory_order_acquire);
+    return arena && (uint8_t*)ptr >= arena && (uint8_t*)ptr < mem_arena_end;
+}
+
+static hasp_mem_pool_t* hasp_mem_find_pool(void* ptr, uint16_t& block)
+{
+    for(uint8_t i = 0; i < mem_pool_count; i++) {
+        hasp_mem_pool_t* pool = &mem_pools[i];
+        uint8_t* end          = pool->base + pool->block_count * pool->block_size;
+        if((uint8_t*)ptr >= pool->base && (uint8_t*)ptr < end) {
+            block = ((uint8_t*)ptr - pool->base) / pool->block_size;
+            return pool;
+        }
+    }
+    return NULL;
+}
+
+static void* hasp_mem_pool_malloc(size_t size)
+{
+    if(size == 0 || size > mem_pools[mem_pool_count - 1].block_size) return NULL;
+
+    if(!hasp_mem_pool_init()) return NULL;
+
+    void* ptr = NULL;
+    HASP_MEM_LOCK();
+    {
+        for(uint8_t i = 0; i < mem_pool_count; i++) {
+            hasp_mem_pool_t* pool = &mem_pools[i];
+            if(size > pool->block_size) continue;
+
+            if(pool->free_head >= pool->block_count) { // exhausted
+                pool->fallbacks.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+
+            uint16_t block         = pool->free_head;
+            ptr                    = pool->base + block * pool->block_size;
+            pool->free_head        = *(uint16_t*)ptr;
+            pool->requested[block] = size;
+            pool->requested_bytes += size;
+            pool->allocs.fetch_add(1, std::memory_order_relaxed);
+            if(++pool->used > pool->high_water) pool->high_water = pool->used;
+            break;
+        }
+    }
+    HASP_MEM_UNLOCK();
+    return ptr;
+}
+
+static void hasp_mem_pool_free(void* ptr)
+{
+    uint16_t block;
+    HASP_MEM_LOCK();
+    hasp_mem_pool_t* pool = hasp_mem_find_pool(ptr, block);
+    if(pool && pool->requested[block] > 0) { // ignore double free
+        pool->requested_bytes -= pool->requested[block];
+        pool->requested[block] = 0;
+        *(uint16_t*)ptr        = pool->free_head;
+        pool->free_head        = block;
+        pool->used--;
+    }
+    HASP_MEM_UNLOCK();
+}
+
+/**
+ * Get the statistics of a fixed-block pool
+ * @return false if the pool index is out of range
+ */
+bool hasp_mem_get_pool_stats(uint8_t index, hasp_mem_pool_stats_t* stats)
+{
+    if(index >= mem_pool_count || !stats) return false;
+
+    HASP_MEM_LOCK();
+    hasp_mem_pool_t* pool = &mem_pools[index];
+    stats->block_size     = pool->block_size;
+    stats->block_count    = pool->block_count;
+    stats->used           = pool->used;
+    stats->high_water     = pool->high_water;
+    stats->allocs         = pool->allocs;
+    stats->fallbacks      = pool->fallbacks;
+
+    // Internal fragmentation: the part of the used blocks that was not requested
+    size_t reserved      = pool->used * pool->block_size;
+    stats->fragmentation = reserved ? 100 - pool->requested_bytes * 100 / reserved : 0;
+    HASP_MEM_UNLOCK();
+    return true;
+}
+#else
+bool hasp_mem_get_pool_stats(uint8_t index, hasp_mem_pool_stats_t* stats)
+{
+    return false;
+}
+#endif // HASP_MEM_POOLS
+
+void hasp_mem_get_stats(uint32_t* psram_allocs, uint32_t* heap_allocs)
+{
+    if(psram_allocs) *psram_allocs = mem_psram_allocs;
+    if(heap_allocs) *heap_allocs = mem_heap_allocs;
+}
+
+void* hasp_calloc(size_t num, size_t size)
+{
+    size_t len = num * size;
+    if(num && len / num != size) return NULL; // overflow
+
+    void* ptr = hasp_malloc(len);
+    if(ptr) memset(ptr, 0, len);
+    return ptr;
+}
+
+void* hasp_malloc(size_t size)
+{
+#if HASP_MEM_POOLS > 0
+    if(void* ptr = hasp_mem_pool_malloc(size)) return ptr;
+#endif
+
+    if(size >= HASP_MEM_PSRAM_MIN && hasp_use_psram()) return hasp_mem_psram_malloc(size);
+    return hasp_mem_heap_malloc(size);
+}
+
+/* Persistent buffers live until the object or page is deleted, keep them out of internal RAM */
+void* hasp_calloc_persistent(size_t num, size_t size)
+{
+    if(!hasp_use_psram()) return hasp_calloc(num, size);
+
+    size_t len = num * size;
+    if(num && len / num != size) return NULL; // overflow
+
+    void* ptr = hasp_mem_psram_malloc(len);
+    if(ptr) memset(ptr, 0, len);
+    return ptr;
+}
+
 /* NOTE: when realloc returns NULL, it leaves the original memory untouched */
 void* hasp_realloc(void* ptr, size_t new_size)
 {
+    if(!ptr) return hasp_malloc(new_size);
+
+#if HASP_MEM_POOLS > 0
+    if(hasp_mem_in_pool(ptr)) {
+        uint16_t block;
+        HASP_MEM_LOCK();
+        hasp_mem_pool_t* pool = hasp_mem_find_pool(ptr, block);
+        size_t old_size       = pool ? pool->requested[block] : 0;
+        if(pool && new_size > 0 && new_size <= pool->block_size) { // still fits in the same block
+            pool->requested_bytes += new_size;
+            pool->requested_bytes -= old_size;
+            pool->requested[block] = new_size;
+            HASP_MEM_UNLOCK();
+            return ptr;
+        }
+        HASP_MEM_UNLOCK();
+
+        void* new_ptr = hasp_malloc(new_size);
+        if(!new_ptr) return NULL;
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+        hasp_mem_pool_free(ptr);
+        return new_ptr;
+    }
+#endif
+
 #ifdef ESP32
-    return hasp_use_psram() ? ps_realloc(ptr, new_size) : realloc(ptr, new_size);
+    return (new_size >= HASP_MEM_PSRAM_MIN && hasp_use_psram()) ? ps_realloc(ptr, new_size) : realloc(ptr, new_size);
 #else
     return realloc(ptr, new_size);
 #endif
@@ -43,6 +353,15 @@ void* hasp_realloc(void* ptr, size_t new_size)
 
 void hasp_free(void* ptr)
 {
+    if(!ptr) return;
+
+#if HASP_MEM_POOLS > 0
+    if(hasp_mem_in_pool(ptr)) {
+        hasp_mem_pool_free(ptr);
+        return;
+    }
+#endif
+
     free(ptr);
 }
 
@@ -75,4 +394,4 @@ void lodepng_free(void* ptr)
 {
     hasp_free(ptr);
 }
-#endif // LODEPNG_NO_COMPILE_ALLOCATORS
\ No newline at end of file
+#endif // LODEPNG_NO_COMPILE_ALLOCATORS
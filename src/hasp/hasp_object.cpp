@@ -152,6 +152,11 @@ void object_set_normalized_group_values(hasp_update_value_t& value)
 {
     if(value.group == 0 || value.min == value.max) return;
 
+#if HASP_USE_LAZY_PAGES > 0
+    // A page that is not built gets the value when it is, a built one keeps it for when it is rebuilt
+    for(uint8_t i = PAGE_START_INDEX; i <= HASP_NUM_PAGES; i++) haspPages.retain_group(i, value);
+#endif
+
     uint8_t page = haspPages.get();
     object_set_group_values(haspPages.get_obj(page), value); // Update visible objects first
 
@@ -165,6 +170,14 @@ void object_set_normalized_group_values(hasp_update_value_t& value)
 // Used in the dispatcher
 void hasp_process_attribute(uint8_t pageid, uint8_t objid, const char* attr, const char* payload, bool update)
 {
+#if HASP_USE_LAZY_PAGES > 0
+    if(update) haspPages.retain(pageid, objid, attr, payload);
+    if(!haspPages.is_built(pageid)) {
+        if(update) return;       // the retained value is applied when the page is built
+        haspPages.build(pageid); // getters need the object
+    }
+#endif
+
     if(lv_obj_t* obj = hasp_find_obj_from_page_id(pageid, objid)) {
         hasp_process_obj_attribute(obj, attr, payload, update); // || strlen(payload) > 0);
     } else {
@@ -219,6 +232,439 @@ static void object_add_task(lv_obj_t* obj, lv_task_cb_t task_xcb, uint16_t inter
     // (void)task; // unused
 }
 
+/**
+ * Create an object of a given type with the openHASP defaults
+ * @param parent_obj the object to create it on
+ * @param sdbm the hash of the type name or its lv_hasp_obj_type_t
+ * @return the new object or NULL if the type is not supported
+ */
+lv_obj_t* hasp_create_object(lv_obj_t* parent_obj, uint16_t sdbm)
+{
+    lv_obj_t* obj = NULL;
+
+    switch(sdbm) {
+            /* ----- Custom Objects ------ */
+        case LV_HASP_ALARM:
+        case HASP_OBJ_ALARM:
+            obj = lv_obj_create(parent_obj, NULL);
+            if(obj) obj->user_data.objid = LV_HASP_ALARM;
+            break;
+
+        /* ----- Basic Objects ------ */
+        case LV_HASP_BTNMATRIX:
+        case HASP_OBJ_BTNMATRIX:
+            obj = lv_btnmatrix_create(parent_obj, NULL);
+            if(obj) {
+                lv_btnmatrix_set_recolor(obj, true);
+                if(obj_check_type(parent_obj, LV_HASP_ALARM))
+                    lv_obj_set_event_cb(obj, alarm_event_handler);
+                else
+                    lv_obj_set_event_cb(obj, btnmatrix_event_handler);
+
+                lv_btnmatrix_ext_t* ext = (lv_btnmatrix_ext_t*)lv_obj_get_ext_attr(obj);
+                btnmatrix_default_map   = ext->map_p; // store the static pointer to the default lvgl btnmap
+                obj->user_data.objid    = LV_HASP_BTNMATRIX;
+            }
+            break;
+
+#if LV_USE_TABLE > 0
+        case LV_HASP_TABLE:
+        case HASP_OBJ_TABLE:
+            obj = lv_table_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, selector_event_handler);
+                obj->user_data.objid = LV_HASP_TABLE;
+            }
+            break;
+#endif
+
+        case LV_HASP_BUTTON:
+        case HASP_OBJ_BTN:
+            obj = lv_btn_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_t* lbl = lv_label_create(obj, NULL);
+                if(lbl) {
+                    lv_label_set_text(lbl, "");
+                    lv_label_set_recolor(lbl, true);
+                    lbl->user_data.objid = LV_HASP_LABEL;
+                    lv_obj_align(lbl, NULL, LV_ALIGN_CENTER, 0, 0);
+                }
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_BUTTON;
+            }
+            break;
+
+        case LV_HASP_CHECKBOX:
+        case HASP_OBJ_CHECKBOX:
+            obj = lv_checkbox_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, toggle_event_handler);
+                obj->user_data.objid = LV_HASP_CHECKBOX;
+            }
+            break;
+
+        case LV_HASP_LABEL:
+        case HASP_OBJ_LABEL:
+            obj = lv_label_create(parent_obj, NULL);
+            if(obj) {
+                lv_label_set_long_mode(obj, LV_LABEL_LONG_CROP);
+                lv_label_set_recolor(obj, true);
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_LABEL;
+
+                // if(id >= 250) object_add_task(obj, event_timer_clock, 1000);
+            }
+            break;
+
+        case LV_HASP_TEXTAREA:
+        case HASP_OBJ_TEXTAREA:
+            obj = lv_textarea_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, textarea_event_handler);
+                lv_textarea_set_cursor_click_pos(obj, true);
+                obj->user_data.objid = LV_HASP_TEXTAREA;
+            }
+            break;
+
+        case LV_HASP_IMAGE:
+        case HASP_OBJ_IMG:
+            obj = lv_img_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_IMAGE;
+            }
+            break;
+
+#if HASP_USE_QRCODE > 0
+        case LV_HASP_QRCODE:
+        case HASP_OBJ_QRCODE:
+            obj = lv_qrcode_create(parent_obj, 140, LV_COLOR_BLACK, LV_COLOR_WHITE);
+            if(obj) {
+                lv_obj_set_event_cb(obj, delete_event_handler);
+                obj->user_data.objid = LV_HASP_QRCODE;
+            }
+            break;
+#endif
+
+        case LV_HASP_ARC:
+        case HASP_OBJ_ARC:
+            obj = lv_arc_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_ARC;
+            }
+            break;
+
+        case LV_HASP_CONTAINER:
+        case HASP_OBJ_CONT:
+            obj = lv_cont_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_CONTAINER;
+            }
+            break;
+
+        case LV_HASP_OBJECT:
+        case HASP_OBJ_OBJ:
+            obj = lv_obj_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_OBJECT;
+            }
+            break;
+
+#if LVGL_VERSION_MAJOR == 7 && LV_USE_PAGE
+        case LV_HASP_PAGE:
+        case HASP_OBJ_PAGE:
+            obj = lv_page_create(parent_obj, NULL);
+            if(obj) obj->user_data.objid = LV_HASP_PAGE;
+            // No event handler for pages
+            break;
+#endif
+
+#if LV_USE_WIN && LVGL_VERSION_MAJOR == 7
+        case LV_HASP_WINDOW:
+        case HASP_OBJ_WIN:
+            obj = lv_win_create(parent_obj, NULL);
+            if(obj) obj->user_data.objid = LV_HASP_WINDOW;
+            // No event handler for pages
+            break;
+
+#endif
+
+#if LVGL_VERSION_MAJOR == 8
+        case LV_HASP_LED:
+        case HASP_OBJ_LED:
+            obj = lv_led_create(parent_obj);
+            if(obj) {
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_LED;
+            }
+            break;
+
+        case LV_HASP_TILEVIEW:
+        case HASP_OBJ_TILEVIEW:
+            obj = lv_tileview_create(parent_obj);
+            if(obj) obj->user_data.objid = LV_HASP_TILEVIEW;
+            // No event handler for tileviews
+            break;
+
+        case LV_HASP_TABVIEW:
+        case HASP_OBJ_TABVIEW:
+            obj = lv_tabview_create(parent_obj, LV_DIR_TOP, 100);
+            // No event handler for tabs
+            if(obj) {
+                lv_obj_set_event_cb(obj, selector_event_handler);
+                obj->user_data.objid = LV_HASP_TABVIEW;
+            }
+            break;
+
+#else
+        case LV_HASP_LED:
+        case HASP_OBJ_LED:
+            obj = lv_led_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_LED;
+            }
+            break;
+
+#if LV_USE_TILEVIEW > 0
+        case LV_HASP_TILEVIEW:
+        case HASP_OBJ_TILEVIEW:
+            obj = lv_tileview_create(parent_obj, NULL);
+            if(obj) obj->user_data.objid = LV_HASP_TILEVIEW;
+
+            // No event handler for tileviews
+            break;
+#endif
+
+        case LV_HASP_TABVIEW:
+        case HASP_OBJ_TABVIEW:
+            obj = lv_tabview_create(parent_obj, NULL);
+            // No event handler for tabs
+            if(obj) {
+                lv_obj_set_event_cb(obj, selector_event_handler);
+                obj->user_data.objid = LV_HASP_TABVIEW;
+            }
+            break;
+
+        case LV_HASP_TAB:
+        case HASP_OBJ_TAB:
+            if(parent_obj && parent_obj->user_data.objid == LV_HASP_TABVIEW) {
+                obj = lv_tabview_add_tab(parent_obj, "Tab");
+                if(obj) {
+                    lv_obj_set_event_cb(obj, generic_event_handler);
+                    obj->user_data.objid = LV_HASP_TAB;
+                }
+            } else {
+                LOG_WARNING(TAG_HASP, F("Parent of a tab must be a tabview object"));
+                return;
+            }
+            break;
+
+#endif
+        /* ----- Color Objects ------ */
+        case LV_HASP_CPICKER:
+        case HASP_OBJ_CPICKER:
+            obj = lv_cpicker_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, cpicker_event_handler);
+                obj->user_data.objid = LV_HASP_CPICKER;
+            }
+            break;
+
+#if LV_USE_SPINNER != 0
+        case LV_HASP_SPINNER:
+        case HASP_OBJ_SPINNER:
+            obj = lv_spinner_create(parent_obj, NULL);
+            if(obj) {
+                obj->user_data.objid = LV_HASP_SPINNER;
+                lv_obj_set_event_cb(obj, generic_event_handler);
+            }
+            break;
+#endif
+
+        /* ----- Range Objects ------ */
+        case LV_HASP_SLIDER:
+        case HASP_OBJ_SLIDER:
+            obj = lv_slider_create(parent_obj, NULL);
+            if(obj) {
+                lv_slider_set_range(obj, 0, 100);
+                lv_obj_set_event_cb(obj, slider_event_handler);
+                obj->user_data.objid = LV_HASP_SLIDER;
+            }
+            // bool knobin = config[F("knobin")].as<bool>() | true;
+            // lv_slider_set_knob_in(obj, knobin);
+            break;
+
+        case LV_HASP_GAUGE:
+        case HASP_OBJ_GAUGE:
+            obj = lv_gauge_create(parent_obj, NULL);
+            if(obj) {
+                lv_gauge_set_range(obj, 0, 100);
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_GAUGE;
+            }
+            break;
+
+        case LV_HASP_LINE:
+        case HASP_OBJ_LINE:
+            obj = lv_line_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_style_local_line_width(obj, LV_LINE_PART_MAIN, LV_STATE_DEFAULT, 1);
+                lv_obj_set_event_cb(obj, delete_event_handler);
+                obj->user_data.objid = LV_HASP_LINE;
+            }
+            break;
+
+        case LV_HASP_BAR:
+        case HASP_OBJ_BAR:
+            obj = lv_bar_create(parent_obj, NULL);
+            if(obj) {
+                lv_bar_set_range(obj, 0, 100);
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_BAR;
+            }
+            break;
+
+        case LV_HASP_LINEMETER:
+        case HASP_OBJ_LMETER: // obsolete
+        case HASP_OBJ_LINEMETER:
+            obj = lv_linemeter_create(parent_obj, NULL);
+            if(obj) {
+                lv_linemeter_set_range(obj, 0, 100);
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_LINEMETER;
+            }
+            break;
+
+#if LV_USE_SPINBOX > 0
+        case LV_HASP_SPINBOX:
+        case HASP_OBJ_SPINBOX:
+            obj = lv_spinbox_create(parent_obj, NULL);
+            if(obj) {
+                lv_spinbox_set_range(obj, 0, 100);
+                lv_obj_set_event_cb(obj, slider_event_handler);
+                obj->user_data.objid = LV_HASP_SPINBOX;
+            }
+            break;
+#endif
+
+        case LV_HASP_LIST:
+        case HASP_OBJ_LIST:
+            obj = lv_list_create(parent_obj, NULL);
+            if(obj) {
+                // Callbacks are set on the individual buttons
+                obj->user_data.objid = LV_HASP_LIST;
+            }
+            break;
+
+#if LV_USE_CHART > 0
+        case LV_HASP_CHART:
+        case HASP_OBJ_CHART:
+            obj = lv_chart_create(parent_obj, NULL);
+            if(obj) {
+                lv_chart_set_range(obj, 0, 100);
+                lv_obj_set_event_cb(obj, generic_event_handler);
+
+                lv_chart_add_series(obj, LV_COLOR_RED);
+                lv_chart_add_series(obj, LV_COLOR_GREEN);
+                lv_chart_add_series(obj, LV_COLOR_BLUE);
+
+                lv_chart_series_t* ser = my_chart_get_series(obj, 2);
+                lv_chart_set_next(obj, ser, 10);
+                lv_chart_set_next(obj, ser, 20);
+                lv_chart_set_next(obj, ser, 30);
+                lv_chart_set_next(obj, ser, 40);
+
+                obj->user_data.objid = LV_HASP_CHART;
+            }
+            break;
+#endif
+
+        /* ----- On/Off Objects ------ */
+        case LV_HASP_SWITCH:
+        case HASP_OBJ_SWITCH:
+            obj = lv_switch_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, toggle_event_handler);
+                obj->user_data.objid = LV_HASP_SWITCH;
+            }
+            break;
+
+        /* ----- List Object ------- */
+        case LV_HASP_DROPDOWN:
+        case HASP_OBJ_DROPDOWN:
+            obj = lv_dropdown_create(parent_obj, NULL);
+            if(obj) {
+                lv_dropdown_set_text(obj, NULL); // Clear default text
+                lv_dropdown_set_draw_arrow(obj, true);
+                // lv_dropdown_set_anim_time(obj, 200);
+                lv_obj_set_top(obj, true);
+                // lv_obj_align(obj, NULL, LV_ALIGN_IN_TOP_MID, 0, 20);
+                lv_obj_set_event_cb(obj, selector_event_handler);
+                obj->user_data.objid = LV_HASP_DROPDOWN;
+            }
+            break;
+
+        case LV_HASP_ROLLER:
+        case HASP_OBJ_ROLLER:
+            obj = lv_roller_create(parent_obj, NULL);
+            // lv_obj_align(obj, NULL, LV_ALIGN_IN_TOP_MID, 0, 20);
+            if(obj) {
+                lv_roller_set_auto_fit(obj, false);
+                lv_obj_set_event_cb(obj, selector_event_handler);
+                obj->user_data.objid = LV_HASP_ROLLER;
+            }
+            break;
+
+        case LV_HASP_MSGBOX:
+        case HASP_OBJ_MSGBOX:
+            obj = lv_msgbox_create(parent_obj, NULL);
+            if(obj) {
+                /* Assign default OK btnmap and enable recolor */
+                if(msgbox_default_map) lv_msgbox_add_btns(obj, msgbox_default_map);
+                lv_msgbox_ext_t* ext = (lv_msgbox_ext_t*)lv_obj_get_ext_attr(obj);
+                if(ext && ext->btnm) lv_btnmatrix_set_recolor(ext->btnm, true);
+
+                /* msgbox parameters */
+                lv_obj_align(obj, NULL, LV_ALIGN_CENTER, 0, 0);
+                lv_obj_set_auto_realign(obj, true);
+                lv_obj_set_event_cb(obj, msgbox_event_handler);
+                obj->user_data.objid = LV_HASP_MSGBOX;
+            }
+            break;
+
+#if LV_USE_CALENDAR > 0
+        case LV_HASP_CALENDER:
+        case HASP_OBJ_CALENDAR:
+            obj = lv_calendar_create(parent_obj, NULL);
+            // lv_obj_align(obj, NULL, LV_ALIGN_IN_TOP_MID, 0, 20);
+            if(obj) {
+                lv_obj_set_event_cb(obj, calendar_event_handler);
+                obj->user_data.objid = LV_HASP_CALENDER;
+
+                object_add_task(obj, event_timer_calendar, 5000);
+            }
+            break;
+#endif
+
+            /* ----- Other Object ------ */
+            // default:
+            //    return LOG_WARNING(TAG_HASP, F("Unsupported Object ID %u"), objid);
+    }
+
+    if(obj) {
+        // Prevent losing press when the press is slid out of the objects.
+        // (E.g. a Button can be released out of it if it was being pressed)
+        lv_obj_add_protect(obj, LV_PROTECT_PRESS_LOST);
+        lv_obj_set_gesture_parent(obj, false);
+        lv_obj_set_click(obj, true);
+    }
+    return obj;
+}
+
 /**
  * Create a new object according to the json config
  * @param config Json representation for this object
@@ -230,6 +676,15 @@ void hasp_new_object(const JsonObject& config, uint8_t& saved_page_id)
     /* Skip line detection */
     if(!config[FPSTR(FP_SKIP)].isNull() && config[FPSTR(FP_SKIP)].as<bool>()) return;
 
+    /* Class definition */
+    if(!config[FPSTR(FP_CLASS)].isNull() && config[FPSTR(FP_ID)].isNull()) {
+        std::string name = config[FPSTR(FP_CLASS)].as<std::string>();
+        config.remove(FPSTR(FP_CLASS));
+        config.remove(FPSTR(FP_PAGE)); // classes are global
+        hasp_style_define(name.c_str(), config);
+        return;
+    }
+
     /* Page selection */
     uint8_t pageid = saved_page_id;
     if(!config[FPSTR(FP_PAGE)].isNull()) {
@@ -246,6 +701,10 @@ void hasp_new_object(const JsonObject& config, uint8_t& saved_page_id)
         saved_page_id = pageid; /* save the current pageid for next objects */
     }
 
+#if HASP_USE_LAZY_PAGES > 0
+    haspPages.pin(pageid); /* build the page before adding runtime objects */
+#endif
+
     /* A custom parentid was set */
     if(!config[FPSTR(FP_PARENTID)].isNull()) {
         uint8_t parentid = config[FPSTR(FP_PARENTID)].as<uint8_t>();
@@ -265,6 +724,7 @@ void hasp_new_object(const JsonObject& config, uint8_t& saved_page_id)
 
     /* Create the object if it does not exist */
     lv_obj_t* obj = hasp_find_obj_from_parent_id(parent_obj, id);
+    bool created  = !obj;
     if(!obj) {
 
         /* Create the object first */
@@ -284,418 +744,7 @@ void hasp_new_object(const JsonObject& config, uint8_t& saved_page_id)
         //     config.remove(FPSTR(FP_OBJID));
         // }
 
-        switch(sdbm) {
-                /* ----- Custom Objects ------ */
-            case LV_HASP_ALARM:
-            case HASP_OBJ_ALARM:
-                obj = lv_obj_create(parent_obj, NULL);
-                if(obj) obj->user_data.objid = LV_HASP_ALARM;
-                break;
-
-            /* ----- Basic Objects ------ */
-            case LV_HASP_BTNMATRIX:
-            case HASP_OBJ_BTNMATRIX:
-                obj = lv_btnmatrix_create(parent_obj, NULL);
-                if(obj) {
-                    lv_btnmatrix_set_recolor(obj, true);
-                    if(obj_check_type(parent_obj, LV_HASP_ALARM))
-                        lv_obj_set_event_cb(obj, alarm_event_handler);
-                    else
-                        lv_obj_set_event_cb(obj, btnmatrix_event_handler);
-
-                    lv_btnmatrix_ext_t* ext = (lv_btnmatrix_ext_t*)lv_obj_get_ext_attr(obj);
-                    btnmatrix_default_map   = ext->map_p; // store the static pointer to the default lvgl btnmap
-                    obj->user_data.objid    = LV_HASP_BTNMATRIX;
-                }
-                break;
-
-#if LV_USE_TABLE > 0
-            case LV_HASP_TABLE:
-            case HASP_OBJ_TABLE:
-                obj = lv_table_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, selector_event_handler);
-                    obj->user_data.objid = LV_HASP_TABLE;
-                }
-                break;
-#endif
-
-            case LV_HASP_BUTTON:
-            case HASP_OBJ_BTN:
-                obj = lv_btn_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_t* lbl = lv_label_create(obj, NULL);
-                    if(lbl) {
-                        lv_label_set_text(lbl, "");
-                        lv_label_set_recolor(lbl, true);
-                        lbl->user_data.objid = LV_HASP_LABEL;
-                        lv_obj_align(lbl, NULL, LV_ALIGN_CENTER, 0, 0);
-                    }
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_BUTTON;
-                }
-                break;
-
-            case LV_HASP_CHECKBOX:
-            case HASP_OBJ_CHECKBOX:
-                obj = lv_checkbox_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, toggle_event_handler);
-                    obj->user_data.objid = LV_HASP_CHECKBOX;
-                }
-                break;
-
-            case LV_HASP_LABEL:
-            case HASP_OBJ_LABEL:
-                obj = lv_label_create(parent_obj, NULL);
-                if(obj) {
-                    lv_label_set_long_mode(obj, LV_LABEL_LONG_CROP);
-                    lv_label_set_recolor(obj, true);
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_LABEL;
-
-                    // if(id >= 250) object_add_task(obj, event_timer_clock, 1000);
-                }
-                break;
-
-            case LV_HASP_TEXTAREA:
-            case HASP_OBJ_TEXTAREA:
-                obj = lv_textarea_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, textarea_event_handler);
-                    lv_textarea_set_cursor_click_pos(obj, true);
-                    obj->user_data.objid = LV_HASP_TEXTAREA;
-                }
-                break;
-
-            case LV_HASP_IMAGE:
-            case HASP_OBJ_IMG:
-                obj = lv_img_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_IMAGE;
-                }
-                break;
-
-#if HASP_USE_QRCODE > 0
-            case LV_HASP_QRCODE:
-            case HASP_OBJ_QRCODE:
-                obj = lv_qrcode_create(parent_obj, 140, LV_COLOR_BLACK, LV_COLOR_WHITE);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, delete_event_handler);
-                    obj->user_data.objid = LV_HASP_QRCODE;
-                }
-                break;
-#endif
-
-            case LV_HASP_ARC:
-            case HASP_OBJ_ARC:
-                obj = lv_arc_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_ARC;
-                }
-                break;
-
-            case LV_HASP_CONTAINER:
-            case HASP_OBJ_CONT:
-                obj = lv_cont_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_CONTAINER;
-                }
-                break;
-
-            case LV_HASP_OBJECT:
-            case HASP_OBJ_OBJ:
-                obj = lv_obj_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_OBJECT;
-                }
-                break;
-
-#if LVGL_VERSION_MAJOR == 7 && LV_USE_PAGE
-            case LV_HASP_PAGE:
-            case HASP_OBJ_PAGE:
-                obj = lv_page_create(parent_obj, NULL);
-                if(obj) obj->user_data.objid = LV_HASP_PAGE;
-                // No event handler for pages
-                break;
-#endif
-
-#if LV_USE_WIN && LVGL_VERSION_MAJOR == 7
-            case LV_HASP_WINDOW:
-            case HASP_OBJ_WIN:
-                obj = lv_win_create(parent_obj, NULL);
-                if(obj) obj->user_data.objid = LV_HASP_WINDOW;
-                // No event handler for pages
-                break;
-
-#endif
-
-#if LVGL_VERSION_MAJOR == 8
-            case LV_HASP_LED:
-            case HASP_OBJ_LED:
-                obj = lv_led_create(parent_obj);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_LED;
-                }
-                break;
-
-            case LV_HASP_TILEVIEW:
-            case HASP_OBJ_TILEVIEW:
-                obj = lv_tileview_create(parent_obj);
-                if(obj) obj->user_data.objid = LV_HASP_TILEVIEW;
-                // No event handler for tileviews
-                break;
-
-            case LV_HASP_TABVIEW:
-            case HASP_OBJ_TABVIEW:
-                obj = lv_tabview_create(parent_obj, LV_DIR_TOP, 100);
-                // No event handler for tabs
-                if(obj) {
-                    lv_obj_set_event_cb(obj, selector_event_handler);
-                    obj->user_data.objid = LV_HASP_TABVIEW;
-                }
-                break;
-
-#else
-            case LV_HASP_LED:
-            case HASP_OBJ_LED:
-                obj = lv_led_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_LED;
-                }
-                break;
-
-#if LV_USE_TILEVIEW > 0
-            case LV_HASP_TILEVIEW:
-            case HASP_OBJ_TILEVIEW:
-                obj = lv_tileview_create(parent_obj, NULL);
-                if(obj) obj->user_data.objid = LV_HASP_TILEVIEW;
-
-                // No event handler for tileviews
-                break;
-#endif
-
-            case LV_HASP_TABVIEW:
-            case HASP_OBJ_TABVIEW:
-                obj = lv_tabview_create(parent_obj, NULL);
-                // No event handler for tabs
-                if(obj) {
-                    lv_obj_set_event_cb(obj, selector_event_handler);
-                    obj->user_data.objid = LV_HASP_TABVIEW;
-                }
-                break;
-
-            case LV_HASP_TAB:
-            case HASP_OBJ_TAB:
-                if(parent_obj && parent_obj->user_data.objid == LV_HASP_TABVIEW) {
-                    obj = lv_tabview_add_tab(parent_obj, "Tab");
-                    if(obj) {
-                        lv_obj_set_event_cb(obj, generic_event_handler);
-                        obj->user_data.objid = LV_HASP_TAB;
-                    }
-                } else {
-                    LOG_WARNING(TAG_HASP, F("Parent of a tab must be a tabview object"));
-                    return;
-                }
-                break;
-
-#endif
-            /* ----- Color Objects ------ */
-            case LV_HASP_CPICKER:
-            case HASP_OBJ_CPICKER:
-                obj = lv_cpicker_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, cpicker_event_handler);
-                    obj->user_data.objid = LV_HASP_CPICKER;
-                }
-                break;
-
-#if LV_USE_SPINNER != 0
-            case LV_HASP_SPINNER:
-            case HASP_OBJ_SPINNER:
-                obj = lv_spinner_create(parent_obj, NULL);
-                if(obj) {
-                    obj->user_data.objid = LV_HASP_SPINNER;
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                }
-                break;
-#endif
-
-            /* ----- Range Objects ------ */
-            case LV_HASP_SLIDER:
-            case HASP_OBJ_SLIDER:
-                obj = lv_slider_create(parent_obj, NULL);
-                if(obj) {
-                    lv_slider_set_range(obj, 0, 100);
-                    lv_obj_set_event_cb(obj, slider_event_handler);
-                    obj->user_data.objid = LV_HASP_SLIDER;
-                }
-                // bool knobin = config[F("knobin")].as<bool>() | true;
-                // lv_slider_set_knob_in(obj, knobin);
-                break;
-
-            case LV_HASP_GAUGE:
-            case HASP_OBJ_GAUGE:
-                obj = lv_gauge_create(parent_obj, NULL);
-                if(obj) {
-                    lv_gauge_set_range(obj, 0, 100);
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_GAUGE;
-                }
-                break;
-
-            case LV_HASP_LINE:
-            case HASP_OBJ_LINE:
-                obj = lv_line_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_style_local_line_width(obj, LV_LINE_PART_MAIN, LV_STATE_DEFAULT, 1);
-                    lv_obj_set_event_cb(obj, delete_event_handler);
-                    obj->user_data.objid = LV_HASP_LINE;
-                }
-                break;
-
-            case LV_HASP_BAR:
-            case HASP_OBJ_BAR:
-                obj = lv_bar_create(parent_obj, NULL);
-                if(obj) {
-                    lv_bar_set_range(obj, 0, 100);
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_BAR;
-                }
-                break;
-
-            case LV_HASP_LINEMETER:
-            case HASP_OBJ_LMETER: // obsolete
-            case HASP_OBJ_LINEMETER:
-                obj = lv_linemeter_create(parent_obj, NULL);
-                if(obj) {
-                    lv_linemeter_set_range(obj, 0, 100);
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_LINEMETER;
-                }
-                break;
-
-#if LV_USE_SPINBOX > 0
-            case LV_HASP_SPINBOX:
-            case HASP_OBJ_SPINBOX:
-                obj = lv_spinbox_create(parent_obj, NULL);
-                if(obj) {
-                    lv_spinbox_set_range(obj, 0, 100);
-                    lv_obj_set_event_cb(obj, slider_event_handler);
-                    obj->user_data.objid = LV_HASP_SPINBOX;
-                }
-                break;
-#endif
-
-            case LV_HASP_LIST:
-            case HASP_OBJ_LIST:
-                obj = lv_list_create(parent_obj, NULL);
-                if(obj) {
-                    // Callbacks are set on the individual buttons
-                    obj->user_data.objid = LV_HASP_LIST;
-                }
-                break;
-
-#if LV_USE_CHART > 0
-            case LV_HASP_CHART:
-            case HASP_OBJ_CHART:
-                obj = lv_chart_create(parent_obj, NULL);
-                if(obj) {
-                    lv_chart_set_range(obj, 0, 100);
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-
-                    lv_chart_add_series(obj, LV_COLOR_RED);
-                    lv_chart_add_series(obj, LV_COLOR_GREEN);
-                    lv_chart_add_series(obj, LV_COLOR_BLUE);
-
-                    lv_chart_series_t* ser = my_chart_get_series(obj, 2);
-                    lv_chart_set_next(obj, ser, 10);
-                    lv_chart_set_next(obj, ser, 20);
-                    lv_chart_set_next(obj, ser, 30);
-                    lv_chart_set_next(obj, ser, 40);
-
-                    obj->user_data.objid = LV_HASP_CHART;
-                }
-                break;
-#endif
-
-            /* ----- On/Off Objects ------ */
-            case LV_HASP_SWITCH:
-            case HASP_OBJ_SWITCH:
-                obj = lv_switch_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, toggle_event_handler);
-                    obj->user_data.objid = LV_HASP_SWITCH;
-                }
-                break;
-
-            /* ----- List Object ------- */
-            case LV_HASP_DROPDOWN:
-            case HASP_OBJ_DROPDOWN:
-                obj = lv_dropdown_create(parent_obj, NULL);
-                if(obj) {
-                    lv_dropdown_set_text(obj, NULL); // Clear default text
-                    lv_dropdown_set_draw_arrow(obj, true);
-                    // lv_dropdown_set_anim_time(obj, 200);
-                    lv_obj_set_top(obj, true);
-                    // lv_obj_align(obj, NULL, LV_ALIGN_IN_TOP_MID, 0, 20);
-                    lv_obj_set_event_cb(obj, selector_event_handler);
-                    obj->user_data.objid = LV_HASP_DROPDOWN;
-                }
-                break;
-
-            case LV_HASP_ROLLER:
-            case HASP_OBJ_ROLLER:
-                obj = lv_roller_create(parent_obj, NULL);
-                // lv_obj_align(obj, NULL, LV_ALIGN_IN_TOP_MID, 0, 20);
-                if(obj) {
-                    lv_roller_set_auto_fit(obj, false);
-                    lv_obj_set_event_cb(obj, selector_event_handler);
-                    obj->user_data.objid = LV_HASP_ROLLER;
-                }
-                break;
-
-            case LV_HASP_MSGBOX:
-            case HASP_OBJ_MSGBOX:
-                obj = lv_msgbox_create(parent_obj, NULL);
-                if(obj) {
-                    /* Assign default OK btnmap and enable recolor */
-                    if(msgbox_default_map) lv_msgbox_add_btns(obj, msgbox_default_map);
-                    lv_msgbox_ext_t* ext = (lv_msgbox_ext_t*)lv_obj_get_ext_attr(obj);
-                    if(ext && ext->btnm) lv_btnmatrix_set_recolor(ext->btnm, true);
-
-                    /* msgbox parameters */
-                    lv_obj_align(obj, NULL, LV_ALIGN_CENTER, 0, 0);
-                    lv_obj_set_auto_realign(obj, true);
-                    lv_obj_set_event_cb(obj, msgbox_event_handler);
-                    obj->user_data.objid = LV_HASP_MSGBOX;
-                }
-                break;
-
-#if LV_USE_CALENDAR > 0
-            case LV_HASP_CALENDER:
-            case HASP_OBJ_CALENDAR:
-                obj = lv_calendar_create(parent_obj, NULL);
-                // lv_obj_align(obj, NULL, LV_ALIGN_IN_TOP_MID, 0, 20);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, calendar_event_handler);
-                    obj->user_data.objid = LV_HASP_CALENDER;
-
-                    object_add_task(obj, pageid, id, event_timer_calendar, 5000);
-                }
-                break;
-#endif
-
-                /* ----- Other Object ------ */
-                // default:
-                //    return LOG_WARNING(TAG_HASP, F("Unsupported Object ID %u"), objid);
-        }
+        obj = hasp_create_object(parent_obj, sdbm);
 
         /* No object was actually created */
         if(!obj) {
@@ -703,12 +752,6 @@ void hasp_new_object(const JsonObject& config, uint8_t& saved_page_id)
             return;
         }
 
-        // Prevent losing press when the press is slid out of the objects.
-        // (E.g. a Button can be released out of it if it was being pressed)
-        lv_obj_add_protect(obj, LV_PROTECT_PRESS_LOST);
-        lv_obj_set_gesture_parent(obj, false);
-        lv_obj_set_click(obj, true);
-
         /* id tag the object */
         obj->user_data.id = id;
 
@@ -740,5 +783,12 @@ void hasp_new_object(const JsonObject& config, uint8_t& saved_page_id)
         // object already exists
     }
 
+    /* Shared styles first, so the attributes of this line take precedence */
+    if(!config[FPSTR(FP_CLASS)].isNull()) {
+        std::string name = config[FPSTR(FP_CLASS)].as<std::string>();
+        config.remove(FPSTR(FP_CLASS));
+        hasp_style_apply(obj, name.c_str(), created);
+    }
+
     hasp_parse_json_attributes(obj, config);
 }
@@ -95,6 +95,7 @@ enum lv_hasp_obj_type_t {
 };
 
 void hasp_new_object(const JsonObject& config, uint8_t& saved_page_id);
+lv_obj_t* hasp_create_object(lv_obj_t* parent_obj, uint16_t sdbm);
 
 lv_obj_t* hasp_find_obj_from_parent_id(lv_obj_t* parent, uint8_t objid);
 lv_obj_t* hasp_find_obj_from_page_id(uint8_t pageid, uint8_t objid);
@@ -107,6 +108,7 @@ void object_dispatch_state(uint8_t pageid, uint8_t btnid, const char* payload);
 void hasp_process_attribute(uint8_t pageid, uint8_t objid, const char* attr, const char* payload, bool update);
 int hasp_parse_json_attributes(lv_obj_t* obj, const JsonObject& doc);
 
+void object_set_group_values(lv_obj_t* parent, hasp_update_value_t& value);
 void object_set_normalized_group_values(hasp_update_value_t& value);
 
 /**
@@ -127,7 +129,9 @@ inline lv_hasp_obj_type_t obj_get_type(const lv_obj_t* obj)
  */
 inline const char* obj_get_type_name(const lv_obj_t* obj)
 {
-    if(obj_get_type(obj) == LV_HASP_TAB) return "tab"; // LVGL reports tab objects as "lv_page"
+    if(obj_get_type(obj) == LV_HASP_TAB) return "tab";       // LVGL reports tab objects as "lv_page"
+    if(obj_get_type(obj) == LV_HASP_ALARM) return "alarm";   // and alarms as "lv_obj"
+    if(obj_get_type(obj) == LV_HASP_QRCODE) return "qrcode"; // and qrcodes as "lv_canvas"
 
     lv_obj_type_t list;
     lv_obj_get_type(obj, &list);
@@ -16,6 +16,99 @@
 
 namespace hasp {
 
+#if HASP_USE_LAZY_PAGES > 0
+/* Lazy pages
+ *
+ * While loading the pages file, only the file offsets of the objects on pages 1 to HASP_NUM_PAGES are recorded.
+ * Page properties and objects on page 0 are created immediately. The objects of a page are created from the
+ * recorded offsets when the page is first loaded. Attribute updates, group updates and values changed by the user are
+ * retained per page in the order they were last set, so a page that is evicted under memory pressure can be rebuilt
+ * with its last values. A min or max set after a val is replayed after it, as it was applied.
+ *
+ * The offsets are only valid as long as the pages file does not change. Before it is overwritten or another file is
+ * indexed, drop_index builds the pages that still depend on it and they are no longer evicted.
+ */
+#if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
+static inline uint32_t page_file_tell(File& file)
+{
+    return file.position();
+}
+static inline void page_file_seek(File& file, uint32_t pos)
+{
+    file.seek(pos);
+}
+#else
+static inline uint32_t page_file_tell(std::istream& file)
+{
+    return file.tellg();
+}
+static inline void page_file_seek(std::istream& file, uint32_t pos)
+{
+    file.clear();
+    file.seekg(pos);
+}
+#endif
+
+// Record the position of each object, only page properties and page 0 objects are created
+template <class T> static void page_index_jsonl(T& file, uint8_t& saved_page_id)
+{
+    DynamicJsonDocument jsonl(MQTT_MAX_PACKET_SIZE / 2 + 128);
+    uint32_t start = page_file_tell(file);
+
+    while(deserializeJson(jsonl, file) == DeserializationError::Ok) {
+        uint32_t end       = page_file_tell(file);
+        JsonObject config  = jsonl.as<JsonObject>();
+        uint8_t pageid     = config[FPSTR(FP_PAGE)].isNull() ? saved_page_id : config[FPSTR(FP_PAGE)].as<uint8_t>();
+        bool is_page_child = config[FPSTR(FP_ID)].as<uint8_t>() > 0 && pageid >= PAGE_START_INDEX &&
+                             pageid <= HASP_NUM_PAGES;
+
+        if(is_page_child && haspPages.add_source(pageid, start, end - start)) {
+            saved_page_id = pageid;
+        } else {
+            hasp_new_object(config, saved_page_id);
+        }
+        start = end;
+    }
+}
+
+// Create the objects between offset and offset + length
+template <class T> static void page_parse_source(T& file, uint32_t offset, uint32_t length, uint8_t pageid)
+{
+    DynamicJsonDocument jsonl(MQTT_MAX_PACKET_SIZE / 2 + 128);
+    page_file_seek(file, offset);
+
+    while(page_file_tell(file) < offset + length && deserializeJson(jsonl, file) == DeserializationError::Ok) {
+        hasp_new_object(jsonl.as<JsonObject>(), pageid);
+    }
+}
+
+// One entry per key, moved to the end when it is set again so the values are replayed in the order they were last set
+static hasp_page_retained_t& page_retained_entry(hasp_page_lazy_data_t* lazy, const std::string& key)
+{
+    std::vector<hasp_page_retained_t>& retained = lazy->retained;
+    for(auto it = retained.begin(); it != retained.end(); ++it) {
+        if(it->key != key) continue;
+        hasp_page_retained_t entry = std::move(*it);
+        retained.erase(it);
+        retained.push_back(std::move(entry));
+        return retained.back();
+    }
+    retained.push_back(hasp_page_retained_t());
+    retained.back().key = key;
+    return retained.back();
+}
+
+// Compare two paths to the same file, with or without the lvgl drive letter or a leading dot
+static bool page_same_file(const char* a, const char* b)
+{
+    if(a[0] == 'L' && a[1] == ':') a += 2;
+    if(b[0] == 'L' && b[1] == ':') b += 2;
+    if(a[0] == '.' && (a[1] == '/' || a[1] == '\\')) a++;
+    if(b[0] == '.' && (b[1] == '/' || b[1] == '\\')) b++;
+    return !strcmp(a, b);
+}
+#endif // HASP_USE_LAZY_PAGES
+
 bool Page::is_valid(uint8_t pageid)
 {
     if(pageid > 0 && pageid <= HASP_NUM_PAGES) return true;
@@ -76,6 +169,16 @@ void Page::init(uint8_t start_page)
         _meta_data[i].back = start_page;
 
         set_name(i, NULL);
+
+#if HASP_USE_LAZY_PAGES > 0
+        _lazy[i].sources.clear();
+        _lazy[i].retained.clear();
+        _lazy[i].last_shown = 0;
+        _lazy[i].build_time = 0;
+        _lazy[i].resident   = 0;
+        _lazy[i].built      = true; // until sources are added
+        _lazy[i].pinned     = false;
+#endif
     }
 }
 
@@ -85,6 +188,15 @@ void Page::clear(uint8_t pageid)
     if(page == lv_layer_top() || is_valid(pageid)) {
         LOG_TRACE(TAG_HASP, F(D_HASP_CLEAR_PAGE), pageid);
         lv_obj_clean(page);
+#if HASP_USE_LAZY_PAGES > 0
+        if(pageid >= PAGE_START_INDEX && pageid <= HASP_NUM_PAGES) {
+            hasp_page_lazy_data_t* lazy = &_lazy[pageid - PAGE_START_INDEX];
+            lazy->sources.clear();
+            lazy->retained.clear();
+            lazy->built  = true;
+            lazy->pinned = true; // objects can only be added at runtime now
+        }
+#endif
     } else {
         LOG_WARNING(TAG_HASP, F(D_HASP_INVALID_LAYER)); // lv_layer_sys
     }
@@ -94,6 +206,12 @@ void Page::set(uint8_t pageid, lv_scr_load_anim_t anim_type, uint32_t time, uint
 {
     if(!is_valid(pageid)) return; // produces a log warning if not between 1 and 12
 
+#if HASP_USE_LAZY_PAGES > 0
+    build(pageid); // create the page objects on first use
+    _lazy[pageid - PAGE_START_INDEX].last_shown = lv_tick_get();
+    evict_inactive(pageid);
+#endif
+
     lv_obj_t* page = get_obj(pageid);
     if(!page) {
         // Invalid page object
@@ -107,6 +225,9 @@ void Page::set(uint8_t pageid, lv_scr_load_anim_t anim_type, uint32_t time, uint
     } else if((anim_type != LV_SCR_LOAD_ANIM_NONE && time > 0) || delay > 0) {
         // Change page after a delay or animation, don't publish it yet
         my_scr_load_anim(page, anim_type, time, delay, false); // dispatches when animation ends
+#if HASP_USE_FREETYPE > 0
+        font_page_switched(pageid);
+#endif
 
     } else {
         // No delay or animation set, update now
@@ -114,6 +235,9 @@ void Page::set(uint8_t pageid, lv_scr_load_anim_t anim_type, uint32_t time, uint
         lv_scr_load_anim(page, anim_type, time, delay, false);
         _current_page = pageid;
         dispatch_current_page();
+#if HASP_USE_FREETYPE > 0
+        font_page_switched(pageid);
+#endif
 #if defined(HASP_DEBUG_OBJ_TREE)
         hasp_object_tree(page, pageid, 0);
 #endif
@@ -175,7 +299,7 @@ void Page::set_name(uint8_t pageid, const char* name)
 
     LOG_DEBUG(TAG_HASP, F("%s - %d"), __FILE__, __LINE__);
     if(size > 1) {
-        _pagenames[pageid] = (char*)hasp_calloc(sizeof(char), size);
+        _pagenames[pageid] = (char*)hasp_calloc_persistent(sizeof(char), size);
         LOG_DEBUG(TAG_HASP, F("%s - %d"), __FILE__, __LINE__);
         if(_pagenames[pageid] == NULL) return;
         strncpy(_pagenames[pageid], name, size);
@@ -204,7 +328,8 @@ uint8_t Page::get()
     return _current_page;
 }
 
-void Page::load_jsonl(const char* pagesfile)
+// A lazy load only records where the page objects are, load other files with lazy = false to parse them right away
+void Page::load_jsonl(const char* pagesfile, bool lazy)
 {
     uint8_t savedPage = haspPages.get();
 #if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
@@ -227,7 +352,16 @@ void Page::load_jsonl(const char* pagesfile)
         LOG_ERROR(TAG_HASP, F(D_FILE_LOAD_FAILED), pagesfile);
         return;
     }
-    dispatch_parse_jsonl(file, savedPage);
+#if HASP_USE_LAZY_PAGES > 0
+    if(lazy) {
+        if(!_lazy_file.empty()) drop_index(_lazy_file.c_str());
+        _lazy_file    = pagesfile;
+        _lazy_loading = true;
+        page_index_jsonl(file, savedPage);
+        _lazy_loading = false;
+    } else
+#endif
+        dispatch_parse_jsonl(file, savedPage);
     file.close();
 
     LOG_INFO(TAG_HASP, F(D_FILE_LOADED), pagesfile);
@@ -253,7 +387,16 @@ void Page::load_jsonl(const char* pagesfile)
     LOG_TRACE(TAG_HASP, F("Loading %s from disk..."), path);
     std::ifstream f(path); // taking file as inputstream
     if(f) {
-        dispatch_parse_jsonl(f, savedPage);
+#if HASP_USE_LAZY_PAGES > 0
+        if(lazy) {
+            if(!_lazy_file.empty()) drop_index(_lazy_file.c_str());
+            _lazy_file    = path;
+            _lazy_loading = true;
+            page_index_jsonl(f, savedPage);
+            _lazy_loading = false;
+        } else
+#endif
+            dispatch_parse_jsonl(f, savedPage);
     }
     f.close();
     LOG_INFO(TAG_HASP, F("Loaded %s from disk"), path);
@@ -315,6 +458,183 @@ bool Page::get_id(const lv_obj_t* obj, uint8_t* pageid)
     return false;
 }
 
+#if HASP_USE_LAZY_PAGES > 0
+bool Page::is_built(uint8_t pageid)
+{
+    if(pageid < PAGE_START_INDEX || pageid > HASP_NUM_PAGES) return true; // layers are always built
+    return _lazy[pageid - PAGE_START_INDEX].built;
+}
+
+// Returns false when the page can't be rebuilt, its objects must be created now
+bool Page::add_source(uint8_t pageid, uint32_t offset, uint32_t length)
+{
+    if(pageid < PAGE_START_INDEX || pageid > HASP_NUM_PAGES) return false;
+
+    hasp_page_lazy_data_t* lazy = &_lazy[pageid - PAGE_START_INDEX];
+    if(lazy->pinned) return false;
+
+    if(!lazy->sources.empty() && lazy->sources.back().first + lazy->sources.back().second == offset) {
+        lazy->sources.back().second += length; // merge consecutive objects into one read
+    } else {
+        lazy->sources.push_back(std::make_pair(offset, length));
+    }
+    lazy->built = false;
+    return true;
+}
+
+// The pages file is about to change, build the pages that still depend on it and keep them from now on
+void Page::drop_index(const char* filename)
+{
+    if(_lazy_file.empty() || !page_same_file(_lazy_file.c_str(), filename)) return;
+
+    GuiLock lock("pages"); // called from the web server too
+    for(uint8_t i = 0; i < HASP_NUM_PAGES; i++) {
+        hasp_page_lazy_data_t* lazy = &_lazy[i];
+        if(lazy->sources.empty()) continue;
+
+        build(i + PAGE_START_INDEX);
+        lazy->sources.clear();
+        lazy->retained.clear();
+        lazy->pinned = true;
+    }
+    LOG_VERBOSE(TAG_HASP, F("Pages no longer loaded from %s"), _lazy_file.c_str());
+    _lazy_file.clear();
+}
+
+// Create the objects from the pages file and restore the retained attribute values
+void Page::build(uint8_t pageid)
+{
+    if(is_built(pageid)) return;
+
+    hasp_page_lazy_data_t* lazy = &_lazy[pageid - PAGE_START_INDEX];
+    lazy->built                 = true; // hasp_new_object must not trigger a build
+    _lazy_loading               = true;
+
+    uint32_t start = millis();
+#if LV_MEM_CUSTOM == 0
+    lv_mem_monitor_t mem_mon;
+    lv_mem_monitor(&mem_mon);
+    uint32_t free_before = mem_mon.free_size;
+#endif
+
+#if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
+    File file = HASP_FS.open(_lazy_file.c_str(), "r");
+#else
+    std::ifstream file(_lazy_file.c_str());
+#endif
+    if(file) {
+        for(auto& source : lazy->sources) page_parse_source(file, source.first, source.second, pageid);
+        file.close();
+    } else {
+        LOG_ERROR(TAG_HASP, F(D_FILE_LOAD_FAILED), _lazy_file.c_str());
+    }
+
+    for(auto& item : lazy->retained) {
+        if(item.key[0] == 'g') {
+            object_set_group_values(_pages[pageid - PAGE_START_INDEX], item.group);
+            continue;
+        }
+        size_t pos = item.key.find('.');
+        if(lv_obj_t* obj = hasp_find_obj_from_page_id(pageid, atoi(item.key.c_str()))) {
+            hasp_process_obj_attribute(obj, item.key.c_str() + pos + 1, item.payload.c_str(), true);
+        }
+    }
+    _lazy_loading = false;
+
+    lazy->build_time = millis() - start;
+#if LV_MEM_CUSTOM == 0
+    lv_mem_monitor(&mem_mon);
+    lazy->resident = free_before > mem_mon.free_size ? free_before - mem_mon.free_size : 0;
+#endif
+    LOG_VERBOSE(TAG_HASP, F("Page %u built in %u ms, %u bytes"), pageid, lazy->build_time, lazy->resident);
+}
+
+// Tear down the objects of a page, it is rebuilt on the next load
+void Page::evict(uint8_t pageid)
+{
+    hasp_page_lazy_data_t* lazy = &_lazy[pageid - PAGE_START_INDEX];
+    lv_obj_clean(_pages[pageid - PAGE_START_INDEX]);
+    lazy->built = false;
+    LOG_VERBOSE(TAG_HASP, F("Page %u evicted, %u bytes"), pageid, lazy->resident);
+}
+
+// Evict the least recently shown pages while LVGL memory is low
+void Page::evict_inactive(uint8_t keep_pageid)
+{
+#if LV_MEM_CUSTOM == 0
+    lv_mem_monitor_t mem_mon;
+    lv_mem_monitor(&mem_mon);
+
+    while(mem_mon.free_size < HASP_LAZY_PAGES_MIN_FREE) {
+        uint8_t lru = 0;
+        for(uint8_t i = 0; i < HASP_NUM_PAGES; i++) {
+            hasp_page_lazy_data_t* lazy = &_lazy[i];
+            if(!lazy->built || lazy->pinned || lazy->sources.empty()) continue;
+            if(i + PAGE_START_INDEX == keep_pageid || _pages[i] == lv_scr_act()) continue;
+            if(lru == 0 || lazy->last_shown < _lazy[lru - PAGE_START_INDEX].last_shown) lru = i + PAGE_START_INDEX;
+        }
+        if(lru == 0) break; // nothing left to evict
+
+        evict(lru);
+        lv_mem_monitor(&mem_mon);
+    }
+#endif
+}
+
+// Runtime objects are not in the pages file, build the page first and never evict it
+void Page::pin(uint8_t pageid)
+{
+    if(_lazy_loading || pageid < PAGE_START_INDEX || pageid > HASP_NUM_PAGES) return;
+    build(pageid);
+    _lazy[pageid - PAGE_START_INDEX].pinned = true;
+}
+
+// Keep the last value of an attribute, to restore it when the page is rebuilt
+void Page::retain(uint8_t pageid, uint8_t objid, const char* attr, const char* payload)
+{
+    if(_lazy_loading || pageid < PAGE_START_INDEX || pageid > HASP_NUM_PAGES) return;
+
+    hasp_page_lazy_data_t* lazy = &_lazy[pageid - PAGE_START_INDEX];
+    if(lazy->sources.empty()) return; // page can't be evicted
+
+    std::string key = std::to_string(objid);
+    key += '.';
+    key += attr;
+    page_retained_entry(lazy, key).payload = payload;
+}
+
+// Keep the last value of a group, the objects of the group may be on a page that is not built
+void Page::retain_group(uint8_t pageid, const hasp_update_value_t& value)
+{
+    if(_lazy_loading || pageid < PAGE_START_INDEX || pageid > HASP_NUM_PAGES) return;
+
+    hasp_page_lazy_data_t* lazy = &_lazy[pageid - PAGE_START_INDEX];
+    if(lazy->sources.empty()) return; // page can't be evicted
+
+    hasp_page_retained_t& entry = page_retained_entry(lazy, "g" + std::to_string(value.group));
+    entry.group                 = value;
+    entry.group.obj             = NULL; // the sender may be deleted before the page is built
+}
+
+void Page::get_info(JsonObject& info)
+{
+    char size_buf[32];
+    char buffer[64];
+    char key[8];
+
+    for(uint8_t i = 0; i < HASP_NUM_PAGES; i++) {
+        hasp_page_lazy_data_t* lazy = &_lazy[i];
+        if(lazy->sources.empty()) continue;
+
+        Parser::format_bytes(lazy->resident, size_buf, sizeof(size_buf));
+        snprintf_P(buffer, sizeof(buffer), PSTR("%s, %u ms, %s"), lazy->built ? "loaded" : "unloaded",
+                   lazy->build_time, size_buf);
+        snprintf_P(key, sizeof(key), PSTR("Page %u"), i + PAGE_START_INDEX);
+        info[key] = buffer;
+    }
+}
+#endif // HASP_USE_LAZY_PAGES
+
 } // namespace hasp
 
 hasp::Page haspPages;
@@ -6,11 +6,20 @@
 
 #include "hasplib.h"
 
+#if HASP_USE_LAZY_PAGES > 0
+#include <string>
+#include <vector>
+#endif
+
 /*********************
  *      DEFINES
  *********************/
 #define PAGE_START_INDEX 1 // Page number of array index 0
 
+#ifndef HASP_LAZY_PAGES_MIN_FREE
+#define HASP_LAZY_PAGES_MIN_FREE 8192 // Evict inactive pages when less LVGL memory is free
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -22,6 +31,26 @@ struct hasp_page_meta_data_t
     uint8_t back : 4;
 };
 
+#if HASP_USE_LAZY_PAGES > 0
+struct hasp_page_retained_t
+{
+    std::string key;           // "id.attribute", or "g" and the group id for a group update
+    std::string payload;       // value of the attribute
+    hasp_update_value_t group; // value of the group update
+};
+
+struct hasp_page_lazy_data_t
+{
+    std::vector<std::pair<uint32_t, uint32_t>> sources; // file offset and length of the jsonl objects
+    std::vector<hasp_page_retained_t> retained;          // last value per key, in the order they were set
+    uint32_t last_shown;                                 // tick when the page was last loaded
+    uint32_t build_time;                                 // milliseconds needed to build the page
+    uint32_t resident;                                   // LVGL memory used by the page objects
+    bool built;
+    bool pinned; // runtime objects were added, the page can't be rebuilt from the file
+};
+#endif
+
 namespace hasp {
 
 class Page {
@@ -30,6 +59,14 @@ class Page {
     hasp_page_meta_data_t _meta_data[HASP_NUM_PAGES]; // index 0 = Page 1 etc.
     lv_obj_t* _pages[HASP_NUM_PAGES];                 // index 0 = Page 1 etc.
     uint8_t _current_page;
+#if HASP_USE_LAZY_PAGES > 0
+    hasp_page_lazy_data_t _lazy[HASP_NUM_PAGES]; // index 0 = Page 1 etc.
+    std::string _lazy_file; // pages file the sources point into
+    bool _lazy_loading;
+
+    void evict(uint8_t pageid);
+    void evict_inactive(uint8_t keep_pageid);
+#endif
 
   public:
     Page();
@@ -55,10 +92,21 @@ class Page {
     void set_name(uint8_t pageid, const char* name);
 
     uint8_t get();
-    void load_jsonl(const char* pagesfile);
+    void load_jsonl(const char* pagesfile, bool lazy = true);
     lv_obj_t* get_obj(uint8_t pageid);
     bool get_id(const lv_obj_t* obj, uint8_t* pageid);
     bool is_valid(uint8_t pageid);
+
+#if HASP_USE_LAZY_PAGES > 0
+    bool is_built(uint8_t pageid);
+    void build(uint8_t pageid);
+    void pin(uint8_t pageid);
+    bool add_source(uint8_t pageid, uint32_t offset, uint32_t length);
+    void drop_index(const char* filename);
+    void retain(uint8_t pageid, uint8_t objid, const char* attr, const char* payload);
+    void retain_group(uint8_t pageid, const hasp_update_value_t& value);
+    void get_info(JsonObject& info);
+#endif
 };
 
 } // namespace hasp
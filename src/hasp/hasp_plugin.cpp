@@ -0,0 +1,198 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#if HASP_TARGET_PC
+#include <chrono>
+#endif
+
+#include "hasplib.h"
+#include "hasp_plugin.h"
+#include "hasp_plugin_core.h"
+
+struct plugin_slot_t
+{
+    const hasp_plugin_t* plugin;
+    plugin_stats_t stats;
+    uint32_t last_loop;
+};
+
+// Filled by static initializers, so it must not need a constructor itself
+static plugin_slot_t plugin_slots[HASP_PLUGIN_MAX];
+static uint8_t plugin_count = 0;
+
+static inline uint32_t plugin_micros()
+{
+#if HASP_TARGET_PC
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#else
+    return micros();
+#endif
+}
+
+static void plugin_done(plugin_slot_t& slot, uint32_t start, const char* what)
+{
+    uint32_t elapsed = plugin_micros() - start;
+    uint32_t budget  = slot.plugin->budget ? slot.plugin->budget : HASP_PLUGIN_BUDGET;
+    if(plugin_account(slot.stats, elapsed, budget, millis())) {
+        LOG_WARNING(TAG_CUSTOM, F("%s %s took %u us, budget %u us (%u overruns)"), slot.plugin->name, what, elapsed,
+                    budget, slot.stats.overruns);
+    }
+}
+
+bool plugin_register(const hasp_plugin_t* plugin)
+{
+    if(!plugin) return false;
+
+    for(uint8_t i = 0; i < plugin_count; i++)
+        if(plugin_slots[i].plugin == plugin) return true;
+
+    // Can run before the log is up, the registry is reported by plugin_setup
+    if(plugin_count >= HASP_PLUGIN_MAX) return false;
+
+    plugin_slots[plugin_count].plugin = plugin;
+    memset(&plugin_slots[plugin_count].stats, 0, sizeof(plugin_stats_t));
+    plugin_slots[plugin_count].last_loop = 0;
+    plugin_count++;
+    return true;
+}
+
+#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
+/* The custom_* functions of my_custom.h as one plugin that wants every message. It registers at boot like the
+ * others, gpioSetup runs before plugin_setup and must already see the pins it uses. */
+static const hasp_plugin_t plugin_custom = {
+    "custom", "*", "*", 0, 0, custom_setup, custom_loop, custom_every_second, custom_every_5seconds,
+    custom_pin_in_use, custom_get_sensors, custom_topic_payload, custom_state_subtopic};
+HASP_PLUGIN_REGISTER(plugin_custom);
+#endif
+
+void plugin_setup()
+{
+    for(uint8_t i = 0; i < plugin_count; i++) {
+        plugin_slot_t& slot = plugin_slots[i];
+        LOG_TRACE(TAG_CUSTOM, F("Plugin %s: topics %s, states %s, loop %u ms"), slot.plugin->name,
+                  slot.plugin->topics ? slot.plugin->topics : "-", slot.plugin->states ? slot.plugin->states : "-",
+                  slot.plugin->loop_interval);
+        slot.last_loop = millis();
+        if(!slot.plugin->setup) continue;
+
+        uint32_t start = plugin_micros();
+        slot.plugin->setup();
+        // setup may take its time, only count it
+        plugin_account(slot.stats, plugin_micros() - start, UINT32_MAX, millis());
+    }
+    if(plugin_count) LOG_INFO(TAG_CUSTOM, F("%u plugins loaded"), plugin_count);
+}
+
+uint32_t plugin_loop()
+{
+    uint32_t next = UINT32_MAX;
+    for(uint8_t i = 0; i < plugin_count; i++) {
+        plugin_slot_t& slot = plugin_slots[i];
+        if(!slot.plugin->loop) continue;
+
+        uint32_t wait = plugin_wait(millis(), slot.last_loop, slot.plugin->loop_interval);
+        if(wait == 0) {
+            slot.last_loop = millis();
+            uint32_t start = plugin_micros();
+            slot.plugin->loop();
+            plugin_done(slot, start, "loop");
+            // an interval of 0 must not keep the main loop from sleeping, it runs again on the next iteration anyway
+            wait = slot.plugin->loop_interval ? slot.plugin->loop_interval : HASP_PLUGIN_MIN_WAIT;
+        }
+        if(wait < next) next = wait;
+    }
+    return next;
+}
+
+void plugin_every_second()
+{
+    for(uint8_t i = 0; i < plugin_count; i++) {
+        plugin_slot_t& slot = plugin_slots[i];
+        if(!slot.plugin->every_second) continue;
+
+        uint32_t start = plugin_micros();
+        slot.plugin->every_second();
+        plugin_done(slot, start, "every_second");
+    }
+}
+
+void plugin_every_5seconds()
+{
+    for(uint8_t i = 0; i < plugin_count; i++) {
+        plugin_slot_t& slot = plugin_slots[i];
+        if(!slot.plugin->every_5seconds) continue;
+
+        uint32_t start = plugin_micros();
+        slot.plugin->every_5seconds();
+        plugin_done(slot, start, "every_5seconds");
+    }
+}
+
+bool plugin_pin_in_use(uint8_t pin)
+{
+    for(uint8_t i = 0; i < plugin_count; i++)
+        if(plugin_slots[i].plugin->pin_in_use && plugin_slots[i].plugin->pin_in_use(pin)) return true;
+    return false;
+}
+
+void plugin_get_sensors(JsonDocument& doc)
+{
+    for(uint8_t i = 0; i < plugin_count; i++) {
+        plugin_slot_t& slot = plugin_slots[i];
+        if(!slot.plugin->get_sensors) continue;
+
+        uint32_t start = plugin_micros();
+        slot.plugin->get_sensors(doc);
+        plugin_done(slot, start, "get_sensors");
+    }
+}
+
+bool plugin_has_topics()
+{
+    for(uint8_t i = 0; i < plugin_count; i++)
+        if(plugin_slots[i].plugin->topic_payload && plugin_slots[i].plugin->topics &&
+           *plugin_slots[i].plugin->topics)
+            return true;
+    return false;
+}
+
+bool plugin_topic_payload(const char* topic, const char* payload, uint8_t source)
+{
+    bool handled = false;
+    for(uint8_t i = 0; i < plugin_count; i++) {
+        plugin_slot_t& slot = plugin_slots[i];
+        if(!slot.plugin->topic_payload || !plugin_filter_match(slot.plugin->topics, topic)) continue;
+
+        uint32_t start = plugin_micros();
+        slot.plugin->topic_payload(topic, payload, source);
+        plugin_done(slot, start, topic);
+        handled = true;
+    }
+    return handled;
+}
+
+void plugin_state_subtopic(const char* subtopic, const char* payload)
+{
+    for(uint8_t i = 0; i < plugin_count; i++) {
+        plugin_slot_t& slot = plugin_slots[i];
+        if(!slot.plugin->state_subtopic || !plugin_filter_match(slot.plugin->states, subtopic)) continue;
+
+        uint32_t start = plugin_micros();
+        slot.plugin->state_subtopic(subtopic, payload);
+        plugin_done(slot, start, subtopic);
+    }
+}
+
+void plugin_get_info(JsonObject& info)
+{
+    char buffer[64];
+    for(uint8_t i = 0; i < plugin_count; i++) {
+        plugin_stats_t& stats = plugin_slots[i].stats;
+        uint32_t avg          = stats.calls ? (uint32_t)(stats.total_us / stats.calls) : 0;
+        snprintf_P(buffer, sizeof(buffer), PSTR("%u x %u us, max %u us, %u overruns"), stats.calls, avg, stats.max_us,
+                   stats.overruns);
+        info[plugin_slots[i].plugin->name] = buffer;
+    }
+}
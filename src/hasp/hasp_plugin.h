@@ -0,0 +1,64 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Plugin registry for custom code
+ *
+ * Each module describes itself in a hasp_plugin_t and registers it once, e.g. from file scope with
+ * HASP_PLUGIN_REGISTER(my_plugin). Callbacks that are NULL are skipped. Custom messages hasp/<plate>/custom/<topic>
+ * and outbound state messages only reach the plugins whose filter matches the (sub)topic, see hasp_plugin_core.h.
+ * The time spent in every call is accounted per plugin and a call that exceeds the budget is logged.
+ */
+
+#ifndef HASP_PLUGIN_H
+#define HASP_PLUGIN_H
+
+#include "hasplib.h"
+
+#ifndef HASP_PLUGIN_MAX
+#define HASP_PLUGIN_MAX 8
+#endif
+
+#ifndef HASP_PLUGIN_BUDGET
+#define HASP_PLUGIN_BUDGET 5000 // us per call
+#endif
+
+#ifndef HASP_PLUGIN_MIN_WAIT
+#define HASP_PLUGIN_MIN_WAIT 5 // ms the main loop may sleep when a plugin loops every iteration
+#endif
+
+typedef struct
+{
+    const char* name;       // shown in the logs and the info page
+    const char* topics;     // custom topics it handles, e.g. "fanspeed,fanangle" or "fan*", NULL for none
+    const char* states;     // state subtopics it listens to, e.g. "p1b*,page", NULL for none
+    uint32_t loop_interval; // ms between loop calls, 0 for every iteration of the main loop but at least every
+                            // HASP_PLUGIN_MIN_WAIT ms
+    uint32_t budget;        // us per call before it counts as an overrun, 0 for HASP_PLUGIN_BUDGET
+
+    void (*setup)();                                                              // at boot
+    void (*loop)();                                                               // non-blocking
+    void (*every_second)();                                                       //
+    void (*every_5seconds)();                                                     //
+    bool (*pin_in_use)(uint8_t pin);                                              // true if the plugin owns the pin
+    void (*get_sensors)(JsonDocument& doc);                                       // add a JsonObject to the sensors
+    void (*topic_payload)(const char* topic, const char* payload, uint8_t source); // custom/<topic> messages
+    void (*state_subtopic)(const char* subtopic, const char* payload);            // outbound state messages
+} hasp_plugin_t;
+
+/* Adds the plugin, which must stay valid, returns false when the registry is full */
+bool plugin_register(const hasp_plugin_t* plugin);
+
+#define HASP_PLUGIN_REGISTER(plugin) static const bool plugin##_registered = plugin_register(&plugin)
+
+void plugin_setup();
+uint32_t plugin_loop(); // returns the ms until the next plugin loop is due
+void plugin_every_second();
+void plugin_every_5seconds();
+bool plugin_pin_in_use(uint8_t pin);
+void plugin_get_sensors(JsonDocument& doc);
+bool plugin_has_topics();
+bool plugin_topic_payload(const char* topic, const char* payload, uint8_t source);
+void plugin_state_subtopic(const char* subtopic, const char* payload);
+void plugin_get_info(JsonObject& info);
+
+#endif // HASP_PLUGIN_H
@@ -0,0 +1,45 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include <string.h>
+
+#include "hasp_plugin_core.h"
+
+bool plugin_filter_match(const char* filter, const char* topic)
+{
+    if(!filter || !topic) return false;
+
+    while(*filter) {
+        const char* end = strchr(filter, ',');
+        size_t len      = end ? (size_t)(end - filter) : strlen(filter);
+
+        if(len > 0 && filter[len - 1] == '*') {
+            if(!strncmp(filter, topic, len - 1)) return true; // prefix
+        } else if(len > 0 && !strncmp(filter, topic, len) && topic[len] == '\0') {
+            return true;
+        }
+
+        if(!end) break;
+        filter = end + 1;
+    }
+    return false;
+}
+
+bool plugin_account(plugin_stats_t& stats, uint32_t elapsed, uint32_t budget, uint32_t now)
+{
+    stats.calls++;
+    stats.total_us += elapsed;
+    if(elapsed > stats.max_us) stats.max_us = elapsed;
+    if(elapsed <= budget) return false;
+
+    stats.overruns++;
+    if(stats.overruns > 1 && now - stats.warned < HASP_PLUGIN_WARN_INTERVAL) return false;
+    stats.warned = now;
+    return true;
+}
+
+uint32_t plugin_wait(uint32_t now, uint32_t last, uint32_t interval)
+{
+    uint32_t elapsed = now - last;
+    return elapsed >= interval ? 0 : interval - elapsed;
+}
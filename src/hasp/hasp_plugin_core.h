@@ -0,0 +1,38 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Bookkeeping of the plugin registry that doesn't depend on the rest of the firmware
+ *
+ * A filter is a comma separated list of names, a name ending in * matches every topic that starts with it and a
+ * lone * matches everything. A NULL or empty filter matches nothing, the plugin is not called for that kind of
+ * message at all.
+ */
+
+#ifndef HASP_PLUGIN_CORE_H
+#define HASP_PLUGIN_CORE_H
+
+#include <stdint.h>
+
+#ifndef HASP_PLUGIN_WARN_INTERVAL
+#define HASP_PLUGIN_WARN_INTERVAL 10000 // ms between two overrun warnings of the same plugin
+#endif
+
+struct plugin_stats_t
+{
+    uint32_t calls;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint32_t overruns; // calls that took longer than the budget
+    uint32_t warned;   // ms timestamp of the last overrun warning
+};
+
+/* Does the topic pass the filter */
+bool plugin_filter_match(const char* filter, const char* topic);
+
+/* Adds a call that took elapsed us, returns true when it overran the budget and a warning is due */
+bool plugin_account(plugin_stats_t& stats, uint32_t elapsed, uint32_t budget, uint32_t now);
+
+/* ms until a loop that last ran at last is due again, 0 when it is due now */
+uint32_t plugin_wait(uint32_t now, uint32_t last, uint32_t interval);
+
+#endif // HASP_PLUGIN_CORE_H
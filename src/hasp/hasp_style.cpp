@@ -1,229 +1,302 @@
 /* MIT License - Copyright (c) 2019-2024 Francis Van Roie
    For full license information read the LICENSE file in the project folder */
 
-#include "hasp_attribute.h" /*To see all the hashes*/
-
-static void set_style_attribute(lv_style_t * style, lv_state_t state, int16_t val)
-{
-    lv_color_t color;
-
-    switch(1) {
-        case ATTR_RADIUS:
-            lv_style_set_radius(style, state, val);
-            break;
-        case ATTR_BG_COLOR:
-            lv_style_set_bg_color(style, state, color);
-            break;
-
-            // break; case ATTR_CLIP_CORNER:lv_style_set_clip_corner(style, state, val!=0);
-        case ATTR_SIZE:
-            lv_style_set_size(style, state, val);
-            break;
-        case ATTR_TRANSFORM_WIDTH:
-            lv_style_set_transform_width(style, state, val);
-            break;
-        case ATTR_TRANSFORM_HEIGHT:
-            lv_style_set_transform_height(style, state, val);
-            // break; case ATTR_TRANSFORM_ANGLE:lv_style_set_transform_angle(style, state, val);
-            // break; case ATTR_TRANSFORM_ZOOM:lv_style_set_transform_zoom(style, state, val);
-            // break; case ATTR_OPA_SCALE:lv_style_set_opa_scale(style, state, (lv_opa_t)val);
-            break;
-        case ATTR_PAD_TOP:
-            lv_style_set_pad_top(style, state, val);
-            break;
-        case ATTR_PAD_BOTTOM:
-            lv_style_set_pad_bottom(style, state, val);
-            break;
-        case ATTR_PAD_LEFT:
-            lv_style_set_pad_left(style, state, val);
-            break;
-        case ATTR_PAD_RIGHT:
-            lv_style_set_pad_right(style, state, val);
-            break;
-        case ATTR_PAD_INNER:
-            lv_style_set_pad_inner(style, state, val);
-            // break; case ATTR_MARGIN_TOP:lv_style_set_margin_top(style, state, val);
-            // break; case ATTR_MARGIN_BOTTOM:lv_style_set_margin_bottom(style, state, val);
-            // break; case ATTR_MARGIN_LEFT:lv_style_set_margin_left(style, state, val);
-            // break; case ATTR_MARGIN_RIGHT:lv_style_set_margin_right(style, state, val);
-            // break; case ATTR_BG_BLEND_MODE:lv_style_set_bg_blend_mode, lv_blend_mode_t, _int, scalar)
-            break;
-        case ATTR_BG_MAIN_STOP:
-            lv_style_set_bg_main_stop(style, state, val);
-            break;
-        case ATTR_BG_GRAD_STOP:
-            lv_style_set_bg_grad_stop(style, state, val);
-            // break; case ATTR_BG_GRAD_DIR:lv_style_set_bg_grad_dir, lv_grad_dir_t, _int, scalar)
-            break;
-        case ATTR_BG_GRAD_COLOR:
-            lv_style_set_bg_grad_color(style, state, color);
-            break;
-        case ATTR_BG_OPA:
-            lv_style_set_bg_opa(style, state, (lv_opa_t)val);
-            break;
-        case ATTR_BORDER_WIDTH:
-            lv_style_set_border_width(style, state, val);
-            // break; case ATTR_BORDER_SIDE:lv_style_set_border_side, lv_border_side_t, _int, scalar)
-            // break; case ATTR_BORDER_BLEND_MODE:lv_style_set_border_blend_mode, lv_blend_mode_t, _int, scalar)
-            break;
-        case ATTR_BORDER_POST:
-            lv_style_set_border_post(style, state, val != 0);
-            break;
-        case ATTR_BORDER_COLOR:
-            lv_style_set_border_color(style, state, color);
-            break;
-        case ATTR_BORDER_OPA:
-            lv_style_set_border_opa(style, state, (lv_opa_t)val);
-            break;
-        case ATTR_OUTLINE_WIDTH:
-            lv_style_set_outline_width(style, state, val);
-            break;
-        case ATTR_OUTLINE_PAD:
-            lv_style_set_outline_pad(style, state, val);
-            // break; case ATTR_OUTLINE_BLEND_MODE:lv_style_set_outline_blend_mode, lv_blend_mode_t, _int, scalar)
-            break;
-        case ATTR_OUTLINE_COLOR:
-            lv_style_set_outline_color(style, state, color);
-            break;
-        case ATTR_OUTLINE_OPA:
-            lv_style_set_outline_opa(style, state, (lv_opa_t)val);
-            break;
-        case ATTR_SHADOW_WIDTH:
-            lv_style_set_shadow_width(style, state, val);
-            break;
-        case ATTR_SHADOW_OFS_X:
-            lv_style_set_shadow_ofs_x(style, state, val);
-            break;
-        case ATTR_SHADOW_OFS_Y:
-            lv_style_set_shadow_ofs_y(style, state, val);
-            break;
-        case ATTR_SHADOW_SPREAD:
-            lv_style_set_shadow_spread(style, state, val);
-            // break; case ATTR_SHADOW_BLEND_MODE:lv_style_set_shadow_blend_mode, lv_blend_mode_t, _int, scalar)
-            break;
-        case ATTR_SHADOW_COLOR:
-            lv_style_set_shadow_color(style, state, color);
-            break;
-        case ATTR_SHADOW_OPA:
-            lv_style_set_shadow_opa(style, state, (lv_opa_t)val);
-            break;
-        case ATTR_PATTERN_REPEAT:
-            lv_style_set_pattern_repeat(style, state, val != 0);
-            // break; case ATTR_PATTERN_BLEND_MODE:lv_style_set_pattern_blend_mode, lv_blend_mode_t, _int, scalar)
-            break;
-        case ATTR_PATTERN_RECOLOR:
-            lv_style_set_pattern_recolor(style, state, color);
-            break;
-        case ATTR_PATTERN_OPA:
-            lv_style_set_pattern_opa(style, state, (lv_opa_t)val);
-            break;
-        case ATTR_PATTERN_RECOLOR_OPA:
-            lv_style_set_pattern_recolor_opa(style, state, (lv_opa_t)val);
-            // break; case ATTR_PATTERN_IMAGE:lv_style_set_pattern_image, const void*, _ptr, scalar)
-            break;
-        case ATTR_VALUE_LETTER_SPACE:
-            lv_style_set_value_letter_space(style, state, val);
-            break;
-        case ATTR_VALUE_LINE_SPACE:
-            lv_style_set_value_line_space(style, state, val);
-            // break; case ATTR_VALUE_BLEND_MODE:lv_style_set_value_blend_mode, lv_blend_mode_t, _int, scalar)
-            break;
-        case ATTR_VALUE_OFS_X:
-            lv_style_set_value_ofs_x(style, state, val);
-            break;
-        case ATTR_VALUE_OFS_Y:
-            lv_style_set_value_ofs_y(style, state, val);
-            break;
-        case ATTR_VALUE_ALIGN:
-            lv_style_set_value_align(style, state, (lv_align_t)val);
-            break;
-        case ATTR_VALUE_COLOR:
-            lv_style_set_value_color(style, state, color);
-            break;
-        case ATTR_VALUE_OPA:
-            lv_style_set_value_opa(style, state, (lv_opa_t)val);
-            // break; case ATTR_VALUE_FONT:lv_style_set_value_font, const lv_font_t*, _ptr, scalar)
-            // break; case ATTR_VALUE_STR:lv_style_set_value_str, const char*, _ptr, scalar)
-            break;
-        case ATTR_TEXT_LETTER_SPACE:
-            lv_style_set_text_letter_space(style, state, val);
-            break;
-        case ATTR_TEXT_LINE_SPACE:
-            lv_style_set_text_line_space(style, state, val);
-            // break; case ATTR_TEXT_DECOR:lv_style_set_text_decor, lv_text_decor_t, _int, scalar)
-            // break; case ATTR_TEXT_BLEND_MODE:lv_style_set_text_blend_mode, lv_blend_mode_t, _int, scalar)
-            break;
-        case ATTR_TEXT_COLOR:
-            lv_style_set_text_color(style, state, color);
-            break;
-        case ATTR_TEXT_SEL_COLOR:
-            lv_style_set_text_sel_color(style, state, color);
-            // break; case ATTR_TEXT_SEL_BG_COLOR:lv_style_set_text_sel_bg_color(style, state, color);
-            break;
-        case ATTR_TEXT_OPA:
-            lv_style_set_text_opa(style, state, (lv_opa_t)val);
-            // break; case ATTR_TEXT_FONT:lv_style_set_text_font, const lv_font_t*, _ptr, scalar)
-            break;
-        case ATTR_LINE_WIDTH:
-            lv_style_set_line_width(style, state, val);
-            // break; case ATTR_LINE_BLEND_MODE:lv_style_set_line_blend_mode, lv_blend_mode_t, _int, scalar)
-            break;
-        case ATTR_LINE_DASH_WIDTH:
-            lv_style_set_line_dash_width(style, state, val);
-            break;
-        case ATTR_LINE_DASH_GAP:
-            lv_style_set_line_dash_gap(style, state, val);
-            break;
-        case ATTR_LINE_ROUNDED:
-            lv_style_set_line_rounded(style, state, val != 0);
-            break;
-        case ATTR_LINE_COLOR:
-            lv_style_set_line_color(style, state, color);
-            break;
-        case ATTR_LINE_OPA:
-            lv_style_set_line_opa(style, state, (lv_opa_t)val);
-            // break; case ATTR_IMAGE_BLEND_MODE:lv_style_set_image_blend_mode, lv_blend_mode_t, _int, scalar)
-            break;
-        case ATTR_IMAGE_RECOLOR:
-            lv_style_set_image_recolor(style, state, color);
-            break;
-        case ATTR_IMAGE_OPA:
-            lv_style_set_image_opa(style, state, (lv_opa_t)val);
-            break;
-        case ATTR_IMAGE_RECOLOR_OPA:
-            lv_style_set_image_recolor_opa(style, state, (lv_opa_t)val);
-            // break; case ATTR_TRANSITION_TIME:lv_style_set_transition_time(style, state, val);
-            // break; case ATTR_TRANSITION_DELAY:lv_style_set_transition_delay(style, state, val);
-            // break; case ATTR_TRANSITION_PROP_1:lv_style_set_ transition_prop_1(style, state, val);
-            // break; case ATTR_TRANSITION_PROP_2:lv_style_set_ transition_prop_2(style, state, val);
-            // break; case ATTR_TRANSITION_PROP_3:lv_style_set_ transition_prop_3(style, state, val);
-            // break; case ATTR_TRANSITION_PROP_4:lv_style_set_ transition_prop_4(style, state, val);
-            // break; case ATTR_TRANSITION_PROP_5:lv_style_set_ transition_prop_5(style, state, val);
-            // break; case ATTR_TRANSITION_PROP_6:lv_style_set_ transition_prop_6(style, state, val);
-            //#if LV_USE_ANIMATION
-            // break; case ATTR_TRANSITION_PATH:lv_style_set_transition_path, lv_anim_path_t*, _ptr, scalar)
-            //#else
-            //        /*For compatibility*/
-            // break; case ATTR_TRANSITION_PATH:lv_style_set_transition_path, const void*, _ptr, scalar)
-            //#endif
-            break;
-        case ATTR_SCALE_WIDTH:
-            lv_style_set_scale_width(style, state, val);
-            break;
-        case ATTR_SCALE_BORDER_WIDTH:
-            lv_style_set_scale_border_width(style, state, val);
-            break;
-        case ATTR_SCALE_END_BORDER_WIDTH:
-            lv_style_set_scale_end_border_width(style, state, val);
-            break;
-        case ATTR_SCALE_END_LINE_WIDTH:
-            lv_style_set_scale_end_line_width(style, state, val);
-            break;
-        case ATTR_SCALE_GRAD_COLOR:
-            lv_style_set_scale_grad_color(style, state, color);
-            break;
-        case ATTR_SCALE_END_COLOR:
-            lv_style_set_scale_end_color(style, state, color);
-        default:;
+/* Style classes
+ *
+ * A jsonl line with a "class" key but without an "id" defines a named class:
+ *   {"class":"warning","bg_color":"#FF0000","text_color":"white","radius":10}
+ * Objects reference it with {"page":1,"id":5,"obj":"btn","class":"warning","text":"Alert"}
+ *
+ * The attributes are applied to the first new object of each object type using the class. The local style
+ * properties they set or changed are then moved into shared lv_style_t's, so every next object of that type only
+ * holds a pointer to them instead of its own copy of the property list. Other local properties of the objects are
+ * left alone. Attributes that do not change a style (e.g. text or toggle) are replayed on each object.
+ */
+
+#include "hasplib.h"
+
+#include <map>
+#include <vector>
+
+#define HASP_STYLE_MAX_PARTS 8 // virtual parts 0-7 and real parts 0x40-0x47 are probed
+
+struct hasp_style_part_t
+{
+    uint8_t part;
+    lv_style_t* style;
+};
+
+struct hasp_style_type_t
+{
+    uint8_t objid;
+    bool built;
+    uint16_t uses;
+    std::vector<hasp_style_part_t> parts;
+    std::vector<std::pair<std::string, std::string>> attributes; // not part of any style
+};
+
+struct hasp_style_class_t
+{
+    std::string attributes; // serialized json
+    std::vector<hasp_style_type_t> types;
+};
+
+static std::map<std::string, hasp_style_class_t> style_classes;
+
+static void style_process_attributes(lv_obj_t* obj, const std::string& attributes)
+{
+    DynamicJsonDocument doc(256 + attributes.length() * 2);
+    if(deserializeJson(doc, attributes)) return;
+    hasp_parse_json_attributes(obj, doc.as<JsonObject>());
+}
+
+#if LVGL_VERSION_MAJOR == 7
+
+static inline uint8_t style_part_id(uint8_t i)
+{
+    return i < HASP_STYLE_MAX_PARTS ? i : _LV_OBJ_PART_REAL_FIRST + i - HASP_STYLE_MAX_PARTS;
+}
+
+/* A v7 property list holds each property id, with its state in the high byte, followed by its value. The size of
+ * the value follows from the type bits of the id, as in lv_style.c */
+static size_t style_prop_value_size(lv_style_property_t prop)
+{
+    uint8_t type = prop & 0xF;
+    if(type < LV_STYLE_ID_COLOR) return sizeof(lv_style_int_t);
+    if(type < LV_STYLE_ID_OPA) return sizeof(lv_color_t);
+    if(type < LV_STYLE_ID_PTR) return sizeof(lv_opa_t);
+    return sizeof(const void*);
+}
+
+struct hasp_style_prop_t
+{
+    lv_style_property_t prop;
+    uint8_t value[sizeof(const void*)];
+};
+
+/* The properties of a style, copied out so the style can be changed while walking them */
+static std::vector<hasp_style_prop_t> style_props(const lv_style_t* style)
+{
+    std::vector<hasp_style_prop_t> props;
+    if(!style || !style->map) return props;
+
+    for(size_t i = 0; style->map[i] != _LV_STYLE_CLOSING_PROP;) {
+        hasp_style_prop_t p = {};
+        memcpy(&p.prop, style->map + i, sizeof(p.prop));
+        i += sizeof(p.prop);
+        memcpy(p.value, style->map + i, style_prop_value_size(p.prop));
+        i += style_prop_value_size(p.prop);
+        props.push_back(p);
+    }
+    return props;
+}
+
+/* True when style has the property in the same state with the same value */
+static bool style_has_prop(const lv_style_t* style, const hasp_style_prop_t& p)
+{
+    for(const hasp_style_prop_t& q : style_props(style))
+        if(q.prop == p.prop) return !memcmp(q.value, p.value, style_prop_value_size(p.prop));
+    return false;
+}
+
+static void style_set_prop(lv_style_t* style, const hasp_style_prop_t& p)
+{
+    uint8_t type = p.prop & 0xF;
+    if(type < LV_STYLE_ID_COLOR) {
+        lv_style_int_t value;
+        memcpy(&value, p.value, sizeof(value));
+        _lv_style_set_int(style, p.prop, value);
+    } else if(type < LV_STYLE_ID_OPA) {
+        lv_color_t value;
+        memcpy(&value, p.value, sizeof(value));
+        _lv_style_set_color(style, p.prop, value);
+    } else if(type < LV_STYLE_ID_PTR) {
+        _lv_style_set_opa(style, p.prop, p.value[0]);
+    } else {
+        const void* value;
+        memcpy(&value, p.value, sizeof(value));
+        _lv_style_set_ptr(style, p.prop, value);
+    }
+}
+
+/* Removing the last property keeps the end mark of the list allocated */
+static void style_drop_empty(lv_style_t* style)
+{
+    if(style && style->map && style->map[0] == _LV_STYLE_CLOSING_PROP) lv_style_reset(style);
+}
+
+/* Hash of the local style property lists of all parts, to tell whether an attribute changed any of them */
+static uint32_t style_local_hash(lv_obj_t* obj)
+{
+    uint32_t hash = 2166136261u; // FNV-1a
+    for(uint8_t i = 0; i < HASP_STYLE_MAX_PARTS * 2; i++) {
+        uint8_t part = style_part_id(i);
+        if(!lv_obj_get_style_list(obj, part)) continue;
+        lv_style_t* local = lv_obj_get_local_style(obj, part);
+        if(!local || !local->map) continue;
+
+        const uint8_t* map = local->map;
+        for(uint32_t n = _lv_style_get_mem_size(local); n; n--) hash = (hash ^ *map++) * 16777619u;
+        hash = (hash ^ part) * 16777619u;
+    }
+    return hash;
+}
+
+/* Apply the class to the first object of this type and move the local style properties it set into shared styles.
+ * Properties the object held before, its creation defaults or attributes set earlier, stay local. */
+static void style_build(lv_obj_t* obj, const hasp_style_class_t& cls, hasp_style_type_t& type)
+{
+    DynamicJsonDocument doc(256 + cls.attributes.length() * 2);
+    if(deserializeJson(doc, cls.attributes)) return;
+
+    type.attributes.clear();
+    for(hasp_style_part_t& p : type.parts) lv_style_reset(p.style);
+
+    lv_style_t before[HASP_STYLE_MAX_PARTS * 2];
+    for(uint8_t i = 0; i < HASP_STYLE_MAX_PARTS * 2; i++) {
+        uint8_t part = style_part_id(i);
+        lv_style_init(&before[i]);
+        if(!lv_obj_get_style_list(obj, part)) continue;
+        lv_style_t* local = lv_obj_get_local_style(obj, part);
+        if(local) lv_style_copy(&before[i], local);
+    }
+
+    for(JsonPair keyValue : doc.as<JsonObject>()) {
+        std::string value = keyValue.value().as<std::string>();
+        uint32_t hash     = style_local_hash(obj);
+        hasp_process_obj_attribute(obj, keyValue.key().c_str(), value.c_str(), true);
+        if(style_local_hash(obj) == hash) type.attributes.push_back({keyValue.key().c_str(), value});
+    }
+
+    for(uint8_t i = 0; i < HASP_STYLE_MAX_PARTS * 2; i++) {
+        uint8_t part = style_part_id(i);
+        if(!lv_obj_get_style_list(obj, part)) continue;
+
+        std::vector<hasp_style_prop_t> changed;
+        for(const hasp_style_prop_t& p : style_props(lv_obj_get_local_style(obj, part)))
+            if(!style_has_prop(&before[i], p)) changed.push_back(p);
+        if(changed.empty()) continue;
+
+        /* Reuse the style of a previous definition, objects using it pick up the new properties */
+        lv_style_t* shared = NULL;
+        for(hasp_style_part_t& p : type.parts)
+            if(p.part == part) shared = p.style;
+
+        if(!shared) {
+            shared = (lv_style_t*)hasp_malloc(sizeof(lv_style_t));
+            if(!shared) {
+                LOG_ERROR(TAG_HASP, F(D_ERROR_OUT_OF_MEMORY));
+                continue;
+            }
+            lv_style_init(shared);
+            type.parts.push_back({part, shared});
+        }
+
+        lv_style_t* local = lv_obj_get_local_style(obj, part);
+        for(const hasp_style_prop_t& p : changed) {
+            style_set_prop(shared, p);
+            lv_style_remove_prop(local, p.prop);
+        }
+        style_drop_empty(local);
+        lv_obj_add_style(obj, part, shared);
     }
-}
\ No newline at end of file
+
+    for(uint8_t i = 0; i < HASP_STYLE_MAX_PARTS * 2; i++) lv_style_reset(&before[i]);
+    for(hasp_style_part_t& p : type.parts) lv_obj_report_style_mod(p.style); // also the parts a redefinition emptied
+    type.built = true;
+}
+
+void hasp_style_apply(lv_obj_t* obj, const char* name, bool created)
+{
+    auto it = style_classes.find(name);
+    if(it == style_classes.end()) {
+        LOG_WARNING(TAG_HASP, F("Unknown class %s"), name);
+        return;
+    }
+
+    hasp_style_class_t& cls = it->second;
+    hasp_style_type_t* type = NULL;
+    for(hasp_style_type_t& t : cls.types)
+        if(t.objid == obj->user_data.objid) type = &t;
+
+    /* Existing objects already carry their own local styles, these would end up in the class */
+    if(!created && (!type || !type->built)) {
+        style_process_attributes(obj, cls.attributes);
+        return;
+    }
+
+    if(!type) {
+        cls.types.push_back({obj->user_data.objid, false, 0});
+        type = &cls.types.back();
+    }
+    type->uses++;
+
+    if(!type->built) {
+        style_build(obj, cls, *type);
+        LOG_VERBOSE(TAG_HASP, F("Class %s built for %s"), name, obj_get_type_name(obj));
+        return;
+    }
+
+    for(hasp_style_part_t& p : type->parts) {
+        /* Only the properties of the class are dropped from the local style, which wins over the shared one */
+        if(created) {
+            lv_style_t* local = lv_obj_get_local_style(obj, p.part);
+            if(local) {
+                for(const hasp_style_prop_t& prop : style_props(p.style)) lv_style_remove_prop(local, prop.prop);
+                style_drop_empty(local);
+            }
+        }
+        lv_obj_add_style(obj, p.part, p.style);
+    }
+
+    for(auto& attr : type->attributes) hasp_process_obj_attribute(obj, attr.first.c_str(), attr.second.c_str(), true);
+}
+
+void hasp_style_get_info(JsonObject& info)
+{
+    char value[48];
+    for(auto& it : style_classes) {
+        uint32_t size = 0;
+        uint16_t uses = 0;
+        for(hasp_style_type_t& t : it.second.types) {
+            uses += t.uses;
+            for(hasp_style_part_t& p : t.parts) size += sizeof(lv_style_t) + _lv_style_get_mem_size(p.style);
+        }
+        snprintf_P(value, sizeof(value), PSTR("%u uses, %u bytes"), uses, size);
+        info[it.first] = value;
+    }
+}
+
+#else
+
+void hasp_style_apply(lv_obj_t* obj, const char* name, bool created)
+{
+    auto it = style_classes.find(name);
+    if(it == style_classes.end()) {
+        LOG_WARNING(TAG_HASP, F("Unknown class %s"), name);
+        return;
+    }
+    style_process_attributes(obj, it->second.attributes);
+}
+
+void hasp_style_get_info(JsonObject& info)
+{}
+
+#endif
+
+void hasp_style_define(const char* name, const JsonObject& config)
+{
+    hasp_style_class_t& cls = style_classes[name];
+
+    std::string attributes;
+    serializeJson(config, attributes);
+    if(attributes == cls.attributes) return; // reloading the same pages file, the shared styles are still valid
+    cls.attributes = attributes;
+
+#if LVGL_VERSION_MAJOR == 7
+    /* Styles are rebuilt by the next new object using the class */
+    for(hasp_style_type_t& t : cls.types) t.built = false;
+#endif
+
+    LOG_VERBOSE(TAG_HASP, F("Class %s = %s"), name, cls.attributes.c_str());
+}
@@ -0,0 +1,15 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_STYLE_H
+#define HASP_STYLE_H
+
+#include "hasplib.h"
+
+const char FP_CLASS[] PROGMEM = "class";
+
+void hasp_style_define(const char* name, const JsonObject& config);
+void hasp_style_apply(lv_obj_t* obj, const char* name, bool created);
+void hasp_style_get_info(JsonObject& info);
+
+#endif
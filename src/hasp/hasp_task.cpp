@@ -32,9 +32,7 @@ void task_every_second_cb(lv_task_t* task)
     telnetEverySecond();
 #endif
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
-    custom_every_second();
-#endif
+    plugin_every_second();
     // debugEverySecond();
 
     switch(task->repeat_count) {
@@ -53,9 +51,7 @@ void task_every_second_cb(lv_task_t* task)
             break;
 
         case 3:
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
-            custom_every_5seconds();
-#endif
+            plugin_every_5seconds();
             break;
 
         case 4: {
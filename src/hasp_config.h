@@ -57,6 +57,8 @@ const char FP_CONFIG_ZIFONT[] PROGMEM          = "font";
 const char FP_CONFIG_PAGES[] PROGMEM           = "pages";
 const char FP_CONFIG_COLOR1[] PROGMEM          = "color1";
 const char FP_CONFIG_COLOR2[] PROGMEM          = "color2";
+const char FP_CONFIG_FONTCACHE[] PROGMEM       = "fontcache";
+const char FP_CONFIG_FONTWARMUP[] PROGMEM      = "fontwarmup";
 const char FP_CONFIG_ENABLE[] PROGMEM          = "enable";
 const char FP_CONFIG_HOST[] PROGMEM            = "host";
 const char FP_CONFIG_PORT[] PROGMEM            = "port";
@@ -14,6 +14,7 @@
 #define debug_newline(io) io->println()
 
 #elif HASP_TARGET_PC
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
@@ -458,3 +459,79 @@ void debugPrintPrefix(uint8_t tag, int level, Print* _logOutput)
     debug_print(_logOutput, PSTR(" %s: "), buffer);
 #endif
 }
+
+#if !HASP_TARGET_ARDUINO
+void debugPrintLog(uint8_t tag, int level, const char* format, ...)
+{
+    va_list args;
+
+    debugPrintPrefix(tag, level, NULL);
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    debug_newline();
+    fflush(stdout);
+
+#if HASP_USE_LOG_RING || HASP_USE_TELNET > 0
+    /* The telnet sessions get the same line with a shorter prefix, the log ring only the message */
+    char buffer[256];
+    char tagname[10];
+    debug_get_tag(tag, tagname);
+    uint32_t msecs = millis();
+    int len = snprintf(buffer, sizeof(buffer), "[" D_TIME_MILLIS ".%03d] %s: ", msecs / 1000, msecs % 1000, tagname);
+
+    va_start(args, format);
+    int size = vsnprintf(buffer + len, sizeof(buffer) - len, format, args);
+    va_end(args);
+    if(size < 0) size = 0;
+    if(size >= (int)(sizeof(buffer) - len)) size = sizeof(buffer) - len - 1; // truncated
+
+    log_ring_append(tag, level, msecs, buffer + len, size);
+#if HASP_USE_TELNET > 0
+    telnet_log_write(buffer, len + size);
+    telnet_log_write("\r\n", 2);
+    telnet_update_prompt();
+#endif
+#endif
+}
+#endif
+
+#if HASP_USE_LOG_RING
+void debug_get_log(JsonDocument& doc, uint32_t cursor, int level, size_t max)
+{
+    log_ring_line_t line;
+    char text[HASP_LOG_RING_LINE_SIZE + 1];
+    char tagname[10];
+    const size_t room = JSON_OBJECT_SIZE(6) + sizeof(text) + sizeof(tagname);
+
+    if(cursor == 0) cursor = log_ring_first();
+    JsonArray lines = doc.createNestedArray(F("lines"));
+
+    for(size_t count = 0; count < max && doc.capacity() - doc.memoryUsage() > room + JSON_OBJECT_SIZE(2);) {
+        uint32_t seq          = cursor;
+        log_ring_result_t res = log_ring_read(cursor, line, text, sizeof(text));
+        if(res == LOG_RING_EMPTY) break;
+
+        if(res == LOG_RING_GAP) { // tell the reader what it missed
+            JsonObject gap = lines.createNestedObject();
+            gap[F("seq")]  = seq;
+            gap[F("gap")]  = line.missed;
+            count++;
+            continue;
+        }
+        if(line.level > level) continue;
+
+        debug_get_tag(line.tag, tagname);
+        JsonObject obj  = lines.createNestedObject();
+        obj[F("seq")]   = line.seq;
+        obj[F("ms")]    = line.millis;
+        obj[F("level")] = line.level;
+        obj[F("tag")]   = (char*)tagname; // copied, the buffers are reused
+        obj[F("msg")]   = (char*)text;
+        count++;
+    }
+
+    doc[F("cursor")]  = cursor;
+    doc[F("pending")] = log_ring_next() - cursor;
+}
+#endif
@@ -9,6 +9,7 @@
 #endif
 
 #include "hasp_conf.h"
+#include "hasp_log_ring.h"
 
 #include "ArduinoJson.h"
 #include "hasp_debug.h"
@@ -48,46 +49,14 @@ void debugStopSyslog(void);
 #define LOG_LEVEL_DEBUG 8
 #define LOG_LEVEL_OUTPUT 9
 
-#define LOG_FATAL(x, ...)                                                                                              \
-    debugPrintPrefix(x, LOG_LEVEL_FATAL, NULL);                                                                        \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
-#define LOG_ERROR(x, ...)                                                                                              \
-    debugPrintPrefix(x, LOG_LEVEL_ERROR, NULL);                                                                        \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
-#define LOG_WARNING(x, ...)                                                                                            \
-    debugPrintPrefix(x, LOG_LEVEL_WARNING, NULL);                                                                      \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
-#define LOG_NOTICE(x, ...)                                                                                             \
-    debugPrintPrefix(x, LOG_LEVEL_NOTICE, NULL);                                                                       \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
-#define LOG_TRACE(x, ...)                                                                                              \
-    debugPrintPrefix(x, LOG_LEVEL_TRACE, NULL);                                                                        \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
-#define LOG_VERBOSE(x, ...)                                                                                            \
-    debugPrintPrefix(x, LOG_LEVEL_VERBOSE, NULL);                                                                      \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
-#define LOG_DEBUG(x, ...)                                                                                              \
-    debugPrintPrefix(x, LOG_LEVEL_DEBUG, NULL);                                                                        \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
-#define LOG_INFO(x, ...)                                                                                               \
-    debugPrintPrefix(x, LOG_LEVEL_INFO, NULL);                                                                         \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
+#define LOG_FATAL(x, ...) debugPrintLog(x, LOG_LEVEL_FATAL, __VA_ARGS__)
+#define LOG_ERROR(x, ...) debugPrintLog(x, LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARNING(x, ...) debugPrintLog(x, LOG_LEVEL_WARNING, __VA_ARGS__)
+#define LOG_NOTICE(x, ...) debugPrintLog(x, LOG_LEVEL_NOTICE, __VA_ARGS__)
+#define LOG_TRACE(x, ...) debugPrintLog(x, LOG_LEVEL_TRACE, __VA_ARGS__)
+#define LOG_VERBOSE(x, ...) debugPrintLog(x, LOG_LEVEL_VERBOSE, __VA_ARGS__)
+#define LOG_DEBUG(x, ...) debugPrintLog(x, LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(x, ...) debugPrintLog(x, LOG_LEVEL_INFO, __VA_ARGS__)
 
 /* json keys used in the configfile */
 // const char FP_CONFIG_STARTPAGE[] PROGMEM = "startpage";
@@ -145,12 +114,20 @@ void debugStop(void);
 void debugPrintHaspHeader(Print* output);
 void debugPrintTag(uint8_t tag, Print* _logOutput);
 void debugPrintPrefix(uint8_t tag, int level, Print* _logOutput);
+#if !HASP_TARGET_ARDUINO
+void debugPrintLog(uint8_t tag, int level, const char* format, ...) __attribute__((format(printf, 3, 4)));
+#endif
 bool debugSyslogPrefix(uint8_t tag, int level, Print* _logOutput, const char* processname);
 
 #ifdef __cplusplus
 }
 #endif
 
+#if HASP_USE_LOG_RING
+/* Fills doc with up to max lines of the log ring from cursor on, 0 starts at the oldest line */
+void debug_get_log(JsonDocument& doc, uint32_t cursor, int level, size_t max);
+#endif
+
 /* ===== Read/Write Configuration ===== */
 #if HASP_USE_CONFIG > 0
 bool debugGetConfig(const JsonObject& settings);
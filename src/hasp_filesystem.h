@@ -13,24 +13,6 @@ void filesystemList();
 void filesystemInfo();
 void filesystemSetupFiles();
 
-enum { ZIP_NO_COMPRESSION = 0, ZIP_DEFLTATE = 8 };
-typedef uint16_t zip_compression_method_t;
-
-typedef struct
-{
-    uint16_t dummy_bytes; // total struct needs to be a multiple of 4 bytes
-    uint16_t min_version;
-    uint16_t flags;
-    zip_compression_method_t compression_method;
-    uint16_t time_modified;
-    uint16_t date_modified;
-    uint32_t crc;
-    uint32_t compressed_size;
-    uint32_t uncompressed_size;
-    uint16_t filename_length; // OK
-    uint16_t extra_length;
-} zip_file_header_t;
-
 #if defined(ARDUINO_ARCH_ESP32)
 #if HASP_USE_SPIFFS > 0
 #include "SPIFFS.h"
@@ -64,7 +46,6 @@ typedef struct
 #endif // ARDUINO_ARCH
 
 #if defined(ARDUINO_ARCH_ESP32)
-void filesystemUnzip(const char*, const char* filename, uint8_t source);
 String filesystem_list(fs::FS& fs, const char* dirname, uint8_t levels);
 #endif
 
@@ -31,8 +31,7 @@ bool gui_pop_screenshot_request(void);
 #include <limits.h>
 #endif
 
-#if ESP32
-static SemaphoreHandle_t xGuiSemaphore = NULL;
+#if ESP32 && HASP_USE_LVGL_TASK == 1
 static TaskHandle_t g_lvgl_task_handle;
 #endif
 
@@ -137,9 +136,10 @@ void gui_antiburn_cb(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* col
 
 IRAM_ATTR void gui_monitor_cb(lv_disp_drv_t* disp_drv, uint32_t time, uint32_t px)
 {
-    // if(screenshotIsDirty) return;
-    LOG_DEBUG(TAG_GUI, F("The Screen is dirty"));
     screenshotIsDirty = true;
+#if HASP_USE_FREETYPE > 0
+    font_monitor_frame(time);
+#endif
 }
 
 IRAM_ATTR bool gui_touch_read(lv_indev_drv_t* indev_driver, lv_indev_data_t* data)
@@ -282,6 +282,15 @@ void guiSetup()
     lv_disp_t* display       = lv_disp_drv_register(&disp_drv);
     lv_disp_set_rotation(display, rotation[(4 + gui_settings.rotation - TFT_ROTATION) % 4]);
 
+#elif HASP_TARGET_PC && (USE_MONITOR || USE_FBDEV || HASP_USE_NULL_DRIVER) // The driver turns each flushed area
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.buffer   = &disp_buf;
+    disp_drv.flush_cb = gui_flush_cb;
+    disp_drv.hor_res  = haspTft.width(); // size after the rotation
+    disp_drv.ver_res  = haspTft.height();
+    lv_disp_drv_register(&disp_drv);
+
 #else // Use lvgl transformations
     static lv_disp_drv_t disp_drv;
     lv_disp_drv_init(&disp_drv);
@@ -298,7 +307,7 @@ void guiSetup()
     lv_disp_t* display       = lv_disp_drv_register(&disp_drv);
     lv_disp_set_rotation(display, rotation[(4 + gui_settings.rotation - TFT_ROTATION) % 4]);
 #endif
-    disp_drv.monitor_cb = gui_monitor_cb;
+    lv_disp_get_default()->driver.monitor_cb = gui_monitor_cb; // lvgl keeps a copy of disp_drv
 
     // register a touchscreen/mouse driver - only on real hardware and SDL2
     // Win32 and POSIX handles input drivers in tft_driver
@@ -314,6 +323,9 @@ void guiSetup()
 #endif
     lv_indev_t* mouse_indev  = lv_indev_drv_register(&indev_drv);
     mouse_indev->driver.type = LV_INDEV_TYPE_POINTER;
+#if USE_MONITOR && HASP_TARGET_PC
+    haspTft.rotate_input(&mouse_indev->driver);
+#endif
 #else
     // find the first registered input device to add a cursor to
     lv_indev_t* mouse_indev = NULL;
@@ -375,19 +387,14 @@ void guiSetup()
     lv_obj_set_style_local_bg_color(lv_layer_sys(), LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLACK);
     lv_obj_set_style_local_bg_opa(lv_layer_sys(), LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_OPA_0);
 
-#if defined(ESP32) && defined(HASP_USE_ESP_MQTT)
-    xGuiSemaphore = xSemaphoreCreateMutex();
-    if(!xGuiSemaphore) {
-        LOG_FATAL(TAG_GUI, "Create mutex for LVGL failed");
-    }
-#endif // ESP32 && HASP_USE_ESP_MQTT
+    gui_lock_setup();
 
     LOG_INFO(TAG_LVGL, F(D_SERVICE_STARTED));
 }
 
-IRAM_ATTR void guiLoop(void)
+IRAM_ATTR uint32_t guiLoop(void)
 {
-    lv_task_handler(); // process animations
+    uint32_t next = lv_task_handler(); // process animations
 
 #if defined(STM32F4xx)
     //  tick.update();
@@ -402,6 +409,8 @@ IRAM_ATTR void guiLoop(void)
         guiTakeScreenshot("screenshot.bmp");
     }
 #endif
+
+    return next;
 }
 
 void guiEverySecond(void)
@@ -414,22 +423,13 @@ void gui_task(void* args)
 {
     LOG_TRACE(TAG_GUI, "Start to run LVGL");
     while(haspDevice.pc_is_running) {
-        // no idea what MQTT has to do with LVGL - the #if is copied from the code below
-#if defined(ESP32) && defined(HASP_USE_ESP_MQTT)
-        /* Try to take the semaphore, call lvgl related function on success */
-        if(pdTRUE == xSemaphoreTake(xGuiSemaphore, portMAX_DELAY)) {
-            lv_task_handler();
-            xSemaphoreGive(xGuiSemaphore);
-            vTaskDelay(pdMS_TO_TICKS(5));
+        uint32_t next;
+        {
+            GuiLock lock("lvgl");
+            next = lv_task_handler();
         }
-#else
-        // optimize lv_task_handler() by actually using the returned delay value
-        auto time_start     = millis();
-        uint32_t sleep_time = lv_task_handler();
-        delay(sleep_time);
-        auto time_end = millis();
-        lv_tick_inc(time_end - time_start);
-#endif
+        // the tick is read from millis(), sleep until the next lvgl task outside of the lock
+        delay(next ? next : 1);
     }
 }
 #endif // HASP_USE_LVGL_TASK
@@ -452,27 +452,27 @@ esp_err_t gui_setup_lvgl_task()
 }
 #endif // HASP_USE_LVGL_TASK
 
-IRAM_ATTR bool gui_acquire(TickType_t timeout)
-{
-#if ESP32
-    TaskHandle_t task = xTaskGetCurrentTaskHandle();
-    if(g_lvgl_task_handle == task) return true;
-    if(xSemaphoreTake(xGuiSemaphore, timeout) != pdTRUE) return false;
-#endif
-    return true;
-}
+#endif // ESP32 && HASP_USE_ESP_MQTT
 
-IRAM_ATTR void gui_release(void)
+#if HASP_USE_GUI_LOCK > 0
+void gui_get_lock_info(JsonObject& info)
 {
-#if ESP32
-    TaskHandle_t task = xTaskGetCurrentTaskHandle();
-    if(g_lvgl_task_handle == task) return;
-    xSemaphoreGive(xGuiSemaphore);
-    // LOG_VERBOSE(TAG_TFT, F("GIVE"));
-#endif
+    char buffer[64];
+    gui_lock_stats_t stats;
+    gui_lock_get_stats(stats);
+
+    snprintf_P(buffer, sizeof(buffer), PSTR("%u, %u contended, %u timeouts"), stats.locks, stats.contended,
+               stats.timeouts);
+    info[F("Locks")] = buffer;
+    snprintf_P(buffer, sizeof(buffer), PSTR("avg %u us, max %u us"),
+               stats.contended ? (uint32_t)(stats.wait_us / stats.contended) : 0, stats.max_wait_us);
+    info[F("Wait")] = buffer;
+    snprintf_P(buffer, sizeof(buffer), PSTR("avg %u us, max %u us (%s)"),
+               stats.locks ? (uint32_t)(stats.hold_us / stats.locks) : 0, stats.max_hold_us,
+               stats.max_hold_name ? stats.max_hold_name : "-");
+    info[F("Hold")] = buffer;
 }
-
-#endif // ESP32 && HASP_USE_ESP_MQTT
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 #if HASP_USE_CONFIG > 0
@@ -43,7 +43,7 @@ struct gui_conf_t
 /* ===== Default Event Processors ===== */
 void guiTftInit(void);
 void guiSetup(void);
-IRAM_ATTR void guiLoop(void);
+IRAM_ATTR uint32_t guiLoop(void); // returns the ms until the next lvgl task
 void guiEverySecond(void);
 void guiStart(void);
 void guiStop(void);
@@ -67,10 +67,11 @@ void gui_task(void* args);
 
 /* ===== Locks ===== */
 #ifdef ESP32
-IRAM_ATTR bool gui_acquire(TickType_t timeout);
-IRAM_ATTR void gui_release(void);
 esp_err_t gui_setup_lvgl_task(void);
 #endif
+#if HASP_USE_GUI_LOCK > 0
+void gui_get_lock_info(JsonObject& info);
+#endif
 
 /* ===== Read/Write Configuration ===== */
 #if HASP_USE_CONFIG > 0
@@ -0,0 +1,146 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Lock around lvgl
+ *
+ * lvgl is not thread-safe. The main loop, the lvgl task, the MQTT client and the async web server only take this
+ * lock around the code that touches lvgl, so a message that arrives while the loop is busy with the network or a
+ * file only waits for the section that is drawing at that moment. The lock is recursive: a command dispatched from
+ * a locked section can lock again.
+ */
+
+#include "hasp_gui_lock.h"
+
+#if HASP_USE_GUI_LOCK > 0
+
+#include <string.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Arduino.h>
+#else
+#include <chrono>
+#include <mutex>
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+static SemaphoreHandle_t gui_mutex = NULL;
+
+void gui_lock_setup(void)
+{
+    if(!gui_mutex) gui_mutex = xSemaphoreCreateRecursiveMutex();
+}
+
+static inline bool gui_lock_take(uint32_t timeout_ms)
+{
+    if(!gui_mutex) gui_lock_setup();
+    TickType_t ticks = timeout_ms == GUI_LOCK_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    return xSemaphoreTakeRecursive(gui_mutex, ticks) == pdTRUE;
+}
+
+static inline bool gui_lock_try(void)
+{
+    if(!gui_mutex) gui_lock_setup();
+    return xSemaphoreTakeRecursive(gui_mutex, 0) == pdTRUE;
+}
+
+static inline void gui_lock_give(void)
+{
+    xSemaphoreGiveRecursive(gui_mutex);
+}
+
+static inline uint32_t gui_lock_micros(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+#else
+static std::recursive_timed_mutex gui_mutex;
+
+void gui_lock_setup(void)
+{}
+
+static inline bool gui_lock_take(uint32_t timeout_ms)
+{
+    if(timeout_ms != GUI_LOCK_FOREVER) return gui_mutex.try_lock_for(std::chrono::milliseconds(timeout_ms));
+    gui_mutex.lock();
+    return true;
+}
+
+static inline bool gui_lock_try(void)
+{
+    return gui_mutex.try_lock();
+}
+
+static inline void gui_lock_give(void)
+{
+    gui_mutex.unlock();
+}
+
+static inline uint32_t gui_lock_micros(void)
+{
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+#endif
+
+// Only changed by the thread that holds the lock, except the timeouts
+static gui_lock_stats_t gui_lock_stats;
+static uint16_t gui_lock_depth   = 0;
+static uint32_t gui_lock_since   = 0;
+static const char* gui_lock_name = nullptr;
+
+bool gui_acquire(uint32_t timeout_ms, const char* name)
+{
+    uint32_t wait = 0;
+    if(!gui_lock_try()) {
+        uint32_t start = gui_lock_micros();
+        if(!gui_lock_take(timeout_ms)) {
+            __atomic_add_fetch(&gui_lock_stats.timeouts, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+        wait = gui_lock_micros() - start;
+        gui_lock_stats.contended++;
+        gui_lock_stats.wait_us += wait;
+        if(wait > gui_lock_stats.max_wait_us) gui_lock_stats.max_wait_us = wait;
+    }
+
+    if(gui_lock_depth++ == 0) {
+        gui_lock_stats.locks++;
+        gui_lock_since = gui_lock_micros();
+        gui_lock_name  = name;
+    }
+    return true;
+}
+
+void gui_release(void)
+{
+    if(gui_lock_depth == 0) return; // not held
+
+    if(--gui_lock_depth == 0) {
+        uint32_t hold = gui_lock_micros() - gui_lock_since;
+        gui_lock_stats.hold_us += hold;
+        if(hold > gui_lock_stats.max_hold_us) {
+            gui_lock_stats.max_hold_us   = hold;
+            gui_lock_stats.max_hold_name = gui_lock_name;
+        }
+    }
+    gui_lock_give();
+}
+
+void gui_lock_get_stats(gui_lock_stats_t& stats)
+{
+    gui_acquire(GUI_LOCK_FOREVER);
+    stats = gui_lock_stats;
+    if(gui_lock_depth == 1) stats.locks--; // not this one
+    gui_release();
+}
+
+void gui_lock_reset_stats(void)
+{
+    gui_acquire(GUI_LOCK_FOREVER);
+    memset(&gui_lock_stats, 0, sizeof(gui_lock_stats));
+    gui_release();
+}
+
+#endif // HASP_USE_GUI_LOCK
@@ -0,0 +1,73 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_GUI_LOCK_H
+#define HASP_GUI_LOCK_H
+
+#include <stdint.h>
+
+/* Only the ESP32 and the PC builds run lvgl next to other threads, elsewhere the lock compiles away */
+#ifndef HASP_USE_GUI_LOCK
+#if defined(ARDUINO_ARCH_ESP32) || !defined(ARDUINO)
+#define HASP_USE_GUI_LOCK 1
+#else
+#define HASP_USE_GUI_LOCK 0
+#endif
+#endif
+
+#define GUI_LOCK_FOREVER UINT32_MAX
+
+struct gui_lock_stats_t
+{
+    uint32_t locks;            // outermost acquisitions, nested ones are free
+    uint32_t contended;        // acquisitions that had to wait for another thread
+    uint32_t timeouts;         // acquisitions that gave up
+    uint32_t max_wait_us;      //
+    uint32_t max_hold_us;      //
+    uint64_t wait_us;          //
+    uint64_t hold_us;          //
+    const char* max_hold_name; // section that held the lock longest
+};
+
+#if HASP_USE_GUI_LOCK > 0
+void gui_lock_setup(void);
+
+/* Takes the recursive lock around lvgl, the name of the section is kept for the statistics */
+bool gui_acquire(uint32_t timeout_ms, const char* name = nullptr);
+void gui_release(void);
+
+void gui_lock_get_stats(gui_lock_stats_t& stats);
+void gui_lock_reset_stats(void);
+#else
+static inline void gui_lock_setup(void)
+{}
+static inline bool gui_acquire(uint32_t, const char* = nullptr)
+{
+    return true;
+}
+static inline void gui_release(void)
+{}
+#endif
+
+/* Holds the lock until the end of the scope */
+class GuiLock {
+  public:
+    explicit GuiLock(const char* name, uint32_t timeout_ms = GUI_LOCK_FOREVER) : _locked(gui_acquire(timeout_ms, name))
+    {}
+    ~GuiLock()
+    {
+        if(_locked) gui_release();
+    }
+    bool locked() const
+    {
+        return _locked;
+    }
+
+    GuiLock(const GuiLock&)            = delete;
+    GuiLock& operator=(const GuiLock&) = delete;
+
+  private:
+    bool _locked;
+};
+
+#endif // HASP_GUI_LOCK_H
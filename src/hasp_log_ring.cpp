@@ -0,0 +1,196 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* History of the log lines for remote readers
+ *
+ * Each line is appended once, as a header and the text, to a fixed buffer. An entry is never split at the end of the
+ * buffer, the writer starts over at the front instead. The oldest entries are dropped until the new one fits, and a
+ * table indexed by the sequence number finds the entry of any line that is still kept without a scan.
+ *
+ * Writers only wait for each other. Readers work like a seqlock: they copy the entry and then check that the oldest
+ * line is still not past their cursor. The writer moves the oldest line before it overwrites anything, so a copy that
+ * passes the check was not torn, and one that fails is reported as a gap.
+ */
+
+#include "hasp_log_ring.h"
+
+#if HASP_USE_LOG_RING
+
+#include <string.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Arduino.h>
+#elif !defined(ARDUINO)
+#include <mutex>
+#endif
+
+#if(HASP_LOG_RING_LINES & (HASP_LOG_RING_LINES - 1)) != 0
+#error "HASP_LOG_RING_LINES must be a power of two"
+#endif
+#if HASP_LOG_RING_SIZE > 65536
+#error "HASP_LOG_RING_SIZE can be at most 65536"
+#endif
+
+struct log_ring_entry_t
+{
+    uint32_t seq;
+    uint32_t millis;
+    uint16_t len;
+    uint8_t level;
+    uint8_t tag;
+};
+
+#define LOG_RING_ALIGN(x) (((x) + 3) & ~3)
+#define LOG_RING_MASK (HASP_LOG_RING_LINES - 1)
+
+static_assert(LOG_RING_ALIGN(sizeof(log_ring_entry_t) + HASP_LOG_RING_LINE_SIZE) <= HASP_LOG_RING_SIZE,
+              "HASP_LOG_RING_SIZE must hold at least one line");
+
+static uint32_t log_ring_buffer[HASP_LOG_RING_SIZE / 4]; // uint32_t to align the headers
+static uint16_t log_ring_offset[HASP_LOG_RING_LINES];    // entry of each line kept, by seq & LOG_RING_MASK
+static uint32_t log_ring_head      = 0;                  // where the next entry goes, only used by writers
+static uint32_t log_ring_first_seq = 1;                  // oldest line kept
+static uint32_t log_ring_next_seq  = 1;                  // line the next append gets
+static log_ring_stats_t log_ring_stats;
+
+#if defined(ARDUINO_ARCH_ESP32)
+static portMUX_TYPE log_ring_mux = portMUX_INITIALIZER_UNLOCKED;
+#define LOG_RING_LOCK() portENTER_CRITICAL(&log_ring_mux)
+#define LOG_RING_UNLOCK() portEXIT_CRITICAL(&log_ring_mux)
+#elif !defined(ARDUINO)
+static std::mutex log_ring_mutex;
+#define LOG_RING_LOCK() log_ring_mutex.lock()
+#define LOG_RING_UNLOCK() log_ring_mutex.unlock()
+#else
+#define LOG_RING_LOCK() // single threaded
+#define LOG_RING_UNLOCK()
+#endif
+
+static inline uint8_t* log_ring_at(uint32_t offset)
+{
+    return (uint8_t*)log_ring_buffer + offset;
+}
+
+static inline uint32_t log_ring_entry_size(uint32_t offset)
+{
+    return LOG_RING_ALIGN(sizeof(log_ring_entry_t) + ((log_ring_entry_t*)log_ring_at(offset))->len);
+}
+
+void log_ring_append(uint8_t tag, uint8_t level, uint32_t millis, const char* text, size_t len)
+{
+    // Drop the newline, readers add their own
+    while(len > 0 && (text[len - 1] == '\n' || text[len - 1] == '\r')) len--;
+    bool truncated = len > HASP_LOG_RING_LINE_SIZE;
+    if(truncated) len = HASP_LOG_RING_LINE_SIZE;
+    uint32_t size = LOG_RING_ALIGN(sizeof(log_ring_entry_t) + len);
+
+    LOG_RING_LOCK();
+
+    uint32_t start = log_ring_head;
+    bool wrapped   = start + size > HASP_LOG_RING_SIZE;
+    if(wrapped) start = 0;
+    uint32_t first   = log_ring_first_seq;
+    uint32_t seq     = log_ring_next_seq;
+    uint32_t evicted = 0;
+
+    // Drop the oldest lines that are in the way, those left behind at the end when starting over at the front and
+    // the one whose slot in the index the new line needs
+    while(first != seq) {
+        uint32_t offset = log_ring_offset[first & LOG_RING_MASK];
+        bool overlaps   = offset < start + size && offset + log_ring_entry_size(offset) > start;
+        bool skipped    = wrapped && offset >= log_ring_head;
+        bool full       = seq - first >= HASP_LOG_RING_LINES;
+        if(!overlaps && !skipped && !full) break;
+        first++;
+        evicted++;
+    }
+    if(evicted) {
+        __atomic_store_n(&log_ring_first_seq, first, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE); // readers see the eviction before the new data
+    }
+
+    log_ring_entry_t* entry = (log_ring_entry_t*)log_ring_at(start);
+    entry->seq              = seq;
+    entry->millis           = millis;
+    entry->len              = len;
+    entry->level            = level;
+    entry->tag              = tag;
+    memcpy(entry + 1, text, len);
+    log_ring_offset[seq & LOG_RING_MASK] = start;
+    log_ring_head                        = start + size;
+
+    log_ring_stats.lines++;
+    log_ring_stats.evicted += evicted;
+    if(truncated) log_ring_stats.truncated++;
+
+    __atomic_store_n(&log_ring_next_seq, seq + 1, __ATOMIC_RELEASE); // publish the line
+
+    LOG_RING_UNLOCK();
+}
+
+log_ring_result_t log_ring_read(uint32_t& cursor, log_ring_line_t& line, char* text, size_t size)
+{
+    for(;;) {
+        uint32_t first = __atomic_load_n(&log_ring_first_seq, __ATOMIC_ACQUIRE);
+        uint32_t next  = __atomic_load_n(&log_ring_next_seq, __ATOMIC_ACQUIRE);
+
+        if((int32_t)(cursor - first) < 0 || (int32_t)(next - cursor) < 0) {
+            // Fell behind, or a cursor from before a reboot
+            line.seq    = cursor;
+            line.missed = (int32_t)(cursor - first) < 0 ? first - cursor : 0;
+            line.millis = 0;
+            line.len    = 0;
+            line.level  = 0;
+            line.tag    = 0;
+            if(size) text[0] = 0;
+            cursor = first;
+            __atomic_add_fetch(&log_ring_stats.missed, line.missed, __ATOMIC_RELAXED);
+            return LOG_RING_GAP;
+        }
+        if(cursor == next) return LOG_RING_EMPTY;
+
+        uint32_t offset = log_ring_offset[cursor & LOG_RING_MASK];
+        if(offset > HASP_LOG_RING_SIZE - sizeof(log_ring_entry_t)) continue; // not an entry, check again
+        log_ring_entry_t entry;
+        memcpy(&entry, log_ring_at(offset), sizeof(entry));
+        size_t len = entry.len;
+        if(len > HASP_LOG_RING_SIZE - offset - sizeof(entry)) len = 0; // torn, fails the check below
+        if(size && len >= size) len = size - 1;
+        if(size) {
+            memcpy(text, log_ring_at(offset) + sizeof(entry), len);
+            text[len] = 0;
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        first = __atomic_load_n(&log_ring_first_seq, __ATOMIC_RELAXED);
+        if((int32_t)(cursor - first) < 0 || entry.seq != cursor) continue; // overwritten while copying
+
+        line.seq    = entry.seq;
+        line.millis = entry.millis;
+        line.missed = 0;
+        line.len    = len;
+        line.level  = entry.level;
+        line.tag    = entry.tag;
+        cursor++;
+        return LOG_RING_LINE;
+    }
+}
+
+uint32_t log_ring_first(void)
+{
+    return __atomic_load_n(&log_ring_first_seq, __ATOMIC_ACQUIRE);
+}
+
+uint32_t log_ring_next(void)
+{
+    return __atomic_load_n(&log_ring_next_seq, __ATOMIC_ACQUIRE);
+}
+
+void log_ring_get_stats(log_ring_stats_t& stats)
+{
+    LOG_RING_LOCK();
+    stats = log_ring_stats;
+    LOG_RING_UNLOCK();
+}
+
+#endif // HASP_USE_LOG_RING
@@ -0,0 +1,82 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_LOG_RING_H
+#define HASP_LOG_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Bytes kept for the history and the most lines it can hold, a power of two */
+#ifndef HASP_LOG_RING_SIZE
+#if defined(ARDUINO_ARCH_ESP32)
+#define HASP_LOG_RING_SIZE 8192
+#define HASP_LOG_RING_LINES 256
+#elif defined(ARDUINO_ARCH_ESP8266)
+#define HASP_LOG_RING_SIZE 2048
+#define HASP_LOG_RING_LINES 64
+#elif !defined(ARDUINO)
+#define HASP_LOG_RING_SIZE 65536
+#define HASP_LOG_RING_LINES 2048
+#else
+#define HASP_LOG_RING_SIZE 0
+#endif
+#endif
+
+#ifndef HASP_LOG_RING_LINES
+#define HASP_LOG_RING_LINES 128
+#endif
+
+/* Longer lines are cut off */
+#ifndef HASP_LOG_RING_LINE_SIZE
+#define HASP_LOG_RING_LINE_SIZE 256
+#endif
+
+#define HASP_USE_LOG_RING (HASP_LOG_RING_SIZE > 0)
+
+enum log_ring_result_t {
+    LOG_RING_EMPTY = 0, // the cursor is at the newest line
+    LOG_RING_LINE,      // a line was copied and the cursor moved past it
+    LOG_RING_GAP,       // lines were overwritten before the cursor got to them, the cursor moved to the oldest line
+};
+
+struct log_ring_line_t
+{
+    uint32_t seq;    // sequence number of the line, or of the first missed line of a gap
+    uint32_t millis; // time the line was logged
+    uint32_t missed; // number of lines lost in a gap
+    uint16_t len;    // length of the text
+    uint8_t level;   //
+    uint8_t tag;     //
+};
+
+struct log_ring_stats_t
+{
+    uint32_t lines;     // lines appended since boot
+    uint32_t evicted;   // oldest lines overwritten to make room
+    uint32_t truncated; // lines longer than HASP_LOG_RING_LINE_SIZE
+    uint32_t missed;    // lines that readers reported as gaps
+};
+
+#if HASP_USE_LOG_RING
+
+/* Called once for every log line, from any task. Never waits for readers. */
+void log_ring_append(uint8_t tag, uint8_t level, uint32_t millis, const char* text, size_t len);
+
+/* Copies the line at the cursor of a reader into text, which is always terminated.
+ * Readers each keep their own cursor and never lock out a writer, a copy that got overwritten is detected and
+ * reported as a gap. Start a new reader at log_ring_first() to get the whole history or at log_ring_next() to only
+ * get new lines. */
+log_ring_result_t log_ring_read(uint32_t& cursor, log_ring_line_t& line, char* text, size_t size);
+
+uint32_t log_ring_first(void); // sequence number of the oldest line
+uint32_t log_ring_next(void);  // sequence number the next line will get
+
+void log_ring_get_stats(log_ring_stats_t& stats);
+
+#else
+static inline void log_ring_append(uint8_t, uint8_t, uint32_t, const char*, size_t)
+{}
+#endif
+
+#endif // HASP_LOG_RING_H
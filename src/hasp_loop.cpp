@@ -0,0 +1,189 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Sleep of the main loop
+ *
+ * Instead of a fixed delay after every iteration, the main loop waits until the earliest time any subsystem asked
+ * for with loop_schedule: the next lvgl task, a running debounce timer or the one second jobs. Sources that receive
+ * work outside of the loop, like the MQTT client, the console and telnet threads or a GPIO interrupt, end the wait
+ * early with loop_wake. Subsystems that can only be polled are covered by HASP_LOOP_MAX_SLEEP.
+ */
+
+#include "hasp_loop.h"
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#if defined(ARDUINO_ARCH_ESP8266)
+#include <coredecls.h>
+#endif
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#endif
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+#if defined(ARDUINO)
+#define HASP_LOOP_MIN_SLEEP 1 // always yield to the lower priority tasks
+#else
+#define HASP_LOOP_MIN_SLEEP 0
+#endif
+
+static uint32_t loop_timeout = HASP_LOOP_MAX_SLEEP;
+static loop_stats_t loop_stats;
+
+#if defined(ARDUINO_ARCH_ESP32)
+static TaskHandle_t loop_task = NULL;
+
+void loop_setup(void)
+{
+    loop_task = xTaskGetCurrentTaskHandle(); // setup() and loop() run in the same task
+}
+
+void loop_wake(void)
+{
+    if(loop_task) xTaskNotifyGive(loop_task);
+}
+
+IRAM_ATTR void loop_wake_from_isr(void)
+{
+    if(!loop_task) return;
+    BaseType_t higher = pdFALSE;
+    vTaskNotifyGiveFromISR(loop_task, &higher);
+    if(higher) portYIELD_FROM_ISR();
+}
+
+static bool loop_wait(uint32_t ms)
+{
+    return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms)) != 0;
+}
+
+static inline uint32_t loop_now(void)
+{
+    return millis();
+}
+
+#elif defined(ARDUINO_ARCH_ESP8266)
+static volatile bool loop_woken = false;
+
+void loop_setup(void)
+{}
+
+void loop_wake(void)
+{
+    loop_woken = true;
+}
+
+IRAM_ATTR void loop_wake_from_isr(void)
+{
+    loop_woken = true;
+}
+
+static bool loop_wait(uint32_t ms)
+{
+    esp_delay(ms, []() { return !loop_woken; }, 1); // the flag is checked every ms while the sdk runs
+    bool woken = loop_woken;
+    loop_woken = false;
+    return woken;
+}
+
+static inline uint32_t loop_now(void)
+{
+    return millis();
+}
+
+#elif defined(ARDUINO)
+static volatile bool loop_woken = false;
+
+void loop_setup(void)
+{}
+
+void loop_wake(void)
+{
+    loop_woken = true;
+}
+
+void loop_wake_from_isr(void)
+{
+    loop_woken = true;
+}
+
+static bool loop_wait(uint32_t ms)
+{
+    uint32_t start = millis();
+    while(!loop_woken && millis() - start < ms) delay(1);
+    bool woken = loop_woken;
+    loop_woken = false;
+    return woken;
+}
+
+static inline uint32_t loop_now(void)
+{
+    return millis();
+}
+
+#else
+static std::mutex loop_mutex;
+static std::condition_variable loop_cond;
+static bool loop_woken = false;
+
+void loop_setup(void)
+{}
+
+void loop_wake(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(loop_mutex);
+        loop_woken = true;
+    }
+    loop_cond.notify_one();
+}
+
+void loop_wake_from_isr(void)
+{
+    loop_wake();
+}
+
+static bool loop_wait(uint32_t ms)
+{
+    std::unique_lock<std::mutex> lock(loop_mutex);
+    loop_cond.wait_for(lock, std::chrono::milliseconds(ms), [] { return loop_woken; });
+    bool woken = loop_woken;
+    loop_woken = false;
+    return woken;
+}
+
+static inline uint32_t loop_now(void)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+#endif
+
+void loop_schedule(uint32_t ms)
+{
+    if(ms < loop_timeout) loop_timeout = ms;
+}
+
+void loop_sleep(void)
+{
+    uint32_t timeout = loop_timeout;
+    loop_timeout     = HASP_LOOP_MAX_SLEEP;
+#if HASP_LOOP_MIN_SLEEP > 0
+    if(timeout < HASP_LOOP_MIN_SLEEP) timeout = HASP_LOOP_MIN_SLEEP;
+#endif
+    loop_stats.loops++;
+
+    uint32_t start = loop_now();
+    if(timeout > 0 && loop_wait(timeout)) loop_stats.wakeups++;
+    loop_stats.slept += loop_now() - start;
+}
+
+void loop_get_stats(loop_stats_t& stats, bool reset)
+{
+    stats = loop_stats;
+    if(reset) loop_stats = {};
+}
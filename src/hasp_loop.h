@@ -0,0 +1,40 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_LOOP_H
+#define HASP_LOOP_H
+
+#include <stdint.h>
+
+#ifndef HASP_LOOP_MAX_SLEEP
+#if defined(ARDUINO)
+#define HASP_LOOP_MAX_SLEEP 20 // ms, the web server, serial console and wifi are still polled
+#else
+#define HASP_LOOP_MAX_SLEEP 250 // ms, every input posts a wakeup
+#endif
+#endif
+
+struct loop_stats_t
+{
+    uint32_t loops;   // iterations of the main loop
+    uint32_t wakeups; // sleeps that were cut short by loop_wake
+    uint32_t slept;   // ms spent waiting
+};
+
+void loop_setup(void);
+
+/* The next iteration of the main loop must start within ms, the shortest request of an iteration wins */
+void loop_schedule(uint32_t ms);
+
+/* Starts the next iteration now, safe from any thread */
+void loop_wake(void);
+
+/* Same, from an interrupt handler */
+void loop_wake_from_isr(void);
+
+/* Called at the end of the main loop, sleeps until the earliest scheduled time or a wakeup */
+void loop_sleep(void);
+
+void loop_get_stats(loop_stats_t& stats, bool reset);
+
+#endif // HASP_LOOP_H
@@ -32,7 +32,9 @@
 #include "hasp/hasp_object.h"
 #include "hasp/hasp_page.h"
 #include "hasp/hasp_parser.h"
+#include "hasp/hasp_style.h"
 #include "hasp/hasp_lvfs.h"
+#include "hasp/hasp_export.h"
 
 #include "hasp/lv_theme_hasp.h"
 
@@ -72,4 +74,7 @@
 
 #if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
 #include "custom/my_custom.h"
-#endif
\ No newline at end of file
+#endif
+
+#include "hasp_gui_lock.h"
+#include "hasp/hasp_plugin.h"
@@ -107,6 +107,7 @@
 
 #define D_DISPATCH_COMMAND_NOT_FOUND "Befehl '%s' nicht gefunden"
 #define D_DISPATCH_INVALID_PAGE "Ungültige Seite %s"
+#define D_DISPATCH_INVALID_PAYLOAD "Invalid payload for '%s'"
 #define D_DISPATCH_REBOOT "Jetzt die MCU neu starten!"
 
 #define D_JSON_FAILED "JSON Parsing fehlgeschlagen:"
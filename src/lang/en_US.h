@@ -107,6 +107,7 @@
 
 #define D_DISPATCH_COMMAND_NOT_FOUND "Command '%s' not found"
 #define D_DISPATCH_INVALID_PAGE "Invalid page %s"
+#define D_DISPATCH_INVALID_PAYLOAD "Invalid payload for '%s'"
 #define D_DISPATCH_REBOOT "Rebooting the MCU now!"
 
 #define D_JSON_FAILED "JSON parsing failed:"
@@ -107,6 +107,7 @@
 
 #define D_DISPATCH_COMMAND_NOT_FOUND "No se encontró el comando '%s'"
 #define D_DISPATCH_INVALID_PAGE "Página inválida %s"
+#define D_DISPATCH_INVALID_PAYLOAD "Invalid payload for '%s'"
 #define D_DISPATCH_REBOOT "Reiniciando microprocesador!"
 
 #define D_JSON_FAILED "No se pudo analizar JSON:"
@@ -107,6 +107,7 @@
 
 #define D_DISPATCH_COMMAND_NOT_FOUND "Command '%s' not found" // new
 #define D_DISPATCH_INVALID_PAGE "Invalid page %s"             // new
+#define D_DISPATCH_INVALID_PAYLOAD "Invalid payload for '%s'"
 #define D_DISPATCH_REBOOT "Rebooting the MCU now!"            // new
 
 #define D_JSON_FAILED "JSON parsing failed:"             // new
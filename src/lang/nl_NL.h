@@ -107,6 +107,7 @@
 
 #define D_DISPATCH_COMMAND_NOT_FOUND "Opdracht '%s' niet gevonden"
 #define D_DISPATCH_INVALID_PAGE "Ongeldige pagina %s"
+#define D_DISPATCH_INVALID_PAYLOAD "Invalid payload for '%s'"
 #define D_DISPATCH_REBOOT "De MCU wordt herstart!"
 
 #define D_JSON_FAILED "JSON verwerking mislukt:"
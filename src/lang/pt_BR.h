@@ -107,6 +107,7 @@
 
 #define D_DISPATCH_COMMAND_NOT_FOUND "Comando '%s' não encontrado"
 #define D_DISPATCH_INVALID_PAGE "Página inválida %s"
+#define D_DISPATCH_INVALID_PAYLOAD "Invalid payload for '%s'"
 #define D_DISPATCH_REBOOT "Reiniciando a MCU agora!"
 
 #define D_JSON_FAILED "Falha ao analisar JSON:"
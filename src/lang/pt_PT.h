@@ -107,6 +107,7 @@
 
 #define D_DISPATCH_COMMAND_NOT_FOUND "Não se encontrou o comando '%s'"
 #define D_DISPATCH_INVALID_PAGE "Página inválida %s"
+#define D_DISPATCH_INVALID_PAYLOAD "Invalid payload for '%s'"
 #define D_DISPATCH_REBOOT "A reiniciar dispositivo!"
 
 #define D_JSON_FAILED "Não foi possível analisar o JSON:"
@@ -107,6 +107,7 @@
 
 #define D_DISPATCH_COMMAND_NOT_FOUND "Команда '%s' не найдена"
 #define D_DISPATCH_INVALID_PAGE "Неверная страница %s"
+#define D_DISPATCH_INVALID_PAYLOAD "Invalid payload for '%s'"
 #define D_DISPATCH_REBOOT "Перезагружаем устройство!"
 
 #define D_JSON_FAILED "Парсинг JSON не удался:"
@@ -107,6 +107,7 @@
 
 #define D_DISPATCH_COMMAND_NOT_FOUND "Kommando '%s' hittades inte
 #define D_DISPATCH_INVALID_PAGE "Ogiltig sida %s"
+#define D_DISPATCH_INVALID_PAYLOAD "Invalid payload for '%s'"
 #define D_DISPATCH_REBOOT "Startar om MCU nu!"
 
 #define D_JSON_FAILED "JSON parsning misslyckades:"
@@ -403,6 +403,14 @@ bool debugStartSerial()
     return true;
 }
 
+#if HASP_USE_LOG_RING
+// Gets every message as it is printed to the outputs, whether or not an output is attached
+static void debugLogRingLine(uint8_t tag, int level, const char* line, size_t len)
+{
+    log_ring_append(tag, level, millis(), line, len);
+}
+#endif
+
 // Do NOT call Log function before debugSetup is called
 void debugSetup(JsonObject settings)
 {
@@ -412,6 +420,9 @@ void debugSetup(JsonObject settings)
     Log.unregisterOutput(0);
     Log.unregisterOutput(1);
     Log.unregisterOutput(3);
+#if HASP_USE_LOG_RING
+    Log.setLine(debugLogRingLine, HASP_LOG_LEVEL);
+#endif
 
 #if HASP_USE_CONFIG > 0
     if(!settings[FPSTR(FP_CONFIG_BAUD)].isNull()) {
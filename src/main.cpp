@@ -12,6 +12,7 @@
 */
 
 #include "hasplib.h"
+#include "hasp_loop.h"
 #include "hasp_oobe.h"
 #include "sys/net/hasp_network.h"
 #include "sys/net/hasp_time.h"
@@ -136,9 +137,7 @@ void setup()
     slaveSetup();
 #endif
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
-    custom_setup();
-#endif
+    plugin_setup();
 
     // guiStart();
 
@@ -159,26 +158,23 @@ void setup()
     gui_setup_lvgl_task();
 #endif // HASP_USE_LVGL_TASK
 
+    loop_setup();
     mainLastLoopTime = 0; // reset loop counter
 }
 
+/* Only the sections that touch lvgl hold the gui lock, commands lock it in dispatch_topic_payload */
 IRAM_ATTR void loop()
 {
-#if defined(ESP32) && defined(HASP_USE_ESP_MQTT)
-    if(!gui_acquire(portMAX_DELAY)) {
-        // LOG_ERROR(TAG_MAIN, F("TAKE Mutex"));
-        delay(5); // ms
-        return;
-    }
-#endif
-
 #if HASP_TARGET_PC
     /* Process jsonl/json commands deferred from MQTT thread (LVGL not thread-safe on PC). */
     dispatch_process_deferred();
 #endif
 
 #if HASP_USE_LVGL_TASK == 0
-    guiLoop();
+    {
+        GuiLock lock("lvgl");
+        loop_schedule(guiLoop()); // until the next lvgl task
+    }
 #endif
 
 #if HASP_USE_WIFI > 0 || HASP_USE_ETHERNET > 0
@@ -186,9 +182,17 @@ IRAM_ATTR void loop()
 #endif
 
 #if HASP_USE_GPIO > 0
-    gpioLoop();
+    {
+        GuiLock lock("gpio");
+        gpioLoop();
+    }
 #endif // GPIO
 
+    {
+        GuiLock lock("gesture");
+        gesture_event_loop(); // queued by the touch driver
+    }
+
 #if HASP_USE_MQTT > 0
     mqttLoop();
 #endif
@@ -197,13 +201,21 @@ IRAM_ATTR void loop()
 
 #if HASP_USE_CONSOLE > 0
     // debugLoop();
-    consoleLoop();
+    {
+        GuiLock lock("console");
+        consoleLoop();
+    }
 #endif
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
-    custom_loop();
+#if HASP_USE_TELNET > 0 && HASP_TARGET_PC
+    telnetLoop(); // runs in networkLoop on the devices
 #endif
 
+    {
+        GuiLock lock("plugins");
+        loop_schedule(plugin_loop()); // until the next plugin loop is due
+    }
+
 #ifdef HASP_USE_STAT_COUNTER
     statLoopCounter++; // measures the average looptime
 #endif
@@ -213,7 +225,11 @@ IRAM_ATTR void loop()
         mainLastLoopTime = millis();
 
         /* Runs Every Second */
-        haspEverySecond(); // sleep timer & statusupdate
+        {
+            GuiLock lock("every second");
+            haspEverySecond(); // sleep timer & statusupdate
+            plugin_every_second();
+        }
 
 #if HASP_USE_MQTT > 0
         mqttEverySecond();
@@ -227,9 +243,6 @@ IRAM_ATTR void loop()
         telnetEverySecond();
 #endif
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
-        custom_every_second();
-#endif
         // debugEverySecond();
 
         switch(++mainLoopCounter) {
@@ -248,9 +261,10 @@ IRAM_ATTR void loop()
                 //   gpioEvery5Seconds();
 #endif
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
-                custom_every_5seconds();
-#endif
+                {
+                    GuiLock lock("every 5 seconds");
+                    plugin_every_5seconds();
+                }
                 break;
 
             case 4:
@@ -265,26 +279,20 @@ IRAM_ATTR void loop()
             case 5:
                 mainLoopCounter = 0;
 #ifdef HASP_USE_STAT_COUNTER
-                if(statLoopCounter)
-                    LOG_DEBUG(TAG_MAIN, F("%d millis per loop, %d counted"), 5000 / statLoopCounter, statLoopCounter);
+                if(statLoopCounter) {
+                    loop_stats_t stats;
+                    loop_get_stats(stats, true);
+                    LOG_DEBUG(TAG_MAIN, F("%d millis per loop, %d counted, %u%% asleep, %u wakeups"),
+                              5000 / statLoopCounter, statLoopCounter, stats.slept / 50, stats.wakeups);
+                }
                 statLoopCounter = 0;
 #endif
                 break;
         }
     }
 
-#if defined(ESP32) && defined(HASP_USE_ESP_MQTT)
-    gui_release();
-#endif
+    loop_schedule(1000 - (millis() - mainLastLoopTime)); // until the next second
 
-// allow the cpu to switch to other tasks
-#if HASP_USE_LVGL_TASK == 0
-#ifdef ARDUINO_ARCH_ESP8266
-    delay(2); // ms
-#else
-    delay(2); // ms
-#endif
-#else // HASP_USE_LVGL_TASK != 0
-    delay(2); // ms
-#endif
+    // allow the cpu to switch to other tasks until there is work to do
+    loop_sleep();
 }
@@ -27,6 +27,16 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#if defined(POSIX)
+#include <sys/resource.h>
+#endif
 
 #include "hasplib.h"
 
@@ -35,6 +45,7 @@
 #endif
 
 #include "hasp_debug.h"
+#include "hasp_loop.h"
 
 // hasp_gui.cpp
 extern uint16_t tft_width;
@@ -106,6 +117,167 @@ void InitializeConsoleOutput()
 }
 #endif
 
+/* Replay of a recorded MQTT trace
+ *
+ * Each line of the trace holds the receive time in milliseconds, the topic relative to the node topic and the
+ * payload, separated by a single space. Empty lines and lines starting with # are ignored:
+ *     1250 command/p1b2.text 21.5 °C
+ *
+ * The messages are fed through dispatch_topic_payload at the recorded time divided by the speed factor,
+ * or back-to-back when the speed is 0. The main loop keeps running in between messages.
+ * With a repeat count the trace is played again right after the last message of the previous pass, and the run fails
+ * when the later passes leave more free blocks or more used memory in the lvgl heap than the first pass did.
+ */
+
+#ifndef REPLAY_FREE_BLOCK_SLACK
+#define REPLAY_FREE_BLOCK_SLACK 4 // free blocks the later passes may add, e.g. for a label that got longer
+#endif
+#ifndef REPLAY_USED_SLACK
+#define REPLAY_USED_SLACK 256 // bytes
+#endif
+
+struct replay_message_t
+{
+    uint32_t time;
+    std::string topic;
+    std::string payload;
+};
+
+static bool replay_load(const char* path, std::vector<replay_message_t>& messages)
+{
+    std::ifstream file(path);
+    if(!file.is_open()) return false;
+
+    std::string line;
+    while(std::getline(file, line)) {
+        if(!line.empty() && line.back() == '\r') line.pop_back();
+        if(line.empty() || line[0] == '#') continue;
+
+        size_t pos1 = line.find(' ');
+        if(pos1 == std::string::npos) continue;
+        size_t pos2 = line.find(' ', pos1 + 1);
+
+        replay_message_t msg;
+        msg.time  = strtoul(line.c_str(), NULL, 10);
+        msg.topic = line.substr(pos1 + 1, pos2 == std::string::npos ? std::string::npos : pos2 - pos1 - 1);
+        if(pos2 != std::string::npos) msg.payload = line.substr(pos2 + 1);
+        messages.push_back(msg);
+    }
+
+    std::stable_sort(messages.begin(), messages.end(),
+                     [](const replay_message_t& a, const replay_message_t& b) { return a.time < b.time; });
+    return true;
+}
+
+static void replay_print_stat(const char* name, std::vector<uint32_t>& samples)
+{
+    if(samples.empty()) return;
+    std::sort(samples.begin(), samples.end());
+
+    uint64_t sum = 0;
+    for(uint32_t sample : samples) sum += sample;
+
+    std::cerr << "  " << name << " us: p50 " << samples[samples.size() * 50 / 100] << ", p99 "
+              << samples[samples.size() * 99 / 100] << ", max " << samples.back() << ", avg " << sum / samples.size()
+              << std::endl;
+}
+
+static int replay_run(const char* path, double speed, uint32_t repeat)
+{
+    std::vector<replay_message_t> messages;
+    if(!replay_load(path, messages)) {
+        std::cerr << "Failed to open replay file " << path << std::endl;
+        return 1;
+    }
+
+    typedef std::chrono::steady_clock clock;
+    std::vector<uint32_t> dispatch_us;
+    std::vector<uint32_t> render_us;
+    std::vector<uint32_t> latency_us;
+    if(repeat < 1) repeat = 1;
+    dispatch_us.reserve(messages.size() * repeat);
+    render_us.reserve(messages.size() * repeat);
+    latency_us.reserve(messages.size() * repeat);
+
+    size_t lvgl_peak = 0;
+#if LV_MEM_CUSTOM == 0
+    lv_mem_monitor_t first_pass; // heap layout after the first pass, later passes should not fragment it further
+    memset(&first_pass, 0, sizeof(first_pass));
+#endif
+    uint32_t duration       = messages.empty() ? 0 : messages.back().time;
+    clock::time_point start = clock::now();
+
+    for(size_t n = 0; n < repeat * messages.size(); n++) {
+        const replay_message_t& msg = messages[n % messages.size()];
+        if(!haspDevice.pc_is_running) break;
+
+        // Keep the application running until the message is due
+        clock::time_point due = start;
+        if(speed > 0)
+            due += std::chrono::microseconds(
+                (uint64_t)(((uint64_t)duration * (n / messages.size()) + msg.time) * 1000.0 / speed));
+        for(clock::time_point now = clock::now(); now < due && haspDevice.pc_is_running; now = clock::now()) {
+            loop_schedule(std::chrono::duration_cast<std::chrono::milliseconds>(due - now).count());
+            loop();
+        }
+        if(speed <= 0) due = clock::now();
+
+        clock::time_point t0 = clock::now();
+        dispatch_topic_payload(msg.topic.c_str(), msg.payload.c_str(), !msg.payload.empty(), TAG_MQTT);
+        clock::time_point t1 = clock::now();
+        {
+            GuiLock lock("replay");
+            lv_refr_now(NULL); // render the invalidated areas now
+        }
+        clock::time_point t2 = clock::now();
+
+        dispatch_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count());
+        render_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count());
+        latency_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(t2 - due).count());
+
+#if LV_MEM_CUSTOM == 0
+        lv_mem_monitor_t mem_mon;
+        lv_mem_monitor(&mem_mon);
+        if(mem_mon.total_size - mem_mon.free_size > lvgl_peak) lvgl_peak = mem_mon.total_size - mem_mon.free_size;
+        if(n + 1 == messages.size()) first_pass = mem_mon;
+#endif
+    }
+
+    uint32_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+    int result       = 0;
+
+    // Report on stderr, so the results are still shown with --quiet
+    std::cerr << std::endl
+              << "Replay " << path << ": " << dispatch_us.size() << " messages in " << elapsed << " ms (speed "
+              << speed << ")" << std::endl;
+    replay_print_stat("dispatch", dispatch_us);
+    replay_print_stat("render  ", render_us);
+    replay_print_stat("latency ", latency_us);
+#if LV_MEM_CUSTOM == 0
+    std::cerr << "  lvgl heap peak: " << lvgl_peak << " bytes" << std::endl;
+    if(repeat > 1 && dispatch_us.size() == repeat * messages.size()) {
+        lv_mem_monitor_t mem_mon;
+        lv_mem_monitor(&mem_mon);
+        size_t first_used = first_pass.total_size - first_pass.free_size;
+        size_t last_used  = mem_mon.total_size - mem_mon.free_size;
+        bool fragmented   = mem_mon.free_cnt > first_pass.free_cnt + REPLAY_FREE_BLOCK_SLACK;
+        bool leaked       = last_used > first_used + REPLAY_USED_SLACK;
+
+        std::cerr << "  lvgl free blocks: " << first_pass.free_cnt << " after pass 1, " << mem_mon.free_cnt
+                  << " after pass " << repeat << " (fragmentation " << (int)first_pass.frag_pct << "% -> "
+                  << (int)mem_mon.frag_pct << "%)" << (fragmented ? " FAILED" : "") << std::endl;
+        std::cerr << "  lvgl heap used: " << first_used << " bytes after pass 1, " << last_used << " bytes after pass "
+                  << repeat << (leaked ? " FAILED" : "") << std::endl;
+        if(fragmented || leaked) result = 1;
+    }
+#endif
+#if defined(POSIX)
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0) std::cerr << "  max rss: " << usage.ru_maxrss << " kB" << std::endl;
+#endif
+    return result;
+}
+
 void usage(const char* progName, const char* version)
 {
     std::cout << "\n"
@@ -124,6 +296,9 @@ void usage(const char* progName, const char* version)
 #elif defined(POSIX)
               << "                        (default: '~/.local/share/hasp/hasp')" << std::endl
 #endif
+              << "    -r  | --replay      Replay a recorded MQTT trace file and report the timings" << std::endl
+              << "    -s  | --speed       Replay speed factor, 0 = as fast as possible (default: 1)" << std::endl
+              << "    -n  | --repeat      Number of times the replay file is played (default: 1)" << std::endl
               << std::endl;
     fflush(stdout);
 }
@@ -133,6 +308,10 @@ int main(int argc, char* argv[])
     bool showhelp         = false;
     bool console          = true;
     char config[PATH_MAX] = {'\0'};
+    char replay[PATH_MAX] = {'\0'};
+    double speed          = 1;
+    uint32_t repeat       = 1;
+    int result            = 0;
 
 #if defined(WINDOWS)
     InitializeConsoleOutput();
@@ -179,6 +358,34 @@ int main(int argc, char* argv[])
                 std::cout << "Missing config directory" << std::endl;
                 showhelp = true;
             }
+        } else if(strncmp(argv[arg], "--replay", 8) == 0 || strncmp(argv[arg], "-r", 2) == 0) {
+            if(arg + 1 < argc) {
+                // resolve the path before changing to the config directory
+#if defined(POSIX)
+                if(!realpath(argv[arg + 1], replay))
+#endif
+                    strcpy(replay, argv[arg + 1]);
+                arg++;
+            } else {
+                std::cout << "Missing replay file" << std::endl;
+                showhelp = true;
+            }
+        } else if(strncmp(argv[arg], "--speed", 7) == 0 || strncmp(argv[arg], "-s", 2) == 0) {
+            if(arg + 1 < argc) {
+                speed = atof(argv[arg + 1]);
+                arg++;
+            } else {
+                std::cout << "Missing speed value" << std::endl;
+                showhelp = true;
+            }
+        } else if(strncmp(argv[arg], "--repeat", 8) == 0 || strncmp(argv[arg], "-n", 2) == 0) {
+            if(arg + 1 < argc) {
+                repeat = strtoul(argv[arg + 1], NULL, 10);
+                arg++;
+            } else {
+                std::cout << "Missing repeat count" << std::endl;
+                showhelp = true;
+            }
         } else {
             std::cout << "Unrecognized command line parameter: " << argv[arg] << std::endl;
             showhelp = true;
@@ -209,8 +416,12 @@ int main(int argc, char* argv[])
     cd(config);
 
     setup();
-    while(haspDevice.pc_is_running) {
-        loop();
+    if(replay[0] != '\0') {
+        result = replay_run(replay, speed, repeat);
+    } else {
+        while(haspDevice.pc_is_running) {
+            loop();
+        }
     }
 
 end:
@@ -218,9 +429,9 @@ end:
     std::cout << std::endl << std::flush;
     fflush(stdout);
     FreeConsole();
-    exit(0);
+    exit(result);
 #endif
-    return 0;
+    return result;
 }
 
 #endif
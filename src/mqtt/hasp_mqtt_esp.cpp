@@ -18,6 +18,7 @@
 #include "hasp_debug.h"
 #include "hasp_config.h"
 #include "hasp_gui.h"
+#include "hasp_loop.h"
 
 #include "../hasp/hasp_dispatch.h"
 #include "freertos/queue.h"
@@ -222,7 +223,8 @@ void mqtt_enqueue_message(const char* topic, const char* payload, size_t payload
 
 void mqtt_process_topic_payload(const char* topic, const char* payload, unsigned int length)
 {
-    if(gui_acquire(pdMS_TO_TICKS(30))) {
+    // The lock is only held while the loop draws or runs a command, wait for that rather than queue
+    if(gui_acquire(30, "mqtt")) {
         mqttLoop(); // First empty the MQTT queue
         LOG_TRACE(TAG_MQTT_RCV, F("%s = %s"), topic, payload);
         dispatch_topic_payload(topic, payload, length > 0, TAG_MQTT);
@@ -230,6 +232,7 @@ void mqtt_process_topic_payload(const char* topic, const char* payload, unsigned
     } else {
         mqtt_enqueue_message(topic, payload, length);
     }
+    loop_wake(); // render the changes or empty the queue now
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -371,11 +374,11 @@ void onMqttConnect(esp_mqtt_client_handle_t client)
     // mqttSubscribeTo(mqttGroupTopic + subtopic);
     // mqttSubscribeTo(mqttNodeTopic + subtopic);
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
-    String subtopic = F(MQTT_TOPIC_CUSTOM "/#");
-    mqttSubscribeTo(mqttGroupCommandTopic + subtopic);
-    mqttSubscribeTo(mqttNodeCommandTopic + subtopic);
-#endif
+    if(plugin_has_topics()) {
+        String subtopic = F(MQTT_TOPIC_CUSTOM "/#");
+        mqttSubscribeTo(mqttGroupCommandTopic + subtopic);
+        mqttSubscribeTo(mqttNodeCommandTopic + subtopic);
+    }
 
     /* Home Assistant auto-configuration */
 #ifdef HASP_USE_HA
@@ -46,6 +46,7 @@ const char FP_CONFIG_GROUP[] PROGMEM = "group";
 
 #include "hasp/hasp_dispatch.h" // for dispatch_topic_payload, dispatch_defer_command
 #include "hasp_debug.h"         // for logging
+#include "hasp_loop.h"          // for loop_wake
 
 #if !defined(_WIN32)
 #include <unistd.h>
@@ -163,6 +164,7 @@ static void mqtt_message_cb(char* topic, char* payload, size_t length)
         dispatch_mtx.lock();
         dispatch_topic_payload(topic, (const char*)payload, length > 0, TAG_MQTT);
         dispatch_mtx.unlock();
+        loop_wake(); // render the changes now
         return;
 
 #ifdef HASP_USE_BROADCAST
@@ -174,6 +176,7 @@ static void mqtt_message_cb(char* topic, char* payload, size_t length)
         dispatch_mtx.lock();
         dispatch_topic_payload(topic, (const char*)payload, length > 0, TAG_MQTT);
         dispatch_mtx.unlock();
+        loop_wake(); // render the changes now
         return;
 #endif
 
@@ -215,6 +218,7 @@ static void mqtt_message_cb(char* topic, char* payload, size_t length)
         dispatch_mtx.lock();
         dispatch_topic_payload(topic, (const char*)payload, length > 0, TAG_MQTT);
         dispatch_mtx.unlock();
+        loop_wake(); // render the changes now
     }
 }
 
@@ -334,13 +338,13 @@ static void onConnect(void* context, MQTTAsync_successData* response)
     topic = mqttNodeTopic + "config/#";
     mqtt_subscribe(mqtt_client, topic.c_str());
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
-    topic = mqttGroupTopic + MQTT_TOPIC_CUSTOM "/#";
-    mqtt_subscribe(mqtt_client, topic.c_str());
+    if(plugin_has_topics()) {
+        topic = mqttGroupTopic + MQTT_TOPIC_CUSTOM "/#";
+        mqtt_subscribe(mqtt_client, topic.c_str());
 
-    topic = mqttNodeTopic + MQTT_TOPIC_CUSTOM "/#";
-    mqtt_subscribe(mqtt_client, topic.c_str());
-#endif
+        topic = mqttNodeTopic + MQTT_TOPIC_CUSTOM "/#";
+        mqtt_subscribe(mqtt_client, topic.c_str());
+    }
 
 #ifdef HASP_USE_BROADCAST
     topic = MQTT_PREFIX "/" MQTT_TOPIC_BROADCAST "/" MQTT_TOPIC_COMMAND "/#";
@@ -270,13 +270,13 @@ static void onConnect(void* context)
     topic = mqttNodeTopic + "config/#";
     mqtt_subscribe(mqtt_client, topic.c_str());
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
-    topic = mqttGroupTopic + MQTT_TOPIC_CUSTOM "/#";
-    mqtt_subscribe(mqtt_client, topic.c_str());
+    if(plugin_has_topics()) {
+        topic = mqttGroupTopic + MQTT_TOPIC_CUSTOM "/#";
+        mqtt_subscribe(mqtt_client, topic.c_str());
 
-    topic = mqttNodeTopic + MQTT_TOPIC_CUSTOM "/#";
-    mqtt_subscribe(mqtt_client, topic.c_str());
-#endif
+        topic = mqttNodeTopic + MQTT_TOPIC_CUSTOM "/#";
+        mqtt_subscribe(mqtt_client, topic.c_str());
+    }
 
 #ifdef HASP_USE_BROADCAST
     topic = MQTT_PREFIX "/" MQTT_TOPIC_BROADCAST "/" MQTT_TOPIC_COMMAND "/#";
@@ -311,12 +311,12 @@ void mqttStart()
     snprintf_P(topic, sizeof(topic), PSTR("%s" MQTT_TOPIC_CONFIG "/#"), mqttNodeTopic);
     mqttSubscribeTo(topic);
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
-    snprintf_P(topic, sizeof(topic), PSTR("%s" MQTT_TOPIC_CUSTOM "/#"), mqttGroupTopic);
-    mqttSubscribeTo(topic);
-    snprintf_P(topic, sizeof(topic), PSTR("%s" MQTT_TOPIC_CUSTOM "/#"), mqttNodeTopic);
-    mqttSubscribeTo(topic);
-#endif
+    if(plugin_has_topics()) {
+        snprintf_P(topic, sizeof(topic), PSTR("%s" MQTT_TOPIC_CUSTOM "/#"), mqttGroupTopic);
+        mqttSubscribeTo(topic);
+        snprintf_P(topic, sizeof(topic), PSTR("%s" MQTT_TOPIC_CUSTOM "/#"), mqttNodeTopic);
+        mqttSubscribeTo(topic);
+    }
 
 #ifdef HASP_USE_BROADCAST
     snprintf_P(topic, sizeof(topic), PSTR(MQTT_PREFIX "/" MQTT_TOPIC_BROADCAST "/" MQTT_TOPIC_COMMAND "/#"));
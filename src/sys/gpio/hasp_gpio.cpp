@@ -6,6 +6,7 @@
 #include "hasplib.h"
 
 #include "hasp_gpio.h"
+#include "hasp_loop.h"
 
 // Device Drivers
 #include "dev/device.h"
@@ -16,13 +17,13 @@
 #define INPUT_PULLDOWN INPUT
 #endif
 
-#ifdef ARDUINO
-#include "AceButton.h"
+#include "hasp_gpio_input.h"
 
-using namespace ace_button;
-ButtonConfig buttonConfig; // Clicks, double-clicks and long presses
-ButtonConfig switchConfig; // Clicks only
-#else
+#if HASP_NUM_GPIO_CONFIG > GPIO_INPUT_MAX_CHANNELS
+#error "HASP_NUM_GPIO_CONFIG exceeds the number of input channels"
+#endif
+
+#ifndef ARDUINO
 
 #define HIGH 1
 #define LOW 0
@@ -54,6 +55,33 @@ hasp_gpio_config_t gpioConfig[HASP_NUM_GPIO_CONFIG] = {
 };
 uint8_t pwm_channel = 1; // Backlight has 0
 
+// Index of the first config in use for each pin, and the configs of each group in index order
+#define GPIO_NO_CONFIG 0xFF
+static uint8_t gpio_pin_index[NUM_DIGITAL_PINS];
+static uint8_t gpio_group_head[256];
+static uint8_t gpio_group_next[HASP_NUM_GPIO_CONFIG];
+
+static void gpio_build_index()
+{
+    memset(gpio_pin_index, GPIO_NO_CONFIG, sizeof(gpio_pin_index));
+    memset(gpio_group_head, GPIO_NO_CONFIG, sizeof(gpio_group_head));
+
+    for(uint8_t i = HASP_NUM_GPIO_CONFIG; i-- > 0;) {
+        gpio_group_next[i] = GPIO_NO_CONFIG;
+        if(!gpioConfigInUse(i)) continue;
+
+        if(gpioConfig[i].pin < NUM_DIGITAL_PINS) gpio_pin_index[gpioConfig[i].pin] = i;
+        gpio_group_next[i]                   = gpio_group_head[gpioConfig[i].group];
+        gpio_group_head[gpioConfig[i].group] = i;
+    }
+}
+
+static inline hasp_gpio_config_t* gpio_find_pin(uint8_t pin)
+{
+    if(pin >= NUM_DIGITAL_PINS || gpio_pin_index[pin] == GPIO_NO_CONFIG) return NULL;
+    return &gpioConfig[gpio_pin_index[pin]];
+}
+
 static inline void gpio_input_event(uint8_t pin, hasp_event_t eventid);
 
 static inline void gpio_update_group(uint8_t group, lv_obj_t* obj, bool power, int32_t val, int32_t min, int32_t max)
@@ -92,23 +120,51 @@ void gotTouch()
     touchdetected = true;
 }
 
-// Overrides the readButton function on ESP32
-class CapacitiveConfig : public ButtonConfig {
+#endif
 
-  protected:
-    // Number of iterations to sample the capacitive switch. Higher number
-    // provides better smoothing but increases the time taken for a single read.
-    // static const uint8_t kSamples = 10;
+#ifdef ARDUINO
+// Inputs report their edges by interrupt, the input engine only reads the pins that changed
+class GpioArduinoBackend : public GpioInputBackend {
+  public:
+    uint64_t touch_pins = 0; // read from the touch flag instead of the pin
 
-    // The threshold value which is considered to be a "touch" on the switch.
-    static const long kTouchThreshold = 32;
+    uint32_t now() override
+    {
+        return millis();
+    }
+
+    int read(uint8_t pin) override
+    {
+#if defined(ARDUINO_ARCH_ESP32)
+        if(pin < 64 && (touch_pins >> pin & 1)) return touchdetected ? HIGH : LOW; // HIGH = not touched
+#endif
+        return digitalRead(pin);
+    }
 
-    int readButton(uint8_t pin) override
+    bool attach(uint8_t pin, GpioInput* engine, uint8_t id) override;
+    void detach(uint8_t pin) override
     {
-        return touchdetected ? HIGH : LOW; // HIGH = not touched
+        detachInterrupt(digitalPinToInterrupt(pin));
     }
 };
-CapacitiveConfig touchConfig; // Capacitive touch
+
+static GpioArduinoBackend gpioBackend;
+static GpioInput gpioInput(gpioBackend);
+
+static IRAM_ATTR void gpio_isr(void* arg)
+{
+    gpioInput.edge((uint8_t)(uintptr_t)arg, millis()); // no virtual call, the vtable is in flash
+    loop_wake_from_isr();
+}
+
+bool GpioArduinoBackend::attach(uint8_t pin, GpioInput* engine, uint8_t id)
+{
+    int irq = digitalPinToInterrupt(pin);
+    if(irq < 0) return false; // NOT_AN_INTERRUPT, the pin is polled
+
+    attachInterruptArg(irq, gpio_isr, (void*)(uintptr_t)id, CHANGE);
+    return true;
+}
 #endif
 
 void gpio_log_serial_dimmer(const char* command)
@@ -120,13 +176,12 @@ void gpio_log_serial_dimmer(const char* command)
 }
 
 #ifdef ARDUINO
-static void gpio_event_handler(AceButton* button, uint8_t eventType, uint8_t buttonState)
+static void gpio_event_handler(void* arg, uint8_t btnid, gpio_input_event_t event)
 {
-    uint8_t btnid = button->getId();
     hasp_event_t eventid;
     bool state = false;
-    switch(eventType) {
-        case AceButton::kEventPressed:
+    switch(event) {
+        case GPIO_INPUT_PRESSED:
             if(gpioConfig[btnid].type != hasp_gpio_type_t::BUTTON_TYPE) {
                 eventid = HASP_EVENT_ON;
             } else {
@@ -135,21 +190,14 @@ static void gpio_event_handler(AceButton* button, uint8_t eventType, uint8_t but
             state = true;
             // touchdetected = false;
             break;
-        case 2: // AceButton::kEventClicked:
+        case GPIO_INPUT_CLICKED:
             eventid = HASP_EVENT_UP;
             break;
-        // case AceButton::kEventDoubleClicked:
-        //     eventid = HASP_EVENT_DOUBLE;
-        //     break;
-        case AceButton::kEventLongPressed:
+        case GPIO_INPUT_LONG_PRESSED:
             eventid = HASP_EVENT_LONG;
             // state = true; // do not repeat DOWN + LONG
             break;
-        // case AceButton::kEventRepeatPressed:
-        //     eventid = HASP_EVENT_HOLD;
-        //     state = true; // do not repeat DOWN + LONG + HOLD
-        //     break;
-        case AceButton::kEventReleased:
+        case GPIO_INPUT_RELEASED:
             if(gpioConfig[btnid].type != hasp_gpio_type_t::BUTTON_TYPE) {
                 eventid = HASP_EVENT_OFF;
             } else {
@@ -170,47 +218,36 @@ static void gpio_event_handler(AceButton* button, uint8_t eventType, uint8_t but
 
 /* ********************************* GPIO Setup *************************************** */
 
-void aceButtonSetup(void)
+// Buttons send clicks and long presses, switches only clicks
+static void gpio_setup_input(uint8_t index, uint8_t released_state)
 {
-    // Button Features
-    buttonConfig.setEventHandler(gpio_event_handler);
-    buttonConfig.setFeature(ButtonConfig::kFeatureClick);
-    buttonConfig.clearFeature(ButtonConfig::kFeatureDoubleClick);
-    buttonConfig.setFeature(ButtonConfig::kFeatureLongPress);
-    // buttonConfig.clearFeature(ButtonConfig::kFeatureRepeatPress);
-    buttonConfig.clearFeature(ButtonConfig::kFeatureSuppressClickBeforeDoubleClick); // Causes annoying pauses
-    buttonConfig.setFeature(ButtonConfig::kFeatureSuppressAfterClick);
-    // Delays
-    buttonConfig.setClickDelay(LV_INDEV_DEF_LONG_PRESS_TIME);
-    buttonConfig.setDoubleClickDelay(LV_INDEV_DEF_LONG_PRESS_TIME);
-    buttonConfig.setLongPressDelay(LV_INDEV_DEF_LONG_PRESS_TIME);
-    buttonConfig.setRepeatPressDelay(LV_INDEV_DEF_LONG_PRESS_TIME);
-    buttonConfig.setRepeatPressInterval(LV_INDEV_DEF_LONG_PRESS_REP_TIME);
-
-    // Switch Features
-    switchConfig.setEventHandler(gpio_event_handler);
-    switchConfig.setFeature(ButtonConfig::kFeatureClick);
-    switchConfig.clearFeature(ButtonConfig::kFeatureLongPress);
-    switchConfig.clearFeature(ButtonConfig::kFeatureRepeatPress);
-    switchConfig.clearFeature(ButtonConfig::kFeatureDoubleClick);
-    switchConfig.setClickDelay(100); // decrease click delay from default 200 ms
+    hasp_gpio_config_t* gpio   = &gpioConfig[index];
+    gpio_input_config_t config = {};
+    config.pin                 = gpio->pin;
+    config.pressed_level       = !released_state;
+
+    if(gpio->type == hasp_gpio_type_t::SWITCH ||
+       (gpio->type >= hasp_gpio_type_t::BATTERY && gpio->type <= hasp_gpio_type_t::WINDOW)) {
+        config.features    = GPIO_INPUT_FEATURE_CLICK;
+        config.click_delay = 100;
+    } else {
+        config.features = GPIO_INPUT_FEATURE_CLICK | GPIO_INPUT_FEATURE_LONG_PRESS | GPIO_INPUT_FEATURE_SUPPRESS_CLICK;
+        config.click_delay      = LV_INDEV_DEF_LONG_PRESS_TIME;
+        config.long_press_delay = LV_INDEV_DEF_LONG_PRESS_TIME;
+    }
 
 #if defined(ARDUINO_ARCH_ESP32)
-    // Capacitive Touch Features
-    touchConfig.setEventHandler(gpio_event_handler);
-    touchConfig.setFeature(ButtonConfig::kFeatureClick);
-    touchConfig.clearFeature(ButtonConfig::kFeatureDoubleClick);
-    touchConfig.setFeature(ButtonConfig::kFeatureLongPress);
-    // touchConfig.clearFeature(ButtonConfig::kFeatureRepeatPress);
-    touchConfig.clearFeature(ButtonConfig::kFeatureSuppressClickBeforeDoubleClick); // Causes annoying pauses
-    touchConfig.setFeature(ButtonConfig::kFeatureSuppressAfterClick);
-    // Delays
-    touchConfig.setClickDelay(LV_INDEV_DEF_LONG_PRESS_TIME);
-    touchConfig.setDoubleClickDelay(LV_INDEV_DEF_LONG_PRESS_TIME);
-    touchConfig.setLongPressDelay(LV_INDEV_DEF_LONG_PRESS_TIME);
-    touchConfig.setRepeatPressDelay(LV_INDEV_DEF_LONG_PRESS_TIME);
-    touchConfig.setRepeatPressInterval(LV_INDEV_DEF_LONG_PRESS_REP_TIME);
+    if(gpio->type == hasp_gpio_type_t::TOUCH) {
+        gpioBackend.touch_pins |= 1ULL << gpio->pin;
+        config.features |= GPIO_INPUT_FEATURE_POLL; // no edges, the touch flag is read on every loop
+    } else {
+        gpioBackend.touch_pins &= ~(1ULL << gpio->pin);
+    }
 #endif
+
+    gpioInput.add(index, config);
+    gpio->power = gpioInput.is_pressed_raw(index);
+    gpio->max   = 0;
 }
 
 // Can be called ad-hoc to change a setup
@@ -246,30 +283,19 @@ static void gpio_setup_pin(uint8_t index)
             break;
     }
 
+    gpioInput.remove(index);
     gpio->power = 0; // off by default, value is set to 0
     gpio->max   = 255;
     switch(gpio->type) {
         case hasp_gpio_type_t::SWITCH:
         case hasp_gpio_type_t::BATTERY... hasp_gpio_type_t::WINDOW:
-            if(gpio->btn) delete gpio->btn;
-            gpio->btn   = new AceButton(&switchConfig, gpio->pin, default_state, index);
-            gpio->power = gpio->btn->isPressedRaw();
-            pinMode(gpio->pin, input_mode);
-            gpio->max = 0;
-            break;
         case hasp_gpio_type_t::BUTTON_TYPE:
-            if(gpio->btn) delete gpio->btn;
-            gpio->btn   = new AceButton(&buttonConfig, gpio->pin, default_state, index);
-            gpio->power = gpio->btn->isPressedRaw();
             pinMode(gpio->pin, input_mode);
-            gpio->max = 0;
+            gpio_setup_input(index, default_state);
             break;
 #if defined(ARDUINO_ARCH_ESP32)
         case hasp_gpio_type_t::TOUCH:
-            if(gpio->btn) delete gpio->btn;
-            gpio->btn   = new AceButton(&touchConfig, gpio->pin, HIGH, index);
-            gpio->power = gpio->btn->isPressedRaw();
-            gpio->max   = 0;
+            gpio_setup_input(index, HIGH);
             // touchAttachInterrupt(gpio->pin, gotTouch, 33);
             break;
 #endif
@@ -345,7 +371,8 @@ void gpioSetup()
     LOG_WARNING(TAG_GPIO, F("Reboot counter %d"), rtcRecordCounter++);
 #endif
 
-    aceButtonSetup();
+    gpio_build_index();
+    gpioInput.set_callback(gpio_event_handler, NULL);
 
     for(uint8_t i = 0; i < HASP_NUM_GPIO_CONFIG; i++) {
         gpio_setup_pin(i);
@@ -358,10 +385,8 @@ void gpioSetup()
 
 IRAM_ATTR void gpioLoop(void)
 {
-    // Should be called every 4-5ms or faster, for the default debouncing time of ~20ms.
-    for(uint8_t i = 0; i < HASP_NUM_GPIO_CONFIG; i++) {
-        if(gpioConfig[i].btn) gpioConfig[i].btn->check();
-    }
+    // Returns at once unless an interrupt came in or a debounce or long press timer is running
+    if(gpioInput.loop()) loop_schedule(5);
 }
 
 #else
@@ -405,6 +430,7 @@ void gpioEvery5Seconds(void)
 
 bool gpio_get_pin_state(uint8_t pin, bool& power, int32_t& val)
 {
+    // the pin map holds the first config of a pin, the output may be a later one
     for(uint8_t i = 0; i < HASP_NUM_GPIO_CONFIG; i++) {
         if(gpioConfig[i].pin == pin && gpio_is_output(&gpioConfig[i])) {
             power = gpioConfig[i].power;
@@ -450,24 +476,20 @@ void gpio_output_state(hasp_gpio_config_t* gpio)
 
 bool gpio_input_pin_state(uint8_t pin)
 {
-    for(uint8_t i = 0; i < HASP_NUM_GPIO_CONFIG; i++) {
-        if(gpioConfig[i].pin == pin && gpioConfigInUse(i)) {
-            gpio_input_state(&gpioConfig[i]);
-            return true;
-        }
-    }
-    return false;
+    hasp_gpio_config_t* gpio = gpio_find_pin(pin);
+    if(!gpio) return false;
+
+    gpio_input_state(gpio);
+    return true;
 }
 
 bool gpio_output_pin_state(uint8_t pin)
 {
-    for(uint8_t i = 0; i < HASP_NUM_GPIO_CONFIG; i++) {
-        if(gpioConfig[i].pin == pin && gpioConfigInUse(i)) {
-            gpio_output_state(&gpioConfig[i]);
-            return true;
-        }
-    }
-    return false;
+    hasp_gpio_config_t* gpio = gpio_find_pin(pin);
+    if(!gpio) return false;
+
+    gpio_output_state(gpio);
+    return true;
 }
 
 static inline int32_t gpio_limit(int32_t val, int32_t min, int32_t max)
@@ -585,13 +607,8 @@ static inline bool gpio_set_dac_value(hasp_gpio_config_t* gpio)
 
 bool gpio_get_pin_config(uint8_t pin, hasp_gpio_config_t** gpio)
 {
-    for(uint8_t i = 0; i < HASP_NUM_GPIO_CONFIG; i++) {
-        if(gpioConfig[i].pin == pin) {
-            *gpio = &gpioConfig[i];
-            return true;
-        }
-    }
-    return false;
+    *gpio = gpio_find_pin(pin);
+    return *gpio != NULL;
 }
 
 // Update the actual value of one pin, does NOT update group members
@@ -668,10 +685,10 @@ static void gpio_set_normalized_value(hasp_gpio_config_t* gpio, hasp_update_valu
 // Dispatch all group member values
 void gpio_output_group_values(uint8_t group)
 {
-    for(uint8_t k = 0; k < HASP_NUM_GPIO_CONFIG; k++) {
+    for(uint8_t k = gpio_group_head[group]; k != GPIO_NO_CONFIG; k = gpio_group_next[k]) {
         hasp_gpio_config_t* gpio = &gpioConfig[k];
-        if(gpio->group == group && gpio_is_output(gpio)) // group members that are outputs
-            gpio_output_state(&gpioConfig[k]);
+        if(gpio_is_output(gpio)) // group members that are outputs
+            gpio_output_state(gpio);
     }
 }
 
@@ -681,11 +698,8 @@ void gpio_output_group_values(uint8_t group)
 void gpio_set_normalized_group_values(hasp_update_value_t& value)
 {
     // Set all pins first, minimizes delays
-    for(uint8_t k = 0; k < HASP_NUM_GPIO_CONFIG; k++) {
-        hasp_gpio_config_t* gpio = &gpioConfig[k];
-        if(gpio->group == value.group && gpioConfigInUse(k)) // group members that are outputs
-            gpio_set_normalized_value(gpio, value);
-    }
+    for(uint8_t k = gpio_group_head[value.group]; k != GPIO_NO_CONFIG; k = gpio_group_next[k])
+        gpio_set_normalized_value(&gpioConfig[k], value); // group members in use
 
     // Log the changed output values
     // gpio_output_group_values(value.group);
@@ -760,13 +774,7 @@ void gpio_set_moodlight(moodlight_t& moodlight)
 
 bool gpioInUse(uint8_t pin)
 {
-    for(uint8_t i = 0; i < HASP_NUM_GPIO_CONFIG; i++) {
-        if((gpioConfig[i].pin == pin) && gpioConfigInUse(i)) {
-            return true; // pin matches and is in use
-        }
-    }
-
-    return false;
+    return gpio_find_pin(pin) != NULL; // pin matches and is in use
 }
 
 bool gpioIsSystemPin(uint8_t gpio)
@@ -780,12 +788,10 @@ bool gpioIsSystemPin(uint8_t gpio)
         return true;
     }
 
-#if defined(HASP_USE_CUSTOM) && HASP_USE_CUSTOM > 0
-    if(custom_pin_in_use(gpio)) {
+    if(plugin_pin_in_use(gpio)) {
         LOG_DEBUG(TAG_GPIO, F(D_BULLET D_GPIO_PIN " %d => Custom"), gpio);
         return true;
     }
-#endif
 
     // To-do:
     // Backlight GPIO
@@ -812,6 +818,7 @@ bool gpioSavePinConfig(uint8_t config_num, uint8_t pin, uint8_t type, uint8_t gr
         gpioConfig[config_num].inverted      = inverted;
         LOG_TRACE(TAG_GPIO, F("Saving Pin config #%d pin %d - type %d - group %d - func %d"), config_num, pin, type,
                   group, pinfunc);
+        gpio_build_index();
         return true;
     }
 
@@ -1040,6 +1047,7 @@ bool gpioSetConfig(const JsonObject& settings)
             i++;
         }
         changed |= status;
+        gpio_build_index();
     }
 
     return changed;
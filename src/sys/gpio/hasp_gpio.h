@@ -6,11 +6,6 @@
 
 #include "hasplib.h"
 
-#ifdef ARDUINO
-#include "AceButton.h"
-using namespace ace_button;
-#endif
-
 struct hasp_gpio_config_t
 {
     uint8_t pin : 8;           // pin number
@@ -22,9 +17,6 @@ struct hasp_gpio_config_t
     uint8_t power : 1;
     uint16_t val;
     uint16_t max;
-#ifdef ARDUINO
-    AceButton* btn;
-#endif
 };
 
 extern hasp_gpio_config_t gpioConfig[HASP_NUM_GPIO_CONFIG];
@@ -0,0 +1,208 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Debouncing of GPIO inputs
+ *
+ * Each channel is a small state machine. An edge, reported by interrupt or found while polling, starts the settle
+ * timer of the channel. Only when the pin has been quiet for GPIO_INPUT_DEBOUNCE_TIME its level is read and compared
+ * with the debounced state, so a bouncing contact gives a single event. A pressed channel with the long press feature
+ * keeps its timer running until the long press fires or the pin is released.
+ *
+ * Channels without a running timer are not visited at all: the main loop only pays for the pins that changed.
+ */
+
+#include "hasp_gpio_input.h"
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#endif
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+GpioInput::GpioInput(GpioInputBackend& backend) : backend(backend), pending(0)
+{
+    for(uint8_t id = 0; id < GPIO_INPUT_MAX_CHANNELS; id++) channels[id].state = CHANNEL_FREE;
+}
+
+void GpioInput::set_callback(gpio_input_cb_t cb, void* arg)
+{
+    this->cb     = cb;
+    this->cb_arg = arg;
+}
+
+int GpioInput::read(channel_t& channel)
+{
+    read_count++;
+    return backend.read(channel.config.pin);
+}
+
+void GpioInput::emit(uint8_t id, gpio_input_event_t event)
+{
+    if(cb) cb(cb_arg, id, event);
+}
+
+/* The pin is not known to be pressed or released until it settled, so adding it does not send an event */
+bool GpioInput::add(uint8_t id, const gpio_input_config_t& config)
+{
+    if(id >= GPIO_INPUT_MAX_CHANNELS) return false;
+    remove(id);
+
+    channel_t& channel = channels[id];
+    uint32_t bit       = 1UL << id;
+    channel.config     = config;
+    channel.settling   = false;
+    channel.level      = read(channel);
+    channel.state      = channel.level == config.pressed_level ? CHANNEL_PRESSED : CHANNEL_RELEASED;
+    channel.edge       = backend.now();
+    channel.pressed_at = channel.edge;
+
+    if(!(config.features & GPIO_INPUT_FEATURE_POLL) && !backend.attach(config.pin, this, id))
+        channel.config.features |= GPIO_INPUT_FEATURE_POLL; // no interrupt on this pin
+
+    if(channel.config.features & GPIO_INPUT_FEATURE_POLL) polled |= bit;
+    return true;
+}
+
+/* The lx106 has no atomic read-modify-write and the libatomic fallback is not in IRAM, so on the ESP8266 the
+ * pending mask is changed with interrupts disabled */
+#if defined(ARDUINO_ARCH_ESP8266)
+void GpioInput::pending_clear(uint32_t bits)
+{
+    uint32_t saved = xt_rsil(15);
+    pending &= ~bits;
+    xt_wsr_ps(saved);
+}
+
+uint32_t GpioInput::pending_take()
+{
+    uint32_t saved = xt_rsil(15);
+    uint32_t bits  = pending;
+    pending        = 0;
+    xt_wsr_ps(saved);
+    return bits;
+}
+
+IRAM_ATTR void GpioInput::edge(uint8_t id, uint32_t time)
+{
+    channels[id].edge = time;
+    uint32_t saved    = xt_rsil(15);
+    pending |= 1UL << id;
+    xt_wsr_ps(saved);
+}
+#else
+void GpioInput::pending_clear(uint32_t bits)
+{
+    pending.fetch_and(~bits);
+}
+
+uint32_t GpioInput::pending_take()
+{
+    return pending.exchange(0);
+}
+
+IRAM_ATTR void GpioInput::edge(uint8_t id, uint32_t time)
+{
+    channels[id].edge = time;
+    pending.fetch_or(1UL << id);
+}
+#endif
+
+void GpioInput::remove(uint8_t id)
+{
+    if(id >= GPIO_INPUT_MAX_CHANNELS || channels[id].state == CHANNEL_FREE) return;
+
+    channel_t& channel = channels[id];
+    uint32_t bit       = 1UL << id;
+    if(!(channel.config.features & GPIO_INPUT_FEATURE_POLL)) backend.detach(channel.config.pin);
+
+    channel.state = CHANNEL_FREE;
+    pending_clear(bit);
+    active &= ~bit;
+    polled &= ~bit;
+}
+
+bool GpioInput::is_pressed(uint8_t id) const
+{
+    return id < GPIO_INPUT_MAX_CHANNELS &&
+           (channels[id].state == CHANNEL_PRESSED || channels[id].state == CHANNEL_LONG_PRESSED);
+}
+
+bool GpioInput::is_pressed_raw(uint8_t id)
+{
+    if(id >= GPIO_INPUT_MAX_CHANNELS || channels[id].state == CHANNEL_FREE) return false;
+    return read(channels[id]) == channels[id].config.pressed_level;
+}
+
+/* Called once the pin stopped bouncing */
+void GpioInput::settle(uint8_t id)
+{
+    channel_t& channel = channels[id];
+    bool pressed       = read(channel) == channel.config.pressed_level;
+    channel.settling   = false;
+
+    if(pressed && channel.state == CHANNEL_RELEASED) {
+        channel.state      = CHANNEL_PRESSED;
+        channel.pressed_at = channel.edge;
+        emit(id, GPIO_INPUT_PRESSED);
+
+    } else if(!pressed && channel.state != CHANNEL_RELEASED) {
+        bool clicked = (channel.config.features & GPIO_INPUT_FEATURE_CLICK) && channel.state == CHANNEL_PRESSED &&
+                       channel.edge - channel.pressed_at < channel.config.click_delay;
+        channel.state = CHANNEL_RELEASED;
+
+        if(clicked) emit(id, GPIO_INPUT_CLICKED);
+        if(!clicked || !(channel.config.features & GPIO_INPUT_FEATURE_SUPPRESS_CLICK)) emit(id, GPIO_INPUT_RELEASED);
+    }
+}
+
+void GpioInput::update(uint8_t id, uint32_t now)
+{
+    channel_t& channel = channels[id];
+
+    if(channel.settling) {
+        // an interrupt may stamp an edge after now was read, a negative age is still bouncing too
+        if((int32_t)(now - channel.edge) < GPIO_INPUT_DEBOUNCE_TIME) return;
+        settle(id);
+    }
+
+    bool long_press = channel.state == CHANNEL_PRESSED && (channel.config.features & GPIO_INPUT_FEATURE_LONG_PRESS);
+    if(long_press && now - channel.pressed_at >= channel.config.long_press_delay) {
+        channel.state = CHANNEL_LONG_PRESSED;
+        long_press    = false;
+        emit(id, GPIO_INPUT_LONG_PRESSED);
+    }
+
+    if(!channel.settling && !long_press) active &= ~(1UL << id);
+}
+
+bool GpioInput::loop()
+{
+    uint32_t edges = pending_take();
+    if(!(edges | active | polled)) return false; // nothing changed, no pin is read
+
+    uint32_t now = backend.now();
+
+    for(uint32_t mask = polled; mask; mask &= mask - 1) {
+        uint8_t id         = __builtin_ctz(mask);
+        channel_t& channel = channels[id];
+        uint8_t level      = read(channel);
+        if(level != channel.level) {
+            channel.level = level;
+            channel.edge  = now;
+            edges |= 1UL << id;
+        }
+    }
+
+    for(uint32_t mask = edges; mask; mask &= mask - 1) {
+        uint8_t id = __builtin_ctz(mask);
+        if(channels[id].state == CHANNEL_FREE) continue;
+        channels[id].settling = true;
+        active |= 1UL << id;
+    }
+
+    for(uint32_t mask = active; mask; mask &= mask - 1) update(__builtin_ctz(mask), now);
+
+    return active != 0;
+}
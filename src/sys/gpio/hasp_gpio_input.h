@@ -0,0 +1,127 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_GPIO_INPUT_H
+#define HASP_GPIO_INPUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(ARDUINO_ARCH_ESP8266)
+#include <atomic>
+#endif
+
+#ifndef GPIO_INPUT_MAX_CHANNELS
+#define GPIO_INPUT_MAX_CHANNELS 16 // at most 32, one bit per channel in the pending mask
+#endif
+
+#ifndef GPIO_INPUT_DEBOUNCE_TIME
+#define GPIO_INPUT_DEBOUNCE_TIME 20 // ms without edges before the level of a pin is trusted
+#endif
+
+enum gpio_input_event_t {
+    GPIO_INPUT_PRESSED = 0,
+    GPIO_INPUT_RELEASED,
+    GPIO_INPUT_CLICKED, // released before the click delay
+    GPIO_INPUT_LONG_PRESSED,
+};
+
+enum gpio_input_feature_t {
+    GPIO_INPUT_FEATURE_CLICK          = 0x01,
+    GPIO_INPUT_FEATURE_LONG_PRESS     = 0x02,
+    GPIO_INPUT_FEATURE_SUPPRESS_CLICK = 0x04, // no released event after a click
+    GPIO_INPUT_FEATURE_POLL           = 0x08, // the pin has no interrupt and is read on every loop
+};
+
+struct gpio_input_config_t
+{
+    uint8_t pin;
+    uint8_t pressed_level; // level of the pin while it is pressed
+    uint8_t features;      // gpio_input_feature_t flags
+    uint16_t click_delay;
+    uint16_t long_press_delay;
+};
+
+typedef void (*gpio_input_cb_t)(void* arg, uint8_t id, gpio_input_event_t event);
+
+class GpioInput;
+
+/* The pins as seen by the input engine, implemented by the hardware or by a simulation */
+class GpioInputBackend {
+  public:
+    virtual ~GpioInputBackend()
+    {}
+
+    virtual uint32_t now()        = 0; // milliseconds
+    virtual int read(uint8_t pin) = 0;
+
+    /* Calls engine->edge(id, time) from the interrupt handler on every level change of pin */
+    virtual bool attach(uint8_t pin, GpioInput* engine, uint8_t id) = 0;
+    virtual void detach(uint8_t pin)                                 = 0;
+};
+
+/* Debounces inputs that report their edges by interrupt, a loop without pending edges or running timers returns
+ * without reading any pin. Pins that can not interrupt are read on every loop instead. */
+class GpioInput {
+  public:
+    explicit GpioInput(GpioInputBackend& backend);
+
+    void set_callback(gpio_input_cb_t cb, void* arg);
+
+    bool add(uint8_t id, const gpio_input_config_t& config);
+    void remove(uint8_t id);
+    bool is_pressed(uint8_t id) const; // debounced state
+    bool is_pressed_raw(uint8_t id);   // current level of the pin
+
+    /* Safe to call from an interrupt handler, which passes the time itself as the backend is not in IRAM */
+    void edge(uint8_t id, uint32_t time);
+
+    /* Processes the edges and timers that are due, returns true while a timer is running */
+    bool loop();
+
+    uint32_t reads() const
+    {
+        return read_count;
+    }
+
+  private:
+    enum channel_state_t : uint8_t {
+        CHANNEL_FREE = 0,
+        CHANNEL_RELEASED,
+        CHANNEL_PRESSED,
+        CHANNEL_LONG_PRESSED,
+    };
+
+    struct channel_t
+    {
+        gpio_input_config_t config;
+        channel_state_t state;
+        bool settling;          // waiting for the pin to stop bouncing
+        uint8_t level;          // last level seen while polling
+        volatile uint32_t edge; // time of the last edge
+        uint32_t pressed_at;
+    };
+
+    GpioInputBackend& backend;
+    gpio_input_cb_t cb = NULL;
+    void* cb_arg       = NULL;
+    channel_t channels[GPIO_INPUT_MAX_CHANNELS];
+#if defined(ARDUINO_ARCH_ESP8266)
+    volatile uint32_t pending; // set from interrupts, changed with interrupts disabled
+#else
+    std::atomic<uint32_t> pending; // set from interrupts
+#endif
+    uint32_t active     = 0; // channels with a running timer
+    uint32_t polled     = 0; // channels without an interrupt
+    uint32_t read_count = 0;
+
+    void pending_clear(uint32_t bits);
+    uint32_t pending_take();
+
+    int read(channel_t& channel);
+    void emit(uint8_t id, gpio_input_event_t event);
+    void settle(uint8_t id);
+    void update(uint8_t id, uint32_t now);
+};
+
+#endif // HASP_GPIO_INPUT_H
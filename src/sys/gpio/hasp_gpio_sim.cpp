@@ -0,0 +1,95 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hasp_gpio_sim.h"
+
+GpioSimBackend::GpioSimBackend()
+{
+    memset(pins, 0, sizeof(pins));
+}
+
+uint32_t GpioSimBackend::now()
+{
+    return time;
+}
+
+int GpioSimBackend::read(uint8_t pin)
+{
+    return pin < GPIO_SIM_MAX_PINS ? pins[pin].level : 0;
+}
+
+bool GpioSimBackend::attach(uint8_t pin, GpioInput* engine, uint8_t id)
+{
+    if(pin >= GPIO_SIM_MAX_PINS) return false;
+    pins[pin].engine = engine;
+    pins[pin].id     = id;
+    return true;
+}
+
+void GpioSimBackend::detach(uint8_t pin)
+{
+    if(pin < GPIO_SIM_MAX_PINS) pins[pin].engine = NULL;
+}
+
+void GpioSimBackend::set_level(uint8_t pin, uint8_t level)
+{
+    if(pin < GPIO_SIM_MAX_PINS) pins[pin].level = level;
+}
+
+/* Edges with the same time are played in the order they were scheduled */
+bool GpioSimBackend::schedule(uint32_t at, uint8_t pin, uint8_t level)
+{
+    if(count >= GPIO_SIM_MAX_EDGES || pin >= GPIO_SIM_MAX_PINS) return false;
+
+    size_t pos = count;
+    while(pos > 0 && edges[pos - 1].time > at) {
+        edges[pos] = edges[pos - 1];
+        pos--;
+    }
+    edges[pos].time  = at;
+    edges[pos].pin   = pin;
+    edges[pos].level = level;
+    count++;
+    return true;
+}
+
+size_t GpioSimBackend::load(const char* script)
+{
+    size_t loaded = 0;
+
+    while(*script) {
+        char* end;
+        unsigned long at = strtoul(script, &end, 10);
+        if(end != script) {
+            unsigned long pin   = strtoul(end, &end, 10);
+            unsigned long level = strtoul(end, &end, 10);
+            if(schedule(at, pin, level != 0)) loaded++;
+        }
+        script = strchr(end, '\n');
+        if(!script) break;
+        script++;
+    }
+    return loaded;
+}
+
+void GpioSimBackend::advance(uint32_t to)
+{
+    size_t played = 0;
+
+    while(played < count && edges[played].time <= to) {
+        const gpio_sim_edge_t& edge = edges[played++];
+        pin_t& pin                  = pins[edge.pin];
+        time                        = edge.time;
+        if(pin.level == edge.level) continue;
+
+        pin.level = edge.level;
+        if(pin.engine) pin.engine->edge(pin.id, time); // what the interrupt handler does
+    }
+
+    count -= played;
+    memmove(edges, edges + played, count * sizeof(edges[0]));
+    time = to;
+}
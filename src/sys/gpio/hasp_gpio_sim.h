@@ -0,0 +1,60 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_GPIO_SIM_H
+#define HASP_GPIO_SIM_H
+
+#include "hasp_gpio_input.h"
+
+#ifndef GPIO_SIM_MAX_PINS
+#define GPIO_SIM_MAX_PINS 64
+#endif
+
+#ifndef GPIO_SIM_MAX_EDGES
+#define GPIO_SIM_MAX_EDGES 8192 // scripted edges waiting to be played
+#endif
+
+struct gpio_sim_edge_t
+{
+    uint32_t time; // ms
+    uint8_t pin;
+    uint8_t level;
+};
+
+/* Pins driven by a script of timestamped edges instead of hardware, for the PC build and host benchmarks.
+ * The clock only moves when advance() is called, so a run does not depend on the speed of the host. */
+class GpioSimBackend : public GpioInputBackend {
+  public:
+    GpioSimBackend();
+
+    uint32_t now() override;
+    int read(uint8_t pin) override;
+    bool attach(uint8_t pin, GpioInput* engine, uint8_t id) override;
+    void detach(uint8_t pin) override;
+
+    void set_level(uint8_t pin, uint8_t level); // without an edge, e.g. the idle level of a pullup
+    bool schedule(uint32_t time, uint8_t pin, uint8_t level);
+    size_t load(const char* script); // lines of "<ms> <pin> <level>", returns the number of edges
+
+    /* Plays the edges that are due up to time, in order, and moves the clock to time */
+    void advance(uint32_t time);
+    size_t waiting() const
+    {
+        return count;
+    }
+
+  private:
+    struct pin_t
+    {
+        uint8_t level;
+        uint8_t id;
+        GpioInput* engine;
+    };
+
+    pin_t pins[GPIO_SIM_MAX_PINS];
+    gpio_sim_edge_t edges[GPIO_SIM_MAX_EDGES]; // sorted by time
+    size_t count  = 0;
+    uint32_t time = 0;
+};
+
+#endif // HASP_GPIO_SIM_H
@@ -135,7 +135,9 @@ IRAM_ATTR void networkLoop(void)
 #endif // HASP_USE_TASMOTA_CLIENT
 
 #if HASP_USE_HTTP > 0
-    httpLoop();
+    httpLoop(); // the handlers that touch lvgl take the gui lock
+#elif HASP_USE_HTTP_ASYNC > 0
+    httpLoop(); // only feeds the log to the websocket clients
 #endif // HTTP
 
 #if HASP_USE_ARDUINOOTA > 0
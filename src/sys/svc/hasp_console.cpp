@@ -113,7 +113,7 @@ static void console_thread(void* arg)
     while(console_running) {
         std::string input;
         std::getline(std::cin, input);
-        dispatch_text_line(input.c_str(), TAG_CONS);
+        dispatch_defer_text_line(input.c_str(), TAG_CONS); // run on the main loop, next to lvgl
     }
 }
 #endif
@@ -145,7 +145,7 @@ void consoleStart()
     }
 #elif HASP_TARGET_PC
     LOG_TRACE(TAG_MSGR, F(D_SERVICE_STARTING));
-    haspDevice.run_thread(console_thread, NULL);
+    haspDevice.run_thread(console_thread, NULL, "console");
 #endif
 }
 
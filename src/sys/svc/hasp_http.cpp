@@ -26,6 +26,8 @@
 
 #include "sys/net/hasp_network.h"
 #include "sys/net/hasp_time.h"
+#include "sys/svc/hasp_http_file.h"
+#include "sys/svc/hasp_http_writer.h"
 
 #if(HASP_USE_CAPTIVE_PORTAL > 0) && (HASP_USE_WIFI > 0)
 #include <DNSServer.h>
@@ -148,40 +150,6 @@ const uint8_t HTTP_VARS_CSS[] PROGMEM = ":root{"
 // String lcdFirmwareUrl = "http://haswitchplate.com/update/HASwitchPlate.tft";
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-String getOption(int value, String label, int current_value = INT_MIN)
-{
-    char buffer[128];
-    snprintf_P(buffer, sizeof(buffer), PSTR("<option value='%d'%s>%s</option>"), value,
-               (value == current_value ? PSTR(" selected") : ""), label.c_str());
-    return buffer;
-}
-
-String getOption(String& value, String& label, String& current_value)
-{
-    char buffer[128];
-    snprintf_P(buffer, sizeof(buffer), PSTR("<option value='%s'%s>%s</option>"), value.c_str(),
-               (value == current_value ? PSTR(" selected") : ""), label.c_str());
-    return buffer;
-}
-
-static void add_form_button(String& str, const char* label, const char* action)
-{
-    str += "<a href='";
-    str += action;
-    str += "'>";
-    str += label;
-    str += "</a>";
-}
-
-static void add_form_button(String& str, const char* label, const __FlashStringHelper* action)
-{
-    str += "<a href='";
-    str += action;
-    str += "'>";
-    str += label;
-    str += "</a>";
-}
-
 static String http_get_content_type(const String& path)
 {
     char buffer[sizeof(mime::mimeTable[0].mimeType)];
@@ -341,6 +309,85 @@ static void webSendHtmlHeader(const char* title, uint32_t httpdatalength, uint8_
 #endif
 }
 
+/* The current request of webServer as seen by hasp_http_file.cpp and HttpWriter */
+class WebServerTransport : public HttpTransport {
+  public:
+    bool request_header(const char* name, char* value, size_t size) override
+    {
+        if(!webServer.hasHeader(name)) return false;
+        strlcpy(value, webServer.header(name).c_str(), size);
+        return true;
+    }
+    void send_header(const char* name, const char* value) override
+    {
+        webServer.sendHeader(name, value);
+    }
+    void begin(int code, const char* content_type, int32_t length) override
+    {
+        chunked = length < 0;
+        webServer.setContentLength(chunked ? CONTENT_LENGTH_UNKNOWN : length);
+        webServer.send(code, content_type, "");
+    }
+    size_t write(const char* data, size_t len) override
+    {
+        webServer.sendContent(data, len);
+        return webServer.client().connected() ? len : 0;
+    }
+    void end() override
+    {
+        if(chunked) webServer.sendContent(""); // terminating chunk
+    }
+
+  private:
+    bool chunked = false;
+};
+
+static size_t http_free_heap()
+{
+    return haspDevice.get_free_heap();
+}
+
+/* Starts a page that is streamed in chunks, its length does not need to be known upfront */
+static void http_page_begin(HttpWriter& page, const char* title, uint8_t gohome = 0)
+{
+    page.begin(200, "text/html");
+    page.print_P(HTTP_DOCTYPE);
+    if(gohome > 0) page.printf_P(HTTP_META_GO_BACK, gohome);
+    page.printf_P(HTTP_STYLESHEET, "static/vars");
+    page.printf_P(HTTP_HEADER, title);
+    page.print_P(HTTP_HEADER_END);
+}
+
+static void http_writer_end(HttpWriter& page)
+{
+    page.end();
+    LOG_VERBOSE(TAG_HTTP, F("Sent %u bytes in %u chunks, heap used %u bytes"), page.total(), page.chunks(),
+                page.heap_used());
+}
+
+static void http_page_end(HttpWriter& page)
+{
+    page.print_P(HTTP_FOOTER);
+    page.print(haspDevice.get_version());
+    page.print_P(HTTP_END);
+    http_writer_end(page);
+}
+
+static void http_add_option(HttpWriter& page, int value, const char* label, int current_value = INT_MIN)
+{
+    page.printf_P(PSTR("<option value='%d'%s>%s</option>"), value, (value == current_value ? PSTR(" selected") : ""),
+                  label);
+}
+
+static void http_add_group_options(HttpWriter& page, int current_value)
+{
+    http_add_option(page, 0, D_GPIO_GROUP_NONE, current_value);
+    for(int i = 1; i < 15; i++) {
+        page.printf_P(PSTR("<option value='%d'%s>" D_GPIO_GROUP " %d</option>"), i,
+                      (i == current_value ? PSTR(" selected") : ""), i);
+    }
+}
+
 static void http_send_content(const char* form[], int count, uint8_t gohome = 0)
 {
     size_t total = 0;
@@ -376,6 +423,7 @@ bool http_save_config()
     bool updated = false;
 
     if(webServer.method() == HTTP_POST && webServer.hasArg("save")) {
+        GuiLock lock("config"); // the hasp and gui settings are applied to lvgl
         String save = webServer.arg("save");
 
         StaticJsonDocument<256> settings;
@@ -477,6 +525,7 @@ static void http_handle_screenshot()
     if(!http_is_authenticated("screenshot")) return;
 
     { // Execute actions
+        GuiLock lock("screenshot"); // changes pages and flushes the screen into the reply
         if(webServer.hasArg("a")) {
             if(webServer.arg("a") == "next") {
                 dispatch_page_next(LV_SCR_LOAD_ANIM_NONE);
@@ -543,15 +592,16 @@ static void http_handle_screenshot()
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-static void add_json(String& data, JsonDocument& doc)
+/* Streams the members of doc into the object being written */
+static void add_json(HttpWriter& page, JsonDocument& doc, bool& first)
 {
-    char buffer[800];
-    size_t len = serializeJson(doc, buffer, sizeof(buffer));
-    if(doc.isNull()) return; // empty document
-
-    buffer[len - 1] = ',';
-    char* start     = buffer + 1;
-    data += String(start);
+    for(JsonPair kv : doc.as<JsonObject>()) {
+        page.print(first ? "\"" : ",\"");
+        page.print(kv.key().c_str());
+        page.print("\":");
+        serializeJson(kv.value(), page);
+        first = false;
+    }
     doc.clear();
 }
 
@@ -579,29 +629,30 @@ static void webHandleApi()
         webServer.send(200, contentType.c_str(), filesystem_list(HASP_FS, path.c_str(), 5).c_str());
 
     } else if(!strcasecmp(endpoint.c_str(), "info")) {
-        String jsondata((char*)0);
-        jsondata.reserve(HTTP_PAGE_SIZE);
-        jsondata = "{";
+        WebServerTransport transport;
+        HttpWriter page(transport, http_free_heap);
+        bool first = true;
+        page.begin(200, contentType.c_str());
+        page.print("{");
 
         hasp_get_info(doc);
-        add_json(jsondata, doc);
+        add_json(page, doc, first);
 
 #if HASP_USE_MQTT > 0
         mqtt_get_info(doc);
-        add_json(jsondata, doc);
+        add_json(page, doc, first);
 #endif
 
 #if HASP_USE_WIFI > 0 || HASP_USE_EHTERNET > 0
         network_get_info(doc);
-        add_json(jsondata, doc);
+        add_json(page, doc, first);
 #endif
 
         haspDevice.get_info(doc);
-        add_json(jsondata, doc);
+        add_json(page, doc, first);
 
-        jsondata[jsondata.length() - 1] = '}'; // Replace last comma with a bracket
-
-        webServer.send(200, contentType, jsondata);
+        page.print("}");
+        http_writer_end(page);
         return;
 
     } else if(!strcasecmp(endpoint.c_str(), "credits")) {
@@ -639,8 +690,6 @@ static void webHandleApi()
             obj = doc.createNestedObject();
             add_license(obj, "SimpleFTPServer", "2017", "Renzo Mischianti www.mischianti.org", "mit", 1);
 #endif
-            obj = doc.createNestedObject();
-            add_license(obj, "AceButton", "2018", "Brian T. Park", "mit");
             obj = doc.createNestedObject();
             add_license(obj, "QR Code generator", "", "Project Nayuki", "mit");
 #if HASP_USE_WIREGUARD > 0
@@ -654,6 +703,19 @@ static void webHandleApi()
             webServer.send(200, contentType.c_str(), output);
         }
 
+#if HASP_USE_LOG_RING
+    } else if(!strcasecmp(endpoint.c_str(), "log")) {
+        // http://plate01/api/log/?seq=123&level=5 The reply says at which seq to continue
+        uint32_t cursor = strtoul(webServer.arg("seq").c_str(), NULL, 10);
+        int level       = webServer.hasArg("level") ? webServer.arg("level").toInt() : LOG_LEVEL_OUTPUT;
+        debug_get_log(doc, cursor, level, 50);
+
+        const size_t size = measureJson(doc) + 1;
+        char jsondata[size];
+        serializeJson(doc, jsondata, size);
+        webServer.send(200, contentType, jsondata);
+
+#endif
     } else if(!strcasecmp(endpoint.c_str(), "config")) {
 
         JsonObject settings;
@@ -791,6 +853,7 @@ static void webHandleApiConfig()
     }
 
     if(webServer.method() == HTTP_POST || webServer.method() == HTTP_PUT) {
+        GuiLock lock("config");           // the hasp and gui settings are applied to lvgl
         configOutput(settings, TAG_HTTP); // Log input JSON config
 
         if(!strcasecmp(endpoint_key, FP_HASP)) {
@@ -1037,17 +1100,15 @@ static void webUpdateReboot()
     LOG_INFO(TAG_HTTP, F("Update Success: %u bytes received. Rebooting..."), upload->totalSize);
 
     { // Send Content
-        String httpMessage((char*)0);
-        httpMessage.reserve(256);
-        httpMessage += "<h1>";
-        httpMessage += haspDevice.get_hostname();
-        httpMessage += "</h1><hr>";
-        httpMessage += F("<b>Upload complete. Rebooting device, please wait...</b>");
-
-        webSendHtmlHeader(haspDevice.get_hostname(), httpMessage.length(), 10);
-        webServer.sendContent(httpMessage);
+        WebServerTransport transport;
+        HttpWriter page(transport, http_free_heap);
+        http_page_begin(page, haspDevice.get_hostname(), 10);
+        page.print("<h1>");
+        page.print(haspDevice.get_hostname());
+        page.print("</h1><hr>");
+        page.print_P(PSTR("<b>Upload complete. Rebooting device, please wait...</b>"));
+        http_page_end(page);
     }
-    webSendFooter();
     dispatch_reboot(true); // Save the current config
 }
 
@@ -1109,6 +1170,94 @@ static void webHandleFirmwareUpload()
 }
 #endif
 
+#if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
+#if defined(ARDUINO_ARCH_ESP32)
+#if HASP_USE_SPIFFS > 0
+#define HTTP_FS_MOUNTPOINT "/spiffs"
+#else
+#define HTTP_FS_MOUNTPOINT "/littlefs"
+#endif
+#include <sys/stat.h>
+#endif
+
+/* The filesystem as seen by the file server in hasp_http_file.cpp */
+class HaspFsStore : public HttpFileStore {
+  public:
+    bool stat(const char* path, http_file_stat_t& st) override
+    {
+#if defined(ARDUINO_ARCH_ESP32)
+        // Through the VFS, so a validated request is answered without opening the file
+        char fullpath[64];
+        struct stat info;
+        snprintf_P(fullpath, sizeof(fullpath), PSTR(HTTP_FS_MOUNTPOINT "%s"), path);
+        if(::stat(fullpath, &info) < 0) return false;
+        st.is_dir   = S_ISDIR(info.st_mode);
+        st.size     = info.st_size;
+        st.modified = info.st_mtime > 0 ? info.st_mtime : 0;
+        return true;
+#else
+        File entry = HASP_FS.open(path, "r");
+        if(!entry) return false;
+        st.is_dir   = entry.isDirectory();
+        st.size     = entry.size();
+        st.modified = entry.getLastWrite() > 0 ? entry.getLastWrite() : 0;
+        entry.close();
+        return true;
+#endif
+    }
+    bool open(const char* path) override
+    {
+        file = HASP_FS.open(path, "r");
+        return (bool)file;
+    }
+    bool seek(uint32_t pos) override
+    {
+        return file.seek(pos);
+    }
+    size_t read(uint8_t* buffer, size_t len) override
+    {
+        return file.read(buffer, len);
+    }
+    void close() override
+    {
+        file.close();
+    }
+    bool list(const char* dir, http_file_list_cb_t cb, void* arg) override
+    {
+        http_file_stat_t st;
+#if defined(ARDUINO_ARCH_ESP32)
+        File root = HASP_FS.open(dir, FILE_READ);
+        if(!root || !root.isDirectory()) return false;
+
+        File entry = root.openNextFile();
+        while(entry) {
+            st.is_dir   = entry.isDirectory();
+            st.size     = entry.size();
+            st.modified = entry.getLastWrite() > 0 ? entry.getLastWrite() : 0;
+            cb(arg, entry.name(), st);
+            entry = root.openNextFile();
+        }
+        return true;
+#elif defined(ARDUINO_ARCH_ESP8266)
+        Dir root = HASP_FS.openDir(dir);
+        while(root.next()) {
+            st.is_dir   = root.isDirectory();
+            st.size     = root.fileSize();
+            st.modified = root.fileTime() > 0 ? root.fileTime() : 0;
+            cb(arg, root.fileName().c_str(), st);
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+  private:
+    File file;
+};
+
+#endif // HASP_USE_SPIFFS || HASP_USE_LITTLEFS
+
 static inline int handleFilesystemFile(String path)
 {
     if(!http_is_authenticated()) return false;
@@ -1127,8 +1276,11 @@ static inline int handleFilesystemFile(String path)
 
         if(webServer.hasArg("download")) contentType = F("application/octet-stream");
 
-        if(!HASP_FS.exists(path) && HASP_FS.exists(pathWithGz))
+        bool gzip = false; // only a .gz that stands in for the requested file is sent with Content-Encoding
+        if(!HASP_FS.exists(path) && HASP_FS.exists(pathWithGz)) {
             path = pathWithGz; // Only use .gz if normal file doesn't exist
+            gzip = !webServer.hasArg("download"); // a download keeps the .gz as is
+        }
         // if(!HASP_FS.exists(path) && HASP_FS.exists(pathWithBr))
         //     path = pathWithBr; // Only use .gz if normal file doesn't exist
 
@@ -1150,39 +1302,9 @@ static inline int handleFilesystemFile(String path)
             webServer.send(200, contentType, buffer);
 
         } else {
-            File file       = HASP_FS.open(path, "r");
-            time_t modified = file.getLastWrite();
-            String etag((char*)0);
-            etag.reserve(64);
-
-            if(webServer.hasHeader("If-None-Match")) {
-                etag = webServer.header("If-None-Match");
-                etag.replace("\"", "");
-                LOG_DEBUG(TAG_HTTP, F("If-None-Match: %s"), etag.c_str());
-                if(modified > 0 && modified == atol(etag.c_str())) { // Not Changed
-                    file.close();                                    // Skip reading the file contents
-                    http_send_etag(etag);                            // Reuse same ETag
-                    webServer.send(304, contentType, "");            // Use correct mimetype
-                    return 304;                                      // Not Modified
-                }
-            }
-
-            etag = (String)(modified);
-            http_send_etag(etag); // Send new tag with modification datetime
-
-            /* Only needed for brotli encoding. Gzip is handled automatically in streamfile() */
-            /* Brotli is not supported over HTTP/1.1 */
-            // if(path.endsWith(".br") && contentType != String(FPSTR(mime::mimeTable[mime::type::none].mimeType))) {
-            //     webServer.sendHeader("Content-Encoding", "br");
-            //     webServer.streamFile(file, contentType);
-            //     LOG_DEBUG(TAG_HTTP, F("Headers: OK"));
-
-            // } else {
-            // Stream other files directly from filesystem
-            webServer.streamFile(file, contentType);
-            LOG_DEBUG(TAG_HTTP, F("If-None-Match: %s"), etag.c_str());
-            //}
-            file.close();
+            HaspFsStore store;
+            WebServerTransport transport;
+            return http_file_send(transport, store, path.c_str(), contentType.c_str(), gzip);
         }
 
         return 200; // OK
@@ -1212,6 +1334,9 @@ static void handleFileUpload()
                 filename = "/";
                 filename += upload->filename;
             }
+#if HASP_USE_LAZY_PAGES > 0
+            haspPages.drop_index(filename.c_str()); // the page offsets will be invalid
+#endif
             fsUploadFile = HASP_FS.open(filename, "w");
             if(fsUploadFile) {
                 if(!fsUploadFile || fsUploadFile.isDirectory()) {
@@ -1294,6 +1419,9 @@ static void handleFileDelete()
         path.remove(path.length() - 1);
         result = HASP_FS.rmdir(path);
     } else {
+#if HASP_USE_LAZY_PAGES > 0
+        haspPages.drop_index(path.c_str());
+#endif
         result = HASP_FS.remove(path);
     }
     if(result) {
@@ -1327,6 +1455,7 @@ static void handleFileCreate()
             return webServer.send(500, PSTR("text/plain"), PSTR("CREATE FAILED"));
         }
     }
+    GuiLock lock("edit"); // the page commands below change lvgl objects
     if(webServer.hasArg("init")) {
         dispatch_wakeup(TAG_HTTP);
         hasp_init();
@@ -1355,61 +1484,12 @@ static void handleFileList()
 
     String path = webServer.arg("dir");
     // LOG_TRACE(TAG_HTTP, F("handleFileList: %s"), path.c_str());
-    // path.clear();
 
-#if defined(ARDUINO_ARCH_ESP32)
-    File root = HASP_FS.open(path.c_str(), FILE_READ);
-    File file = root.openNextFile();
-    String output((char*)0);
-    output.reserve(HTTP_PAGE_SIZE);
-    output = "[";
-
-    while(file) {
-        if(output != "[") {
-            output += ',';
-        }
-        bool isDir = file.isDirectory();
-        output += F("{\"type\":\"");
-        output += (isDir) ? "dir" : "file";
-        output += F("\",\"name\":\"");
-        if(file.name()[0] == '/') {
-            output += &(file.name()[1]);
-        } else {
-            output += file.name();
-        }
-        output += F("\"}");
-
-        // file.close();
-        file = root.openNextFile();
+    HaspFsStore store;
+    WebServerTransport transport;
+    if(http_file_list(transport, store, path.c_str()) == 404) {
+        webServer.send(404, PSTR("text/plain"), PSTR("BAD PATH"));
     }
-    output += "]";
-    webServer.send(200, PSTR("text/json"), output);
-#elif defined(ARDUINO_ARCH_ESP8266)
-    Dir dir = HASP_FS.openDir(path);
-    String output((char*)0);
-    output.reserve(HTTP_PAGE_SIZE);
-    output = "[";
-
-    while(dir.next()) {
-        File entry = dir.openFile("r");
-        if(output != "[") {
-            output += ',';
-        }
-        bool isDir = false;
-        output += F("{\"type\":\"");
-        output += (isDir) ? "dir" : "file";
-        output += F("\",\"name\":\"");
-        if(entry.name()[0] == '/') {
-            output += &(entry.name()[1]);
-        } else {
-            output += entry.name();
-        }
-        output += F("\"}");
-        entry.close();
-    }
-    output += "]";
-    webServer.send(200, PSTR("text/json"), output);
-#endif
 }
 #endif
 
@@ -1577,21 +1657,24 @@ static void http_handle_gui()
 <div class="col-25"><label for="group">Backlight Pin</label></div>
 <div class="col-75"><select id="bckl" v-model="config.gui.bckl">)";
 
-    String httpGpio((char*)0);
-    httpGpio.reserve(256);
-    httpGpio += getOption(-1, "None");
+    WebServerTransport transport;
+    HttpWriter page(transport, http_free_heap);
+    http_page_begin(page, haspDevice.get_hostname());
+    for(int j = 0; j < min(i, len); j++) page.print(html[j]);
+    i = 0;
+
+    http_add_option(page, -1, "None");
 #if defined(ARDUINO_ARCH_ESP32)
     char buffer[10];
     for(uint8_t gpio = 0; gpio < NUM_DIGITAL_PINS; gpio++) {
         if(!gpioIsSystemPin(gpio)) {
             snprintf_P(buffer, sizeof(buffer), PSTR("GPIO %d"), gpio);
-            httpGpio += getOption(gpio, buffer);
+            http_add_option(page, gpio, buffer);
         } else {
             LOG_WARNING(TAG_HTTP, F("pin %d"), gpio);
         }
     }
 #endif
-    html[min(i++, len)] = httpGpio.c_str();
     html[min(i++, len)] = R"(
 </select></div>
 </div>
@@ -1606,9 +1689,11 @@ static void http_handle_gui()
 #endif
     html[min(i++, len)] = R"(<a v-t="'gui.antiburn'" href="/config/gui?brn=1"></a>)";
     html[min(i++, len)] = R"(<a v-t="'config.btn'" href="/config"></a>)";
-    http_send_content(html, min(i, len));
+    for(int j = 0; j < min(i, len); j++) page.print(html[j]);
+    http_page_end(page);
 
     { // Execute Actions
+        GuiLock lock("gui");
         if(webServer.hasArg("cal")) dispatch_calibrate(NULL, NULL, TAG_HTTP);
         if(webServer.hasArg("brn")) dispatch_antiburn(NULL, "on", TAG_HTTP);
     }
@@ -1754,6 +1839,78 @@ static void http_handle_time()
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 #if HASP_USE_GPIO > 0
+static const char* http_gpio_type_name(uint8_t type)
+{
+    switch(type) {
+        case hasp_gpio_type_t::BUTTON_TYPE:
+            return D_GPIO_BUTTON;
+        case hasp_gpio_type_t::SWITCH:
+            return D_GPIO_SWITCH;
+        case hasp_gpio_type_t::DOOR:
+            return "door";
+        case hasp_gpio_type_t::GARAGE_DOOR:
+            return "garage_door";
+        case hasp_gpio_type_t::GAS:
+            return "gas";
+        case hasp_gpio_type_t::LIGHT:
+            return "light";
+        case hasp_gpio_type_t::LOCK:
+            return "lock";
+        case hasp_gpio_type_t::MOISTURE:
+            return "moisture";
+        case hasp_gpio_type_t::MOTION:
+            return "motion";
+        case hasp_gpio_type_t::OCCUPANCY:
+            return "occupancy";
+        case hasp_gpio_type_t::OPENING:
+            return "opening";
+        case hasp_gpio_type_t::PRESENCE:
+            return "presence";
+        case hasp_gpio_type_t::PROBLEM:
+            return "problem";
+        case hasp_gpio_type_t::SAFETY:
+            return "Safety";
+        case hasp_gpio_type_t::SMOKE:
+            return "Smoke";
+        case hasp_gpio_type_t::VIBRATION:
+            return "Vibration";
+        case hasp_gpio_type_t::WINDOW:
+            return "Window";
+
+        case hasp_gpio_type_t::TOUCH:
+            return D_GPIO_TOUCH;
+        case hasp_gpio_type_t::LED:
+            return D_GPIO_LED;
+        case hasp_gpio_type_t::LED_R:
+            return D_GPIO_LED_R;
+        case hasp_gpio_type_t::LED_G:
+            return D_GPIO_LED_G;
+        case hasp_gpio_type_t::LED_B:
+            return D_GPIO_LED_B;
+        case hasp_gpio_type_t::LIGHT_RELAY:
+            return D_GPIO_LIGHT_RELAY;
+        case hasp_gpio_type_t::POWER_RELAY:
+            return D_GPIO_POWER_RELAY;
+        case hasp_gpio_type_t::SHUTTER_RELAY:
+            return "SHUTTER_RELAY";
+        case hasp_gpio_type_t::PWM:
+            return D_GPIO_PWM;
+        case hasp_gpio_type_t::HASP_DAC:
+            return D_GPIO_DAC;
+
+#if defined(LANBONL8)
+            // case hasp_gpio_type_t::SERIAL_DIMMER:
+            //     return D_GPIO_SERIAL_DIMMER;
+        case hasp_gpio_type_t::SERIAL_DIMMER_L8_HD_INVERTED:
+            return "L8-HD (inv.)";
+        case hasp_gpio_type_t::SERIAL_DIMMER_L8_HD:
+            return "L8-HD";
+#endif
+        default:
+            return D_GPIO_UNKNOWN;
+    }
+}
+
 static void webHandleGpioConfig()
 { // http://plate01/config/gpio
     if(!http_is_authenticated(F("config/gpio"))) return;
@@ -1777,166 +1934,47 @@ static void webHandleGpioConfig()
     }
 
     { // Send Content
-        String httpMessage((char*)0);
-        httpMessage.reserve(HTTP_PAGE_SIZE);
-        httpMessage += "<h1>";
-        httpMessage += haspDevice.get_hostname();
-        httpMessage += "</h1><hr>";
-        httpMessage += F("<h2>" D_HTTP_GPIO_SETTINGS "</h2>");
+        WebServerTransport transport;
+        HttpWriter page(transport, http_free_heap);
+        http_page_begin(page, haspDevice.get_hostname());
+        page.print("<h1>");
+        page.print(haspDevice.get_hostname());
+        page.print("</h1><hr>");
+        page.print_P(PSTR("<h2>" D_HTTP_GPIO_SETTINGS "</h2>"));
 
-        httpMessage += F("<form method='POST' action='/config'>");
+        page.print_P(PSTR("<form method='POST' action='/config'>"));
 
-        httpMessage += F("<table><tr><th>" D_GPIO_PIN "</th><th>Type</th><th>" D_GPIO_GROUP
-                         "</th><th>Default</th><th>Action</th></tr>");
+        page.print_P(PSTR("<table><tr><th>" D_GPIO_PIN "</th><th>Type</th><th>" D_GPIO_GROUP
+                          "</th><th>Default</th><th>Action</th></tr>"));
 
         for(uint8_t gpio = 0; gpio < NUM_DIGITAL_PINS; gpio++) {
             for(uint8_t id = 0; id < HASP_NUM_GPIO_CONFIG; id++) {
                 hasp_gpio_config_t conf = gpioGetPinConfig(id);
                 if((conf.pin == gpio) && gpioConfigInUse(id) && !gpioIsSystemPin(gpio)) {
-                    httpMessage += F("<tr><td>");
-                    // httpMessage += halGpioName(gpio);
-                    httpMessage += haspDevice.gpio_name(gpio).c_str();
-                    if(conf.type >= 0x80) {
-                        httpMessage += F("</td><td><a href='/config/gpio/input?id=");
-                    } else {
-                        httpMessage += F("</td><td><a href='/config/gpio/options?id=");
-                    }
-                    httpMessage += id;
-                    httpMessage += F("'>");
-
-                    switch(conf.type) {
-
-                        case hasp_gpio_type_t::BUTTON_TYPE:
-                            httpMessage += D_GPIO_BUTTON;
-                            break;
-                        case hasp_gpio_type_t::SWITCH:
-                            httpMessage += D_GPIO_SWITCH;
-                            break;
-                        case hasp_gpio_type_t::DOOR:
-                            httpMessage += "door";
-                            break;
-                        case hasp_gpio_type_t::GARAGE_DOOR:
-                            httpMessage += "garage_door";
-                            break;
-                        case hasp_gpio_type_t::GAS:
-                            httpMessage += "gas";
-                            break;
-                        case hasp_gpio_type_t::LIGHT:
-                            httpMessage += "light";
-                            break;
-                        case hasp_gpio_type_t::LOCK:
-                            httpMessage += "lock";
-                            break;
-                        case hasp_gpio_type_t::MOISTURE:
-                            httpMessage += "moisture";
-                            break;
-                        case hasp_gpio_type_t::MOTION:
-                            httpMessage += "motion";
-                            break;
-                        case hasp_gpio_type_t::OCCUPANCY:
-                            httpMessage += "occupancy";
-                            break;
-                        case hasp_gpio_type_t::OPENING:
-                            httpMessage += "opening";
-                            break;
-                        case hasp_gpio_type_t::PRESENCE:
-                            httpMessage += "presence";
-                            break;
-                        case hasp_gpio_type_t::PROBLEM:
-                            httpMessage += "problem";
-                            break;
-                        case hasp_gpio_type_t::SAFETY:
-                            httpMessage += "Safety";
-                            break;
-                        case hasp_gpio_type_t::SMOKE:
-                            httpMessage += "Smoke";
-                            break;
-                        case hasp_gpio_type_t::VIBRATION:
-                            httpMessage += "Vibration";
-                            break;
-                        case hasp_gpio_type_t::WINDOW:
-                            httpMessage += "Window";
-                            break;
-
-                        case hasp_gpio_type_t::TOUCH:
-                            httpMessage += D_GPIO_TOUCH;
-                            break;
-                        case hasp_gpio_type_t::LED:
-                            httpMessage += D_GPIO_LED;
-                            break;
-                        case hasp_gpio_type_t::LED_R:
-                            httpMessage += D_GPIO_LED_R;
-                            break;
-                        case hasp_gpio_type_t::LED_G:
-                            httpMessage += D_GPIO_LED_G;
-                            break;
-                        case hasp_gpio_type_t::LED_B:
-                            httpMessage += D_GPIO_LED_B;
-                            break;
-                        case hasp_gpio_type_t::LIGHT_RELAY:
-                            httpMessage += D_GPIO_LIGHT_RELAY;
-                            break;
-                        case hasp_gpio_type_t::POWER_RELAY:
-                            httpMessage += D_GPIO_POWER_RELAY;
-                            break;
-                        case hasp_gpio_type_t::SHUTTER_RELAY:
-                            httpMessage += "SHUTTER_RELAY";
-                            break;
-                        case hasp_gpio_type_t::PWM:
-                            httpMessage += D_GPIO_PWM;
-                            break;
-                        case hasp_gpio_type_t::HASP_DAC:
-                            httpMessage += D_GPIO_DAC;
-                            break;
-
-#if defined(LANBONL8)
-                            // case hasp_gpio_type_t::SERIAL_DIMMER:
-                            //     httpMessage += D_GPIO_SERIAL_DIMMER;
-                            //     break;
-                        case hasp_gpio_type_t::SERIAL_DIMMER_L8_HD_INVERTED:
-                            httpMessage += F("L8-HD (inv.)");
-                            break;
-                        case hasp_gpio_type_t::SERIAL_DIMMER_L8_HD:
-                            httpMessage += F("L8-HD");
-                            break;
-#endif
-                        default:
-                            httpMessage += D_GPIO_UNKNOWN;
-                    }
-
-                    httpMessage += F("</a></td><td>");
-                    httpMessage += conf.group;
-                    httpMessage += F("</td><td>");
-                    httpMessage += (conf.inverted) ? D_GPIO_STATE_INVERTED : D_GPIO_STATE_NORMAL;
-
-                    httpMessage += ("</td><td><a href='/config/gpio?del=&id=");
-                    httpMessage += id;
-                    httpMessage += ("&pin=");
-                    httpMessage += conf.pin;
-                    httpMessage += ("' class='icon trash'></a></td><tr>");
+                    page.print("<tr><td>");
+                    page.print(haspDevice.gpio_name(gpio).c_str());
+                    page.printf_P(PSTR("</td><td><a href='/config/gpio/%s?id=%u'>%s</a></td><td>%u</td><td>%s"),
+                                  conf.type >= 0x80 ? "input" : "options", id, http_gpio_type_name(conf.type),
+                                  conf.group, (conf.inverted) ? D_GPIO_STATE_INVERTED : D_GPIO_STATE_NORMAL);
+                    page.printf_P(PSTR("</td><td><a href='/config/gpio?del=&id=%u&pin=%u' class='icon trash'></a>"
+                                       "</td><tr>"),
+                                  id, conf.pin);
                     configCount++;
                 }
             }
         }
 
-        httpMessage += F("</table></form>");
+        page.print_P(PSTR("</table></form>"));
 
         if(configCount < HASP_NUM_GPIO_CONFIG) {
-            httpMessage += F("<a href='gpio/input?id=");
-            httpMessage += gpioGetFreeConfigId();
-            httpMessage += F("'>" D_HTTP_ADD_GPIO " Input</a>");
-
-            httpMessage += F("<a href='gpio/options?id=");
-            httpMessage += gpioGetFreeConfigId();
-            httpMessage += F("'>" D_HTTP_ADD_GPIO " Output</a>");
+            page.printf_P(PSTR("<a href='gpio/input?id=%d'>" D_HTTP_ADD_GPIO " Input</a>"), gpioGetFreeConfigId());
+            page.printf_P(PSTR("<a href='gpio/options?id=%d'>" D_HTTP_ADD_GPIO " Output</a>"),
+                          gpioGetFreeConfigId());
         }
 
-        add_form_button(httpMessage, D_BACK_ICON D_HTTP_CONFIGURATION, F("/config"));
-
-        webSendHtmlHeader(haspDevice.get_hostname(), httpMessage.length(), 0);
-        webServer.sendContent(httpMessage);
+        page.print_P(PSTR("<a href='/config'>" D_BACK_ICON D_HTTP_CONFIGURATION "</a>"));
+        http_page_end(page);
     }
-    webSendFooter();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1947,74 +1985,63 @@ static void webHandleGpioOutput()
     { // Send Content
         uint8_t config_id = webServer.arg("id").toInt();
 
-        String httpMessage((char*)0);
-        httpMessage.reserve(HTTP_PAGE_SIZE);
-        httpMessage += "<h1>";
-        httpMessage += haspDevice.get_hostname();
-        httpMessage += "</h1><hr>";
+        WebServerTransport transport;
+        HttpWriter page(transport, http_free_heap);
+        http_page_begin(page, haspDevice.get_hostname());
+        page.print("<h1>");
+        page.print(haspDevice.get_hostname());
+        page.print("</h1><hr>");
 
-        httpMessage += F("<form method='GET' action='/config/gpio'>");
-        httpMessage += F("<input type='hidden' name='id' value='");
-        httpMessage += config_id;
-        httpMessage += F("'>");
+        page.printf_P(PSTR("<form method='GET' action='/config/gpio'><input type='hidden' name='id' value='%u'>"),
+                      config_id);
 
-        httpMessage += F("<p><b>GPIO Output</b></p>");
+        page.print_P(PSTR("<p><b>GPIO Output</b></p>"));
 
-        httpMessage += F("<p><b>" D_GPIO_PIN "</b> <select id='pin' name='pin'>");
+        page.print_P(PSTR("<p><b>" D_GPIO_PIN "</b> <select id='pin' name='pin'>"));
         hasp_gpio_config_t conf = gpioGetPinConfig(config_id);
 
         for(uint8_t io = 0; io < NUM_DIGITAL_PINS; io++) {
             if(((conf.pin == io) || !gpioInUse(io)) && !gpioIsSystemPin(io)) {
-                httpMessage += getOption(io, haspDevice.gpio_name(io).c_str(), conf.pin);
+                http_add_option(page, io, haspDevice.gpio_name(io).c_str(), conf.pin);
             }
         }
-        httpMessage += F("</select></p>");
-
-        httpMessage += F("<p><b>Type</b> <select id='type' name='type'>");
-        httpMessage += getOption(hasp_gpio_type_t::LED, D_GPIO_LED, conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::LED_R, D_GPIO_LED_R, conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::LED_G, D_GPIO_LED_G, conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::LED_B, D_GPIO_LED_B, conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::LIGHT_RELAY, D_GPIO_LIGHT_RELAY, conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::POWER_RELAY, D_GPIO_POWER_RELAY, conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::SHUTTER_RELAY, "Shutter Relay", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::HASP_DAC, D_GPIO_DAC, conf.type);
-        // httpMessage += getOption(hasp_gpio_type_t::SERIAL_DIMMER, D_GPIO_SERIAL_DIMMER, conf.type);
+        page.print_P(PSTR("</select></p>"));
+
+        page.print_P(PSTR("<p><b>Type</b> <select id='type' name='type'>"));
+        http_add_option(page, hasp_gpio_type_t::LED, D_GPIO_LED, conf.type);
+        http_add_option(page, hasp_gpio_type_t::LED_R, D_GPIO_LED_R, conf.type);
+        http_add_option(page, hasp_gpio_type_t::LED_G, D_GPIO_LED_G, conf.type);
+        http_add_option(page, hasp_gpio_type_t::LED_B, D_GPIO_LED_B, conf.type);
+        http_add_option(page, hasp_gpio_type_t::LIGHT_RELAY, D_GPIO_LIGHT_RELAY, conf.type);
+        http_add_option(page, hasp_gpio_type_t::POWER_RELAY, D_GPIO_POWER_RELAY, conf.type);
+        http_add_option(page, hasp_gpio_type_t::SHUTTER_RELAY, "Shutter Relay", conf.type);
+        http_add_option(page, hasp_gpio_type_t::HASP_DAC, D_GPIO_DAC, conf.type);
+        // http_add_option(page, hasp_gpio_type_t::SERIAL_DIMMER, D_GPIO_SERIAL_DIMMER, conf.type);
 #if defined(LANBONL8)
-        httpMessage += getOption(hasp_gpio_type_t::SERIAL_DIMMER_L8_HD, F("L8-HD"), conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::SERIAL_DIMMER_L8_HD_INVERTED, F("L8-HD (inv.)"), conf.type);
+        http_add_option(page, hasp_gpio_type_t::SERIAL_DIMMER_L8_HD, "L8-HD", conf.type);
+        http_add_option(page, hasp_gpio_type_t::SERIAL_DIMMER_L8_HD_INVERTED, "L8-HD (inv.)", conf.type);
 #endif
         if(digitalPinHasPWM(webServer.arg(0).toInt())) {
-            httpMessage += getOption(hasp_gpio_type_t::PWM, D_GPIO_PWM, conf.type);
+            http_add_option(page, hasp_gpio_type_t::PWM, D_GPIO_PWM, conf.type);
         }
-        httpMessage += F("</select></p>");
-
-        httpMessage += F("<p><b>" D_GPIO_GROUP "</b> <select id='group' name='group'>");
-        httpMessage += getOption(0, D_GPIO_GROUP_NONE, conf.group);
-        String group((char*)0);
-        group.reserve(10);
-        for(int i = 1; i < 15; i++) {
-            group = D_GPIO_GROUP " ";
-            group += i;
-            httpMessage += getOption(i, group, conf.group);
-        }
-        httpMessage += F("</select></p>");
+        page.print_P(PSTR("</select></p>"));
 
-        httpMessage += F("<p><b>Value</b> <select id='state' name='state'>");
-        httpMessage += getOption(0, D_GPIO_STATE_NORMAL, conf.inverted);
-        httpMessage += getOption(1, D_GPIO_STATE_INVERTED, conf.inverted);
-        httpMessage += F("</select></p>");
+        page.print_P(PSTR("<p><b>" D_GPIO_GROUP "</b> <select id='group' name='group'>"));
+        http_add_group_options(page, conf.group);
+        page.print_P(PSTR("</select></p>"));
 
-        httpMessage +=
-            F("<p><button type='submit' name='save' value='gpio'>" D_HTTP_SAVE_SETTINGS "</button></p></form>");
+        page.print_P(PSTR("<p><b>Value</b> <select id='state' name='state'>"));
+        http_add_option(page, 0, D_GPIO_STATE_NORMAL, conf.inverted);
+        http_add_option(page, 1, D_GPIO_STATE_INVERTED, conf.inverted);
+        page.print_P(PSTR("</select></p>"));
 
-        httpMessage += PSTR("<p><form method='GET' action='/config/gpio'><button type='submit'>&#8617; " D_HTTP_BACK
-                            "</button></form></p>");
+        page.print_P(
+            PSTR("<p><button type='submit' name='save' value='gpio'>" D_HTTP_SAVE_SETTINGS "</button></p></form>"));
 
-        webSendHtmlHeader(haspDevice.get_hostname(), httpMessage.length(), 0);
-        webServer.sendContent(httpMessage);
+        page.print_P(PSTR("<p><form method='GET' action='/config/gpio'><button type='submit'>&#8617; " D_HTTP_BACK
+                          "</button></form></p>"));
+        http_page_end(page);
     }
-    webSendFooter();
 
     // if(webServer.hasArg("action")) dispatch_text_line(webServer.arg("action").c_str()); // Security check
 }
@@ -2027,82 +2054,71 @@ static void webHandleGpioInput()
     { // Send Content
         uint8_t config_id = webServer.arg("id").toInt();
 
-        String httpMessage((char*)0);
-        httpMessage.reserve(HTTP_PAGE_SIZE);
-        httpMessage += "<h1>";
-        httpMessage += haspDevice.get_hostname();
-        httpMessage += "</h1><hr>";
+        WebServerTransport transport;
+        HttpWriter page(transport, http_free_heap);
+        http_page_begin(page, haspDevice.get_hostname());
+        page.print("<h1>");
+        page.print(haspDevice.get_hostname());
+        page.print("</h1><hr>");
 
-        httpMessage += F("<form method='GET' action='/config/gpio'>");
-        httpMessage += F("<input type='hidden' name='id' value='");
-        httpMessage += config_id;
-        httpMessage += F("'>");
+        page.printf_P(PSTR("<form method='GET' action='/config/gpio'><input type='hidden' name='id' value='%u'>"),
+                      config_id);
 
-        httpMessage += F("<p><b>GPIO Input</b></p>");
+        page.print_P(PSTR("<p><b>GPIO Input</b></p>"));
 
-        httpMessage += F("<p><b>" D_GPIO_PIN "</b> <select id='pin' name='pin'>");
+        page.print_P(PSTR("<p><b>" D_GPIO_PIN "</b> <select id='pin' name='pin'>"));
         hasp_gpio_config_t conf = gpioGetPinConfig(config_id);
 
         for(uint8_t io = 0; io < NUM_DIGITAL_PINS; io++) {
             if(((conf.pin == io) || !gpioInUse(io)) && !gpioIsSystemPin(io)) {
-                httpMessage += getOption(io, haspDevice.gpio_name(io).c_str(), conf.pin);
+                http_add_option(page, io, haspDevice.gpio_name(io).c_str(), conf.pin);
             }
         }
-        httpMessage += F("</select></p>");
-
-        httpMessage += F("<p><b>Type</b> <select id='type' name='type'>");
-        httpMessage += getOption(hasp_gpio_type_t::BUTTON_TYPE, D_GPIO_BUTTON, conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::SWITCH, D_GPIO_SWITCH, conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::DOOR, "door", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::GARAGE_DOOR, "garage_door", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::GAS, "gas", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::LIGHT, "light", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::LOCK, "lock", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::MOISTURE, "moisture", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::MOTION, "motion", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::OCCUPANCY, "occupancy", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::OPENING, "opening", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::PRESENCE, "presence", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::PROBLEM, "problem", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::SAFETY, "Safety", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::SMOKE, "Smoke", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::VIBRATION, "Vibration", conf.type);
-        httpMessage += getOption(hasp_gpio_type_t::WINDOW, "Window", conf.type);
-        httpMessage += F("</select></p>");
-
-        httpMessage += F("<p><b>" D_GPIO_GROUP "</b> <select id='group' name='group'>");
-        httpMessage += getOption(0, D_GPIO_GROUP_NONE, conf.group);
-        String group((char*)0);
-        group.reserve(10);
-        for(int i = 1; i < 15; i++) {
-            group = D_GPIO_GROUP " ";
-            group += i;
-            httpMessage += getOption(i, group, conf.group);
-        }
-        httpMessage += F("</select></p>");
-
-        httpMessage += F("<p><b>Default State</b> <select id='state' name='state'>");
-        httpMessage += getOption(0, "Normally Open", conf.inverted);
-        httpMessage += getOption(1, "Normally Closed", conf.inverted);
-        httpMessage += F("</select></p>");
-
-        httpMessage += F("<p><b>Resistor</b> <select id='func' name='func'>");
-        httpMessage += getOption(hasp_gpio_function_t::INTERNAL_PULLUP, "Internal Pullup", conf.gpio_function);
-        httpMessage += getOption(hasp_gpio_function_t::INTERNAL_PULLDOWN, "Internal Pulldown", conf.gpio_function);
-        httpMessage += getOption(hasp_gpio_function_t::EXTERNAL_PULLUP, "External Pullup", conf.gpio_function);
-        httpMessage += getOption(hasp_gpio_function_t::EXTERNAL_PULLDOWN, "External Pulldown", conf.gpio_function);
-        httpMessage += F("</select></p>");
-
-        httpMessage +=
-            F("<p><button type='submit' name='save' value='gpio'>" D_HTTP_SAVE_SETTINGS "</button></p></form>");
-
-        httpMessage += PSTR("<p><form method='GET' action='/config/gpio'><button type='submit'>&#8617; " D_HTTP_BACK
-                            "</button></form></p>");
-
-        webSendHtmlHeader(haspDevice.get_hostname(), httpMessage.length(), 0);
-        webServer.sendContent(httpMessage);
+        page.print_P(PSTR("</select></p>"));
+
+        page.print_P(PSTR("<p><b>Type</b> <select id='type' name='type'>"));
+        http_add_option(page, hasp_gpio_type_t::BUTTON_TYPE, D_GPIO_BUTTON, conf.type);
+        http_add_option(page, hasp_gpio_type_t::SWITCH, D_GPIO_SWITCH, conf.type);
+        http_add_option(page, hasp_gpio_type_t::DOOR, "door", conf.type);
+        http_add_option(page, hasp_gpio_type_t::GARAGE_DOOR, "garage_door", conf.type);
+        http_add_option(page, hasp_gpio_type_t::GAS, "gas", conf.type);
+        http_add_option(page, hasp_gpio_type_t::LIGHT, "light", conf.type);
+        http_add_option(page, hasp_gpio_type_t::LOCK, "lock", conf.type);
+        http_add_option(page, hasp_gpio_type_t::MOISTURE, "moisture", conf.type);
+        http_add_option(page, hasp_gpio_type_t::MOTION, "motion", conf.type);
+        http_add_option(page, hasp_gpio_type_t::OCCUPANCY, "occupancy", conf.type);
+        http_add_option(page, hasp_gpio_type_t::OPENING, "opening", conf.type);
+        http_add_option(page, hasp_gpio_type_t::PRESENCE, "presence", conf.type);
+        http_add_option(page, hasp_gpio_type_t::PROBLEM, "problem", conf.type);
+        http_add_option(page, hasp_gpio_type_t::SAFETY, "Safety", conf.type);
+        http_add_option(page, hasp_gpio_type_t::SMOKE, "Smoke", conf.type);
+        http_add_option(page, hasp_gpio_type_t::VIBRATION, "Vibration", conf.type);
+        http_add_option(page, hasp_gpio_type_t::WINDOW, "Window", conf.type);
+        page.print_P(PSTR("</select></p>"));
+
+        page.print_P(PSTR("<p><b>" D_GPIO_GROUP "</b> <select id='group' name='group'>"));
+        http_add_group_options(page, conf.group);
+        page.print_P(PSTR("</select></p>"));
+
+        page.print_P(PSTR("<p><b>Default State</b> <select id='state' name='state'>"));
+        http_add_option(page, 0, "Normally Open", conf.inverted);
+        http_add_option(page, 1, "Normally Closed", conf.inverted);
+        page.print_P(PSTR("</select></p>"));
+
+        page.print_P(PSTR("<p><b>Resistor</b> <select id='func' name='func'>"));
+        http_add_option(page, hasp_gpio_function_t::INTERNAL_PULLUP, "Internal Pullup", conf.gpio_function);
+        http_add_option(page, hasp_gpio_function_t::INTERNAL_PULLDOWN, "Internal Pulldown", conf.gpio_function);
+        http_add_option(page, hasp_gpio_function_t::EXTERNAL_PULLUP, "External Pullup", conf.gpio_function);
+        http_add_option(page, hasp_gpio_function_t::EXTERNAL_PULLDOWN, "External Pulldown", conf.gpio_function);
+        page.print_P(PSTR("</select></p>"));
+
+        page.print_P(
+            PSTR("<p><button type='submit' name='save' value='gpio'>" D_HTTP_SAVE_SETTINGS "</button></p></form>"));
+
+        page.print_P(PSTR("<p><form method='GET' action='/config/gpio'><button type='submit'>&#8617; " D_HTTP_BACK
+                          "</button></form></p>"));
+        http_page_end(page);
     }
-    webSendFooter();
 
     // if(webServer.hasArg("action")) dispatch_text_line(webServer.arg("action").c_str()); // Security check
 }
@@ -2465,7 +2481,7 @@ static void httpHandleFile(String path)
     // String(webServer.client().remoteIP()).c_str());
 #endif
 
-    if(statuscode < 300 || statuscode == 304) return; // OK or Not Modified
+    if(statuscode < 300 || statuscode == 304 || statuscode == 416) return; // OK, Not Modified or Range Not Satisfiable
 
     httpHandleInvalidRequest(statuscode, path);
 }
@@ -2551,41 +2567,39 @@ static void httpHandleResetConfig()
     bool resetConfirmed = webServer.arg("confirm") == "yes";
 
     { // Send Content
-        String httpMessage((char*)0);
-        httpMessage.reserve(HTTP_PAGE_SIZE);
-        httpMessage += "<h1>";
-        httpMessage += haspDevice.get_hostname();
-        httpMessage += "</h1><hr>";
-        httpMessage += F("<h2>" D_HTTP_FACTORY_RESET "</h2>");
-
-        if(resetConfirmed) {                           // User has confirmed, so reset everything
-            bool formatted = dispatch_factory_reset(); // configClearEeprom();
-            if(formatted) {
-                httpMessage += F("<div class=\"success\">Reset all saved settings. Restarting device...</div>");
-            } else {
-                httpMessage +=
-                    F("<div class=\"error\">Failed to reset the internal storage to factory settings!</div>");
-                resetConfirmed = false;
-            }
+        WebServerTransport transport;
+        HttpWriter page(transport, http_free_heap);
+        bool formatted = resetConfirmed && dispatch_factory_reset(); // configClearEeprom();
+
+        http_page_begin(page, haspDevice.get_hostname(), formatted ? 10 : 0);
+        page.print("<h1>");
+        page.print(haspDevice.get_hostname());
+        page.print("</h1><hr>");
+        page.print_P(PSTR("<h2>" D_HTTP_FACTORY_RESET "</h2>"));
+
+        if(formatted) { // User has confirmed, so reset everything
+            page.print_P(PSTR("<div class=\"success\">Reset all saved settings. Restarting device...</div>"));
+        } else if(resetConfirmed) {
+            page.print_P(
+                PSTR("<div class=\"error\">Failed to reset the internal storage to factory settings!</div>"));
         } else {
             // Form
-            httpMessage += F("<form method='POST' action='/config/reset'>");
-            httpMessage +=
-                F("<div class=\"warning\"><b>Warning</b><p>This process will reset all settings to the "
-                  "default values. The internal flash will be erased and the device is restarted. You may need to "
-                  "connect to the WiFi AP displayed on the panel to reconfigure the device before accessing it "
-                  "again.</p>"
-                  "<p>ALL FILES WILL BE LOST!</p></div>");
-            httpMessage += F("<p><button class='red' type='submit' name='confirm' value='yes'>" D_HTTP_ERASE_DEVICE
-                             "</button></p></form>");
-
-            add_form_button(httpMessage, D_BACK_ICON D_HTTP_CONFIGURATION, F("/config"));
+            page.print_P(PSTR("<form method='POST' action='/config/reset'>"));
+            page.print_P(
+                PSTR("<div class=\"warning\"><b>Warning</b><p>This process will reset all settings to the "
+                     "default values. The internal flash will be erased and the device is restarted. You may need to "
+                     "connect to the WiFi AP displayed on the panel to reconfigure the device before accessing it "
+                     "again.</p>"
+                     "<p>ALL FILES WILL BE LOST!</p></div>"));
+            page.print_P(PSTR("<p><button class='red' type='submit' name='confirm' value='yes'>" D_HTTP_ERASE_DEVICE
+                              "</button></p></form>"));
+
+            page.print_P(PSTR("<a href='/config'>" D_BACK_ICON D_HTTP_CONFIGURATION "</a>"));
         }
 
-        webSendHtmlHeader(haspDevice.get_hostname(), httpMessage.length(), resetConfirmed ? 10 : 0);
-        webServer.sendContent(httpMessage);
+        http_page_end(page);
+        resetConfirmed = formatted;
     }
-    webSendFooter();
 
     { // Execute Actions
         if(resetConfirmed) {
@@ -2699,7 +2713,7 @@ void httpSetup()
     LOG_DEBUG(TAG_HTTP, F(D_BULLET "Read %s => %s (%d bytes)"), FP_CONFIG_PASS, password.c_str(), password.length());
 
     // ask server to track these headers
-    const char* headerkeys[] = {"Content-Length", "If-None-Match",
+    const char* headerkeys[] = {"Content-Length", "If-None-Match", "If-Modified-Since", "Range", "If-Range",
                                 "Cookie"}; // "Authentication" is automatically checked
     size_t headerkeyssize    = sizeof(headerkeys) / sizeof(char*);
     webServer.collectHeaders(headerkeys, headerkeyssize);
@@ -2746,6 +2760,7 @@ void httpSetup()
     webServer.on("/page/", []() {
         String pageid = webServer.arg("page");
         webServer.send(200, PSTR("text/plain"), "Page: '" + pageid + "'");
+        GuiLock lock("page");
         dispatch_page(NULL, webServer.arg("page").c_str(), TAG_HTTP);
         // dispatch_set_page(pageid.toInt(), LV_SCR_LOAD_ANIM_NONE);
     });
@@ -95,6 +95,29 @@ extern const uint8_t EDIT_HTM_GZ_END[] asm("_binary_data_edit_htm_gz_end");
 
 AsyncWebSocket ws("/ws"); // access at ws://[esp ip]/ws
 
+#if HASP_USE_LOG_RING
+/* Each websocket client tails the log ring from its own cursor */
+#define HTTP_WS_READERS 4
+#define HTTP_WS_LINES 8 // per message
+
+struct http_ws_reader_t
+{
+    uint32_t id;     // websocket client, 0 is a free slot
+    uint32_t cursor; // next line to send, 0 starts at the oldest line
+};
+static http_ws_reader_t ws_readers[HTTP_WS_READERS];
+
+/* The websocket events come in on the async_tcp task, the loop sends the lines */
+#if defined(ARDUINO_ARCH_ESP32)
+static portMUX_TYPE ws_readers_mux = portMUX_INITIALIZER_UNLOCKED;
+#define HTTP_WS_LOCK() portENTER_CRITICAL(&ws_readers_mux)
+#define HTTP_WS_UNLOCK() portEXIT_CRITICAL(&ws_readers_mux)
+#else
+#define HTTP_WS_LOCK() // the events run in the same context as the loop
+#define HTTP_WS_UNLOCK()
+#endif
+#endif
+
 // HTTPUpload* upload;
 
 // static const char HTTP_MENU_BUTTON[] PROGMEM =
@@ -324,6 +347,7 @@ void saveConfig()
 {
     /*    if(webServer.method() == HTTP_POST) {
             if(request->hasArg(PSTR("save"))) {
+                GuiLock lock("config"); // the hasp and gui settings are applied to lvgl
                 String save = request->arg(PSTR("save"));
 
                 StaticJsonDocument<256> settings;
@@ -431,6 +455,7 @@ void webHandleScreenshot(AsyncWebServerRequest* request)
     if(!httpIsAuthenticated(request, F("screenshot"))) return;
 
     if(request->hasArg(F("a"))) {
+        GuiLock lock("screenshot"); // changes pages
         if(request->arg(F("a")) == F("next")) {
             dispatch_page_next(LV_SCR_LOAD_ANIM_NONE);
         } else if(request->arg(F("a")) == F("prev")) {
@@ -441,6 +466,7 @@ void webHandleScreenshot(AsyncWebServerRequest* request)
     }
 
     if(request->hasArg(F("q"))) {
+        GuiLock lock("screenshot"); // the screen is flushed into the reply
         lv_disp_t* disp = lv_disp_get_default();
         // webServer.setContentLength(122 + disp->driver.hor_res * disp->driver.ver_res * sizeof(lv_color_t));
         // request->send_P(200, PSTR("image/bmp"), "");
@@ -519,8 +545,6 @@ void webHandleAbout(AsyncWebServerRequest* request)
     httpMessage += F("<p><h3>QR Code generator</h3>Copyright&copy; Project Nayuki");
     httpMessage += mitLicense;
 #endif
-    httpMessage += F("<p><h3>AceButton</h3>Copyright&copy; 2018 Brian T. Park");
-    httpMessage += mitLicense;
 
     httpMessage += FPSTR(MAIN_MENU_BUTTON);
 
@@ -653,7 +677,12 @@ void webHandleInfo(AsyncWebServerRequest* request)
 
     /* LVGL Stats */
     lv_mem_monitor_t mem_mon;
-    lv_mem_monitor(&mem_mon);
+    uint8_t active_page;
+    {
+        GuiLock lock("info"); // reads the lvgl memory and pages
+        lv_mem_monitor(&mem_mon);
+        active_page = haspPages.get();
+    }
     httpMessage += F("</p><p><b>LVGL Memory: </b>");
     Parser::format_bytes(mem_mon.total_size, size_buf, sizeof(size_buf));
     httpMessage += size_buf;
@@ -667,7 +696,7 @@ void webHandleInfo(AsyncWebServerRequest* request)
     // String(LV_HASP_VER_RES_MAX); httpMessage += F("<br/><b>LCD Version: </b>")) +
     // String(lcdVersion);
     httpMessage += F("</p/><p><b>LCD Active Page: </b>");
-    httpMessage += String(haspPages.get());
+    httpMessage += String(active_page);
 
     /* Wifi Stats */
 #if HASP_USE_WIFI > 0
@@ -987,6 +1016,9 @@ void handleFileUpload(AsyncWebServerRequest* request, String filename, size_t in
             filename = "/" + filename;
         }
         if(filename.length() < 32) {
+#if HASP_USE_LAZY_PAGES > 0
+            haspPages.drop_index(filename.c_str()); // the page offsets will be invalid
+#endif
             fsUploadFile = HASP_FS.open(filename, "w");
             LOG_TRACE(TAG_HTTP, F("handleFileUpload Name: %s"), filename.c_str());
             haspProgressMsg(fsUploadFile.name());
@@ -1041,6 +1073,9 @@ void handleFileDelete(AsyncWebServerRequest* request)
     if(!HASP_FS.exists(path)) {
         return request->send_P(404, mimetype, PSTR("FileNotFound"));
     }
+#if HASP_USE_LAZY_PAGES > 0
+    haspPages.drop_index(path.c_str());
+#endif
     HASP_FS.remove(path);
     request->send_P(200, mimetype, PSTR(""));
     // path.clear();
@@ -1070,6 +1105,7 @@ void handleFileCreate(AsyncWebServerRequest* request)
             return request->send(500, PSTR("text/plain"), PSTR("CREATE FAILED"));
         }
     }
+    GuiLock lock("edit"); // the page commands below change lvgl objects
     if(request->hasArg(F("init"))) {
         dispatch_idle(NULL, "0");
         hasp_init();
@@ -1344,7 +1380,10 @@ void webHandleGuiConfig(AsyncWebServerRequest* request)
         // //webSendFooter(reponse);(httpMessage);
     }
 
-    if(request->hasArg(F("cal"))) dispatch_calibrate(NULL, NULL);
+    if(request->hasArg(F("cal"))) {
+        GuiLock lock("gui");
+        dispatch_calibrate(NULL, NULL, TAG_HTTP);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -2180,6 +2219,102 @@ void httpHandleResetConfig(AsyncWebServerRequest* request)
 }
 #endif // HASP_USE_CONFIG
 
+#if HASP_USE_LOG_RING
+void webHandleApiLog(AsyncWebServerRequest* request)
+{ // http://plate01/api/log/?seq=123&level=5
+    if(!httpIsAuthenticated(request, F("api"))) return;
+
+    DynamicJsonDocument doc(MAX_CONFIG_JSON_ALLOC_SIZE);
+    uint32_t cursor = 0;
+    int level       = LOG_LEVEL_OUTPUT;
+    if(request->hasArg("seq")) cursor = strtoul(request->arg("seq").c_str(), NULL, 10);
+    if(request->hasArg("level")) level = request->arg("level").toInt();
+    debug_get_log(doc, cursor, level, 50); // lock-free, safe on the web server task
+
+    String json((char*)0);
+    serializeJson(doc, json);
+    request->send(200, PSTR("application/json"), json);
+}
+
+static void webSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg,
+                           uint8_t* data, size_t len)
+{
+    switch(type) {
+        case WS_EVT_CONNECT: {
+            bool added = false;
+            HTTP_WS_LOCK();
+            for(http_ws_reader_t& reader : ws_readers) {
+                if(reader.id) continue;
+                reader.cursor = 0;
+                reader.id     = client->id();
+                added         = true;
+                break;
+            }
+            HTTP_WS_UNLOCK();
+            if(added) return;
+            LOG_WARNING(TAG_HTTP, F("Too many log readers"));
+            client->close();
+            break;
+        }
+
+        case WS_EVT_DISCONNECT:
+            HTTP_WS_LOCK();
+            for(http_ws_reader_t& reader : ws_readers)
+                if(reader.id == client->id()) reader.id = 0;
+            HTTP_WS_UNLOCK();
+            break;
+
+        case WS_EVT_DATA: { // the client sends the seq to continue from
+            AwsFrameInfo* info = (AwsFrameInfo*)arg;
+            if(!info->final || info->index != 0 || info->len != len || info->opcode != WS_TEXT) break;
+            char seq[12];
+            if(len >= sizeof(seq)) break;
+            memcpy(seq, data, len);
+            seq[len]        = 0;
+            uint32_t cursor = strtoul(seq, NULL, 10);
+            HTTP_WS_LOCK();
+            for(http_ws_reader_t& reader : ws_readers)
+                if(reader.id == client->id()) reader.cursor = cursor;
+            HTTP_WS_UNLOCK();
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+/* Sends the new lines to the websocket clients, a client whose queue is still full waits and gets a gap */
+static void httpLogLoop(void)
+{
+    uint32_t next = log_ring_next();
+
+    for(http_ws_reader_t& reader : ws_readers) {
+        HTTP_WS_LOCK();
+        http_ws_reader_t copy = reader;
+        HTTP_WS_UNLOCK();
+        if(!copy.id || copy.cursor == next) continue;
+
+        AsyncWebSocketClient* client = ws.client(copy.id);
+        if(!client || client->status() != WS_CONNECTED) continue;
+        if(client->queueIsFull()) continue;
+
+        DynamicJsonDocument doc(MAX_CONFIG_JSON_ALLOC_SIZE);
+        debug_get_log(doc, copy.cursor, LOG_LEVEL_OUTPUT, HTTP_WS_LINES);
+        uint32_t cursor = doc[F("cursor")].as<uint32_t>();
+
+        // Unless the client asked for another seq or left in the meantime
+        HTTP_WS_LOCK();
+        if(reader.id == copy.id && reader.cursor == copy.cursor) reader.cursor = cursor;
+        HTTP_WS_UNLOCK();
+
+        char json[measureJson(doc) + 1];
+        size_t size = serializeJson(doc, json, sizeof(json));
+        client->text(json, size);
+    }
+}
+#endif
+
 void httpStart()
 {
     webServer.begin();
@@ -2245,6 +2380,7 @@ void httpSetup()
     webServer.on(("/page/"), [](AsyncWebServerRequest* request) {
         String pageid = request->arg(F("page"));
         request->send(200, PSTR("text/plain"), "Page: '" + pageid + "'");
+        GuiLock lock("page");
         dispatch_set_page(pageid.toInt(), LV_SCR_LOAD_ANIM_NONE);
     });
 
@@ -2306,6 +2442,12 @@ void httpSetup()
     // These two endpoints are needed in STA and AP mode
     webServer.on(("/config"), webHandleConfig);
 
+#if HASP_USE_LOG_RING
+    webServer.on(("/api/log/"), HTTP_GET, webHandleApiLog);
+    ws.onEvent(webSocketEvent);
+    webServer.addHandler(&ws);
+#endif
+
     LOG_INFO(TAG_HTTP, F(D_SERVICE_STARTED));
     // webStart();  Wait for network connection
 }
@@ -2328,7 +2470,11 @@ void httpReconnect()
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 IRAM_ATTR void httpLoop(void)
-{}
+{
+#if HASP_USE_LOG_RING
+    if(webServerStarted) httpLogLoop();
+#endif
+}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 void httpEverySecond()
@@ -0,0 +1,312 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Serving files from the filesystem
+ *
+ * A request is first answered from the directory entry: a matching If-None-Match or If-Modified-Since gets a 304
+ * without opening the file. A single byte range gets a 206 with only that part of the file, so an interrupted
+ * download of a large image or font can be resumed. The directory listing is streamed in chunks while the directory
+ * is read instead of being collected in memory first.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hasp_http_file.h"
+
+enum http_range_t {
+    HTTP_RANGE_NONE = 0, // send the whole file
+    HTTP_RANGE_OK,
+    HTTP_RANGE_UNSATISFIABLE,
+};
+
+static const char http_months[][4] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                      "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+static const char http_days[][4]   = {"Thu", "Fri", "Sat", "Sun", "Mon", "Tue", "Wed"}; // 1 Jan 1970 was a Thursday
+
+/* IMF-fixdate, e.g. Sun, 06 Nov 1994 08:49:37 GMT */
+void http_date_format(uint32_t time, char* buffer, size_t size)
+{
+    uint32_t days = time / 86400;
+    uint32_t secs = time % 86400;
+
+    // Civil date from the days since 1 Jan 1970, with the year starting in March
+    uint32_t z   = days + 719468;
+    uint32_t era = z / 146097;
+    uint32_t doe = z - era * 146097;
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp  = (5 * doy + 2) / 153;
+    uint32_t day = doy - (153 * mp + 2) / 5 + 1;
+    uint32_t mon = mp < 10 ? mp + 3 : mp - 9;
+    uint32_t yr  = yoe + era * 400 + (mon <= 2);
+
+    snprintf(buffer, size, "%s, %02u %s %04u %02u:%02u:%02u GMT", http_days[days % 7], (unsigned)day,
+             http_months[mon - 1], (unsigned)yr, (unsigned)(secs / 3600), (unsigned)(secs / 60 % 60),
+             (unsigned)(secs % 60));
+}
+
+/* Returns 0 when text is not an IMF-fixdate */
+uint32_t http_date_parse(const char* text)
+{
+    const char* comma = strchr(text, ',');
+    char month[4];
+    unsigned day, yr, hh, mm, ss;
+
+    if(!comma || sscanf(comma + 1, " %u %3s %u %u:%u:%u", &day, month, &yr, &hh, &mm, &ss) != 6) return 0;
+    if(yr < 1970 || day < 1 || day > 31 || hh > 23 || mm > 59 || ss > 60) return 0;
+
+    uint32_t mon = 0;
+    while(mon < 12 && strcmp(month, http_months[mon])) mon++;
+    if(mon++ >= 12) return 0;
+
+    yr -= mon <= 2;
+    uint32_t era = yr / 400;
+    uint32_t yoe = yr - era * 400;
+    uint32_t doy = (153 * (mon > 2 ? mon - 3 : mon + 9) + 2) / 5 + day - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    uint32_t days = era * 146097 + doe - 719468;
+
+    return days * 86400 + hh * 3600 + mm * 60 + ss;
+}
+
+/* Pages, json and the other files that are edited on the plate are revalidated on every use */
+const char* http_file_cache_control(const char* content_type, char* buffer, size_t size)
+{
+    unsigned long age;
+
+    if(!strncmp(content_type, "image/", 6) || strstr(content_type, "font"))
+        age = HTTP_CACHE_AGE_MEDIA;
+    else if(!strcmp(content_type, "text/css") || strstr(content_type, "javascript"))
+        age = HTTP_CACHE_AGE_ASSET;
+    else
+        return "no-cache";
+
+    snprintf(buffer, size, "public, max-age=%lu", age);
+    return buffer;
+}
+
+/* Only a single range is honoured, a list of ranges gets the whole file */
+static http_range_t http_range_parse(const char* header, uint32_t size, uint32_t& first, uint32_t& last)
+{
+    if(strncmp(header, "bytes=", 6) || strchr(header, ',')) return HTTP_RANGE_NONE;
+
+    const char* p = header + 6;
+    char* end;
+
+    if(*p == '-') { // the last n bytes
+        if(!isdigit((unsigned char)p[1])) return HTTP_RANGE_NONE;
+        unsigned long len = strtoul(p + 1, &end, 10);
+        if(len == 0 || size == 0) return HTTP_RANGE_UNSATISFIABLE;
+
+        first = len >= size ? 0 : size - len;
+        last  = size - 1;
+        return HTTP_RANGE_OK;
+    }
+
+    if(!isdigit((unsigned char)*p)) return HTTP_RANGE_NONE;
+    unsigned long from = strtoul(p, &end, 10);
+    if(*end != '-') return HTTP_RANGE_NONE;
+
+    unsigned long to = size ? size - 1 : 0;
+    p                = end + 1;
+    if(isdigit((unsigned char)*p)) {
+        to = strtoul(p, &end, 10);
+        if(to < from) return HTTP_RANGE_NONE;
+    } else if(*p) {
+        return HTTP_RANGE_NONE;
+    }
+
+    if(from >= size) return HTTP_RANGE_UNSATISFIABLE;
+    first = from;
+    last  = to >= size ? size - 1 : to;
+    return HTTP_RANGE_OK;
+}
+
+static bool http_file_not_modified(HttpTransport& http, const char* etag, uint32_t modified)
+{
+    char value[128];
+
+    if(http.request_header("If-None-Match", value, sizeof(value)))
+        return strstr(value, etag) != NULL || !strcmp(value, "*"); // takes precedence over If-Modified-Since
+
+    if(http.request_header("If-Modified-Since", value, sizeof(value))) {
+        uint32_t since = http_date_parse(value);
+        return since != 0 && modified <= since;
+    }
+
+    return false;
+}
+
+/* A range is only sent when the If-Range validator still matches the file */
+static bool http_file_if_range(HttpTransport& http, const char* etag, uint32_t modified)
+{
+    char value[64];
+
+    if(!http.request_header("If-Range", value, sizeof(value))) return true;
+    if(modified == 0) return false;
+    if(value[0] == '"') return !strcmp(value, etag);
+    return http_date_parse(value) == modified;
+}
+
+/* Without a modification time the file has no validators and can only be cached by its age */
+static void http_file_send_cache_headers(HttpTransport& http, const char* etag, const char* date,
+                                         const char* content_type)
+{
+    char value[32];
+
+    if(etag) http.send_header("ETag", etag);
+    if(date) http.send_header("Last-Modified", date);
+    http.send_header("Cache-Control", http_file_cache_control(content_type, value, sizeof(value)));
+}
+
+int http_file_send(HttpTransport& http, HttpFileStore& store, const char* path, const char* content_type, bool gzip)
+{
+    http_file_stat_t st;
+    if(!store.stat(path, st) || st.is_dir) return 404;
+
+    char etag[24];
+    char date[32];
+    char value[64];
+    bool validator = st.modified != 0;
+
+    if(validator) {
+        snprintf(etag, sizeof(etag), "\"%lx-%lx\"", (unsigned long)st.modified, (unsigned long)st.size);
+        http_date_format(st.modified, date, sizeof(date));
+    }
+
+    if(validator && http_file_not_modified(http, etag, st.modified)) {
+        http_file_send_cache_headers(http, etag, date, content_type);
+        http.begin(304, content_type, 0);
+        http.end();
+        return 304;
+    }
+
+    if(!store.open(path)) return 500;
+    http_file_send_cache_headers(http, validator ? etag : NULL, validator ? date : NULL, content_type);
+    http.send_header("Accept-Ranges", "bytes");
+
+    int code       = 200;
+    uint32_t first = 0;
+    uint32_t last  = st.size ? st.size - 1 : 0;
+
+    if(http.request_header("Range", value, sizeof(value)) && http_file_if_range(http, etag, st.modified)) {
+        switch(http_range_parse(value, st.size, first, last)) {
+            case HTTP_RANGE_OK:
+                code = 206;
+                snprintf(value, sizeof(value), "bytes %lu-%lu/%lu", (unsigned long)first, (unsigned long)last,
+                         (unsigned long)st.size);
+                http.send_header("Content-Range", value);
+                break;
+
+            case HTTP_RANGE_UNSATISFIABLE:
+                snprintf(value, sizeof(value), "bytes */%lu", (unsigned long)st.size);
+                http.send_header("Content-Range", value);
+                http.begin(416, content_type, 0);
+                http.end();
+                store.close();
+                return 416;
+
+            default:
+                first = 0;
+                last  = st.size ? st.size - 1 : 0;
+        }
+    }
+
+    if(first > 0 && !store.seek(first)) {
+        store.close();
+        return 500;
+    }
+
+    if(gzip) http.send_header("Content-Encoding", "gzip");
+
+    uint32_t remaining = st.size ? last - first + 1 : 0;
+    http.begin(code, content_type, remaining);
+
+    uint8_t buffer[HTTP_FILE_CHUNK_SIZE];
+    while(remaining > 0) {
+        size_t len = store.read(buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
+        if(len == 0 || http.write((const char*)buffer, len) != len) break; // the file shrunk or the client left
+        remaining -= len;
+    }
+
+    store.close();
+    http.end();
+    return code;
+}
+
+struct http_file_list_t
+{
+    HttpTransport* http;
+    bool started;
+    size_t count;
+    size_t len;
+    char buffer[HTTP_FILE_CHUNK_SIZE / 2];
+};
+
+static void http_file_list_flush(http_file_list_t& list)
+{
+    if(!list.started) {
+        list.http->begin(200, "text/json", -1);
+        list.started = true;
+    }
+    if(list.len) list.http->write(list.buffer, list.len);
+    list.len = 0;
+}
+
+static void http_file_list_add(http_file_list_t& list, const char* text, size_t len)
+{
+    if(list.len + len > sizeof(list.buffer)) http_file_list_flush(list);
+    memcpy(list.buffer + list.len, text, len);
+    list.len += len;
+}
+
+static void http_file_list_entry(void* arg, const char* name, const http_file_stat_t& st)
+{
+    http_file_list_t& list = *(http_file_list_t*)arg;
+    char text[24];
+
+    if(*name == '/') name++;
+
+    if(list.count++) http_file_list_add(list, ",", 1);
+    http_file_list_add(list, "{\"type\":\"", 9);
+    http_file_list_add(list, st.is_dir ? "dir" : "file", st.is_dir ? 3 : 4);
+    http_file_list_add(list, "\",\"name\":\"", 10);
+
+    for(; *name; name++) {
+        unsigned char c = *name;
+        if(c == '"' || c == '\\') {
+            text[0] = '\\';
+            text[1] = c;
+            http_file_list_add(list, text, 2);
+        } else if(c < 0x20) {
+            http_file_list_add(list, text, snprintf(text, sizeof(text), "\\u%04x", c));
+        } else {
+            http_file_list_add(list, name, 1);
+        }
+    }
+
+    if(st.is_dir)
+        http_file_list_add(list, "\"}", 2);
+    else
+        http_file_list_add(list, text, snprintf(text, sizeof(text), "\",\"size\":%lu}", (unsigned long)st.size));
+}
+
+int http_file_list(HttpTransport& http, HttpFileStore& store, const char* dir)
+{
+    http_file_list_t list;
+    list.http    = &http;
+    list.started = false;
+    list.count   = 0;
+    list.len     = 0;
+
+    http_file_list_add(list, "[", 1);
+    if(!store.list(dir, http_file_list_entry, &list) && list.count == 0) return 404;
+    http_file_list_add(list, "]", 1);
+
+    http_file_list_flush(list);
+    http.end();
+    return 200;
+}
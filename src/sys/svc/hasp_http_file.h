@@ -0,0 +1,72 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_HTTP_FILE_H
+#define HASP_HTTP_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef HTTP_FILE_CHUNK_SIZE
+#define HTTP_FILE_CHUNK_SIZE 1024 // bytes read from the filesystem and sent at once
+#endif
+
+#ifndef HTTP_CACHE_AGE_ASSET
+#define HTTP_CACHE_AGE_ASSET 3600 // seconds a browser may use stylesheets and scripts without asking
+#endif
+
+#ifndef HTTP_CACHE_AGE_MEDIA
+#define HTTP_CACHE_AGE_MEDIA 86400 // seconds a browser may use images and fonts without asking
+#endif
+
+struct http_file_stat_t
+{
+    bool is_dir;
+    uint32_t size;
+    uint32_t modified; // unix time, 0 when the filesystem does not keep it
+};
+
+typedef void (*http_file_list_cb_t)(void* arg, const char* name, const http_file_stat_t& st);
+
+/* The filesystem the files are served from, only one file is open at a time */
+class HttpFileStore {
+  public:
+    virtual ~HttpFileStore()
+    {}
+
+    virtual bool stat(const char* path, http_file_stat_t& st) = 0;
+    virtual bool open(const char* path)                       = 0;
+    virtual bool seek(uint32_t pos)                           = 0;
+    virtual size_t read(uint8_t* buffer, size_t len)          = 0;
+    virtual void close()                                      = 0;
+
+    /* Calls cb for each entry in dir, returns false when dir can not be read */
+    virtual bool list(const char* dir, http_file_list_cb_t cb, void* arg) = 0;
+};
+
+/* The connection the response is written to */
+class HttpTransport {
+  public:
+    virtual ~HttpTransport()
+    {}
+
+    /* Copies the value of a request header into value, returns false when the request does not have it */
+    virtual bool request_header(const char* name, char* value, size_t size) = 0;
+
+    virtual void send_header(const char* name, const char* value) = 0;
+
+    /* Sends the status line and the headers, a negative length sends the body in chunks */
+    virtual void begin(int code, const char* content_type, int32_t length) = 0;
+
+    virtual size_t write(const char* data, size_t len) = 0;
+    virtual void end()                                 = 0;
+};
+
+int http_file_send(HttpTransport& http, HttpFileStore& store, const char* path, const char* content_type, bool gzip);
+int http_file_list(HttpTransport& http, HttpFileStore& store, const char* dir);
+
+const char* http_file_cache_control(const char* content_type, char* buffer, size_t size);
+void http_date_format(uint32_t time, char* buffer, size_t size);
+uint32_t http_date_parse(const char* text);
+
+#endif // HASP_HTTP_FILE_H
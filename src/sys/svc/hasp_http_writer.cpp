@@ -0,0 +1,136 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hasp_http_writer.h"
+
+#if defined(ARDUINO)
+#include <pgmspace.h>
+#else
+#define strlen_P strlen
+#define memcpy_P memcpy
+#define vsnprintf_P vsnprintf
+#endif
+
+HttpWriter::HttpWriter(HttpTransport& http, http_heap_probe_t probe) : http(http), probe(probe)
+{}
+
+void HttpWriter::sample_heap()
+{
+    if(!probe) return;
+    size_t heap = probe();
+    if(heap < heap_min) heap_min = heap;
+}
+
+size_t HttpWriter::heap_used() const
+{
+    return heap_start > heap_min ? heap_start - heap_min : 0;
+}
+
+/* The response is always sent in chunks, its length is not known until the last field is written */
+void HttpWriter::begin(int code, const char* content_type)
+{
+    if(probe) heap_start = heap_min = probe();
+    http.begin(code, content_type, -1);
+    started = true;
+}
+
+void HttpWriter::flush()
+{
+    if(!started) begin(200, "text/html");
+    if(used == 0) return;
+
+    sample_heap();
+    http.write(buffer, used);
+    sent += used;
+    used = 0;
+    count++;
+}
+
+void HttpWriter::end()
+{
+    flush();
+    sample_heap();
+    http.end();
+}
+
+void HttpWriter::print(const char* text, size_t len)
+{
+    while(len > 0) {
+        if(used == sizeof(buffer)) flush();
+        size_t n = sizeof(buffer) - used;
+        if(n > len) n = len;
+        memcpy(buffer + used, text, n);
+        used += n;
+        text += n;
+        len -= n;
+    }
+}
+
+void HttpWriter::print(const char* text)
+{
+    if(text) print(text, strlen(text));
+}
+
+void HttpWriter::print_P(const char* text)
+{
+    size_t len = strlen_P(text);
+    while(len > 0) {
+        if(used == sizeof(buffer)) flush();
+        size_t n = sizeof(buffer) - used;
+        if(n > len) n = len;
+        memcpy_P(buffer + used, text, n);
+        used += n;
+        text += n;
+        len -= n;
+    }
+}
+
+void HttpWriter::print(long number)
+{
+    char text[12];
+    print(text, snprintf(text, sizeof(text), "%ld", number));
+}
+
+/* A single field is formatted in place, one that does not fit an empty buffer is truncated */
+void HttpWriter::vprintf_P(const char* format, va_list args)
+{
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf_P(buffer + used, sizeof(buffer) - used, format, copy);
+    va_end(copy);
+
+    if(len < 0) return;
+    if((size_t)len < sizeof(buffer) - used) {
+        used += len;
+        return;
+    }
+
+    flush();
+    len = vsnprintf_P(buffer, sizeof(buffer), format, args);
+    if(len < 0) return;
+    used = (size_t)len < sizeof(buffer) ? len : sizeof(buffer) - 1;
+}
+
+void HttpWriter::printf_P(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vprintf_P(format, args);
+    va_end(args);
+}
+
+size_t HttpWriter::write(uint8_t c)
+{
+    if(used == sizeof(buffer)) flush();
+    buffer[used++] = c;
+    return 1;
+}
+
+size_t HttpWriter::write(const uint8_t* data, size_t len)
+{
+    print((const char*)data, len);
+    return len;
+}
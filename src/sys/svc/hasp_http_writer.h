@@ -0,0 +1,65 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_HTTP_WRITER_H
+#define HASP_HTTP_WRITER_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hasp_http_file.h"
+
+#ifndef HTTP_WRITER_BUFFER_SIZE
+#define HTTP_WRITER_BUFFER_SIZE 512 // bytes collected before they are sent as one chunk
+#endif
+
+typedef size_t (*http_heap_probe_t)(void);
+
+/* Writes a response in chunks of at most HTTP_WRITER_BUFFER_SIZE bytes, the whole page is never held in memory.
+ * Text is copied and fields are formatted straight into the buffer, it is sent to the client when it is full.
+ * The optional probe returns the free heap and is sampled on every chunk to find the lowest point of the request. */
+class HttpWriter {
+  public:
+    explicit HttpWriter(HttpTransport& http, http_heap_probe_t probe = NULL);
+
+    void begin(int code, const char* content_type);
+    void end();
+
+    void print(const char* text);
+    void print(const char* text, size_t len);
+    void print_P(const char* text); // text in PROGMEM
+    void print(long number);
+    void printf_P(const char* format, ...); // format in PROGMEM
+    void vprintf_P(const char* format, va_list args);
+
+    /* Print interface used by serializeJson() */
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* data, size_t len);
+
+    size_t total() const
+    {
+        return sent + used;
+    }
+    size_t chunks() const
+    {
+        return count;
+    }
+    size_t heap_used() const; // free heap at begin() minus the lowest free heap seen while writing
+
+  private:
+    HttpTransport& http;
+    http_heap_probe_t probe;
+    size_t heap_start = 0;
+    size_t heap_min   = 0;
+    size_t sent       = 0;
+    size_t count      = 0;
+    size_t used       = 0;
+    bool started      = false;
+    char buffer[HTTP_WRITER_BUFFER_SIZE];
+
+    void flush();
+    void sample_heap();
+};
+
+#endif // HASP_HTTP_WRITER_H
@@ -1,336 +1,645 @@
 /* MIT License - Copyright (c) 2019-2024 Francis Van Roie
    For full license information read the LICENSE file in the project folder */
 
+/* Telnet console
+ *
+ * Up to TELNET_MAX_CLIENTS sessions are served by an io thread, or by telnetLoop on the ESP8266, which accepts the
+ * clients, does the line editing and sends the queued output without ever blocking on a socket. The main loop only
+ * handles the completed lines, so commands still run next to the gui, and writes the log output into the queue of
+ * each logged in session. A session that does not read its output loses the log lines that do not fit in its queue
+ * instead of stalling the device.
+ */
+
 #include "hasplib.h"
 
 #if HASP_USE_TELNET > 0
 
-#include "ConsoleInput.h"
-#include <StreamUtils.h>
-
 #include "hasp_debug.h"
+#include "hasp_loop.h"
 #include "hasp_telnet.h"
-#include "hasp_http.h"
+#include "hasp_telnet_session.h"
 
 #include "../../hasp/hasp_dispatch.h"
 
-#define IAC_SHOW_CHARACTERS "\xff\xfc\x01"
-#define IAC_HIDE_CHARACTERS "\xff\xfb\x01"
+#if HASP_USE_HTTP > 0 || HASP_USE_HTTP_ASYNC > 0
+#include "hasp_http.h"
+extern hasp_http_config_t http_config;
+#endif
 
 #if defined(ARDUINO_ARCH_ESP32)
 #include <WiFi.h>
-WiFiClient telnetClient;
+#include <lwip/sockets.h>
 static WiFiServer* telnetServer;
+static WiFiClient telnetClients[TELNET_MAX_CLIENTS];
 #elif defined(ARDUINO_ARCH_ESP8266)
 #include <ESP8266WiFi.h>
-WiFiClient telnetClient;
 static WiFiServer* telnetServer;
+static WiFiClient telnetClients[TELNET_MAX_CLIENTS];
+#elif defined(POSIX)
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+static int telnet_listen_fd = -1;
+static int telnet_fds[TELNET_MAX_CLIENTS];
 #else
-// #include <STM32Ethernet.h>
-EthernetClient telnetClient;
-static EthernetServer telnetServer(23);
+#error "The telnet console needs an ESP32, ESP8266 or POSIX target"
 #endif
 
-#if HASP_USE_HTTP > 0 || HASP_USE_HTTP_ASYNC > 0
-extern hasp_http_config_t http_config;
+#if defined(ARDUINO_ARCH_ESP8266)
+#define TELNET_LOCK() // single threaded, the io runs in telnetLoop
+#else
+#include <mutex>
+static std::mutex telnet_mutex;
+#define TELNET_LOCK() std::lock_guard<std::mutex> lock(telnet_mutex)
 #endif
 
-// Create a new Stream that buffers all writes to telnetClient
-WriteBufferingClient bufferedTelnetClient{telnetClient, HASP_CONSOLE_BUFFER};
+#define TELNET_IO_PERIOD 10 // ms between two passes of the io thread
+#define TELNET_MAX_ATTEMPTS 3
 
-uint8_t telnetLoginState   = TELNET_UNAUTHENTICATED;
-uint16_t telnetPort        = 23;
-uint8_t telnetEnabled      = true; // Enable telnet debug output
-uint8_t telnetLoginAttempt = 0;    // Initial attempt
-ConsoleInput* telnetConsole;
+// IAC WILL ECHO, IAC WILL SUPPRESS-GO-AHEAD: the client sends each key and the server does the echo
+#define IAC_CHARACTER_MODE "\xff\xfb\x01\xff\xfb\x03"
 
-void telnet_update_prompt()
+uint16_t telnetPort   = TELNET_PORT;
+uint8_t telnetEnabled = true; // Enable telnet debug output
+
+/* All below is guarded by telnet_mutex */
+static TelnetSession telnet_sessions[TELNET_MAX_CLIENTS];
+static bool telnet_running   = false; // the io thread keeps serving
+static bool telnet_io_active = false; // the io thread has not finished yet
+static uint16_t telnet_rejected;      // clients closed because all sessions were taken
+
+struct telnet_rx_t
+{
+    char data[64]; // bytes received but not yet used by the line editor
+    uint8_t pos;
+    uint8_t len;
+};
+static telnet_rx_t telnet_rx[TELNET_MAX_CLIENTS];
+
+/* ===== Socket backends, only used by the io thread ===== */
+
+#if defined(POSIX)
+static bool telnet_backend_listen(uint16_t port)
 {
-    if(telnetConsole) telnetConsole->update(__LINE__);
-    bufferedTelnetClient.flush();
+    signal(SIGPIPE, SIG_IGN); // a client that went away must not end the program
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0) return false;
+
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    struct sockaddr_in addr = {};
+    addr.sin_family         = AF_INET;
+    addr.sin_addr.s_addr    = htonl(INADDR_ANY);
+    addr.sin_port           = htons(port);
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, TELNET_MAX_CLIENTS) < 0) {
+        close(fd);
+        return false;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    for(uint8_t id = 0; id < TELNET_MAX_CLIENTS; id++) telnet_fds[id] = -1;
+    telnet_listen_fd = fd;
+    return true;
+}
+
+static void telnet_backend_unlisten()
+{
+    if(telnet_listen_fd >= 0) close(telnet_listen_fd);
+    telnet_listen_fd = -1;
 }
 
-static inline void telnet_new_prompt(const char* prompt)
+/* Accepts a waiting client into slot id, without a free slot (id == TELNET_MAX_CLIENTS) it is closed right away */
+static bool telnet_backend_accept(uint8_t id, char* remote, size_t size)
 {
-    if(!telnetConsole) return;
+    struct sockaddr_in addr;
+    socklen_t addr_size = sizeof(addr);
+    int fd              = accept(telnet_listen_fd, (struct sockaddr*)&addr, &addr_size);
+    if(fd < 0) return false;
+
+    if(id >= TELNET_MAX_CLIENTS) {
+        close(fd);
+        return true;
+    }
 
-    telnetClient.println(IAC_SHOW_CHARACTERS);
-    telnetConsole->setPrompt(prompt);
-    telnetConsole->clearLine(); // avoid leaking information, updates the prompt
-    telnet_update_prompt();
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    inet_ntop(AF_INET, &addr.sin_addr, remote, size);
+    telnet_fds[id] = fd;
+    return true;
 }
 
-static inline void telnet_echo_on()
+/* Returns the bytes received, 0 when there are none and -1 when the client is gone */
+static int telnet_backend_read(uint8_t id, char* buffer, size_t size)
 {
-    telnetClient.print(IAC_SHOW_CHARACTERS);
+    ssize_t len = recv(telnet_fds[id], buffer, size, 0);
+    if(len > 0) return len;
+    if(len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return 0;
+    return -1;
 }
 
-static inline void telnet_password_prompt()
+/* Returns the bytes sent, 0 when the socket buffer is full and -1 when the client is gone */
+static int telnet_backend_write(uint8_t id, const char* data, size_t len)
 {
-    telnetClient.print(IAC_SHOW_CHARACTERS D_PASSWORD " " IAC_HIDE_CHARACTERS);
+    ssize_t sent = send(telnet_fds[id], data, len, 0);
+    if(sent >= 0) return sent;
+    if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return 0;
+    return -1;
 }
 
-static inline void telnet_username_prompt()
+static void telnet_backend_close(uint8_t id)
 {
-    telnetClient.print(IAC_SHOW_CHARACTERS D_USERNAME " ");
+    close(telnet_fds[id]);
+    telnet_fds[id] = -1;
 }
 
-static void telnetClientDisconnect()
+/* Sleeps until a client sent something or TELNET_IO_PERIOD ms passed */
+static void telnet_backend_wait()
 {
-    if(telnetClient.connected())
-        LOG_TRACE(TAG_TELN, F(D_TELNET_CLOSING_CONNECTION), telnetClient.remoteIP().toString().c_str());
-    bufferedTelnetClient.flush(); // empty buffer
-    telnetClient.flush();         // empty buffer
+    struct pollfd fds[TELNET_MAX_CLIENTS + 1];
+    nfds_t num = 0;
 
-    Log.unregisterOutput(1); // telnetClient
-    telnetClient.stop();
+    if(telnet_listen_fd >= 0) fds[num++] = {telnet_listen_fd, POLLIN, 0};
+    for(uint8_t id = 0; id < TELNET_MAX_CLIENTS; id++)
+        if(telnet_fds[id] >= 0) fds[num++] = {telnet_fds[id], POLLIN, 0};
 
-    telnetLoginState   = TELNET_UNAUTHENTICATED;
-    telnetLoginAttempt = 0; // Initial attempt
-    delete telnetConsole;
-    telnetConsole = NULL;
+    poll(fds, num, TELNET_IO_PERIOD);
 }
 
-void telnetStop(void)
+#else // ESP32 and ESP8266
+
+static bool telnet_backend_listen(uint16_t port)
 {
-    telnetClientDisconnect();
+    if(!telnetServer) telnetServer = new WiFiServer(port);
+    if(!telnetServer) return false;
+
+    telnetServer->setNoDelay(true);
+    telnetServer->begin();
+    return true;
+}
+
+static void telnet_backend_unlisten()
+{
+    if(!telnetServer) return;
+    telnetServer->stop();
     delete telnetServer;
     telnetServer = NULL;
 }
 
-void telnetClientLogon()
+/* Accepts a waiting client into slot id, without a free slot (id == TELNET_MAX_CLIENTS) it is closed right away */
+static bool telnet_backend_accept(uint8_t id, char* remote, size_t size)
 {
-    debugPrintHaspHeader(&bufferedTelnetClient);
-    telnetLoginState   = TELNET_AUTHENTICATED; // User and Pass are correct
-    telnetLoginAttempt = 0;                    // Reset attempt counter
-                                               // telnetClient.setTimeout(10);
+    if(!telnetServer || !telnetServer->hasClient()) return false;
 
-    // empty buffers
-    bufferedTelnetClient.flush();
-    telnet_new_prompt("Prompt > ");
-    telnetClient.flush();
+    WiFiClient client = telnetServer->available();
+    if(id >= TELNET_MAX_CLIENTS) {
+        client.stop();
+        return true;
+    }
 
-    /* Now register logger for telnet and switch to buffered stream */
-    Log.registerOutput(1, &bufferedTelnetClient, LOG_LEVEL_VERBOSE, true);
-    LOG_TRACE(TAG_TELN, F(D_TELNET_CLIENT_LOGIN_FROM), telnetClient.remoteIP().toString().c_str());
+    client.setNoDelay(true);
+    strncpy(remote, client.remoteIP().toString().c_str(), size - 1);
+    remote[size - 1]  = 0;
+    telnetClients[id] = client;
+    return true;
 }
 
-void telnetAcceptClient()
+/* Returns the bytes received, 0 when there are none and -1 when the client is gone */
+static int telnet_backend_read(uint8_t id, char* buffer, size_t size)
 {
-    bufferedTelnetClient.flush(); // empty buffer
+    WiFiClient& client = telnetClients[id];
+
+    int available = client.available();
+    if(available > 0) return client.read((uint8_t*)buffer, (size_t)available < size ? available : size);
+    return client.connected() ? 0 : -1;
+}
+
+/* Returns the bytes sent, 0 when the socket buffer is full and -1 when the client is gone */
+static int telnet_backend_write(uint8_t id, const char* data, size_t len)
+{
+    WiFiClient& client = telnetClients[id];
+
+#if defined(ARDUINO_ARCH_ESP32)
+    // WiFiClient::write waits until all data is sent, the socket itself does not have to
+    int sent = send(client.fd(), data, len, MSG_DONTWAIT);
+    if(sent >= 0) return sent;
+    return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+#else
+    size_t room = client.availableForWrite();
+    if(room == 0) return client.connected() ? 0 : -1;
+    return client.write((const uint8_t*)data, len < room ? len : room);
+#endif
+}
+
+static void telnet_backend_close(uint8_t id)
+{
+    telnetClients[id].stop();
+}
+
+static void telnet_backend_wait()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    vTaskDelay(pdMS_TO_TICKS(TELNET_IO_PERIOD));
+#endif
+}
+
+#endif // POSIX
 
-    if(telnetClient) {
-        telnetClient.stop();     // previous client has disconnected
-        Log.unregisterOutput(1); // telnetClient
+/* ===== Io thread ===== */
+
+static void telnet_io_close(uint8_t id)
+{
+    telnet_backend_close(id);
+    telnet_sessions[id].slot = TELNET_SLOT_CLOSED;
+    telnet_rx[id].pos        = 0;
+    telnet_rx[id].len        = 0;
+}
+
+static void telnet_io_accept()
+{
+    uint8_t id = 0;
+    while(id < TELNET_MAX_CLIENTS && telnet_sessions[id].slot != TELNET_SLOT_FREE) id++;
+
+    char remote[sizeof(telnet_sessions[0].remote)] = "";
+    if(!telnet_backend_accept(id, remote, sizeof(remote))) return;
+
+    if(id >= TELNET_MAX_CLIENTS || !telnet_sessions[id].begin(remote)) {
+        if(id < TELNET_MAX_CLIENTS) telnet_backend_close(id); // out of memory
+        telnet_rejected++;
     }
-    telnetClient = telnetServer->available(); // ready for new client
-    if(!telnetClient) {
-        LOG_VERBOSE(TAG_TELN, F(D_TELNET_CLIENT_NOT_CONNECTED));
-        return;
+}
+
+static void telnet_io_receive(uint8_t id)
+{
+    TelnetSession& session = telnet_sessions[id];
+    telnet_rx_t& rx        = telnet_rx[id];
+
+    for(;;) {
+        if(rx.pos < rx.len) {
+            rx.pos += session.input(rx.data + rx.pos, rx.len - rx.pos);
+            if(session.line_ready || session.cancel) loop_wake(); // the main loop runs the line
+            if(rx.pos < rx.len) return; // a completed line waits for the main loop
+        }
+        if(session.line_ready || session.cancel) return;
+
+        int len = telnet_backend_read(id, rx.data, sizeof(rx.data));
+        if(len <= 0) {
+            if(len < 0) telnet_io_close(id);
+            return;
+        }
+        rx.pos = 0;
+        rx.len = len;
+    }
+}
+
+static void telnet_io_send(uint8_t id)
+{
+    TelnetSession& session = telnet_sessions[id];
+    const char* data;
+    size_t len;
+
+    while((len = session.peek(&data)) > 0) {
+        int sent = telnet_backend_write(id, data, len);
+        if(sent < 0) {
+            telnet_io_close(id);
+            return;
+        }
+        session.consume(sent);
+        if((size_t)sent < len) return; // the socket buffer is full, try again on the next pass
+    }
+}
+
+/* One pass over the server and all clients, returns false once the server is stopped */
+static bool telnet_io()
+{
+    TELNET_LOCK();
+
+    if(!telnet_running) {
+        for(uint8_t id = 0; id < TELNET_MAX_CLIENTS; id++)
+            if(telnet_sessions[id].slot != TELNET_SLOT_FREE && telnet_sessions[id].slot != TELNET_SLOT_CLOSED)
+                telnet_io_close(id);
+        telnet_backend_unlisten();
+        telnet_io_active = false;
+        return false;
+    }
+
+    telnet_io_accept();
+
+    for(uint8_t id = 0; id < TELNET_MAX_CLIENTS; id++) {
+        telnet_slot_t slot = telnet_sessions[id].slot;
+        if(slot == TELNET_SLOT_FREE || slot == TELNET_SLOT_CLOSED) continue;
+
+        if(slot != TELNET_SLOT_CLOSING) telnet_io_receive(id);
+        if(telnet_sessions[id].slot != TELNET_SLOT_CLOSED) telnet_io_send(id);
+        if(telnet_sessions[id].slot == TELNET_SLOT_CLOSING) telnet_io_close(id);
     }
-    LOG_INFO(TAG_TELN, F(D_TELNET_CLIENT_CONNECT_FROM), telnetClient.remoteIP().toString().c_str());
-    telnetClient.setNoDelay(true);
-    telnetClient.printf("\x1b]2;%s\x07" TERM_CLEAR_LINE, haspDevice.get_hostname());
-    telnetClient.println("\r\nWelcome\r\n");
 
-    /* Avoid a buffer here */
-    // telnetClient.print((char)0xFF); // DO TERMINAL-TYPE
-    // telnetClient.print((char)0xFD);
-    // telnetClient.print((char)0x1B);
+    return true;
+}
 
+#if defined(ARDUINO_ARCH_ESP32)
+static void telnet_task(void* arg)
+{
+    while(telnet_io()) telnet_backend_wait();
+    vTaskDelete(NULL);
+}
+#elif defined(POSIX)
+static void telnet_thread(void* arg)
+{
+    while(telnet_io()) telnet_backend_wait();
+}
+#endif
+
+/* ===== Sessions, only used by the main loop ===== */
+
+static bool telnet_login_required()
+{
 #if HASP_USE_HTTP > 0 || HASP_USE_HTTP_ASYNC > 0
-    if(strlen(http_config.username) != 0 || strlen(http_config.password) != 0) {
-        telnetLoginState = TELNET_UNAUTHENTICATED;
-        telnetClient.println();
-        telnet_username_prompt();
-    } else
+    return strlen(http_config.username) != 0 || strlen(http_config.password) != 0;
+#else
+    return false;
 #endif
-    {
-        telnetClientLogon();
+}
+
+static const char* telnet_prompt(uint8_t login)
+{
+    switch(login) {
+        case TELNET_AUTHENTICATED:
+            return "Prompt > ";
+        case TELNET_USERNAME_OK:
+        case TELNET_USERNAME_NOK:
+            return D_PASSWORD " ";
+        default:
+            return D_USERNAME " ";
     }
+}
+
+static void telnet_print(uint8_t id, const char* text)
+{
+    TELNET_LOCK();
+    telnet_sessions[id].write(text);
+}
+
+static void telnet_set_login(uint8_t id, uint8_t login)
+{
+    TELNET_LOCK();
+    TelnetSession& session = telnet_sessions[id];
 
-    telnetClient.flush();
-    telnetLoginAttempt = 0; // Initial attempt
+    session.login = login;
+    session.echo  = login != TELNET_USERNAME_OK && login != TELNET_USERNAME_NOK; // hide the password
+    session.hide_prompt();
+    session.show_prompt(telnet_prompt(login));
 }
 
-#if 0
-static inline void telnetProcessLine()
+static void telnet_close(uint8_t id)
 {
-    telnetInputBuffer[telnetInputIndex] = 0; // null terminate our char array
+    TELNET_LOCK();
+    if(telnet_sessions[id].slot == TELNET_SLOT_OPEN) telnet_sessions[id].slot = TELNET_SLOT_CLOSING;
+}
 
-    switch(telnetLoginState) {
-        case TELNET_UNAUTHENTICATED: {
-            telnetClient.printf(PSTR(D_PASSWORD" %c%c%c"), 0xFF, 0xFB, 0x01); // Hide characters
+static void telnet_logon(uint8_t id, const char* remote)
+{
+    LOG_TRACE(TAG_TELN, F(D_TELNET_CLIENT_LOGIN_FROM), remote);
+    {
+        TELNET_LOCK();
+        telnet_sessions[id].attempts = 0;
+    }
+    telnet_set_login(id, TELNET_AUTHENTICATED);
+}
+
+static void telnet_greet(uint8_t id, const char* remote)
+{
+    char buffer[128];
+    snprintf_P(buffer, sizeof(buffer), PSTR(IAC_CHARACTER_MODE "\x1b]2;%s\x07\r\nWelcome to %s %s\r\n\r\n"),
+               haspDevice.get_hostname(), haspDevice.get_hostname(), haspDevice.get_version());
+    telnet_print(id, buffer);
+
+    LOG_INFO(TAG_TELN, F(D_TELNET_CLIENT_CONNECT_FROM), remote);
+    if(telnet_login_required())
+        telnet_set_login(id, TELNET_UNAUTHENTICATED);
+    else
+        telnet_logon(id, remote);
+}
+
+static void telnet_process_line(uint8_t id, uint8_t login, const char* input, const char* remote)
+{
+    switch(login) {
+        case TELNET_UNAUTHENTICATED:
 #if HASP_USE_HTTP > 0 || HASP_USE_HTTP_ASYNC > 0
-            telnetLoginState = strcmp(telnetInputBuffer, http_config.username) == 0 ? TELNET_USERNAME_OK : TELNET_USERNAME_NOK;
+            telnet_set_login(id, strcmp(input, http_config.username) == 0 ? TELNET_USERNAME_OK : TELNET_USERNAME_NOK);
             break;
-        }
+
         case TELNET_USERNAME_OK:
-        case TELNET_USERNAME_NOK: {
-            telnetClient.printf(PSTR("%c%c%c\n"), 0xFF, 0xFC, 0x01); // Show characters
-            if(telnetLoginState == TELNET_USERNAME_OK && strcmp(telnetInputBuffer, http_config.password) == 0) {
-                telnetClientLogon();
-            } else {
-                telnetLoginState = TELNET_UNAUTHENTICATED;
-                telnetLoginAttempt++; // Subsequent attempt
-                telnetClient.println(F(D_NETWORK_CONNECTION_UNAUTHORIZED"\r\n"));
-                LOG_WARNING(TAG_TELN, F(D_TELNET_INCORRECT_LOGIN_ATTEMPT), telnetClient.remoteIP().toString().c_str());
-                if(telnetLoginAttempt >= 3) {
-                    telnetClientDisconnect();
-                } else {
-                    telnetClient.print(F(D_USERNAME" "));
-                }
+        case TELNET_USERNAME_NOK:
+            if(login == TELNET_USERNAME_OK && strcmp(input, http_config.password) == 0) {
+                telnet_logon(id, remote);
+                break;
             }
+
+            telnet_print(id, D_NETWORK_CONNECTION_UNAUTHORIZED "\r\n\r\n");
+            bool locked_out;
+            {
+                TELNET_LOCK();
+                locked_out = ++telnet_sessions[id].attempts >= TELNET_MAX_ATTEMPTS;
+            }
+            if(locked_out)
+                telnet_close(id);
+            else
+                telnet_set_login(id, TELNET_UNAUTHENTICATED);
+            LOG_WARNING(TAG_TELN, F(D_TELNET_INCORRECT_LOGIN_ATTEMPT), remote);
 #else
-            telnetClientLogon();
+            telnet_logon(id, remote);
 #endif
             break;
-        }
+
         default:
-            if(telnetInputIndex > 0) {
-                if(strcasecmp_P(telnetInputBuffer, PSTR("exit")) == 0) {
-                    telnetClientDisconnect();
-                } else {
-                    dispatchTextLine(telnetInputBuffer);
-                }
+            if(strcasecmp_P(input, PSTR("exit")) == 0 || strcasecmp_P(input, PSTR("quit")) == 0 ||
+               strcasecmp_P(input, PSTR("bye")) == 0) {
+                telnet_close(id);
+            } else if(strcasecmp_P(input, PSTR("logoff")) == 0) {
+                if(telnet_login_required())
+                    telnet_set_login(id, TELNET_UNAUTHENTICATED);
+                else
+                    telnet_close(id);
+            } else {
+                if(*input) dispatch_text_line(input, TAG_TELN);
+                telnet_update_prompt();
             }
     }
-
-    telnetInputIndex = 0; // reset input buffer index
 }
 
-static inline void telnetProcessData(char ch)
+static void telnet_service(uint8_t id)
 {
+    TelnetSession& session = telnet_sessions[id];
+    char line[TELNET_LINE_SIZE];
+    char remote[sizeof(session.remote)];
+    telnet_slot_t slot;
+    uint8_t login;
+    uint32_t dropped;
+    bool has_line;
+    bool cancel;
 
-    switch(ch) {
-        case 10: // Linefeed
-            telnetInputIndex = 0;
-            break;
-        case 8: // Backspace
-            if(telnetInputIndex > 0) telnetInputIndex--;
-            break;
-        case 13: // Carriage Return
-            telnetProcessLine("");
+    {
+        TELNET_LOCK();
+        slot = session.slot;
+        if(slot == TELNET_SLOT_FREE || slot == TELNET_SLOT_CLOSING) return;
+
+        strcpy(remote, session.remote);
+        login    = session.login;
+        dropped  = session.dropped;
+        cancel   = slot == TELNET_SLOT_OPEN && session.cancel;
+        has_line = slot == TELNET_SLOT_OPEN && session.line_ready;
+        if(has_line) {
+            strcpy(line, session.line());
+            session.take_line();
+        }
+
+        if(slot == TELNET_SLOT_CONNECTED) {
+            session.slot = TELNET_SLOT_OPEN;
+        } else if(slot == TELNET_SLOT_CLOSED) {
+            session.end();
+            session.slot = TELNET_SLOT_FREE;
+        }
+    }
+
+    switch(slot) {
+        case TELNET_SLOT_CONNECTED:
+            telnet_greet(id, remote);
             break;
-        case 32 ... 250:
-            if(!isprint(ch)) {
-                telnetClient.printf(PSTR(" 0x%02x "), ch);
-            }
-            // If we have room left in our buffer add the current byte
-            if(telnetInputIndex < sizeof(telnetInputBuffer) - 1) {
-                telnetInputBuffer[telnetInputIndex++] = ch;
+
+        case TELNET_SLOT_CLOSED:
+            LOG_TRACE(TAG_TELN, F(D_TELNET_CLOSING_CONNECTION), remote);
+            if(dropped) {
+                LOG_VERBOSE(TAG_TELN, F("Dropped %u bytes of output to %s"), dropped, remote);
             }
+            break;
+
+        default:
+            if(cancel)
+                telnet_close(id);
+            else if(has_line)
+                telnet_process_line(id, login, line, remote);
     }
+}
+
+/* ===== Log output ===== */
+
+/* Queues log output to every logged in session, never blocks */
+void telnet_log_write(const char* data, size_t len)
+{
+    TELNET_LOCK();
+    for(uint8_t id = 0; id < TELNET_MAX_CLIENTS; id++) {
+        TelnetSession& session = telnet_sessions[id];
+        if(session.slot != TELNET_SLOT_OPEN || session.login != TELNET_AUTHENTICATED) continue;
 
-    // Properly terminate buffer string
-    if(telnetInputIndex < sizeof(telnetInputBuffer)) {
-        telnetInputBuffer[telnetInputIndex] = 0;
+        session.hide_prompt();
+        session.write(data, len);
     }
 }
 
-static inline void telnetProcessCharacter(char ch)
+/* Redraws the prompt and the line being typed below the last log line */
+void telnet_update_prompt()
 {
-    // if(ch == (char)0xff || telnetInCommandMode) {
-    //    telnetProcessCharacter(ch);
-    //} else {
-    telnetProcessData(ch);
-    //}
+    TELNET_LOCK();
+    for(uint8_t id = 0; id < TELNET_MAX_CLIENTS; id++) {
+        TelnetSession& session = telnet_sessions[id];
+        if(session.slot == TELNET_SLOT_OPEN && session.login == TELNET_AUTHENTICATED)
+            session.show_prompt(telnet_prompt(session.login));
+    }
 }
 
+#if HASP_TARGET_ARDUINO
+class TelnetLogOutput : public Print {
+  public:
+    size_t write(uint8_t c) override
+    {
+        telnet_log_write((const char*)&c, 1);
+        return 1;
+    }
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        telnet_log_write((const char*)buffer, size);
+        return size;
+    }
+};
+static TelnetLogOutput telnetLogOutput;
 #endif
 
-static void telnetProcessLine(const char* input)
-{
-    bufferedTelnetClient.flush();
+/* ===== Default Event Processors ===== */
 
-    switch(telnetLoginState) {
-        case TELNET_UNAUTHENTICATED: {
+void telnetStart()
+{
+    if(!telnetEnabled) return;
 
-#if HASP_USE_HTTP > 0 || HASP_USE_HTTP_ASYNC > 0
-            bool username_is_valid = strcmp(input, http_config.username) == 0;
-            telnetLoginState       = username_is_valid ? TELNET_USERNAME_OK : TELNET_USERNAME_NOK;
-            telnet_password_prompt();
-            break;
-        }
-        case TELNET_USERNAME_OK:
-        case TELNET_USERNAME_NOK: {
-            bool password_is_valid = strcmp(input, http_config.password) == 0;
-            if(telnetConsole) telnetConsole->clearLine();
-            telnet_echo_on(); // Show characters
+    {
+        TELNET_LOCK();
+        if(telnet_running || telnet_io_active) return;
+    }
 
-            if(telnetLoginState == TELNET_USERNAME_OK && password_is_valid) {
-                telnetClientLogon();
-            } else {
-                telnetLoginState = TELNET_UNAUTHENTICATED;
-                telnetLoginAttempt++; // Subsequent attempt
-                LOG_WARNING(TAG_TELN, F(D_TELNET_INCORRECT_LOGIN_ATTEMPT), telnetClient.remoteIP().toString().c_str());
+    if(!telnet_backend_listen(telnetPort)) {
+        LOG_ERROR(TAG_TELN, F(D_TELNET_FAILED));
+        return;
+    }
 
-                telnetClient.println(F(D_NETWORK_CONNECTION_UNAUTHORIZED));
+    {
+        TELNET_LOCK();
+        telnet_running   = true;
+        telnet_io_active = true;
+    }
 
-                if(telnetLoginAttempt >= 3) {
-                    telnetClientDisconnect();
-                } else {
-                    telnetClient.println(F("\r\n\r\n" D_USERNAME " "));
-                }
-            }
-#else
-            telnetClientLogon();
-#endif
-            break;
+#if defined(ARDUINO_ARCH_ESP32)
+    if(xTaskCreate(telnet_task, "telnetTask", 1024 * 3, NULL, 1, NULL) != pdPASS) {
+        {
+            TELNET_LOCK();
+            telnet_running   = false;
+            telnet_io_active = false;
         }
-        default:
-            if(strcasecmp_P(input, PSTR("exit")) == 0 || strcasecmp_P(input, PSTR("quit")) == 0 ||
-               strcasecmp_P(input, PSTR("bye")) == 0) {
-                telnetClientDisconnect();
-            } else if(strcasecmp_P(input, PSTR("logoff")) == 0) {
-#if HASP_USE_HTTP > 0 || HASP_USE_HTTP_ASYNC > 0
-                if(strcmp(input, http_config.password) == 0) {
-                    telnet_username_prompt();
-                    telnetLoginState = TELNET_UNAUTHENTICATED;
-                } else
-#endif
-                {
-                    telnetClientDisconnect();
-                }
-            } else {
-                dispatch_text_line(input, TAG_TELN);
-            }
+        telnet_backend_unlisten();
+        LOG_ERROR(TAG_TELN, F(D_TELNET_FAILED));
+        return;
     }
+#elif defined(POSIX)
+    haspDevice.run_thread(telnet_thread, NULL, "telnet");
+#endif
 
-    telnetClient.flush();
+#if HASP_TARGET_ARDUINO
+    Log.registerOutput(1, &telnetLogOutput, LOG_LEVEL_VERBOSE, true);
+#endif
+    LOG_INFO(TAG_TELN, F(D_TELNET_STARTED " (port %u)"), telnetPort);
 }
 
-void telnetStart()
+void telnetStop(void)
 {
-    // telnetSetConfig(settings);
-
-    if(telnetEnabled) { // Setup telnet server for remote debug output
-#if defined(STM32F4xx)
-        // if(!telnetServer) telnetServer = new EthernetServer(telnetPort);
-        // if(telnetServer) {
-        telnetServer->begin();
-        LOG_INFO(TAG_TELN, F(D_TELNET_STARTED));
-        // } else {
-        //    LOG_ERROR(TAG_TELN,F("Failed to start telnet server"));
-        //}
+#if HASP_TARGET_ARDUINO
+    Log.unregisterOutput(1); // telnet sessions
+#endif
+
+    {
+        TELNET_LOCK();
+        telnet_running = false;
+    }
+
+#if defined(ARDUINO_ARCH_ESP8266)
+    telnet_io(); // closes the clients and the server
 #else
-        if(!telnetServer) telnetServer = new WiFiServer(telnetPort);
-        if(telnetServer) {
-            telnetServer->setNoDelay(true);
-            telnetServer->begin();
-
-            // telnetConsole = new ConsoleInput(&telnetClient, HASP_CONSOLE_BUFFER);
-            // if(telnetConsole != NULL) {
-            //     telnetConsole->setLineCallback(telnetProcessLine);
-            //     LOG_INFO(TAG_TELN, F(D_TELNET_STARTED));
-            //     return;
-            // }
-            LOG_INFO(TAG_TELN, F(D_TELNET_STARTED));
-        } else {
-            LOG_ERROR(TAG_TELN, F(D_TELNET_FAILED));
+    for(;;) { // wait for the io thread to close the clients and the server
+        {
+            TELNET_LOCK();
+            if(!telnet_io_active) break;
         }
-#endif
+        delay(1);
     }
+#endif
+
+    for(uint8_t id = 0; id < TELNET_MAX_CLIENTS; id++) telnet_service(id); // release the closed sessions
 }
 
 void telnetSetup()
@@ -342,86 +651,26 @@ void telnetSetup()
 
 IRAM_ATTR void telnetLoop()
 {
-    // Basic telnet client handling code from: https://gist.github.com/tablatronix/4793677ca748f5f584c95ec4a2b10303
-
-#if defined(STM32F4xx)
-    Ethernet.schedule();
-    // if(telnetServer)
-    { // client is connected
-        EthernetClient client = telnetServer->available();
-        if(client) {
-            if(!telnetClient || !telnetClient.connected()) {
-                // telnetAcceptClient(client);
-
-                telnetClient = client; // ready for new client
-                // LOG_TRACE(TAG_TELN,F("Client connected from %s"), telnetClient.remoteIP().toString().c_str());
-                if(!telnetClient) {
-                    LOG_WARNING(TAG_TELN, F(D_TELNET_CLIENT_NOT_CONNECTED));
-                    return;
-                }
-                LOG_TRACE(TAG_TELN, F(D_TELNET_CLIENT_CONNECTED));
-
-                /* Avoid a buffer here */
-                // telnetClient.print(0xFF); // DO TERMINAL-TYPE
-                // telnetClient.print(0xFD);
-                // telnetClient.print(0x1B);
-
-            } else {
-                // client.stop(); // have client, block new connections
-            }
-        }
-    }
-#else
-
-    /* Active Client: Process user input */
-    if(telnetClient.connected()) {
-        if(telnetConsole) {
-            while(int16_t key = telnetConsole->readKey()) {
-                switch(key) {
-                    case 0xf8:
-                    case KEY_CTRL('C'): // 0x03 = ^C = Cancel (Quit)
-                        telnetClientDisconnect();
-                        break;
-
-                    case 0xec:
-                    case KEY_CTRL('D'): // ^D = Disconnect (Logout)
-                        LOG_DEBUG(TAG_TELN, "Ctrl-D");
-                        break;
-                }
-                if(!telnetConsole) return; // the telnetConsole was destroyed
-                if(bufferedTelnetClient.available() <= 0) bufferedTelnetClient.flush(); // flush pending updates
-            };
-
-        } else {
-            telnetConsole = new ConsoleInput(&bufferedTelnetClient, HASP_CONSOLE_BUFFER);
-            if(telnetConsole) {
-                telnetConsole->setLineCallback(telnetProcessLine);
-#ifdef HASP_DEBUG
-                telnetConsole->setDebug(true);
+#if defined(ARDUINO_ARCH_ESP8266)
+    if(telnet_running) telnet_io();
 #endif
-            } else {
-                telnetClientDisconnect();
-                LOG_ERROR(TAG_TELN, F(D_TELNET_FAILED));
-            }
-        }
-    }
 
-#endif
+    for(uint8_t id = 0; id < TELNET_MAX_CLIENTS; id++) telnet_service(id);
 }
 
 void telnetEverySecond(void)
 {
-    if(!telnetClient.connected() && telnetLoginState != TELNET_UNAUTHENTICATED) {
-        telnetClientDisconnect(); // active client disconnected
+    static uint16_t reported = 0;
+    uint16_t rejected;
+
+    {
+        TELNET_LOCK();
+        rejected = telnet_rejected;
     }
 
-    if(telnetServer && telnetServer->hasClient()) { // a new client has connected
-        if(!telnetClient.connected()) {             // nobody is already connected
-            telnetAcceptClient();                   // allow the new client
-        } else {
-            LOG_WARNING(TAG_TELN, F(D_TELNET_CLIENT_REJECTED));
-            telnetServer->available().stop(); // already have a client, block new connections
-        }
+    if(rejected != reported) {
+        reported = rejected;
+        LOG_WARNING(TAG_TELN, F(D_TELNET_CLIENT_REJECTED));
     }
 }
 
@@ -460,4 +709,4 @@ bool telnetSetConfig(const JsonObject& settings)
 }
 #endif // HASP_USE_CONFIG
 
-#endif
\ No newline at end of file
+#endif
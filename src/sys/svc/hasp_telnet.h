@@ -7,6 +7,11 @@
 #if HASP_USE_TELNET > 0
 
 #include "hasplib.h"
+#include "hasp_telnet_session.h"
+
+#ifndef TELNET_PORT
+#define TELNET_PORT 23
+#endif
 
 /* ===== Default Event Processors ===== */
 void telnetSetup();
@@ -18,6 +23,7 @@ void telnetStop(void);
 
 /* ===== Special Event Processors ===== */
 void telnet_update_prompt();
+void telnet_log_write(const char* data, size_t len);
 
 /* ===== Getter and Setter Functions ===== */
 
@@ -27,10 +33,5 @@ bool telnetSetConfig(const JsonObject& settings);
 bool telnetGetConfig(const JsonObject& settings);
 #endif
 
-#define TELNET_UNAUTHENTICATED 0
-#define TELNET_USERNAME_OK 10
-#define TELNET_USERNAME_NOK 99
-#define TELNET_AUTHENTICATED 255
-
 #endif
 #endif
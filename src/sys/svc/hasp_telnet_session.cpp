@@ -0,0 +1,189 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hasp_telnet_session.h"
+
+#define TELNET_IAC 255
+#define TELNET_SB 250
+#define TELNET_SE 240
+#define TELNET_WILL 251
+#define TELNET_DONT 254
+
+enum {
+    IAC_NONE = 0,
+    IAC_COMMAND,    // got IAC
+    IAC_OPTION,     // got IAC WILL/WONT/DO/DONT
+    IAC_SUB,        // inside a subnegotiation
+    IAC_SUB_COMMAND // got IAC inside a subnegotiation
+};
+
+bool TelnetSession::begin(const char* address)
+{
+    if(!queue) queue = (char*)malloc(TELNET_QUEUE_SIZE);
+    if(!queue) return false;
+
+    slot         = TELNET_SLOT_CONNECTED;
+    login        = TELNET_UNAUTHENTICATED;
+    attempts     = 0;
+    echo         = true;
+    line_ready   = false;
+    prompt_shown = false;
+    cancel       = false;
+    dropped      = 0;
+    queued       = 0;
+    head         = 0;
+    count        = 0;
+    length       = 0;
+    iac          = IAC_NONE;
+    got_cr       = false;
+    buffer[0]    = 0;
+
+    strncpy(remote, address, sizeof(remote) - 1);
+    remote[sizeof(remote) - 1] = 0;
+    return true;
+}
+
+void TelnetSession::end()
+{
+    free(queue);
+    queue = NULL;
+    count = 0;
+}
+
+size_t TelnetSession::write(const char* data, size_t len)
+{
+    if(!queue || len > TELNET_QUEUE_SIZE - count) {
+        dropped += len;
+        return 0;
+    }
+
+    size_t tail  = (head + count) % TELNET_QUEUE_SIZE;
+    size_t first = TELNET_QUEUE_SIZE - tail;
+    if(first > len) first = len;
+    memcpy(queue + tail, data, first);
+    memcpy(queue, data + first, len - first);
+
+    count += len;
+    queued += len;
+    return len;
+}
+
+size_t TelnetSession::write(const char* text)
+{
+    return write(text, strlen(text));
+}
+
+/* The oldest queued bytes that are contiguous in the ring buffer */
+size_t TelnetSession::peek(const char** data) const
+{
+    size_t len = TELNET_QUEUE_SIZE - head;
+    if(len > count) len = count;
+    *data = queue + head;
+    return len;
+}
+
+void TelnetSession::consume(size_t len)
+{
+    if(len > count) len = count;
+    head = (head + len) % TELNET_QUEUE_SIZE;
+    count -= len;
+}
+
+/* Returns the number of bytes used, input stops after a completed line until the main loop took it */
+size_t TelnetSession::input(const char* data, size_t len)
+{
+    size_t i = 0;
+
+    while(i < len && !line_ready && !cancel) {
+        uint8_t c = data[i++];
+
+        switch(iac) {
+            case IAC_COMMAND:
+                if(c >= TELNET_WILL && c <= TELNET_DONT)
+                    iac = IAC_OPTION;
+                else if(c == TELNET_SB)
+                    iac = IAC_SUB;
+                else
+                    iac = IAC_NONE; // two-byte command or an escaped 0xFF, neither is a character we use
+                continue;
+            case IAC_OPTION:
+                iac = IAC_NONE;
+                continue;
+            case IAC_SUB:
+                if(c == TELNET_IAC) iac = IAC_SUB_COMMAND;
+                continue;
+            case IAC_SUB_COMMAND:
+                iac = c == TELNET_SE ? IAC_NONE : IAC_SUB;
+                continue;
+        }
+
+        if(got_cr) {
+            got_cr = false;
+            if(c == '\n' || c == 0) continue; // CR LF and CR NUL end a single line
+        }
+
+        switch(c) {
+            case TELNET_IAC:
+                iac = IAC_COMMAND;
+                break;
+
+            case '\r':
+                got_cr = true;
+                // fall through
+            case '\n':
+                buffer[length] = 0;
+                line_ready     = true;
+                prompt_shown   = false;
+                write("\r\n", 2);
+                break;
+
+            case 0x08: // Backspace
+            case 0x7f: // Delete
+                if(length > 0) {
+                    length--;
+                    if(echo) write("\b \b", 3);
+                }
+                break;
+
+            case 0x03: // Ctrl-C
+                cancel = true;
+                break;
+
+            default:
+                if(c < 0x20 || length >= sizeof(buffer) - 1) break;
+                buffer[length++] = c;
+                if(echo) write((const char*)&c, 1);
+        }
+    }
+
+    return i;
+}
+
+void TelnetSession::take_line()
+{
+    line_ready = false;
+    length     = 0;
+    buffer[0]  = 0;
+}
+
+/* Shows the prompt followed by the line being edited */
+void TelnetSession::show_prompt(const char* prompt)
+{
+    if(prompt_shown || line_ready) return;
+
+    write(prompt);
+    if(echo) write(buffer, length);
+    prompt_shown = true;
+}
+
+/* Clears the prompt line so output can be written in its place */
+void TelnetSession::hide_prompt()
+{
+    if(!prompt_shown) return;
+
+    write("\r\x1b[0K", 5);
+    prompt_shown = false;
+}
@@ -0,0 +1,91 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_TELNET_SESSION_H
+#define HASP_TELNET_SESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TELNET_MAX_CLIENTS
+#define TELNET_MAX_CLIENTS 3 // concurrent telnet sessions
+#endif
+
+#ifndef TELNET_QUEUE_SIZE
+#define TELNET_QUEUE_SIZE 2048 // bytes of output queued per session before output is dropped
+#endif
+
+#ifndef TELNET_LINE_SIZE
+#ifdef HASP_CONSOLE_BUFFER
+#define TELNET_LINE_SIZE HASP_CONSOLE_BUFFER
+#else
+#define TELNET_LINE_SIZE 256 // maximum length of a command line
+#endif
+#endif
+
+#define TELNET_UNAUTHENTICATED 0
+#define TELNET_USERNAME_OK 10
+#define TELNET_USERNAME_NOK 99
+#define TELNET_AUTHENTICATED 255
+
+enum telnet_slot_t : uint8_t {
+    TELNET_SLOT_FREE = 0,
+    TELNET_SLOT_CONNECTED, // accepted by the io thread, not yet greeted by the main loop
+    TELNET_SLOT_OPEN,
+    TELNET_SLOT_CLOSING, // the main loop ended the session, remaining output is sent before closing
+    TELNET_SLOT_CLOSED,  // the socket is closed, the main loop still has to release the slot
+};
+
+/* One telnet client
+ *
+ * The io thread feeds the received bytes to input(), which does the line editing and the echo, and sends what
+ * write() queued. The main loop takes the completed lines and writes the responses and the log output. The output
+ * queue is a ring buffer of TELNET_QUEUE_SIZE bytes: a write that does not fit is dropped as a whole and counted,
+ * so a slow client never blocks the writer. The session does no locking, the owner serializes all calls.
+ */
+class TelnetSession {
+  public:
+    telnet_slot_t slot = TELNET_SLOT_FREE;
+    uint8_t login      = TELNET_UNAUTHENTICATED; // TELNET_* login state
+    uint8_t attempts   = 0;                      // failed logins
+    bool echo          = true;                   // false while typing a password
+    bool line_ready    = false;                  // line() holds a completed line for the main loop
+    bool prompt_shown  = false;                  // the prompt is on the last line of the terminal
+    bool cancel        = false;                  // Ctrl-C was pressed
+    char remote[48];                             // address of the client
+    uint32_t dropped = 0;                        // output bytes dropped because the client did not keep up
+    uint32_t queued  = 0;                        // output bytes queued
+
+    bool begin(const char* address);
+    void end();
+
+    size_t write(const char* data, size_t len);
+    size_t write(const char* text);
+    size_t pending() const
+    {
+        return count;
+    }
+    size_t peek(const char** data) const;
+    void consume(size_t len);
+
+    size_t input(const char* data, size_t len);
+    const char* line() const
+    {
+        return buffer;
+    }
+    void take_line();
+    void show_prompt(const char* prompt);
+    void hide_prompt();
+
+  private:
+    char* queue  = NULL; // ring buffer of TELNET_QUEUE_SIZE bytes
+    size_t head  = 0;    // index of the oldest byte
+    size_t count = 0;    // bytes in the queue
+
+    char buffer[TELNET_LINE_SIZE];
+    size_t length = 0; // length of the line being edited
+    uint8_t iac   = 0; // state of the telnet command parser
+    bool got_cr   = false;
+};
+
+#endif // HASP_TELNET_SESSION_H
@@ -0,0 +1,28 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Checks shared by the host tests, each test is a program of its own, see the Makefile */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+static size_t errors = 0; // failed checks, a test with errors exits with 1
+
+static inline void host_check(bool ok, const char* what)
+{
+    if(ok) return;
+    printf("  FAILED: %s\n", what);
+    errors++;
+}
+
+/* Reports the failed checks and returns the exit code of the test */
+static inline int host_result()
+{
+    printf("%zu errors\n", errors);
+    return errors ? 1 : 0;
+}
+
+#endif // HOST_TEST_H
@@ -0,0 +1,13 @@
+/* Minimal stand-in so qrcodegen.cpp builds on the host */
+#ifndef ARDUINO_H_STUB
+#define ARDUINO_H_STUB
+
+#include <stdint.h>
+
+#include <stdio.h>
+
+#define PROGMEM
+#define pgm_read_byte_near(addr) (*(const uint8_t*)(addr))
+#define snprintf_P snprintf
+
+#endif
@@ -0,0 +1,42 @@
+/* Minimal stand-in so hasp_plugin.cpp and hasp_mem.cpp build on the host, the clock and the log are provided by test_plugin.cpp */
+#ifndef HASPLIB_H_STUB
+#define HASPLIB_H_STUB
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+
+#define F(x) (x)
+#define PSTR(x) (x)
+#define snprintf_P snprintf
+#define TAG_CUSTOM 0
+
+#define LOG_TRACE(tag, ...) ((void)0)
+#define LOG_INFO(tag, ...) ((void)0)
+#define LOG_WARNING(tag, ...) bench_warning(__VA_ARGS__)
+
+uint32_t millis();
+uint32_t micros();
+void bench_warning(const char* format, ...);
+
+struct JsonDocument
+{
+    std::map<std::string, int> sensors;
+};
+
+struct JsonObject
+{
+    std::map<std::string, std::string> values;
+    std::string& operator[](const char* key)
+    {
+        return values[key];
+    }
+};
+
+#define HASP_USE_CUSTOM 1
+#include "my_custom_template.h"
+
+#endif
@@ -0,0 +1,203 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host check of the sysfs backlight
+ *
+ * A fake /sys/class/backlight device is made in a temporary folder. A slider is dragged for two seconds, sending a
+ * level every 10 ms, then a one second fade steps every 30 ms while the display task flushes every 30 ms. The
+ * writes are counted and compared with what opening the file for every change did before, the file must hold the
+ * last level at the end. A backlight with 7 steps and a driver that clamps the minimum check the level read back.
+ * Last a missing device must be retried on a backoff and a failed write must keep its level pending.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "host_test.h"
+#include "hasp_posix_backlight.h"
+
+#define BENCH_FRAME 30 // ms, LV_DISP_DEF_REFR_PERIOD
+
+using dev::PosixBacklight;
+
+static void bench_write_file(const std::string& path, const char* value)
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if(!file) return;
+    fputs(value, file);
+    fclose(file);
+}
+
+/* A sysfs store only parses up to the newline, leftovers of a longer earlier write don't matter */
+static int bench_read_file(const std::string& path)
+{
+    char buffer[32] = {0};
+    FILE* file      = fopen(path.c_str(), "r");
+    if(!file) return -1;
+    if(!fgets(buffer, sizeof(buffer), file)) buffer[0] = 0;
+    fclose(file);
+    return atoi(buffer);
+}
+
+static std::string bench_device(const char* root, const char* name, const char* max, bool mirror)
+{
+    std::string path = std::string(root) + "/" + name;
+    mkdir(path.c_str(), 0755);
+    bench_write_file(path + "/max_brightness", max);
+    bench_write_file(path + "/brightness", "0\n");
+    if(mirror) {
+        symlink("brightness", (path + "/actual_brightness").c_str()); // the driver reports what was written
+    } else {
+        bench_write_file(path + "/actual_brightness", "0\n");
+    }
+    return path;
+}
+
+/* The device code: the display task flushes once per frame while there is a change */
+struct bench_panel_t
+{
+    PosixBacklight backlight;
+    bool task = false;
+    uint32_t frames_written;
+
+    void set_level(uint8_t level)
+    {
+        backlight.set_level(level);
+        if(backlight.pending()) task = true;
+    }
+
+    void frame()
+    {
+        if(!task) return;
+        if(backlight.flush()) {
+            frames_written++;
+        } else {
+            task = false;
+        }
+    }
+};
+
+int main()
+{
+    char root[] = "/tmp/backlight_benchXXXXXX";
+    if(!mkdtemp(root)) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    // Slider and fade on a 10 bit PWM backlight
+    std::string path = bench_device(root, "pwm", "1023\n", true);
+    bench_panel_t panel;
+    host_check(panel.backlight.open(path, 0, 0) && panel.backlight.get_max() == 1023, "opened, max_brightness read");
+
+    uint32_t changes = 0, frames = 0;
+    uint8_t last     = 0;
+    for(uint32_t t = 0; t < 3000; t += 10) {
+        uint8_t level;
+        if(t < 2000) {
+            level = 20 + (t * 211 / 2000); // slider, 10 ms per touch event
+        } else if(t % BENCH_FRAME == 0) {
+            level = 231 - (t - 2000) * 200 / 1000; // fade, one step per task run
+        } else {
+            level = last;
+        }
+        if(level != last) {
+            panel.set_level(level);
+            last = level;
+            changes++;
+        }
+        if(t % BENCH_FRAME == 0) {
+            panel.frame();
+            frames++;
+        }
+    }
+    panel.frame();
+    panel.frame();
+
+    uint32_t writes = panel.backlight.get_writes();
+    printf("pwm: %u level changes in %u frames, before %u open+write+close, now %u writes\n", changes, frames,
+           changes, writes);
+    host_check(writes <= frames + 1, "at most one write per frame");
+    host_check(writes < changes / 2, "slider changes coalesced");
+    host_check(bench_read_file(path + "/brightness") == (last * 1023 + 127) / 255, "last level written");
+    host_check(panel.backlight.get_level() == last, "level read back");
+    host_check(!panel.task && !panel.backlight.pending(), "task stops when idle");
+
+    uint32_t before = panel.backlight.get_writes();
+    panel.set_level(last);
+    panel.frame();
+    host_check(panel.backlight.get_writes() == before, "same level not written again");
+
+    // 7 steps, the level the panel shows is rounded
+    path = bench_device(root, "steps", "7\n", true);
+    bench_panel_t steps;
+    steps.backlight.open(path, 0, 0);
+    steps.set_level(100);
+    host_check(steps.backlight.get_level() == 109, "rounded level known before the write");
+    steps.frame();
+    host_check(bench_read_file(path + "/brightness") == 3, "7 step raw value");
+    host_check(steps.backlight.get_level() == 109, "rounded level read back");
+
+    before = steps.backlight.get_writes();
+    for(uint8_t level = 100; level < 115; level++) steps.set_level(level); // all map to step 3
+    steps.frame();
+    host_check(steps.backlight.get_writes() == before, "levels within a step not written");
+
+    // A driver that keeps the panel lit at its minimum
+    path = bench_device(root, "clamped", "255\n", false);
+    bench_panel_t clamped;
+    clamped.backlight.open(path, 0, 0);
+    bench_write_file(path + "/actual_brightness", "12\n");
+    clamped.set_level(3);
+    clamped.frame();
+    host_check(bench_read_file(path + "/brightness") == 3, "requested level written");
+    host_check(clamped.backlight.get_level() == 12, "clamped level read back from actual_brightness");
+
+    // blmax overrides max_brightness, a missing device is not opened
+    bench_panel_t limited;
+    host_check(limited.backlight.open(root + std::string("/pwm"), 100, 0) && limited.backlight.get_max() == 100,
+               "max override");
+    bench_panel_t missing;
+    std::string none = root + std::string("/none");
+    host_check(missing.backlight.open_due(none, 0), "new device due");
+    host_check(!missing.backlight.open(none, 0, 0) && !missing.backlight.is_open(), "missing device not opened");
+    missing.set_level(10);
+    host_check(!missing.backlight.flush(), "no write without a device");
+
+    // The device code opens when due, a fade updates every frame
+    uint32_t opens = 0;
+    for(uint32_t t = 0; t < 10000; t += BENCH_FRAME) {
+        if(!missing.backlight.open_due(none, t)) continue;
+        missing.backlight.open(none, 0, t);
+        opens++;
+    }
+    printf("missing: %u opens in 10 s of updates every %u ms\n", opens, BENCH_FRAME);
+    host_check(opens == 3, "failed open retried after 1, 2 and 4 s");
+    host_check(!missing.backlight.open_due(none, 15000) && missing.backlight.open_due(none, 15100),
+               "next retry 8 s after the last one");
+    host_check(missing.backlight.open_due(root + std::string("/pwm"), 10000), "another device due at once");
+    bench_device(root, "none", "255\n", true);
+    host_check(missing.backlight.open(none, 0, 15100), "device opened once it appears");
+    host_check(!missing.backlight.open_due(none, 20000), "open device not due");
+
+    // A write the driver refuses stays pending
+    path = bench_device(root, "refused", "255\n", false);
+    unlink((path + "/brightness").c_str());
+    symlink("/dev/full", (path + "/brightness").c_str()); // every write fails with ENOSPC
+    bench_panel_t refused;
+    host_check(refused.backlight.open(path, 0, 0), "refusing device opened");
+    refused.set_level(200);
+    refused.frame();
+    host_check(refused.backlight.pending(), "level kept after a failed write");
+    host_check(refused.backlight.get_writes() == 0, "failed write not counted");
+
+    std::string cleanup = std::string("rm -rf ") + root;
+    if(system(cleanup.c_str()) != 0) perror("cleanup");
+
+    return host_result();
+}
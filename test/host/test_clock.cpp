@@ -0,0 +1,182 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host check of the POSIX time base
+ *
+ * clock_gettime and nanosleep are replaced by a simulated clock, every sleep overshoots a little like it does on a
+ * loaded machine. During 200 simulated seconds the main loop runs every 5 ms while the wall clock is set back an
+ * hour, forward a day and slewed by NTP. An animation, the idle timeout and the teleperiod are driven from millis()
+ * and the lvgl tick, and must run at the pace of the monotonic clock. The old time base, CLOCK_REALTIME for millis()
+ * and a tick counted in 5 ms sleeps, is run next to it for comparison.
+ */
+
+#include <time.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "host_test.h"
+#include "hasp_tick.h"
+
+extern unsigned long PosixMillis();
+extern void msleep(unsigned long millis);
+
+#define BENCH_DURATION 200000 // ms
+#define BENCH_LOOP 5          // ms between two main loops
+#define BENCH_ANIM_TIME 500   // ms
+#define BENCH_IDLE_SHORT 60   // s
+#define BENCH_TELEPERIOD 10   // s
+
+static int64_t sim_monotonic = 1000000000LL * 12345; // ns since boot
+static int64_t sim_realtime  = 1000000000LL * 1700000000;
+
+extern "C" int clock_gettime(clockid_t clock, struct timespec* spec)
+{
+    int64_t ns = clock == CLOCK_REALTIME ? sim_realtime : sim_monotonic;
+    spec->tv_sec  = ns / 1000000000;
+    spec->tv_nsec = ns % 1000000000;
+    return 0;
+}
+
+extern "C" int nanosleep(const struct timespec* req, struct timespec* rem)
+{
+    int64_t ns = (int64_t)req->tv_sec * 1000000000 + req->tv_nsec + rand() % 400000; // up to 0.4 ms late
+    sim_monotonic += ns;
+    sim_realtime += ns;
+    if(rem) rem->tv_sec = rem->tv_nsec = 0;
+    return 0;
+}
+
+static int64_t sim_start = sim_monotonic;
+
+/* The time that really passed, for the reference run */
+static unsigned long sim_millis()
+{
+    return (sim_monotonic - sim_start) / 1000000;
+}
+
+/* The time base before: wall clock millis() and a tick thread counting sleeps */
+static unsigned long old_millis()
+{
+    static time_t start = 0;
+    struct timespec spec;
+    clock_gettime(CLOCK_REALTIME, &spec);
+    if(start == 0) start = spec.tv_sec;
+    return (spec.tv_sec - start) * 1000 + spec.tv_nsec / 1000000;
+}
+
+enum bench_tick_t { TICK_REFERENCE, TICK_HASP, TICK_COUNTED };
+
+struct bench_clock_t
+{
+    const char* name;
+    unsigned long (*millis)();
+    bench_tick_t tick_source;
+
+    uint32_t tick, tick_start;
+    uint32_t anim_next, anim_started, anim_start_tick, anim_value;
+    uint32_t last_activity, idle_fired_at;
+    unsigned long last_second;
+    uint32_t countdown, teleperiods;
+    uint32_t errors;
+};
+
+static void bench_init(bench_clock_t& clock, const char* name, unsigned long (*millis)(), bench_tick_t source)
+{
+    clock             = {};
+    clock.name        = name;
+    clock.millis      = millis;
+    clock.tick_source = source;
+    clock.countdown   = BENCH_TELEPERIOD;
+    clock.last_second = millis();
+    clock.tick_start = clock.tick = source == TICK_HASP ? hasp_tick_get() : 0;
+}
+
+static void bench_loop(bench_clock_t& clock, uint32_t now_ms)
+{
+    uint32_t last = clock.tick;
+    switch(clock.tick_source) {
+        case TICK_REFERENCE:
+            clock.tick = now_ms;
+            break;
+        case TICK_HASP:
+            clock.tick = hasp_tick_get();
+            break;
+        case TICK_COUNTED:
+            clock.tick += BENCH_LOOP;
+            break;
+    }
+    if((int32_t)(clock.tick - last) < 0) clock.errors++; // time went backwards
+
+    // An animation of BENCH_ANIM_TIME started every 10 s, it must end on time and its value must never decrease
+    if(now_ms >= clock.anim_next) {
+        clock.anim_next += 10000;
+        clock.anim_started    = now_ms;
+        clock.anim_start_tick = clock.tick;
+        clock.anim_value      = 0;
+    }
+    uint32_t elapsed = clock.tick - clock.anim_start_tick;
+    uint32_t value   = elapsed >= BENCH_ANIM_TIME ? 1024 : elapsed * 1024 / BENCH_ANIM_TIME;
+    if(value < clock.anim_value) clock.errors++;
+    if(value == 1024 && clock.anim_value < 1024) {
+        int32_t late = (int32_t)(now_ms - clock.anim_started) - BENCH_ANIM_TIME;
+        if(late < 0 || late > BENCH_LOOP + 1) clock.errors++;
+    }
+    clock.anim_value = value;
+
+    // The idle timeout, the panel was touched at 100 s
+    if(!clock.last_activity && now_ms >= 100000) clock.last_activity = clock.tick;
+    if(clock.last_activity && !clock.idle_fired_at && clock.tick - clock.last_activity >= BENCH_IDLE_SHORT * 1000)
+        clock.idle_fired_at = now_ms;
+
+    // The one second timer of the main loop and the teleperiod counting down on it
+    unsigned long millis = clock.millis();
+    if(millis - clock.last_second >= 1000) {
+        clock.last_second = millis;
+        if(--clock.countdown == 0) {
+            clock.teleperiods++;
+            clock.countdown = BENCH_TELEPERIOD;
+        }
+    }
+}
+
+static void bench_report(bench_clock_t& clock, const bench_clock_t& reference, uint32_t elapsed)
+{
+    uint32_t tick = clock.tick_source == TICK_HASP ? hasp_tick_get() : clock.tick;
+    printf("%s: tick drift %d ms, idle timeout off by %d ms, %u teleperiods (expected %u), %u errors\n", clock.name,
+           (int32_t)(elapsed - (tick - clock.tick_start)), (int32_t)(clock.idle_fired_at - reference.idle_fired_at),
+           clock.teleperiods, reference.teleperiods, clock.errors);
+}
+
+int main()
+{
+    bench_clock_t reference, fixed, old;
+    bench_init(reference, "reference", sim_millis, TICK_REFERENCE);
+    bench_init(fixed, "monotonic", PosixMillis, TICK_HASP);
+    bench_init(old, "realtime ", old_millis, TICK_COUNTED);
+
+    for(uint32_t n = 0;; n++) {
+        uint32_t now_ms = sim_millis();
+        if(now_ms >= BENCH_DURATION) break;
+
+        if(n == 3000) sim_realtime -= 3600LL * 1000000000;  // set back an hour
+        if(n == 12000) sim_realtime += 86400LL * 1000000000; // forward a day
+        if(n >= 20000 && n < 21000) sim_realtime += 500000;  // slewed 0.5 ms per loop
+
+        bench_loop(reference, now_ms);
+        bench_loop(fixed, now_ms);
+        bench_loop(old, now_ms);
+        msleep(BENCH_LOOP);
+    }
+
+    uint32_t elapsed = sim_millis();
+    bench_report(fixed, reference, elapsed);
+    bench_report(old, reference, elapsed);
+
+    host_check(reference.errors + fixed.errors == 0, "monotonic ticks and animations");
+    host_check(reference.idle_fired_at && fixed.teleperiods == reference.teleperiods, "teleperiods");
+    int32_t idle_error = (int32_t)(fixed.idle_fired_at - reference.idle_fired_at);
+    host_check(idle_error >= -1 && idle_error <= BENCH_LOOP + 1, "idle timeout");
+
+    return host_result();
+}
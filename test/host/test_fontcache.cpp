@@ -0,0 +1,247 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host check of the FreeType glyph cache statistics and the page warm-up
+ *
+ * The glyphs of three pages of labels are looked up through an FTC_SBitCache the way lv_freetype.c does. A miss
+ * is detected like lv_freetype.c does: the glyph slot of the face is cleared before the lookup, only a render into
+ * the cache loads a glyph into it. With a cache big enough for everything the misses must equal the distinct
+ * glyphs. Then three pages are switched round for several cache sizes, with and without rendering the glyphs of the
+ * next page in between like the warm-up does, and the frame that draws a new page is timed.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <set>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_CACHE_H
+
+#include "host_test.h"
+
+#define BENCH_FONT "data/openhasp.ttf"
+#define BENCH_SEEN_KEYS 256 // like LV_FT_SEEN_KEYS
+
+struct bench_label_t
+{
+    int size;
+    const char* text;
+};
+
+static const bench_label_t page1[] = {
+    {48, "21:45"},
+    {24, "Living room"},
+    {24, "Kitchen"},
+    {24, "Bedroom"},
+    {32, "21.5\xc2\xb0" "C"},
+    {16, "Humidity 45% - Pressure 1013 hPa"},
+};
+static const bench_label_t page2[] = {
+    {32, "Lights"},
+    {24, "Ceiling ON"},
+    {24, "Floor lamp OFF"},
+    {24, "TV backlight 35%"},
+    {16, "Scene: Movie night, Dinner, Reading, All off"},
+};
+static const bench_label_t page3[] = {
+    {48, "Weather"},
+    {24, "Tomorrow: partly cloudy"},
+    {32, "Max 24\xc2\xb0 Min 12\xc2\xb0"},
+    {16, "Wind 12 km/h NW, rain 10 %, UV index 5"},
+    {16, "Sunrise 06:42 Sunset 20:18"},
+};
+
+struct bench_page_t
+{
+    const bench_label_t* labels;
+    size_t count;
+};
+
+static const bench_page_t pages[] = {
+    {page1, sizeof(page1) / sizeof(page1[0])},
+    {page2, sizeof(page2) / sizeof(page2[0])},
+    {page3, sizeof(page3) / sizeof(page3[0])},
+};
+
+struct bench_stats_t
+{
+    uint32_t hits, misses, reloads, faces;
+};
+
+static FT_Library library;
+static FTC_Manager manager;
+static FTC_CMapCache cmap_cache;
+static FTC_SBitCache sbit_cache;
+static bench_stats_t stats;
+static uint32_t seen[BENCH_SEEN_KEYS];
+static int face_id   = 1;
+
+static FT_Error bench_face_requester(FTC_FaceID, FT_Library lib, FT_Pointer, FT_Face* aface)
+{
+    stats.faces++;
+    return FT_New_Face(lib, BENCH_FONT, 0, aface);
+}
+
+static void bench_cache_new(FT_UInt max_faces, FT_UInt max_sizes, FT_ULong max_bytes)
+{
+    if(manager) FTC_Manager_Done(manager);
+    manager = NULL;
+    if(FTC_Manager_New(library, max_faces, max_sizes, max_bytes, bench_face_requester, NULL, &manager) ||
+       FTC_CMapCache_New(manager, &cmap_cache) || FTC_SBitCache_New(manager, &sbit_cache)) {
+        printf("cache manager error\n");
+        errors++;
+    }
+    memset(&stats, 0, sizeof(stats));
+    memset(seen, 0, sizeof(seen));
+}
+
+static uint32_t bench_key(int size, FT_UInt glyph_index)
+{
+    uint32_t key = (uint32_t)size * 2654435761u ^ glyph_index * 40503u;
+    return key ? key : 1;
+}
+
+static bool bench_lookup(int size, uint32_t letter)
+{
+    FT_Size face_size;
+    FTC_ScalerRec scaler = {(FTC_FaceID)&face_id, (FT_UInt)size, (FT_UInt)size, 1, 0, 0};
+    if(FTC_Manager_LookupSize(manager, &scaler, &face_size)) return false;
+
+    FT_Face face          = face_size->face;
+    FT_UInt glyph_index   = FTC_CMapCache_Lookup(cmap_cache, (FTC_FaceID)&face_id, 0, letter);
+    face->glyph->format   = FT_GLYPH_FORMAT_NONE; // only a render into the cache sets it
+    FTC_ImageTypeRec type = {(FTC_FaceID)&face_id, (FT_UInt)size, (FT_UInt)size,
+                             FT_LOAD_RENDER | FT_LOAD_TARGET_NORMAL};
+    FTC_SBit sbit;
+    if(FTC_SBitCache_Lookup(sbit_cache, &type, glyph_index, &sbit, NULL)) return false;
+
+    if(face->glyph->format == FT_GLYPH_FORMAT_NONE) {
+        stats.hits++;
+    } else {
+        uint32_t key      = bench_key(size, glyph_index);
+        uint32_t* slot    = &seen[key % BENCH_SEEN_KEYS];
+        stats.misses++;
+        if(*slot == key) stats.reloads++;
+        *slot = key;
+    }
+    return true;
+}
+
+static uint32_t bench_next_letter(const char*& txt)
+{
+    uint8_t c = *txt++;
+    if(c < 0x80) return c;
+    uint32_t letter = c & 0x1F; // two byte sequences are enough for the bench texts
+    letter          = letter << 6 | (*txt++ & 0x3F);
+    return letter;
+}
+
+static size_t bench_render_page(const bench_page_t& page)
+{
+    size_t glyphs = 0;
+    for(size_t i = 0; i < page.count; i++) {
+        const char* txt = page.labels[i].text;
+        while(*txt) {
+            uint32_t letter = bench_next_letter(txt);
+            if(letter < 0x20) continue;
+            if(!bench_lookup(page.labels[i].size, letter)) errors++;
+            glyphs++;
+        }
+    }
+    return glyphs;
+}
+
+static size_t bench_distinct(const bench_page_t& page, std::set<std::pair<int, uint32_t>>& glyphs)
+{
+    for(size_t i = 0; i < page.count; i++) {
+        const char* txt = page.labels[i].text;
+        while(*txt) glyphs.insert(std::make_pair(page.labels[i].size, bench_next_letter(txt)));
+    }
+    return glyphs.size();
+}
+
+static double bench_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void bench_detection()
+{
+    bench_cache_new(4, 8, 1 << 20);
+
+    std::set<std::pair<int, uint32_t>> distinct;
+    for(const bench_page_t& page : pages) bench_distinct(page, distinct);
+
+    size_t lookups = 0;
+    for(int round = 0; round < 3; round++)
+        for(const bench_page_t& page : pages) lookups += bench_render_page(page);
+
+    bool ok = stats.misses == distinct.size() && stats.hits + stats.misses == lookups && stats.reloads == 0;
+    printf("1 MB cache: %zu lookups, %u hits, %u misses, %zu distinct glyphs, %u reloads%s\n", lookups, stats.hits,
+           stats.misses, distinct.size(), stats.reloads, ok ? "" : " WRONG");
+    if(!ok) errors++;
+}
+
+static void bench_switching(FT_ULong max_bytes, bool warmup)
+{
+    bench_cache_new(16, 16, max_bytes);
+
+    double first = 0, later = 0;
+    uint32_t first_misses = 0, later_misses = 0;
+    int rounds = 20;
+    for(int round = 0; round < rounds; round++) {
+        for(size_t p = 0; p < 3; p++) {
+            // The frame that draws the new page
+            uint32_t misses = stats.misses;
+            auto start      = std::chrono::steady_clock::now();
+            bench_render_page(pages[p]);
+            double ms = bench_ms(start);
+            if(round == 0) {
+                first += ms;
+                first_misses += stats.misses - misses;
+            } else {
+                later += ms;
+                later_misses += stats.misses - misses;
+            }
+
+            // Redraws while the page is shown are served from the cache
+            bench_render_page(pages[p]);
+
+            // Idle time before the next switch
+            if(warmup) bench_render_page(pages[(p + 1) % 3]);
+        }
+    }
+
+    printf("%5lu bytes %-10s first visits %5.3f ms %3.0f glyphs rendered, later switches %5.3f ms %3.0f glyphs "
+           "rendered, %u reloads\n",
+           max_bytes, warmup ? "warm-up" : "no warm-up", first / 3, first_misses / 3.0, later / (3 * (rounds - 1)),
+           later_misses / (3.0 * (rounds - 1)), stats.reloads);
+}
+
+int main()
+{
+    if(FT_Init_FreeType(&library)) {
+        printf("FreeType init error\n");
+        return 1;
+    }
+    FT_Face face;
+    if(FT_New_Face(library, BENCH_FONT, 0, &face)) {
+        printf("Can't open %s, run from the project folder\n", BENCH_FONT);
+        return 1;
+    }
+    FT_Done_Face(face);
+
+    bench_detection();
+
+    for(FT_ULong max_bytes : {2048, 8192, 16384, 65536}) {
+        bench_switching(max_bytes, false);
+        bench_switching(max_bytes, true);
+    }
+
+    FTC_Manager_Done(manager);
+    FT_Done_FreeType(library);
+
+    return host_result();
+}
@@ -0,0 +1,182 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host stand-in for the GPIO inputs of a plate
+ *
+ * Eight buttons and switches are pressed at random moments during a minute of simulated time, every edge bounces a
+ * few times. The same script is played twice through the simulated pin backend: once with an interrupt per pin and
+ * once with every pin polled on each loop, which is what AceButton did. Both runs must give one event per press and
+ * one per release. The main loop runs every 5 ms, the event latency is counted from the first edge of a press.
+ * Last an edge stamped by the interrupt after the loop read the clock must still wait for the debounce time.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "host_test.h"
+#include "hasp_gpio_input.h"
+#include "hasp_gpio_sim.h"
+
+#define BENCH_CHANNELS 8
+#define BENCH_DURATION 60000 // ms
+#define BENCH_TICK 5         // ms between two main loops
+#define BENCH_PRESSES 40     // per channel
+
+struct bench_event_t
+{
+    uint32_t time;
+    uint8_t id;
+    gpio_input_event_t event;
+};
+
+struct bench_run_t
+{
+    GpioSimBackend* sim;
+    std::vector<bench_event_t> events;
+};
+
+static void bench_event(void* arg, uint8_t id, gpio_input_event_t event)
+{
+    bench_run_t* run = (bench_run_t*)arg;
+    run->events.push_back({run->sim->now(), id, event});
+}
+
+/* Presses of 50 to 650 ms, each edge followed by up to 4 bounces within 3 ms */
+static void bench_script(GpioSimBackend& sim, std::vector<uint32_t>& press_times)
+{
+    srand(42);
+    for(uint8_t id = 0; id < BENCH_CHANNELS; id++) {
+        sim.set_level(id + 2, 1); // pullup, released
+        uint32_t slot = BENCH_DURATION / BENCH_PRESSES;
+        for(uint32_t n = 0; n < BENCH_PRESSES; n++) {
+            uint32_t down = n * slot + rand() % (slot / 2) + 10;
+            uint32_t up   = down + 50 + rand() % 600;
+            for(uint32_t edge : {down, up}) {
+                uint8_t level = edge == down ? 0 : 1;
+                if(edge == down) press_times.push_back(down);
+                sim.schedule(edge, id + 2, level);
+                for(int b = rand() % 5; b > 0; b--) {
+                    sim.schedule(edge + b * 2 - 1, id + 2, !level);
+                    sim.schedule(edge + b * 2, id + 2, level);
+                }
+            }
+        }
+    }
+}
+
+static void bench_run(bool polled, bench_run_t& run, uint32_t& reads, uint32_t& busy_loops, double& loop_ns)
+{
+    GpioSimBackend sim;
+    GpioInput input(sim);
+    std::vector<uint32_t> press_times;
+    run.sim = &sim;
+
+    input.set_callback(bench_event, &run);
+    bench_script(sim, press_times);
+
+    for(uint8_t id = 0; id < BENCH_CHANNELS; id++) {
+        gpio_input_config_t config = {};
+        config.pin                 = id + 2;
+        config.pressed_level       = 0;
+        config.click_delay         = id % 2 ? 100 : 400;
+        config.long_press_delay    = 400;
+        config.features            = GPIO_INPUT_FEATURE_CLICK;
+        if(id % 2 == 0) config.features |= GPIO_INPUT_FEATURE_LONG_PRESS | GPIO_INPUT_FEATURE_SUPPRESS_CLICK;
+        if(polled) config.features |= GPIO_INPUT_FEATURE_POLL;
+        input.add(id, config);
+    }
+
+    busy_loops = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(uint32_t t = 0; t <= BENCH_DURATION + 2000; t += BENCH_TICK) {
+        sim.advance(t);
+        uint32_t before = input.reads();
+        input.loop();
+        if(input.reads() != before) busy_loops++;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    loop_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() /
+              (double)((BENCH_DURATION + 2000) / BENCH_TICK + 1);
+    reads = input.reads();
+}
+
+static void bench_latency(const bench_run_t& run, const char* name)
+{
+    // The n-th pressed event of a channel belongs to the n-th scripted press
+    GpioSimBackend sim;
+    std::vector<uint32_t> press_times;
+    bench_script(sim, press_times);
+
+    uint32_t sum = 0, worst = 0, count = 0;
+    uint32_t seen[BENCH_CHANNELS] = {0};
+    for(const bench_event_t& event : run.events) {
+        if(event.event != GPIO_INPUT_PRESSED) continue;
+        uint32_t latency = event.time - press_times[event.id * BENCH_PRESSES + seen[event.id]++];
+        sum += latency;
+        if(latency > worst) worst = latency;
+        count++;
+    }
+    printf("%s: press latency avg %.1f ms, max %u ms\n", name, count ? (double)sum / count : 0.0, worst);
+}
+
+/* An interrupt that stamps its edge after the loop read the clock must not settle the pin right away */
+static void bench_late_edge()
+{
+    GpioSimBackend sim;
+    GpioInput input(sim);
+    bench_run_t run;
+    run.sim = &sim;
+    input.set_callback(bench_event, &run);
+
+    gpio_input_config_t config = {};
+    config.pin                 = 2;
+    sim.set_level(2, 1);
+    sim.advance(100);
+    input.add(0, config);
+
+    sim.set_level(2, 0);
+    input.edge(0, sim.now() + 1);
+    input.loop();
+    host_check(run.events.empty(), "edge stamped after now still bouncing");
+    sim.advance(100 + GPIO_INPUT_DEBOUNCE_TIME + 1);
+    input.loop();
+    host_check(run.events.size() == 1 && run.events[0].event == GPIO_INPUT_PRESSED, "pressed once settled");
+}
+
+int main()
+{
+    bench_run_t irq, poll;
+    uint32_t irq_reads, poll_reads, irq_busy, poll_busy;
+    double irq_ns, poll_ns;
+
+    bench_run(false, irq, irq_reads, irq_busy, irq_ns);
+    bench_run(true, poll, poll_reads, poll_busy, poll_ns);
+
+    uint32_t loops = (BENCH_DURATION + 2000) / BENCH_TICK + 1;
+    printf("%u loops, %u channels, %u presses each\n", loops, BENCH_CHANNELS, BENCH_PRESSES);
+    printf("interrupt: %zu events, %u pin reads, %u loops read a pin, %.0f ns per loop\n", irq.events.size(), irq_reads,
+           irq_busy, irq_ns);
+    printf("polled:    %zu events, %u pin reads, %u loops read a pin, %.0f ns per loop\n", poll.events.size(),
+           poll_reads, poll_busy, poll_ns);
+    bench_latency(irq, "interrupt");
+    bench_latency(poll, "polled   ");
+
+    // One press and one release or suppressed click per scripted press, however much the contacts bounced. A press
+    // close to the click delay may be classified differently, the polled run only sees edges once per loop.
+    for(const bench_run_t* run : {&irq, &poll}) {
+        uint32_t pressed[BENCH_CHANNELS] = {0}, ended[BENCH_CHANNELS] = {0};
+        for(const bench_event_t& event : run->events) {
+            if(event.event == GPIO_INPUT_PRESSED) pressed[event.id]++;
+            if(event.event == GPIO_INPUT_RELEASED || (event.event == GPIO_INPUT_CLICKED && event.id % 2 == 0))
+                ended[event.id]++;
+        }
+        for(uint8_t id = 0; id < BENCH_CHANNELS; id++)
+            host_check(pressed[id] == BENCH_PRESSES && ended[id] == BENCH_PRESSES, "one event per press");
+    }
+
+    bench_late_edge();
+
+    return host_result();
+}
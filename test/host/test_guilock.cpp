@@ -0,0 +1,137 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host check of the gui lock
+ *
+ * First three threads increment a counter through nested locks, no increment may get lost and the nested
+ * acquisitions must not count as locks. Then a stand-in for the main loop draws, polls the network and runs the
+ * one second jobs, while an MQTT thread dispatches a message every few ms with the 30 ms timeout of
+ * mqtt_process_topic_payload. It runs once holding the lock for the whole iteration like before and once only
+ * around the lvgl sections. Reported are the statistics of the lock and how many messages had to be queued.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "host_test.h"
+#include "hasp_gui_lock.h"
+
+#define BENCH_DURATION 3000 // ms per mode
+
+
+static void bench_work(uint32_t us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+static void bench_nesting()
+{
+    gui_lock_reset_stats();
+    uint32_t counter = 0;
+    const int rounds = 20000;
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 3; t++)
+        threads.emplace_back([&counter] {
+            for(int n = 0; n < rounds; n++) {
+                GuiLock outer("outer");
+                GuiLock inner("inner"); // a command dispatched from a locked section
+                uint32_t value = counter;
+                if(n % 1000 == 0) std::this_thread::yield();
+                counter = value + 1;
+            }
+        });
+    for(std::thread& thread : threads) thread.join();
+
+    gui_lock_stats_t stats;
+    gui_lock_get_stats(stats);
+    bool ok = counter == 3 * rounds && stats.locks == 3 * rounds && stats.timeouts == 0;
+    printf("nesting: %u increments of %u, %u locks, %u contended%s\n", counter, 3 * rounds, stats.locks,
+           stats.contended, ok ? "" : " WRONG");
+    if(!ok) errors++;
+
+    GuiLock held("held");
+    std::thread other([] {
+        bool got = gui_acquire(20, "other");
+        if(got) {
+            gui_release();
+            printf("timeout: acquired a lock held by another thread\n");
+            errors++;
+        }
+    });
+    other.join();
+}
+
+static void bench_loop(bool coarse)
+{
+    gui_lock_reset_stats();
+    std::atomic<bool> running(true);
+    std::atomic<uint32_t> queued(0), dispatched(0);
+
+    std::thread mqtt([&] {
+        srand(5);
+        while(running) {
+            bench_work(2000 + rand() % 8000);
+            if(gui_acquire(30, "mqtt")) {
+                GuiLock lock("dispatch"); // dispatch_topic_payload locks again
+                bench_work(300);
+                gui_release();
+                dispatched++;
+            } else {
+                queued++;
+            }
+        }
+    });
+
+    auto start     = std::chrono::steady_clock::now();
+    auto second    = start;
+    uint32_t loops = 0;
+    while(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(BENCH_DURATION)) {
+        if(coarse) gui_acquire(GUI_LOCK_FOREVER, "loop");
+
+        {
+            GuiLock lock("lvgl");
+            bench_work(3000); // lv_task_handler drawing a frame
+        }
+        bench_work(loops % 10 ? 500 : 40000); // network, now and then a blocking read of a file or a socket
+        {
+            GuiLock lock("gpio");
+            bench_work(50);
+        }
+        if(std::chrono::steady_clock::now() - second >= std::chrono::seconds(1)) {
+            second += std::chrono::seconds(1);
+            GuiLock lock("every second");
+            bench_work(2000);
+        }
+
+        if(coarse) gui_release();
+        bench_work(2000); // loop_sleep
+        loops++;
+    }
+    running = false;
+    mqtt.join();
+
+    gui_lock_stats_t stats;
+    gui_lock_get_stats(stats);
+    printf("%-6s %u loops, %u locks, %u contended, wait avg %u max %u us, hold avg %u max %u us (%s), "
+           "%u dispatched, %u queued\n",
+           coarse ? "coarse" : "fine", loops, stats.locks, stats.contended,
+           stats.contended ? (uint32_t)(stats.wait_us / stats.contended) : 0, stats.max_wait_us,
+           stats.locks ? (uint32_t)(stats.hold_us / stats.locks) : 0, stats.max_hold_us,
+           stats.max_hold_name ? stats.max_hold_name : "-", dispatched.load(), queued.load());
+    if(!coarse && (stats.max_wait_us > 30000 || queued)) errors++;
+}
+
+int main()
+{
+    gui_lock_setup();
+    bench_nesting();
+    bench_loop(true);
+    bench_loop(false);
+
+    return host_result();
+}
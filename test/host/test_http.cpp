@@ -0,0 +1,284 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host stand-in for the file server of the web interface
+ *
+ * The files of the given folder are served on a local socket through a plain POSIX transport. A client fetches
+ * every file the way a browser does when a transfer is interrupted halfway and when the page is loaded again. It
+ * counts the bytes received with range and conditional requests against the bytes a server without them sends.
+ */
+
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <netinet/in.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "host_test.h"
+#include "hasp_http_file.h"
+
+class PosixStore : public HttpFileStore {
+  public:
+    explicit PosixStore(const char* root) : root(root)
+    {}
+
+    bool stat(const char* path, http_file_stat_t& st) override
+    {
+        struct stat info;
+        if(::stat((root + path).c_str(), &info) < 0) return false;
+        st.is_dir   = S_ISDIR(info.st_mode);
+        st.size     = info.st_size;
+        st.modified = info.st_mtime;
+        return true;
+    }
+    bool open(const char* path) override
+    {
+        file = fopen((root + path).c_str(), "rb");
+        return file != NULL;
+    }
+    bool seek(uint32_t pos) override
+    {
+        return fseek(file, pos, SEEK_SET) == 0;
+    }
+    size_t read(uint8_t* buffer, size_t len) override
+    {
+        return fread(buffer, 1, len, file);
+    }
+    void close() override
+    {
+        fclose(file);
+        file = NULL;
+    }
+    bool list(const char* dir, http_file_list_cb_t cb, void* arg) override
+    {
+        std::string path = root + dir;
+        DIR* d           = opendir(path.c_str());
+        if(!d) return false;
+
+        while(struct dirent* entry = readdir(d)) {
+            if(entry->d_name[0] == '.') continue;
+            http_file_stat_t st;
+            if(stat((std::string(dir) + "/" + entry->d_name).c_str(), st)) cb(arg, entry->d_name, st);
+        }
+        closedir(d);
+        return true;
+    }
+
+  private:
+    std::string root;
+    FILE* file = NULL;
+};
+
+class SocketTransport : public HttpTransport {
+  public:
+    explicit SocketTransport(int fd, const std::string& request) : fd(fd), request(request)
+    {}
+
+    bool request_header(const char* name, char* value, size_t size) override
+    {
+        size_t len = strlen(name);
+        for(size_t pos = request.find("\r\n"); pos != std::string::npos; pos = request.find("\r\n", pos + 2)) {
+            const char* line = request.c_str() + pos + 2;
+            if(strncasecmp(line, name, len) || line[len] != ':') continue;
+
+            const char* start = line + len + 1;
+            while(*start == ' ') start++;
+            size_t n = strcspn(start, "\r\n");
+            if(n >= size) n = size - 1;
+            memcpy(value, start, n);
+            value[n] = 0;
+            return true;
+        }
+        return false;
+    }
+    void send_header(const char* name, const char* value) override
+    {
+        headers += std::string(name) + ": " + value + "\r\n";
+    }
+    void begin(int code, const char* content_type, int32_t length) override
+    {
+        chunked          = length < 0;
+        std::string head = "HTTP/1.1 " + std::to_string(code) + " X\r\nContent-Type: " + content_type + "\r\n";
+        head += chunked ? "Transfer-Encoding: chunked\r\n" : "Content-Length: " + std::to_string(length) + "\r\n";
+        head += headers + "Connection: close\r\n\r\n";
+        send_all(head.data(), head.size());
+    }
+    size_t write(const char* data, size_t len) override
+    {
+        if(chunked) {
+            char size[16];
+            send_all(size, snprintf(size, sizeof(size), "%zx\r\n", len));
+        }
+        if(!send_all(data, len)) return 0;
+        if(chunked) send_all("\r\n", 2);
+        return len;
+    }
+    void end() override
+    {
+        if(chunked) send_all("0\r\n\r\n", 5);
+    }
+
+  private:
+    int fd;
+    std::string request;
+    std::string headers;
+    bool chunked = false;
+
+    bool send_all(const char* data, size_t len)
+    {
+        while(len > 0) {
+            ssize_t sent = send(fd, data, len, MSG_NOSIGNAL);
+            if(sent <= 0) return false;
+            data += sent;
+            len -= sent;
+        }
+        return true;
+    }
+};
+
+static void bench_serve(int server, const char* root)
+{
+    PosixStore store(root);
+
+    for(;;) {
+        int fd = accept(server, NULL, NULL);
+        if(fd < 0) return;
+
+        std::string request;
+        char buffer[1024];
+        while(request.find("\r\n\r\n") == std::string::npos) {
+            ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+            if(len <= 0) break;
+            request.append(buffer, len);
+        }
+
+        std::string uri = request.substr(4, request.find(' ', 4) - 4);
+        SocketTransport http(fd, request);
+        int code;
+        if(uri.compare(0, 10, "/list?dir=") == 0)
+            code = http_file_list(http, store, uri.c_str() + 10);
+        else
+            code = http_file_send(http, store, uri.c_str(), "image/png", false);
+        if(code == 404 || code == 500) {
+            http.begin(code, "text/plain", 0);
+            http.end();
+        }
+        close(fd);
+    }
+}
+
+struct bench_response_t
+{
+    int code;
+    size_t total; // bytes received, headers included
+    std::string headers;
+    std::string body;
+};
+
+static bench_response_t bench_get(uint16_t port, const std::string& uri, const std::string& headers,
+                                  size_t limit = SIZE_MAX)
+{
+    int fd                  = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family         = AF_INET;
+    addr.sin_port           = htons(port);
+    addr.sin_addr.s_addr    = htonl(INADDR_LOOPBACK);
+    connect(fd, (struct sockaddr*)&addr, sizeof(addr));
+
+    std::string request = "GET " + uri + " HTTP/1.1\r\nHost: bench\r\n" + headers + "\r\n";
+    send(fd, request.data(), request.size(), 0);
+
+    std::string data;
+    char buffer[4096];
+    ssize_t len;
+    while(data.size() < limit && (len = recv(fd, buffer, sizeof(buffer), 0)) > 0) data.append(buffer, len);
+    close(fd);
+    if(data.size() > limit) data.resize(limit); // the connection was dropped here
+
+    bench_response_t response;
+    size_t end       = data.find("\r\n\r\n");
+    response.code    = atoi(data.c_str() + 9);
+    response.total   = data.size();
+    response.headers = data.substr(0, end);
+    response.body    = end == std::string::npos ? "" : data.substr(end + 4);
+    return response;
+}
+
+static std::string bench_header(const bench_response_t& response, const char* name)
+{
+    size_t pos = response.headers.find(std::string("\r\n") + name + ": ");
+    if(pos == std::string::npos) return "";
+    pos += strlen(name) + 4;
+    return response.headers.substr(pos, response.headers.find("\r\n", pos) - pos);
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2) {
+        fprintf(stderr, "usage: %s <folder>\n", argv[0]);
+        return 1;
+    }
+
+    int server              = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    socklen_t size          = sizeof(addr);
+    addr.sin_family         = AF_INET;
+    addr.sin_addr.s_addr    = htonl(INADDR_LOOPBACK);
+    bind(server, (struct sockaddr*)&addr, sizeof(addr));
+    listen(server, 4);
+    getsockname(server, (struct sockaddr*)&addr, &size);
+    uint16_t port = ntohs(addr.sin_port);
+    std::thread(bench_serve, server, argv[1]).detach();
+
+    bench_response_t list = bench_get(port, "/list?dir=/", "");
+    printf("file list: %d, %zu bytes in chunks of at most %d bytes\n", list.code, list.body.size(),
+           HTTP_FILE_CHUNK_SIZE / 2);
+
+    size_t plain = 0, smart = 0, files = 0;
+    DIR* d = opendir(argv[1]);
+    while(struct dirent* entry = readdir(d)) {
+        std::string uri = std::string("/") + entry->d_name;
+        struct stat info;
+        if(stat((std::string(argv[1]) + uri).c_str(), &info) < 0 || !S_ISREG(info.st_mode)) continue;
+        files++;
+
+        bench_response_t full = bench_get(port, uri, "");
+        std::string etag      = bench_header(full, "ETag");
+        size_t half           = full.headers.size() + 4 + full.body.size() / 2;
+
+        // Interrupted halfway, then resumed with a range or fetched again from the start
+        bench_response_t cut  = bench_get(port, uri, "", half);
+        size_t have           = cut.body.size();
+        std::string range     = "Range: bytes=" + std::to_string(have) + "-\r\nIf-Range: " + etag + "\r\n";
+        bench_response_t rest = bench_get(port, uri, range, SIZE_MAX);
+        host_check(cut.body + rest.body == full.body && (have == full.body.size() || rest.code == 206), "resumed");
+
+        // Loaded again with the validators of the first response
+        bench_response_t again = bench_get(port, uri, "If-None-Match: " + etag + "\r\n");
+        std::string modified   = bench_header(full, "Last-Modified");
+        bench_response_t since = bench_get(port, uri, "If-Modified-Since: " + modified + "\r\n");
+        host_check(again.code == 304 && since.code == 304 && again.body.empty(), "not modified");
+
+        // Past the end of the file
+        bench_response_t past = bench_get(port, uri, "Range: bytes=" + std::to_string(info.st_size) + "-\r\n");
+        host_check(past.code == 416, "range past the end");
+
+        plain += cut.total + full.total + full.total;
+        smart += cut.total + rest.total + again.total;
+    }
+    closedir(d);
+
+    host_check(files > 0 && list.code == 200, "files listed");
+    printf("%zu files\n", files);
+    printf("interrupted, resumed and reloaded: %zu bytes instead of %zu (%.1f%% less)\n", smart, plain,
+           plain ? 100.0 * (plain - smart) / plain : 0.0);
+    return host_result();
+}
@@ -0,0 +1,211 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host stand-in for the pages of the web interface
+ *
+ * A GPIO settings page is rendered twice: once by appending every field to a growing string, the way the pages
+ * were built with Arduino String, and once through HttpWriter. Both go to a sink with a fixed buffer so only the
+ * allocations of the page itself are counted. The writer must produce the same bytes, in chunks no larger than its
+ * buffer, without allocating anything on the heap.
+ */
+
+#include <stdlib.h>
+
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+
+#include "host_test.h"
+#include "hasp_http_writer.h"
+
+#define BENCH_HEAP_SIZE 320000 // free heap of a plate without PSram
+
+static size_t bench_live  = 0; // bytes allocated through new
+static size_t bench_peak  = 0;
+static size_t bench_count = 0;
+
+void* operator new(size_t size)
+{
+    size_t* block = (size_t*)malloc(size + sizeof(size_t));
+    if(!block) throw std::bad_alloc();
+    *block = size;
+    bench_live += size;
+    if(bench_live > bench_peak) bench_peak = bench_live;
+    bench_count++;
+    return block + 1;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if(!ptr) return;
+    size_t* block = (size_t*)ptr - 1;
+    bench_live -= *block;
+    free(block);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+static size_t bench_free_heap()
+{
+    return BENCH_HEAP_SIZE - bench_live;
+}
+
+static void bench_heap_reset()
+{
+    bench_peak  = bench_live;
+    bench_count = 0;
+}
+
+/* Captures the response in a buffer that was allocated before the measurement */
+class CaptureTransport : public HttpTransport {
+  public:
+    char body[65536];
+    size_t len       = 0;
+    size_t chunks    = 0;
+    size_t max_chunk = 0;
+    int code         = 0;
+
+    bool request_header(const char*, char*, size_t) override
+    {
+        return false;
+    }
+    void send_header(const char*, const char*) override
+    {}
+    void begin(int code, const char*, int32_t) override
+    {
+        this->code = code;
+    }
+    size_t write(const char* data, size_t size) override
+    {
+        if(len + size > sizeof(body)) return 0;
+        memcpy(body + len, data, size);
+        len += size;
+        chunks++;
+        if(size > max_chunk) max_chunk = size;
+        return size;
+    }
+    void end() override
+    {}
+};
+
+struct bench_pin_t
+{
+    int pin;
+    const char* type;
+    int group;
+    bool inverted;
+};
+
+static const bench_pin_t bench_pins[] = {
+    {2, "Button", 1, false}, {4, "Switch", 2, true},    {5, "Relay", 3, false}, {12, "LED", 0, false},
+    {13, "PWM", 4, true},    {14, "Door", 5, false},    {15, "Motion", 6, true}, {16, "Window", 7, false},
+    {17, "Light", 8, false}, {18, "Smoke", 9, true},    {19, "Gas", 10, false}, {21, "Lock", 11, false},
+    {22, "Power", 12, true}, {23, "Shutter", 13, false}, {25, "DAC", 14, false}, {26, "Touch", 0, true},
+};
+
+#define BENCH_PIN_COUNT (sizeof(bench_pins) / sizeof(bench_pins[0]))
+
+static void bench_render_string(std::string& page)
+{
+    page += "<h1>plate01</h1><hr><h2>GPIO Settings</h2><form method='POST' action='/config'>";
+    page += "<table><tr><th>Pin</th><th>Type</th><th>Group</th><th>Default</th><th>Action</th></tr>";
+    for(size_t i = 0; i < BENCH_PIN_COUNT; i++) {
+        const bench_pin_t& pin = bench_pins[i];
+        page += "<tr><td>GPIO";
+        page += std::to_string(pin.pin);
+        page += "</td><td><a href='/config/gpio/options?id=";
+        page += std::to_string(i);
+        page += "'>";
+        page += pin.type;
+        page += "</a></td><td>";
+        page += std::to_string(pin.group);
+        page += "</td><td>";
+        page += pin.inverted ? "Inverted" : "Normal";
+        page += "</td><td><a href='/config/gpio?del=&id=";
+        page += std::to_string(i);
+        page += "&pin=";
+        page += std::to_string(pin.pin);
+        page += "' class='icon trash'></a></td><tr>";
+    }
+    page += "</table></form>";
+}
+
+static void bench_render_writer(HttpWriter& page)
+{
+    page.print("<h1>plate01</h1><hr><h2>GPIO Settings</h2><form method='POST' action='/config'>");
+    page.print_P("<table><tr><th>Pin</th><th>Type</th><th>Group</th><th>Default</th><th>Action</th></tr>");
+    for(size_t i = 0; i < BENCH_PIN_COUNT; i++) {
+        const bench_pin_t& pin = bench_pins[i];
+        page.print("<tr><td>GPIO");
+        page.print((long)pin.pin);
+        page.printf_P("</td><td><a href='/config/gpio/options?id=%u'>%s</a></td><td>%u</td><td>%s", (unsigned)i,
+                      pin.type, pin.group, pin.inverted ? "Inverted" : "Normal");
+        page.printf_P("</td><td><a href='/config/gpio?del=&id=%u&pin=%u' class='icon trash'></a></td><tr>",
+                      (unsigned)i, pin.pin);
+    }
+    page.print("</table></form>");
+}
+
+int main()
+{
+    static CaptureTransport sink; // not on the measured heap
+
+    // Growing string
+    bench_heap_reset();
+    size_t base = bench_live;
+    {
+        std::string page;
+        bench_render_string(page);
+        sink.begin(200, "text/html", page.size());
+        sink.write(page.data(), page.size());
+        sink.end();
+    }
+    size_t string_peak  = bench_peak - base;
+    size_t string_count = bench_count;
+    std::string expected(sink.body, sink.len);
+
+    // HttpWriter
+    sink.len = sink.chunks = sink.max_chunk = 0;
+    bench_heap_reset();
+    base = bench_live;
+    size_t writer_reported;
+    {
+        HttpWriter page(sink, bench_free_heap);
+        page.begin(200, "text/html");
+        bench_render_writer(page);
+        page.end();
+        writer_reported = page.heap_used();
+        host_check(page.total() == sink.len, "total");
+    }
+    size_t writer_peak  = bench_peak - base;
+    size_t writer_count = bench_count;
+
+    host_check(std::string(sink.body, sink.len) == expected, "same page");
+    host_check(sink.max_chunk <= HTTP_WRITER_BUFFER_SIZE, "chunk size");
+    host_check(writer_peak == 0 && writer_count == 0 && writer_reported == 0, "no allocations");
+    size_t chunks    = sink.chunks;
+    size_t max_chunk = sink.max_chunk;
+
+    // A field longer than the buffer is truncated instead of allocated
+    char longtext[HTTP_WRITER_BUFFER_SIZE * 2];
+    memset(longtext, 'x', sizeof(longtext) - 1);
+    longtext[sizeof(longtext) - 1] = 0;
+    sink.len = sink.chunks = sink.max_chunk = 0;
+    {
+        HttpWriter page(sink);
+        page.print("<p>");
+        page.printf_P("%s", longtext);
+        page.end();
+        host_check(sink.len == 3 + HTTP_WRITER_BUFFER_SIZE - 1 && sink.code == 200, "long field truncated");
+    }
+
+    printf("page of %zu bytes\n", expected.size());
+    printf("string: %zu allocations, heap peak %zu bytes\n", string_count, string_peak);
+    printf("writer: %zu allocations, heap peak %zu bytes, reported %zu, %zu chunks of at most %zu bytes\n",
+           writer_count, writer_peak, writer_reported, chunks, max_chunk);
+    return host_result();
+}
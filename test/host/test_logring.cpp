@@ -0,0 +1,198 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host check of the log ring
+ *
+ * Every line carries its writer, its number and a filler that depends on both, so a reader can tell a torn copy
+ * from a good one. First one thread appends lines of random length while a reader that pauses now and then follows
+ * it: every line must come back intact and in order, and the lines it missed must be reported as gaps. Then three
+ * writers log as fast as they can next to a reader that keeps up and one that sleeps between reads, and the cost of
+ * an append is timed with and without the readers.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "host_test.h"
+#include "hasp_log_ring.h"
+
+#define BENCH_WRITERS 3
+#define BENCH_LINES 200000 // per writer
+
+
+struct bench_reader_t
+{
+    uint32_t cursor;
+    uint32_t lines;
+    uint32_t gaps;
+    uint32_t missed;
+    uint32_t torn;
+    uint32_t out_of_order;
+    uint32_t last_seq;
+    uint32_t last_n[BENCH_WRITERS];
+};
+
+static size_t bench_line(char* text, unsigned writer, unsigned n)
+{
+    int len     = snprintf(text, HASP_LOG_RING_LINE_SIZE, "W%u %u ", writer, n);
+    size_t fill = (n * 7 + writer) % 200;
+    for(size_t i = 0; i < fill; i++) text[len + i] = 'a' + (n + i) % 26;
+    text[len + fill] = 0;
+    return len + fill;
+}
+
+static bool bench_check_line(const char* text, size_t len, unsigned& writer, unsigned& n)
+{
+    if(sscanf(text, "W%u %u ", &writer, &n) != 2) return false;
+    char expected[HASP_LOG_RING_LINE_SIZE + 1];
+    size_t size = bench_line(expected, writer, n);
+    return size == len && !memcmp(expected, text, len);
+}
+
+static void bench_read(bench_reader_t& reader, size_t max)
+{
+    log_ring_line_t line;
+    char text[HASP_LOG_RING_LINE_SIZE + 1];
+
+    for(size_t i = 0; i < max; i++) {
+        log_ring_result_t res = log_ring_read(reader.cursor, line, text, sizeof(text));
+        if(res == LOG_RING_EMPTY) return;
+        if(res == LOG_RING_GAP) {
+            reader.gaps++;
+            reader.missed += line.missed;
+            reader.last_seq = reader.cursor - 1;
+            continue;
+        }
+
+        unsigned writer, n;
+        if(!bench_check_line(text, line.len, writer, n) || writer >= BENCH_WRITERS || line.tag != writer ||
+           line.millis != n) {
+            reader.torn++;
+            continue;
+        }
+        if(line.seq != reader.last_seq + 1 || n < reader.last_n[writer]) reader.out_of_order++;
+        reader.last_seq       = line.seq;
+        reader.last_n[writer] = n;
+        reader.lines++;
+    }
+}
+
+static void bench_report(const char* name, bench_reader_t& reader, uint32_t start, uint32_t end)
+{
+    // Every line from start to end was either read or reported missing
+    bool ok = reader.torn == 0 && reader.out_of_order == 0 && reader.lines + reader.missed == end - start;
+    printf("  %-6s %u lines, %u gaps with %u lines missed, %u torn, %u out of order%s\n", name, reader.lines,
+           reader.gaps, reader.missed, reader.torn, reader.out_of_order, ok ? "" : " WRONG");
+    if(!ok) errors++;
+}
+
+static void bench_single()
+{
+    char text[HASP_LOG_RING_LINE_SIZE + 1];
+    bench_reader_t reader = {};
+    reader.cursor         = log_ring_next();
+    reader.last_seq       = reader.cursor - 1;
+    uint32_t start        = reader.cursor;
+
+    srand(7);
+    for(unsigned n = 0; n < BENCH_LINES; n++) {
+        size_t len = bench_line(text, 0, n);
+        log_ring_append(0, 5, n, text, len);
+        if(rand() % 100 == 0) bench_read(reader, rand() % 4000); // pauses, sometimes too long
+    }
+    bench_read(reader, SIZE_MAX);
+
+    // The history a new reader starts from must be complete
+    bench_reader_t history = {};
+    history.cursor         = log_ring_first();
+    history.last_seq       = history.cursor - 1;
+    uint32_t kept          = log_ring_next() - log_ring_first();
+    bench_read(history, SIZE_MAX);
+
+    printf("single writer, %u lines kept in %u bytes:\n", kept, HASP_LOG_RING_SIZE);
+    bench_report("reader", reader, start, log_ring_next());
+    bench_report("new", history, log_ring_next() - kept, log_ring_next());
+    if(reader.gaps == 0) {
+        printf("  the reader never fell behind\n");
+        errors++;
+    }
+
+    // A cursor from before a reboot restarts at the oldest line
+    log_ring_line_t line;
+    uint32_t stale = log_ring_next() + 100;
+    if(log_ring_read(stale, line, text, sizeof(text)) != LOG_RING_GAP || stale != log_ring_first() || line.missed) {
+        printf("  a stale cursor did not restart at the oldest line\n");
+        errors++;
+    }
+}
+
+static double bench_writers(bool readers)
+{
+    std::atomic<bool> running(true);
+    bench_reader_t fast = {}, slow = {};
+    fast.cursor = slow.cursor = log_ring_next();
+    fast.last_seq = slow.last_seq = fast.cursor - 1;
+    uint32_t start                = fast.cursor;
+
+    std::vector<std::thread> threads;
+    if(readers) {
+        threads.emplace_back([&] {
+            while(running || log_ring_next() != fast.cursor) bench_read(fast, 64);
+        });
+        threads.emplace_back([&] {
+            while(running) {
+                bench_read(slow, 500);
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            bench_read(slow, SIZE_MAX);
+        });
+    }
+
+    std::atomic<uint64_t> elapsed(0);
+    std::vector<std::thread> writers;
+    for(unsigned w = 0; w < BENCH_WRITERS; w++)
+        writers.emplace_back([w, &elapsed] {
+            char text[HASP_LOG_RING_LINE_SIZE + 1];
+            auto begin = std::chrono::steady_clock::now();
+            for(unsigned n = 0; n < BENCH_LINES; n++) {
+                size_t len = bench_line(text, w, n);
+                log_ring_append(w, 5, n, text, len);
+            }
+            elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin)
+                           .count();
+        });
+    for(std::thread& writer : writers) writer.join();
+    running = false;
+    for(std::thread& thread : threads) thread.join();
+
+    double per_line = (double)elapsed / (BENCH_WRITERS * BENCH_LINES);
+    printf("%u writers, %s readers: %.0f ns per append\n", BENCH_WRITERS, readers ? "two" : "no", per_line);
+    if(readers) {
+        bench_report("fast", fast, start, log_ring_next());
+        bench_report("slow", slow, start, log_ring_next());
+        if(slow.gaps == 0) {
+            printf("  the slow reader never fell behind\n");
+            errors++;
+        }
+    }
+    return per_line;
+}
+
+int main()
+{
+    bench_single();
+    bench_writers(false);
+    bench_writers(true);
+
+    log_ring_stats_t stats;
+    log_ring_get_stats(stats);
+    printf("%u lines appended, %u evicted, %u truncated, %u reported missing\n", stats.lines, stats.evicted,
+           stats.truncated, stats.missed);
+
+    return host_result();
+}
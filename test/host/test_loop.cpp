@@ -0,0 +1,171 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host stand-in for the main loop
+ *
+ * The loop runs a fake lvgl task every 30 ms, the one second jobs and a fixed amount of polling per iteration,
+ * while a second thread posts commands at random moments the way the MQTT client and the console do. It runs once
+ * with the fixed delay(2) after every iteration and once sleeping in loop_sleep until a deadline or a wakeup.
+ * Reported are the iterations, the cpu time of the loop thread and the time from posting a command until the
+ * iteration that handled and rendered it. Every command must be handled exactly once.
+ */
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "host_test.h"
+#include "hasp_loop.h"
+
+#define BENCH_DURATION 5000  // ms per mode
+#define BENCH_COMMANDS 100   // posted per mode
+#define BENCH_LVGL_PERIOD 30 // ms, indev read and display refresh
+#define BENCH_POLL_US 20     // us of polling per iteration, network, console and gpio
+
+typedef std::chrono::steady_clock bench_clock;
+
+static std::mutex bench_mutex;
+static std::queue<bench_clock::time_point> bench_queue;
+
+static uint64_t bench_cpu_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void bench_spin(uint32_t us)
+{
+    uint64_t end = bench_cpu_us() + us;
+    while(bench_cpu_us() < end) {
+    }
+}
+
+static void bench_post(bool wake)
+{
+    {
+        std::lock_guard<std::mutex> lock(bench_mutex);
+        bench_queue.push(bench_clock::now());
+    }
+    if(wake) loop_wake();
+}
+
+struct bench_result_t
+{
+    uint32_t loops;
+    uint32_t posted;
+    uint32_t handled;
+    uint64_t cpu_us;
+    std::vector<uint32_t> latency_us;
+};
+
+static void bench_run(bool wakeup, bench_result_t& result)
+{
+    result = {};
+    bench_clock::time_point start = bench_clock::now();
+    auto elapsed_ms               = [start]() {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(bench_clock::now() - start).count();
+    };
+
+    std::atomic<bool> running(true);
+    std::atomic<uint32_t> posted(0);
+    std::thread producer([wakeup, &running, &posted]() {
+        srand(7);
+        for(int n = 0; n < BENCH_COMMANDS && running; n++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10 + rand() % (2 * BENCH_DURATION / BENCH_COMMANDS)));
+            if(!running) break;
+            bench_post(wakeup);
+            posted++;
+        }
+    });
+
+    uint32_t next_lvgl = 0, next_second = 0;
+    uint64_t cpu_start = bench_cpu_us();
+    while(elapsed_ms() < BENCH_DURATION) {
+        uint32_t now = elapsed_ms();
+
+        // dispatch_process_deferred, the command is rendered in the same iteration
+        for(;;) {
+            bench_clock::time_point posted;
+            {
+                std::lock_guard<std::mutex> lock(bench_mutex);
+                if(bench_queue.empty()) break;
+                posted = bench_queue.front();
+                bench_queue.pop();
+            }
+            result.latency_us.push_back(
+                std::chrono::duration_cast<std::chrono::microseconds>(bench_clock::now() - posted).count());
+            result.handled++;
+        }
+
+        // guiLoop
+        if(now >= next_lvgl) next_lvgl = now - now % BENCH_LVGL_PERIOD + BENCH_LVGL_PERIOD;
+        loop_schedule(next_lvgl - now);
+
+        bench_spin(BENCH_POLL_US);
+
+        if(now >= next_second) next_second = now + 1000;
+        loop_schedule(next_second - now);
+
+        result.loops++;
+        if(wakeup) {
+            loop_sleep();
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+    result.cpu_us = bench_cpu_us() - cpu_start;
+
+    running = false;
+    producer.join();
+    result.posted = posted;
+    while(!bench_queue.empty()) { // posted during the last iteration
+        bench_queue.pop();
+        result.posted--;
+    }
+}
+
+static void bench_report(const char* name, bench_result_t& result)
+{
+    std::vector<uint32_t>& samples = result.latency_us;
+    std::sort(samples.begin(), samples.end());
+    uint64_t sum = 0;
+    for(uint32_t sample : samples) sum += sample;
+
+    printf("%s: %u loops, cpu %.2f%%, %u commands, latency us p50 %u, p99 %u, max %u, avg %u\n", name, result.loops,
+           result.cpu_us * 100.0 / (BENCH_DURATION * 1000.0), result.handled,
+           samples.empty() ? 0 : samples[samples.size() / 2], samples.empty() ? 0 : samples[samples.size() * 99 / 100],
+           samples.empty() ? 0 : samples.back(), samples.empty() ? 0 : (uint32_t)(sum / samples.size()));
+}
+
+int main()
+{
+    bench_result_t fixed, wakeup;
+
+    loop_setup();
+    bench_run(false, fixed);
+    bench_run(true, wakeup);
+
+    bench_report("delay(2)  ", fixed);
+    bench_report("loop_sleep", wakeup);
+
+    loop_stats_t stats;
+    loop_get_stats(stats, true);
+    printf("loop_sleep: %u sleeps, %u cut short by a wakeup, %u ms asleep\n", stats.loops, stats.wakeups,
+           stats.slept);
+
+    host_check(fixed.handled > 0 && fixed.handled == fixed.posted, "delay(2) handles every command");
+    host_check(wakeup.handled > 0 && wakeup.handled == wakeup.posted, "loop_sleep handles every command");
+    host_check(stats.loops == wakeup.loops, "sleeps counted");
+    host_check(stats.wakeups <= wakeup.handled, "wakeups counted");
+
+    return host_result();
+}
@@ -0,0 +1,197 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host check of the size class routing of hasp_mem
+ *
+ * Every size class must land in the smallest pool that fits it, a full pool sends the request to the heap and
+ * counts a fallback, and large and persistent requests go to PSram, which is emulated by malloc on the host.
+ * Pool, heap and PSram pointers are all released through hasp_free and hasp_realloc. Last four threads allocate
+ * and free at the same time, no allocation may be lost from the counters.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "host_test.h"
+#include "hasp_mem.h"
+
+#define BENCH_POOLS 5
+#define BENCH_THREADS 4
+#define BENCH_ROUNDS 20000 // allocations per thread
+
+static hasp_mem_pool_stats_t bench_pool(uint8_t index)
+{
+    hasp_mem_pool_stats_t stats = {};
+    hasp_mem_get_pool_stats(index, &stats);
+    return stats;
+}
+
+static uint32_t bench_heap_allocs()
+{
+    uint32_t heap;
+    hasp_mem_get_stats(NULL, &heap);
+    return heap;
+}
+
+static uint32_t bench_psram_allocs()
+{
+    uint32_t psram;
+    hasp_mem_get_stats(&psram, NULL);
+    return psram;
+}
+
+/* Each size must be served by the first pool with a block of at least that size */
+static void bench_size_classes()
+{
+    const uint16_t sizes[] = {1, 16, 17, 32, 33, 64, 65, 128, 129, 256};
+
+    for(uint16_t size : sizes) {
+        uint8_t expected = 0;
+        while(bench_pool(expected).block_size < size) expected++;
+
+        hasp_mem_pool_stats_t before[BENCH_POOLS];
+        for(uint8_t i = 0; i < BENCH_POOLS; i++) before[i] = bench_pool(i);
+        uint32_t heap = bench_heap_allocs();
+
+        void* ptr = hasp_malloc(size);
+        char what[64];
+        snprintf(what, sizeof(what), "%u bytes are served by the %u byte pool", size,
+                 bench_pool(expected).block_size);
+        for(uint8_t i = 0; i < BENCH_POOLS; i++) {
+            uint32_t added = bench_pool(i).allocs - before[i].allocs;
+            host_check(added == (i == expected ? 1u : 0u), what);
+        }
+        host_check(bench_heap_allocs() == heap, "a pooled size does not touch the heap");
+        memset(ptr, 0xA5, size);
+
+        hasp_free(ptr);
+        host_check(bench_pool(expected).used == before[expected].used, "the block is returned to its pool");
+        printf("  %3u bytes -> %3u byte pool\n", size, bench_pool(expected).block_size);
+    }
+
+    uint32_t heap = bench_heap_allocs();
+    void* ptr     = hasp_malloc(257);
+    host_check(bench_heap_allocs() == heap + 1, "a size above the largest block goes to the heap");
+    hasp_free(ptr);
+}
+
+/* A full pool falls back to the heap instead of the next pool */
+static void bench_exhaustion()
+{
+    const uint8_t last          = BENCH_POOLS - 1;
+    hasp_mem_pool_stats_t start = bench_pool(last);
+    std::vector<void*> blocks;
+
+    for(uint16_t i = start.used; i < start.block_count; i++) blocks.push_back(hasp_malloc(start.block_size));
+    host_check(bench_pool(last).used == start.block_count, "the pool is full");
+
+    uint32_t heap  = bench_heap_allocs();
+    void* fallback = hasp_malloc(start.block_size);
+    host_check(fallback != NULL, "a full pool still returns memory");
+    host_check(bench_pool(last).fallbacks == start.fallbacks + 1, "the fallback is counted");
+    host_check(bench_heap_allocs() == heap + 1, "the fallback comes from the heap");
+    host_check(bench_pool(last).used == start.block_count, "the fallback does not use a block");
+
+    hasp_free(fallback);
+    host_check(bench_pool(last).used == start.block_count, "freeing the fallback leaves the pool alone");
+
+    for(void* ptr : blocks) hasp_free(ptr);
+    host_check(bench_pool(last).used == start.used, "every block is back in the pool");
+    host_check(bench_pool(last).high_water == start.block_count, "the high water mark is the full pool");
+
+    void* again = hasp_malloc(start.block_size);
+    host_check(bench_pool(last).allocs == start.allocs + start.block_count - start.used + 1,
+               "the pool serves requests again after it was freed");
+    hasp_free(again);
+    printf("  %u byte pool: %u blocks, %u fallback\n", start.block_size, start.block_count,
+           bench_pool(last).fallbacks - start.fallbacks);
+}
+
+/* Large and persistent requests go to PSram, their pointers are released like any other */
+static void bench_psram()
+{
+    host_check(hasp_use_psram(), "PSram is emulated");
+
+    uint32_t psram = bench_psram_allocs();
+    uint32_t heap  = bench_heap_allocs();
+
+    char* large = (char*)hasp_malloc(4096);
+    host_check(large != NULL, "a large request returns memory");
+    host_check(bench_psram_allocs() == psram + 1, "a large request goes to PSram");
+    memset(large, 'p', 4096);
+
+    char* grown = (char*)hasp_realloc(large, 8192);
+    host_check(grown != NULL && grown[4095] == 'p', "a PSram pointer can grow");
+    hasp_free(grown);
+
+    void* persistent = hasp_calloc_persistent(4, 8);
+    host_check(persistent != NULL, "a persistent request returns memory");
+    host_check(bench_psram_allocs() == psram + 2, "a small persistent request goes to PSram");
+    hasp_free(persistent);
+
+    host_check(bench_heap_allocs() == heap, "PSram requests do not touch the heap");
+}
+
+/* A realloc stays in its block while it fits and moves to a bigger pool with its contents */
+static void bench_realloc()
+{
+    char* ptr = (char*)hasp_malloc(10);
+    memcpy(ptr, "0123456789", 10);
+
+    char* same = (char*)hasp_realloc(ptr, 14);
+    host_check(same == ptr, "a realloc within the block keeps the pointer");
+
+    uint32_t allocs = bench_pool(3).allocs;
+    char* moved     = (char*)hasp_realloc(same, 100);
+    host_check(moved != same, "a realloc above the block moves the pointer");
+    host_check(bench_pool(3).allocs == allocs + 1, "the moved block comes from the 128 byte pool");
+    host_check(memcmp(moved, "0123456789", 10) == 0, "the contents are moved");
+    host_check(bench_pool(0).used == 0, "the old block is released");
+
+    hasp_free(moved);
+    hasp_free(moved); // double free is ignored
+    host_check(bench_pool(3).used == 0, "a double free does not corrupt the pool");
+}
+
+/* Concurrent allocations must all be counted */
+static void bench_threads()
+{
+    uint32_t heap   = bench_heap_allocs();
+    uint32_t allocs = bench_pool(1).allocs;
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < BENCH_THREADS; t++) {
+        threads.emplace_back([] {
+            for(int i = 0; i < BENCH_ROUNDS; i++) {
+                void* pooled = hasp_malloc(24);
+                void* heaped = hasp_malloc(512);
+                hasp_free(heaped);
+                hasp_free(pooled);
+            }
+        });
+    }
+    for(std::thread& thread : threads) thread.join();
+
+    host_check(bench_heap_allocs() - heap == BENCH_THREADS * BENCH_ROUNDS, "every heap allocation is counted");
+    host_check(bench_pool(1).allocs - allocs == BENCH_THREADS * BENCH_ROUNDS, "every pool allocation is counted");
+    host_check(bench_pool(1).used == 0, "every pooled block is returned");
+    printf("  %d threads: %u heap, %u pooled allocations\n", BENCH_THREADS, bench_heap_allocs() - heap,
+           bench_pool(1).allocs - allocs);
+}
+
+int main()
+{
+    printf("size classes\n");
+    bench_size_classes();
+    printf("exhaustion\n");
+    bench_exhaustion();
+    printf("psram\n");
+    bench_psram();
+    printf("realloc\n");
+    bench_realloc();
+    printf("threads\n");
+    bench_threads();
+    return host_result();
+}
@@ -0,0 +1,197 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host check of the POSIX process metrics
+ *
+ * A named thread burns a known amount of cpu next to an idle one, then the heap is filled with small blocks, every
+ * other block is freed and a large buffer is touched. After each step the metrics are sampled and compared with
+ * what the test did. sysinfo().freeram, what the device reported before, is printed next to it. Then a thread
+ * reads the values while the main thread samples, and last the cost of a sample and of reading the copy is measured.
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include <sys/sysinfo.h>
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "host_test.h"
+#include "hasp_posix_metrics.h"
+
+#define BENCH_BUSY_MS 400
+#define BENCH_BLOCKS 2000
+#define BENCH_BLOCK_SIZE 4096
+#define BENCH_LARGE (32u * 1024 * 1024)
+
+static uint64_t bench_thread_cpu_ms()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static size_t bench_freeram()
+{
+    struct sysinfo s_info;
+    return sysinfo(&s_info) < 0 ? 0 : s_info.freeram;
+}
+
+static const posix_thread_metrics_t* bench_find(const posix_metrics_t& metrics, const char* name)
+{
+    for(uint8_t i = 0; i < metrics.threads; i++)
+        if(!strcmp(metrics.thread[i].name, name)) return &metrics.thread[i];
+    return NULL;
+}
+
+static void bench_print(const char* step)
+{
+    posix_metrics_t metrics = posix_metrics_get();
+    printf("%s: rss %zu KB, heap used %zu KB, free %zu KB, large %zu KB, frag %u%%, free heap %zu KB, "
+           "max block %zu KB, freeram %zu KB, %u MHz\n",
+           step, metrics.rss / 1024, metrics.heap_used / 1024, metrics.heap_free / 1024, metrics.heap_large / 1024,
+           posix_metrics_fragmentation(metrics), posix_metrics_free_heap(metrics) / 1024,
+           posix_metrics_max_block(metrics) / 1024, bench_freeram() / 1024, metrics.cpu_mhz);
+}
+
+int main()
+{
+    posix_metrics_sample();
+    bench_print("start");
+
+    // Cpu time per thread
+    std::atomic<uint64_t> busy_cpu(0);
+    std::atomic<bool> idle_running(true);
+    std::thread busy([&busy_cpu]() {
+        pthread_setname_np(pthread_self(), "bench_busy");
+        uint64_t start = bench_thread_cpu_ms();
+        while(bench_thread_cpu_ms() - start < BENCH_BUSY_MS) {
+        }
+        busy_cpu = bench_thread_cpu_ms();
+        std::this_thread::sleep_for(std::chrono::milliseconds(300)); // still alive for the sample
+    });
+    std::thread idle([&idle_running]() {
+        pthread_setname_np(pthread_self(), "bench_idle");
+        while(idle_running) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    });
+
+    posix_metrics_sample();
+    std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_BUSY_MS + 100));
+    posix_metrics_sample();
+    posix_metrics_t metrics = posix_metrics_get();
+
+    printf("threads:");
+    for(uint8_t i = 0; i < metrics.threads; i++)
+        printf(" %s %u ms %u.%u%%", metrics.thread[i].name, metrics.thread[i].cpu_ms, metrics.thread[i].cpu_load / 10,
+               metrics.thread[i].cpu_load % 10);
+    printf(", process %u.%u%%\n", metrics.cpu_load / 10, metrics.cpu_load % 10);
+
+    const posix_thread_metrics_t* thread_busy = bench_find(metrics, "bench_busy");
+    const posix_thread_metrics_t* thread_idle = bench_find(metrics, "bench_idle");
+    const posix_thread_metrics_t* thread_main = bench_find(metrics, "main");
+    host_check(thread_busy && thread_idle && thread_main, "threads found by name");
+    if(thread_busy) {
+        int32_t diff = (int32_t)thread_busy->cpu_ms - (int32_t)busy_cpu;
+        host_check(diff > -30 && diff < 30, "busy thread cpu time within a few ticks");
+        host_check(thread_busy->cpu_load > 600, "busy thread load above 60%");
+    }
+    if(thread_idle) host_check(thread_idle->cpu_load < 100, "idle thread load below 10%");
+    host_check(metrics.cpu_load >= (thread_busy ? thread_busy->cpu_load : 0), "process load includes the threads");
+    idle_running = false;
+    busy.join();
+    idle.join();
+
+    // Heap in use and fragmentation
+    size_t used_before = metrics.heap_used;
+    std::vector<char*> blocks;
+    blocks.reserve(BENCH_BLOCKS); // a vector grown in between would split the freed blocks in two
+    for(int n = 0; n < BENCH_BLOCKS; n++) {
+        blocks.push_back((char*)malloc(BENCH_BLOCK_SIZE));
+        blocks.back()[0] = 1;
+    }
+    posix_metrics_sample();
+    metrics = posix_metrics_get();
+    bench_print("allocated");
+    size_t filled = (size_t)BENCH_BLOCKS * BENCH_BLOCK_SIZE;
+    host_check(metrics.heap_used - used_before >= filled, "heap used grew by the allocated blocks");
+
+    for(int n = 0; n < BENCH_BLOCKS; n += 2) {
+        free(blocks[n]);
+        blocks[n] = NULL;
+    }
+    posix_metrics_sample();
+    metrics = posix_metrics_get();
+    bench_print("holes    ");
+    host_check(metrics.heap_free >= filled / 2, "freed blocks counted as free heap");
+    host_check(posix_metrics_free_heap(metrics) == metrics.heap_free, "free heap is the free heap of the process");
+    host_check(posix_metrics_max_block(metrics) <= posix_metrics_free_heap(metrics), "max block within the free heap");
+    host_check(posix_metrics_fragmentation(metrics) >= 50, "holes between blocks show as fragmentation");
+    host_check(metrics.heap_large < filled / 20, "no large free chunk between the blocks");
+
+    for(char* block : blocks) free(block);
+    posix_metrics_sample();
+    metrics = posix_metrics_get();
+    bench_print("freed    ");
+    host_check(metrics.heap_used < used_before + filled / 10, "heap used back down");
+    host_check(posix_metrics_fragmentation(metrics) < 20, "freed blocks merged, fragmentation gone");
+
+    // Resident set
+    size_t rss_before = metrics.rss;
+    char* large       = (char*)malloc(BENCH_LARGE);
+    memset(large, 0x55, BENCH_LARGE);
+    posix_metrics_sample();
+    metrics = posix_metrics_get();
+    bench_print("touched  ");
+    host_check(metrics.rss - rss_before >= BENCH_LARGE * 9 / 10, "resident set grew by the touched buffer");
+    host_check(metrics.heap_used >= BENCH_LARGE, "mmapped block counted in heap used");
+    free(large);
+
+    // Reads from another thread while sampling, each copy is one whole sample
+    std::atomic<bool> reading(true);
+    std::atomic<size_t> torn(0);
+    std::thread reader([&reading, &torn]() {
+        uint32_t last = 0;
+        while(reading) {
+            posix_metrics_t copy = posix_metrics_get();
+            if(copy.samples < last || copy.threads == 0 || copy.heap_free > copy.heap_arena) torn++;
+            last = copy.samples;
+        }
+    });
+    for(int n = 0; n < 200; n++) posix_metrics_sample();
+    reading = false;
+    reader.join();
+    host_check(torn == 0, "copies read while sampling are whole samples");
+
+    // Cost of sampling against reading the copy
+    auto start = std::chrono::steady_clock::now();
+    for(int n = 0; n < 100; n++) posix_metrics_sample();
+    double sample_us =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() /
+        100000.0;
+
+    volatile size_t sink = 0;
+    start                = std::chrono::steady_clock::now();
+    for(int n = 0; n < 1000000; n++) {
+        posix_metrics_t cached = posix_metrics_get();
+        sink += posix_metrics_free_heap(cached) + posix_metrics_fragmentation(cached) + cached.cpu_mhz;
+    }
+    double read_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() /
+        1000000.0;
+
+    start = std::chrono::steady_clock::now();
+    for(int n = 0; n < 10000; n++) sink += bench_freeram();
+    double sysinfo_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() /
+        10000.0;
+
+    printf("sample %.1f us, cached read %.1f ns, sysinfo %.0f ns\n", sample_us, read_ns, sysinfo_ns);
+    host_check(read_ns < sysinfo_ns, "cached read cheaper than sysinfo");
+
+    return host_result();
+}
@@ -0,0 +1,410 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host check of the plugin registry
+ *
+ * hasp_plugin.cpp is built against stub/hasplib.h, which fakes millis(), micros() and the log and
+ * turns on HASP_USE_CUSTOM. The plugins of my_custom_template.cpp and my_custom_fan_template.cpp are registered at
+ * file scope like the templates do, plus one that follows the page and button states, next to the custom_* functions.
+ * The pins of the custom functions must be known before plugin_setup. Custom messages and state messages must only
+ * reach the plugins whose filter matches, the fan loop must run at its tick rate, the custom loop with an interval of
+ * 0 must still let the main loop sleep and a plugin that overruns its budget must be warned about once and then at
+ * most every HASP_PLUGIN_WARN_INTERVAL. Last the cost of matching a state message against the filters of eight
+ * plugins is timed.
+ */
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "host_test.h"
+#include "hasp_plugin.h"
+#include "hasp_plugin_core.h"
+
+static uint32_t now_ms = 0; // the fake millis()
+static uint32_t now_us = 0; // the fake micros(), a call advances it by the cost of the plugin
+
+struct bench_state_t
+{
+    std::vector<std::string> received; // topics and subtopics it was called for
+    uint32_t setups;
+    uint32_t loops;
+    uint32_t seconds;
+    uint32_t warnings;
+    uint32_t cost; // us every call takes
+};
+
+static bench_state_t my_state, fan_state, serial_state, custom_state;
+
+uint32_t millis()
+{
+    return now_ms;
+}
+
+uint32_t micros()
+{
+    return now_us;
+}
+
+static bench_state_t* bench_state(const char* name)
+{
+    if(!strcmp(name, "my_plugin")) return &my_state;
+    if(!strcmp(name, "fan")) return &fan_state;
+    if(!strcmp(name, "serial")) return &serial_state;
+    if(!strcmp(name, "custom")) return &custom_state;
+    return NULL;
+}
+
+/* The overrun warning of plugin_done, its first argument is the name of the plugin */
+void bench_warning(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    bench_state_t* state = bench_state(va_arg(args, const char*));
+    va_end(args);
+    if(state) state->warnings++;
+}
+
+static void bench_call(bench_state_t& state)
+{
+    now_us += state.cost;
+}
+
+/* As in my_custom_template.cpp */
+static void my_setup()
+{
+    my_state.setups++;
+}
+
+static void my_every_second()
+{
+    my_state.seconds++;
+}
+
+static void my_every_5seconds()
+{}
+
+static bool my_pin_in_use(uint8_t pin)
+{
+    return pin == 21;
+}
+
+static void my_get_sensors(JsonDocument& doc)
+{
+    doc.sensors["my_plugin"] = 1;
+}
+
+static const hasp_plugin_t my_plugin = {
+    "my_plugin",       // name in the log and on the info page
+    NULL,              // custom topics, none
+    NULL,              // state subtopics, none
+    0,                 // loop interval in ms
+    0,                 // time budget per call in us, 0 is the default
+    my_setup,          // setup
+    NULL,              // loop
+    my_every_second,   // every_second
+    my_every_5seconds, // every_5seconds
+    my_pin_in_use,     // pin_in_use
+    my_get_sensors,    // get_sensors
+    NULL,              // topic_payload
+    NULL,              // state_subtopic
+};
+HASP_PLUGIN_REGISTER(my_plugin);
+
+/* As in my_custom_fan_template.cpp */
+static void fan_loop()
+{
+    fan_state.loops++;
+    bench_call(fan_state);
+}
+
+static void fan_topic_payload(const char* topic, const char*, uint8_t)
+{
+    fan_state.received.push_back(topic);
+    bench_call(fan_state);
+}
+
+static const hasp_plugin_t fan_plugin = {
+    "fan",               // name in the log and on the info page
+    "fanspeed,fanangle", // custom topics
+    NULL,                // state subtopics, none
+    10,                  // loop interval in ms
+    2000,                // time budget per call in us, rotating a small image
+    NULL,                // setup
+    fan_loop,            // loop
+    NULL,                // every_second
+    NULL,                // every_5seconds
+    NULL,                // pin_in_use
+    NULL,                // get_sensors
+    fan_topic_payload,   // topic_payload
+    NULL,                // state_subtopic
+};
+HASP_PLUGIN_REGISTER(fan_plugin);
+
+/* Forwards custom/serial* messages and the page and button states of page 1, e.g. to Serial2 */
+static void serial_topic_payload(const char* topic, const char*, uint8_t)
+{
+    serial_state.received.push_back(topic);
+}
+
+static void serial_state_subtopic(const char* subtopic, const char*)
+{
+    serial_state.received.push_back(subtopic);
+}
+
+static const hasp_plugin_t serial_plugin = {
+    "serial",              // name in the log and on the info page
+    "serial*",             // custom topics
+    "p1b*,page",           // state subtopics
+    0,                     // loop interval in ms
+    0,                     // time budget per call in us, 0 is the default
+    NULL,                  // setup
+    NULL,                  // loop
+    NULL,                  // every_second
+    NULL,                  // every_5seconds
+    NULL,                  // pin_in_use
+    NULL,                  // get_sensors
+    serial_topic_payload,  // topic_payload
+    serial_state_subtopic, // state_subtopic
+};
+HASP_PLUGIN_REGISTER(serial_plugin);
+
+/* The older custom_* functions, hasp_plugin.cpp registers them as the "custom" plugin */
+void custom_setup()
+{
+    custom_state.setups++;
+}
+
+void custom_loop()
+{
+    custom_state.loops++;
+}
+
+void custom_every_second()
+{
+    custom_state.seconds++;
+}
+
+void custom_every_5seconds()
+{}
+
+bool custom_pin_in_use(uint8_t pin)
+{
+    return pin == 33;
+}
+
+void custom_get_sensors(JsonDocument& doc)
+{
+    doc.sensors["custom"] = 1;
+}
+
+void custom_topic_payload(const char* topic, const char*, uint8_t)
+{
+    custom_state.received.push_back(topic);
+}
+
+void custom_state_subtopic(const char* subtopic, const char*)
+{
+    custom_state.received.push_back(subtopic);
+}
+
+static size_t bench_plugin_count()
+{
+    JsonObject info;
+    plugin_get_info(info);
+    return info.values.size();
+}
+
+static void bench_setup()
+{
+    // gpioSetup asks before plugin_setup runs
+    host_check(plugin_pin_in_use(33), "custom pin known before setup");
+    host_check(plugin_pin_in_use(21), "plugin pin known before setup");
+    host_check(!plugin_pin_in_use(5), "free pin");
+
+    plugin_setup();
+    host_check(my_state.setups == 1 && custom_state.setups == 1, "setup called once");
+    host_check(bench_plugin_count() == 4, "four plugins");
+    host_check(plugin_register(&fan_plugin) && bench_plugin_count() == 4, "registering twice adds nothing");
+
+    JsonDocument doc;
+    plugin_get_sensors(doc);
+    plugin_every_second();
+    host_check(doc.sensors.size() == 2, "sensors of my_plugin and custom");
+    host_check(my_state.seconds == 1 && custom_state.seconds == 1, "every second");
+    printf("setup: %zu plugins, pins 21 and 33 in use before setup\n", bench_plugin_count());
+}
+
+static void bench_filters()
+{
+    struct
+    {
+        const char* filter;
+        const char* topic;
+        bool match;
+    } cases[] = {
+        {"fanspeed,fanangle", "fanspeed", true},  {"fanspeed,fanangle", "fanangle", true},
+        {"fanspeed,fanangle", "fan", false},      {"fanspeed,fanangle", "fanspeed2", false},
+        {"fan*", "fanspeed", true},               {"fan*", "fan", true},
+        {"fan*", "fa", false},                    {"*", "anything", true},
+        {"*", "", true},                          {"p1b*,page", "p1b12", true},
+        {"p1b*,page", "p2b1", false},             {"p1b*,page", "page", true},
+        {"p1b*,page", "pages", false},            {"", "fanspeed", false},
+        {NULL, "fanspeed", false},                {"a,,b", "b", true},
+        {"a,,b", "", false},                      {"light,", "light", true},
+    };
+    size_t wrong = 0;
+    for(auto& c : cases) {
+        if(plugin_filter_match(c.filter, c.topic) == c.match) continue;
+        printf("filter \"%s\" topic \"%s\" should %smatch\n", c.filter ? c.filter : "NULL", c.topic,
+               c.match ? "" : "not ");
+        wrong++;
+    }
+    printf("%zu filter cases, %zu wrong\n", sizeof(cases) / sizeof(cases[0]), wrong);
+    errors += wrong;
+}
+
+static void bench_routing()
+{
+    host_check(plugin_has_topics(), "has topics");
+    host_check(plugin_topic_payload("fanspeed", "10", 0), "fanspeed handled");
+    host_check(plugin_topic_payload("fanangle", "", 0), "fanangle handled");
+    host_check(plugin_topic_payload("light", "on", 0), "light handled by custom");
+    host_check(plugin_topic_payload("serial2", "hello", 0), "serial2 handled");
+    plugin_state_subtopic("p1b3", "{\"val\":1}");
+    plugin_state_subtopic("p2b3", "{\"val\":1}");
+    plugin_state_subtopic("page", "1");
+    plugin_state_subtopic("fanspeed", "10");
+
+    host_check(my_state.received.empty(), "my_plugin receives nothing");
+    host_check(fan_state.received.size() == 2 && fan_state.received[0] == "fanspeed" &&
+                   fan_state.received[1] == "fanangle",
+               "fan receives fanspeed and fanangle");
+    host_check(serial_state.received.size() == 3 && serial_state.received[0] == "serial2" &&
+                   serial_state.received[1] == "p1b3" && serial_state.received[2] == "page",
+               "serial receives serial2, p1b3 and page");
+    host_check(custom_state.received.size() == 8, "custom receives everything");
+    printf("routing: my_plugin %zu, fan %zu, serial %zu, custom %zu messages\n", my_state.received.size(),
+           fan_state.received.size(), serial_state.received.size(), custom_state.received.size());
+}
+
+static void bench_ticks()
+{
+    // The custom loop runs on every call but does not keep the main loop awake
+    uint32_t start = now_ms, next = UINT32_MAX, custom_loops = custom_state.loops;
+    while(now_ms - start < 1000) {
+        next = plugin_loop();
+        now_ms++;
+    }
+    host_check(next > 0 && next <= HASP_PLUGIN_MIN_WAIT, "custom loop lets the main loop sleep");
+    host_check(custom_state.loops - custom_loops == 1000, "custom loop ran 1000 times");
+    host_check(fan_state.loops >= 99 && fan_state.loops <= 101, "fan loop every 10 ms");
+    printf("ticks: fan loop ran %u times in 1000 ms at a 10 ms interval\n", fan_state.loops);
+
+    // A main loop that sleeps until the next plugin loop is due, as loop_schedule does
+    uint32_t iterations = 0, zero_waits = 0, fan_loops = fan_state.loops;
+    custom_loops = custom_state.loops;
+    start        = now_ms;
+    while(now_ms - start < 1000) {
+        next = plugin_loop();
+        if(next == 0) zero_waits++;
+        now_ms += next ? next : 1;
+        iterations++;
+    }
+    host_check(zero_waits == 0, "no wait of 0 ms");
+    host_check(iterations <= 1000 / HASP_PLUGIN_MIN_WAIT + 1, "main loop sleeps between the plugin loops");
+    host_check(custom_state.loops - custom_loops == iterations, "custom loop on every iteration");
+    host_check(fan_state.loops - fan_loops >= 99 && fan_state.loops - fan_loops <= 101, "fan loop still every 10 ms");
+    printf("sleeping: %u iterations in 1000 ms, custom loop ran %u times, fan loop %u times\n", iterations,
+           custom_state.loops - custom_loops, fan_state.loops - fan_loops);
+}
+
+static bool bench_stats(const char* name, uint32_t& calls, uint32_t& max, uint32_t& overruns)
+{
+    JsonObject info;
+    plugin_get_info(info);
+    uint32_t avg;
+    return sscanf(info[name].c_str(), "%u x %u us, max %u us, %u overruns", &calls, &avg, &max, &overruns) == 4;
+}
+
+static void bench_overruns()
+{
+    uint32_t calls, max, overruns, calls_before, overruns_before;
+    bench_stats("fan", calls_before, max, overruns_before);
+
+    // 30 s of a 10 ms loop that takes 1.5 ms, with 2.5 ms calls from second 5 to 25
+    uint32_t start = now_ms;
+    while(now_ms - start < 30000) {
+        uint32_t t     = now_ms - start;
+        fan_state.cost = t >= 5000 && t < 25000 ? 2500 : 1500;
+        plugin_loop();
+        now_ms++;
+    }
+    fan_state.cost = 0;
+
+    host_check(bench_stats("fan", calls, max, overruns), "fan info");
+    calls -= calls_before;
+    overruns -= overruns_before;
+    host_check(calls >= 2999 && calls <= 3001, "3000 calls");
+    host_check(overruns >= 1999 && overruns <= 2001, "2000 overruns");
+    host_check(max == 2500, "max 2500 us");
+    host_check(fan_state.warnings == 2, "warned at 5 s and 15 s");
+    host_check(my_state.warnings + serial_state.warnings + custom_state.warnings == 0, "no other warnings");
+    printf("overruns: %u calls, %u overruns, max %u us, %u warnings\n", calls, overruns, max, fan_state.warnings);
+}
+
+static void bench_full()
+{
+    static hasp_plugin_t extra[HASP_PLUGIN_MAX];
+    static char names[HASP_PLUGIN_MAX][8];
+    size_t count = bench_plugin_count();
+    bool added   = true;
+    for(size_t i = 0; count + i < HASP_PLUGIN_MAX; i++) {
+        snprintf(names[i], sizeof(names[i]), "extra%zu", i);
+        extra[i].name = names[i];
+        added         = plugin_register(&extra[i]) && added;
+    }
+    host_check(added && bench_plugin_count() == HASP_PLUGIN_MAX, "registry fills up");
+    host_check(!plugin_register(&extra[HASP_PLUGIN_MAX - 1]), "full registry refuses");
+    host_check(!plugin_register(NULL), "NULL refused");
+
+    // Plugins without callbacks are skipped
+    plugin_loop();
+    plugin_every_second();
+    plugin_topic_payload("extra0", "", 0);
+    host_check(my_state.seconds == 2, "registry still walked");
+    printf("full: %zu plugins\n", bench_plugin_count());
+}
+
+static void bench_cost()
+{
+    const char* states[]  = {"p1b1,p1b2", "page", "p2*", "idle", "p3b10", "backlight", "p4b*", "light*"};
+    const char* topics[]  = {"p1b1", "p1b2", "p2b4", "page", "idle", "p5b7", "backlight", "p1b20"};
+    const int rounds      = 1000000;
+    volatile uint32_t hit = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for(int n = 0; n < rounds; n++)
+        for(const char* state : states)
+            if(plugin_filter_match(state, topics[n % 8])) hit++;
+    double filtered = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("cost: %.0f ns to route one state message past 8 plugin filters, %.1f plugins called instead of 8\n",
+           filtered / rounds, (double)hit / rounds);
+}
+
+int main()
+{
+    bench_setup();
+    bench_filters();
+    bench_routing();
+    bench_ticks();
+    bench_overruns();
+    bench_full();
+    bench_cost();
+
+    return host_result();
+}
@@ -0,0 +1,84 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host benchmark of the QR code bitmap update
+ *
+ * For each payload length it reports the encode time and the time to fill the 1-bit bitmap per pixel, the way
+ * lv_canvas_set_px did, and with the row-wise module expansion of qrcode_expand.h.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "host_test.h"
+#include "qrcodegen.h"
+#include "qrcode_expand.h"
+
+typedef std::chrono::steady_clock bench_clock;
+
+/* Stand-in for lv_canvas_set_px on an indexed 1-bit canvas: bounds check and a read-modify-write per pixel */
+__attribute__((noinline)) static void set_px(uint8_t* buf, int w, int h, int x, int y, bool light)
+{
+    if(x >= w || y >= h) return;
+    uint32_t stride = (w + 7) >> 3;
+    uint8_t* p      = buf + y * stride + (x >> 3);
+    uint8_t bit     = 0x80 >> (x & 7);
+    *p              = light ? (*p | bit) : (*p & ~bit);
+}
+
+static void per_pixel(uint8_t* buf, int size, const uint8_t* qr, int scale, int margin)
+{
+    uint32_t stride = (size + 7) >> 3;
+    memset(buf, 0xFF, stride * size); // lv_canvas_fill_bg
+    int scaled = qrcodegen_getSize(qr) * scale;
+    for(int y = 0; y < scaled; y++)
+        for(int x = 0; x < scaled; x++)
+            set_px(buf, size, size, x + margin, y + margin, !qrcodegen_getModule(qr, x / scale, y / scale));
+}
+
+template <typename F> static double time_us(int runs, F f)
+{
+    auto start = bench_clock::now();
+    for(int i = 0; i < runs; i++) f();
+    return std::chrono::duration<double, std::micro>(bench_clock::now() - start).count() / runs;
+}
+
+int main(int argc, char* argv[])
+{
+    int size        = argc > 1 ? atoi(argv[1]) : 240;
+    uint32_t stride = (size + 7) >> 3;
+    std::vector<uint8_t> a(stride * size), b(stride * size);
+    const int runs = 200;
+
+    printf("%5s %7s %5s %10s %12s %12s %8s\n", "bytes", "modules", "scale", "encode us", "per pixel us",
+           "expand us", "speedup");
+
+    for(int len : {8, 16, 32, 48, 64, 96, 120}) { // version 7 is the largest symbol qrcodegen is built for
+        std::vector<uint8_t> data(qrcodegen_BUFFER_LEN_MAX), qr(qrcodegen_BUFFER_LEN_MAX), temp(qrcodegen_BUFFER_LEN_MAX);
+        for(int i = 0; i < len; i++) data[i] = 'A' + i % 26;
+
+        bool ok       = false;
+        double encode = time_us(runs, [&] {
+            memcpy(temp.data(), data.data(), len);
+            ok = qrcodegen_encodeBinary(temp.data(), len, qr.data(), qrcodegen_Ecc_MEDIUM, qrcodegen_VERSION_MIN,
+                                        qrcodegen_VERSION_MAX, qrcodegen_Mask_AUTO, true);
+        });
+        host_check(ok, "payload fits");
+        if(!ok) continue;
+
+        int qr_size = qrcodegen_getSize(qr.data());
+        int scale   = size / (qr_size + 2);
+        int margin  = (size - qr_size * scale) / 2;
+
+        double slow = time_us(runs, [&] { per_pixel(a.data(), size, qr.data(), scale, margin); });
+        double fast = time_us(runs, [&] { qrcode_expand(b.data(), stride, size, qr.data(), scale, margin); });
+
+        host_check(a == b, "same bitmap");
+
+        printf("%5d %7d %5d %10.1f %12.1f %12.1f %7.1fx\n", len, qr_size, scale, encode, slow, fast, slow / fast);
+    }
+    return host_result();
+}
@@ -0,0 +1,171 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host check of the software rotation of the PC display drivers
+ *
+ * A random logical frame is flushed onto an 800x480 panel in areas of random size, the way lvgl hands out dirty
+ * areas, for every rotation with and without inversion. The panel must match a reference frame built pixel by pixel
+ * from the rotation matrix, and panel points must map back to their logical point like a touch. Then full frame
+ * flushes are timed for 16 and 32 bit pixels, tiled against a plain row by row copy.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "host_test.h"
+#include "tft_rotate.h"
+
+#define PANEL_W 800
+#define PANEL_H 480
+#define BENCH_FRAMES 200
+
+
+/* Where a logical pixel lands: turned clockwise around the center of the picture onto the center of the panel */
+static void bench_reference_point(uint8_t rotation, int32_t x, int32_t y, int32_t& px, int32_t& py)
+{
+    int32_t width  = rotation % 2 ? PANEL_H : PANEL_W;
+    int32_t height = rotation % 2 ? PANEL_W : PANEL_H;
+    int32_t dx = 2 * x - (width - 1), dy = 2 * y - (height - 1); // doubled, the center is between pixels
+    for(uint8_t r = 0; r < rotation; r++) {
+        int32_t t = dx;
+        dx        = -dy; // a quarter turn clockwise with y pointing down
+        dy        = t;
+    }
+    px = (dx + PANEL_W - 1) / 2;
+    py = (dy + PANEL_H - 1) / 2;
+}
+
+template <typename T> static void bench_correctness(T invert_mask, const char* name)
+{
+    std::vector<T> logical(PANEL_W * PANEL_H), panel(PANEL_W * PANEL_H), reference(PANEL_W * PANEL_H), area;
+    srand(3);
+
+    for(uint8_t rotation = 0; rotation < 4; rotation++) {
+        for(bool invert : {false, true}) {
+            int32_t width  = rotation % 2 ? PANEL_H : PANEL_W;
+            int32_t height = rotation % 2 ? PANEL_W : PANEL_H;
+            T mask         = invert ? invert_mask : 0;
+            for(T& pixel : logical) pixel = (T)rand() ^ ((T)rand() << 15);
+
+            for(int32_t y = 0; y < height; y++)
+                for(int32_t x = 0; x < width; x++) {
+                    int32_t px, py;
+                    bench_reference_point(rotation, x, y, px, py);
+                    reference[py * PANEL_W + px] = logical[y * width + x] ^ mask;
+                }
+
+            // Dirty areas of random size until the frame is covered, in bands like lvgl's draw buffer
+            std::fill(panel.begin(), panel.end(), 0);
+            for(int32_t y1 = 0; y1 < height;) {
+                int32_t y2 = y1 + rand() % 70;
+                if(y2 >= height) y2 = height - 1;
+                for(int32_t x1 = 0; x1 < width;) {
+                    int32_t x2 = x1 + rand() % 150;
+                    if(x2 >= width) x2 = width - 1;
+                    int32_t w = x2 - x1 + 1, h = y2 - y1 + 1;
+
+                    area.resize(w * h);
+                    std::vector<T> out(w * h);
+                    for(int32_t y = 0; y < h; y++)
+                        memcpy(&area[y * w], &logical[(y1 + y) * width + x1], w * sizeof(T));
+                    tft_rotate_pixels<T>(rotation, mask, area.data(), out.data(), w, h);
+
+                    tft_rect_t in = {x1, y1, x2, y2}, rect;
+                    tft_rotate_rect(rotation, PANEL_W, PANEL_H, in, rect);
+                    int32_t rw = rect.x2 - rect.x1 + 1, rh = rect.y2 - rect.y1 + 1;
+                    if(rw * rh != w * h || rect.x1 < 0 || rect.y1 < 0 || rect.x2 >= PANEL_W || rect.y2 >= PANEL_H) {
+                        errors++;
+                    } else {
+                        for(int32_t y = 0; y < rh; y++)
+                            memcpy(&panel[(rect.y1 + y) * PANEL_W + rect.x1], &out[y * rw], rw * sizeof(T));
+                    }
+                    x1 = x2 + 1;
+                }
+                y1 = y2 + 1;
+            }
+
+            size_t wrong = 0;
+            for(size_t i = 0; i < panel.size(); i++)
+                if(panel[i] != reference[i]) wrong++;
+
+            size_t touch = 0;
+            for(int32_t y = 0; y < height; y += 7)
+                for(int32_t x = 0; x < width; x += 3) {
+                    int32_t px, py;
+                    bench_reference_point(rotation, x, y, px, py);
+                    tft_unrotate_point(rotation, PANEL_W, PANEL_H, px, py);
+                    if(px != x || py != y) touch++;
+                }
+
+            printf("%s rotation %u%s: %zu pixels differ from the reference, %zu touch points off\n", name, rotation,
+                   invert ? " inverted" : "         ", wrong, touch);
+            errors += wrong + touch;
+        }
+    }
+}
+
+/* The plain transposition, source by rows and destination by columns */
+template <typename T> static void bench_rotate_rows(const T* src, T* dst, int32_t w, int32_t h)
+{
+    for(int32_t j = 0; j < h; j++)
+        for(int32_t i = 0; i < w; i++) dst[i * h + (h - 1 - j)] = src[j * w + i];
+}
+
+template <typename T> static void bench_throughput(T invert_mask, const char* name)
+{
+    std::vector<T> src(PANEL_W * PANEL_H), dst(PANEL_W * PANEL_H);
+    for(size_t i = 0; i < src.size(); i++) src[i] = (T)(i * 2654435761u);
+    volatile T sink = 0;
+
+    auto mpix = [](std::chrono::steady_clock::time_point start) {
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return BENCH_FRAMES * (double)PANEL_W * PANEL_H / s / 1e6;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for(int n = 0; n < BENCH_FRAMES; n++) {
+        memcpy(dst.data(), src.data(), src.size() * sizeof(T));
+        sink ^= dst[n];
+    }
+    double copy = mpix(start);
+
+    double rotated[4][2];
+    for(uint8_t rotation = 0; rotation < 4; rotation++)
+        for(int invert = 0; invert < 2; invert++) {
+            start = std::chrono::steady_clock::now();
+            for(int n = 0; n < BENCH_FRAMES; n++) {
+                tft_rotate_pixels<T>(rotation, invert ? invert_mask : 0, src.data(), dst.data(), PANEL_W, PANEL_H);
+                sink ^= dst[n];
+            }
+            rotated[rotation][invert] = mpix(start);
+        }
+
+    start = std::chrono::steady_clock::now();
+    for(int n = 0; n < BENCH_FRAMES; n++) {
+        bench_rotate_rows<T>(src.data(), dst.data(), PANEL_W, PANEL_H);
+        sink ^= dst[n];
+    }
+    double rows = mpix(start);
+
+    printf("%s Mpixel/s: memcpy %.0f, rotation 0 %.0f/%.0f, 90 %.0f/%.0f, 180 %.0f/%.0f, 270 %.0f/%.0f "
+           "(plain/inverted), untiled 90 %.0f\n",
+           name, copy, rotated[0][0], rotated[0][1], rotated[1][0], rotated[1][1], rotated[2][0], rotated[2][1],
+           rotated[3][0], rotated[3][1], rows);
+    printf("%s full %dx%d frame turned 90 degrees in %.2f ms, %.2f ms untiled\n", name, PANEL_W, PANEL_H,
+           PANEL_W * PANEL_H / rotated[1][0] / 1000.0, PANEL_W * PANEL_H / rows / 1000.0);
+}
+
+int main()
+{
+    bench_correctness<uint16_t>(0xFFFF, "16 bit");
+    bench_correctness<uint32_t>(0x00FFFFFF, "32 bit");
+
+    bench_throughput<uint16_t>(0xFFFF, "16 bit");
+    bench_throughput<uint32_t>(0x00FFFFFF, "32 bit");
+
+    return host_result();
+}
@@ -0,0 +1,302 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host check of the telnet session over a loopback socket
+ *
+ * A client socket is connected to a non-blocking server socket, which is served like the io thread does: received
+ * bytes go through input() and the queued output is sent with peek() and consume(). The client types lines with
+ * backspaces, telnet commands and every line ending, and must get the lines and the echo back. The output ring is
+ * then checked against a plain copy with writes and reads of random sizes. Last, log lines are written while the
+ * client does not read: no pass of the server may block, the lines that do not fit must be dropped whole and counted,
+ * and once the client reads again it must receive every line that was queued, intact and in order.
+ */
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "host_test.h"
+#include "hasp_telnet_session.h"
+
+#define BENCH_LOG_LINES 20000
+#define BENCH_MAX_PASS_US 2000 // a server pass that takes longer is counted as blocking
+
+
+
+struct bench_link_t
+{
+    int client;
+    int server;
+};
+
+static bool bench_connect(bench_link_t& link)
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if(listener < 0) return false;
+
+    struct sockaddr_in addr = {};
+    addr.sin_family         = AF_INET;
+    addr.sin_addr.s_addr    = htonl(INADDR_LOOPBACK);
+    addr.sin_port           = 0; // any free port
+    socklen_t size          = sizeof(addr);
+    if(bind(listener, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, 1) < 0 ||
+       getsockname(listener, (struct sockaddr*)&addr, &size) < 0) {
+        close(listener);
+        return false;
+    }
+
+    link.client = socket(AF_INET, SOCK_STREAM, 0);
+    int small   = 4096; // small socket buffers, so the client stops taking output soon
+    setsockopt(link.client, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+    if(connect(link.client, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(listener);
+        return false;
+    }
+    link.server = accept(listener, NULL, NULL);
+    close(listener);
+    if(link.server < 0) return false;
+
+    int on = 1;
+    setsockopt(link.server, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    setsockopt(link.server, SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    fcntl(link.server, F_SETFL, fcntl(link.server, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+/* One pass of the io thread: receive, then send without waiting. Completed lines are taken right away. */
+static void bench_serve(int fd, TelnetSession& session, std::vector<std::string>* lines)
+{
+    char data[64];
+    ssize_t len;
+    while((len = recv(fd, data, sizeof(data), 0)) > 0) {
+        size_t pos = 0;
+        while(pos < (size_t)len) {
+            pos += session.input(data + pos, len - pos);
+            if(session.line_ready) {
+                if(lines) lines->push_back(session.line());
+                session.take_line();
+            }
+            if(session.cancel) {
+                if(lines) lines->push_back("^C");
+                session.cancel = false;
+            }
+        }
+    }
+
+    const char* out;
+    size_t pending;
+    while((pending = session.peek(&out)) > 0) {
+        ssize_t sent = send(fd, out, pending, MSG_NOSIGNAL);
+        if(sent <= 0) return; // full, the next pass tries again
+        session.consume(sent);
+        if((size_t)sent < pending) return;
+    }
+}
+
+/* Reads what the client received within timeout_ms */
+static std::string bench_receive(int fd, TelnetSession& session, int server, int timeout_ms)
+{
+    std::string received;
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while(std::chrono::steady_clock::now() < end) {
+        bench_serve(server, session, NULL);
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if(poll(&pfd, 1, 5) <= 0) {
+            if(session.pending() == 0) break;
+            continue;
+        }
+        char data[4096];
+        ssize_t len = recv(fd, data, sizeof(data), 0);
+        if(len <= 0) break;
+        received.append(data, len);
+    }
+    return received;
+}
+
+static void bench_input()
+{
+    printf("input and echo:\n");
+    bench_link_t link;
+    if(!bench_connect(link)) {
+        host_check(false, "loopback connection");
+        return;
+    }
+
+    TelnetSession session;
+    session.begin("127.0.0.1");
+
+    // backspace and delete, IAC WILL ECHO, a subnegotiation, CR LF, CR NUL and a bare LF
+    const char typed[] = "helx\b\x7flo\r\n"
+                         "\xff\xfb\x01"
+                         "se\xff\xfa\x18\x01\xff\xf0"
+                         "cond\r\0"
+                         "third\n"
+                         "\x03";
+    std::vector<std::string> lines;
+    send(link.client, typed, sizeof(typed) - 1, 0);
+    for(int i = 0; i < 20 && lines.size() < 4; i++) {
+        usleep(1000);
+        bench_serve(link.server, session, &lines);
+    }
+
+    host_check(lines.size() == 4, "four lines");
+    host_check(lines.size() > 0 && lines[0] == "helo", "backspace and delete");
+    host_check(lines.size() > 1 && lines[1] == "second", "telnet commands are not part of the line");
+    host_check(lines.size() > 2 && lines[2] == "third", "CR NUL and LF end a line");
+    host_check(lines.size() > 3 && lines[3] == "^C", "Ctrl-C cancels");
+
+    std::string echo = bench_receive(link.client, session, link.server, 100);
+    host_check(echo == "helx\b \b\b \blo\r\nsecond\r\nthird\r\n", "echo");
+
+    // a password is not echoed, a line that is too long is cut
+    session.echo = false;
+    std::string line(TELNET_LINE_SIZE + 50, 'p');
+    line += "\r\n";
+    send(link.client, line.data(), line.size(), 0);
+    lines.clear();
+    for(int i = 0; i < 20 && lines.empty(); i++) {
+        usleep(1000);
+        bench_serve(link.server, session, &lines);
+    }
+    host_check(lines.size() == 1 && lines[0].size() == TELNET_LINE_SIZE - 1, "long line cut");
+    host_check(bench_receive(link.client, session, link.server, 100) == "\r\n", "no echo of the password");
+
+    printf("  %zu lines\n", lines.size() + 4);
+    session.end();
+    close(link.client);
+    close(link.server);
+}
+
+static void bench_ring()
+{
+    printf("output ring:\n");
+    TelnetSession session;
+    session.begin("ring");
+
+    std::deque<char> model;
+    uint32_t written = 0, dropped = 0, mismatches = 0;
+    char data[TELNET_QUEUE_SIZE];
+
+    srand(3);
+    for(int i = 0; i < 200000; i++) {
+        if(rand() % 2) {
+            size_t len = rand() % (TELNET_QUEUE_SIZE / 3);
+            for(size_t n = 0; n < len; n++) data[n] = (char)rand();
+            size_t res = session.write(data, len);
+            if(res == len) {
+                model.insert(model.end(), data, data + len);
+                written += len;
+            } else if(res == 0) {
+                dropped += len;
+            } else {
+                mismatches++; // partial write
+            }
+        } else {
+            const char* out;
+            size_t len = session.peek(&out);
+            len        = len ? rand() % (len + 1) : 0;
+            for(size_t n = 0; n < len; n++)
+                if(model.empty() || out[n] != model[n]) mismatches++;
+            session.consume(len);
+            model.erase(model.begin(), model.begin() + (len < model.size() ? len : model.size()));
+        }
+        if(session.pending() != model.size()) mismatches++;
+    }
+
+    printf("  %u bytes written, %u dropped, %u mismatches\n", written, dropped, mismatches);
+    host_check(mismatches == 0, "ring contents");
+    host_check(dropped > 0, "writes that do not fit are dropped");
+    host_check(session.dropped == dropped && session.queued == written, "counters");
+    session.end();
+}
+
+static void bench_backpressure()
+{
+    printf("backpressure:\n");
+    bench_link_t link;
+    if(!bench_connect(link)) {
+        host_check(false, "loopback connection");
+        return;
+    }
+
+    TelnetSession session;
+    session.begin("127.0.0.1");
+
+    // The client does not read while the log is written
+    char line[64];
+    uint32_t accepted = 0, slow = 0, max_us = 0;
+    std::vector<bool> queued(BENCH_LOG_LINES);
+    for(unsigned n = 0; n < BENCH_LOG_LINES; n++) {
+        int len   = snprintf(line, sizeof(line), "log line %u %08x\r\n", n, n * 2654435761u);
+        queued[n] = session.write(line, len) == (size_t)len;
+        if(queued[n]) accepted++;
+
+        auto start = std::chrono::steady_clock::now();
+        bench_serve(link.server, session, NULL);
+        uint32_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start)
+                          .count();
+        if(us > max_us) max_us = us;
+        if(us > BENCH_MAX_PASS_US) slow++;
+    }
+
+    printf("  %u of %u lines queued, %u bytes dropped, slowest pass %u us\n", accepted, BENCH_LOG_LINES,
+           session.dropped, max_us);
+    host_check(accepted < BENCH_LOG_LINES && session.dropped > 0, "the client fell behind");
+    host_check(slow == 0, "no server pass blocked");
+
+    // Now the client catches up, it must get exactly the queued lines
+    std::string received = bench_receive(link.client, session, link.server, 2000);
+    size_t pos = 0, lines = 0, bad = 0;
+    unsigned next = 0;
+    while(pos < received.size()) {
+        size_t end = received.find("\r\n", pos);
+        if(end == std::string::npos) {
+            bad++;
+            break;
+        }
+        unsigned n, hash;
+        if(sscanf(received.c_str() + pos, "log line %u %08x", &n, &hash) != 2 || hash != n * 2654435761u ||
+           n >= BENCH_LOG_LINES || !queued[n] || n < next) {
+            bad++;
+        } else {
+            for(; next < n; next++)
+                if(queued[next]) bad++; // a queued line is missing
+            next = n + 1;
+        }
+        lines++;
+        pos = end + 2;
+    }
+    for(; next < BENCH_LOG_LINES; next++)
+        if(queued[next]) bad++;
+
+    printf("  %zu lines received, %zu torn, missing or out of order\n", lines, bad);
+    host_check(bad == 0 && lines == accepted, "received lines");
+
+    session.end();
+    close(link.client);
+    close(link.server);
+}
+
+int main()
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    bench_input();
+    bench_ring();
+    bench_backpressure();
+
+    return host_result();
+}
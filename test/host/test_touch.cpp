@@ -0,0 +1,137 @@
+/* MIT License - Copyright (c) 2019-2024 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host stand-in for the multi-point touch acquisition
+ *
+ * The trace holds the reports of the controller, each report raises its interrupt. lvgl polls the input device
+ * every period ms (LV_INDEV_DEF_READ_PERIOD), which reads the latest report. The trace is played once reading the
+ * controller on every poll and once reading it only after an interrupt. For both it reports the number of
+ * controller reads and, for each gesture, the delay between the report that completed it and its recognition.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "host_test.h"
+#include "touch_gesture.h"
+
+struct bench_report_t
+{
+    uint32_t time;
+    std::vector<touch_point_t> points;
+};
+
+static bool bench_load(const char* path, std::vector<bench_report_t>& reports)
+{
+    std::ifstream file(path);
+    if(!file.is_open()) return false;
+
+    std::string line;
+    while(std::getline(file, line)) {
+        if(line.empty() || line[0] == '#') continue;
+
+        std::istringstream in(line);
+        bench_report_t report;
+        unsigned count;
+        if(!(in >> report.time >> count)) continue;
+
+        for(unsigned i = 0; i < count; i++) {
+            int id, x, y;
+            if(!(in >> id >> x >> y)) break;
+            report.points.push_back({(uint8_t)id, (int16_t)x, (int16_t)y});
+        }
+        reports.push_back(report);
+    }
+    return true;
+}
+
+struct bench_gesture_t
+{
+    uint32_t time;
+    touch_gesture_t gesture;
+};
+
+/* Recognition when every report is processed as soon as it arrives */
+static std::vector<bench_gesture_t> bench_reference(const std::vector<bench_report_t>& reports)
+{
+    std::vector<bench_gesture_t> gestures;
+    dev::TouchPoints touch;
+    for(const bench_report_t& report : reports) {
+        touch_gesture_t gesture = touch.update(report.time, report.points.size(), report.points.data());
+        if(gesture != TOUCH_GESTURE_NONE) gestures.push_back({report.time, gesture});
+    }
+    return gestures;
+}
+
+static void bench_run(const char* name, const std::vector<bench_report_t>& reports,
+                      const std::vector<bench_gesture_t>& reference, uint32_t period, bool irq)
+{
+    dev::TouchPoints touch;
+    touch.set_irq_enabled(irq);
+
+    std::vector<bench_gesture_t> gestures;
+    size_t next                = 0;    // next report of the controller
+    const bench_report_t* last = NULL; // latest report available in the controller
+    uint32_t end               = reports.empty() ? 0 : reports.back().time + 1000;
+    uint32_t presses           = 0;
+
+    for(uint32_t now = 0; now <= end; now += period) {
+        while(next < reports.size() && reports[next].time <= now) {
+            last = &reports[next++];
+            touch.irq();
+        }
+
+        if(touch.read_needed(now)) {
+            static const touch_point_t none[1] = {};
+            touch_gesture_t gesture = last ? touch.update(now, last->points.size(), last->points.data())
+                                           : touch.update(now, 0, none);
+            if(gesture != TOUCH_GESTURE_NONE) gestures.push_back({now, gesture});
+        }
+        if(touch.count > 0) presses++;
+    }
+
+    printf("%-8s reads %6u of %6u polls (%5.1f%% avoided), %u pressed polls\n", name, touch.reads, touch.polls,
+           touch.polls ? 100.0 * (touch.polls - touch.reads) / touch.polls : 0.0, presses);
+
+    for(size_t i = 0; i < gestures.size(); i++) {
+        bool known = i < reference.size() && reference[i].gesture == gestures[i].gesture;
+        host_check(known, "gesture in the reference");
+        if(known)
+            printf("         %-9s latency %3u ms\n", touch_gesture_name(gestures[i].gesture),
+                   gestures[i].time - reference[i].time);
+        else
+            printf("         %-9s not in the reference\n", touch_gesture_name(gestures[i].gesture));
+    }
+    host_check(gestures.size() >= reference.size(), "no gesture missed");
+    if(gestures.size() < reference.size()) printf("         %zu gestures missed\n", reference.size() - gestures.size());
+    if(irq) host_check(touch.reads < touch.polls, "reads only after an interrupt");
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2) {
+        fprintf(stderr, "usage: %s <trace> [period ms]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<bench_report_t> reports;
+    if(!bench_load(argv[1], reports)) {
+        fprintf(stderr, "Failed to open %s\n", argv[1]);
+        return 1;
+    }
+    uint32_t period = argc > 2 ? strtoul(argv[2], NULL, 10) : 20;
+    if(period == 0) period = 20;
+
+    std::vector<bench_gesture_t> reference = bench_reference(reports);
+    printf("%zu reports, %zu gestures, poll period %u ms\n", reports.size(), reference.size(), period);
+
+    host_check(!reference.empty(), "gestures in the trace");
+    bench_run("polling", reports, reference, period, false);
+    bench_run("irq", reports, reference, period, true);
+    return host_result();
+}